@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "adc_manager.h"
+#include "board_pins.h"
+#include "host_hal.h"
+
+/* =========================================================
+ * Host ADC read-path bench
+ *
+ * Cost per sample of the adc_manager read entry points, built with
+ * continuous mode off so every read is a oneshot conversion:
+ *   per_call  adc_manager_read_raw() / _read_mv() once per sample: pin
+ *             lookup and lock round trip each time
+ *   batch     adc_manager_chan_read() on channels opened once: one lock
+ *             per batch, calibration after it
+ * Cases: an 8-sample pitch-bend burst, 8 battery-sense millivolt reads,
+ * and 8 rounds over the three sliders. One JSON line per case and mode
+ * on stdout, logs on stderr. The host mutex is a pthread mutex; on the
+ * device each FreeRTOS take/give costs more, so the gap widens there.
+ * ========================================================= */
+
+#define ADC_BENCH_DEFAULT_ITERS 200000
+#define ADC_BENCH_ROUNDS        8
+#define ADC_BENCH_CHANS         3
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void report(const char *bench, const char *mode, uint32_t iters, uint32_t per_iter, int64_t ns, int failed)
+{
+    printf("{\"bench\":\"adc_read\",\"case\":\"%s\",\"mode\":\"%s\",\"iters\":%u,\"samples\":%llu,"
+           "\"failed\":%d,\"ns_per_sample\":%.1f}\n",
+           bench,
+           mode,
+           (unsigned)iters,
+           (unsigned long long)iters * per_iter,
+           failed,
+           (double)ns / ((double)iters * per_iter));
+}
+
+static void bench_pb_burst(uint32_t iters)
+{
+    int raw[ADC_BENCH_ROUNDS];
+    int failed = 0;
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        for (int s = 0; s < ADC_BENCH_ROUNDS; ++s) failed |= adc_manager_read_raw(PIN_SLIDER_PB, &raw[s]) != ESP_OK;
+    }
+    report("pb_burst", "per_call", iters, ADC_BENCH_ROUNDS, now_ns() - t0, failed);
+
+    adc_chan_t pb;
+    failed = adc_manager_chan_open(PIN_SLIDER_PB, &pb) != ESP_OK;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        failed |= adc_manager_chan_read(&pb, 1, ADC_BENCH_ROUNDS, raw, NULL) != ESP_OK;
+    }
+    report("pb_burst", "batch", iters, ADC_BENCH_ROUNDS, now_ns() - t0, failed);
+}
+
+static void bench_bat_mv(uint32_t iters)
+{
+    int raw[ADC_BENCH_ROUNDS], mv[ADC_BENCH_ROUNDS];
+    int failed = 0;
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        for (int s = 0; s < ADC_BENCH_ROUNDS; ++s) failed |= adc_manager_read_mv(PIN_BAT_VSENSE, &mv[s]) != ESP_OK;
+    }
+    report("bat_mv", "per_call", iters, ADC_BENCH_ROUNDS, now_ns() - t0, failed);
+
+    adc_chan_t bat;
+    failed = adc_manager_chan_open(PIN_BAT_VSENSE, &bat) != ESP_OK;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        failed |= adc_manager_chan_read(&bat, 1, ADC_BENCH_ROUNDS, raw, mv) != ESP_OK;
+    }
+    report("bat_mv", "batch", iters, ADC_BENCH_ROUNDS, now_ns() - t0, failed);
+}
+
+static void bench_sliders(uint32_t iters)
+{
+    static const gpio_num_t pins[ADC_BENCH_CHANS] = {PIN_SLIDER_PB, PIN_SLIDER_MOD, PIN_SLIDER_VEL};
+    int raw[ADC_BENCH_ROUNDS * ADC_BENCH_CHANS];
+    int failed = 0;
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        for (int s = 0; s < ADC_BENCH_ROUNDS * ADC_BENCH_CHANS; ++s) {
+            failed |= adc_manager_read_raw(pins[s % ADC_BENCH_CHANS], &raw[s]) != ESP_OK;
+        }
+    }
+    report("sliders", "per_call", iters, ADC_BENCH_ROUNDS * ADC_BENCH_CHANS, now_ns() - t0, failed);
+
+    adc_chan_t ch[ADC_BENCH_CHANS];
+    for (int k = 0; k < ADC_BENCH_CHANS; ++k) failed |= adc_manager_chan_open(pins[k], &ch[k]) != ESP_OK;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < iters; ++i) {
+        failed |= adc_manager_chan_read(ch, ADC_BENCH_CHANS, ADC_BENCH_ROUNDS, raw, NULL) != ESP_OK;
+    }
+    report("sliders", "batch", iters, ADC_BENCH_ROUNDS * ADC_BENCH_CHANS, now_ns() - t0, failed);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iters = ADC_BENCH_DEFAULT_ITERS;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iters = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-n iterations]\n"
+                    "  -n  iterations per case, default %d\n",
+                    argv[0],
+                    ADC_BENCH_DEFAULT_ITERS);
+            return 2;
+        }
+    }
+    if (iters == 0) iters = 1;
+
+    if (!adc_manager_init()) {
+        fprintf(stderr, "adc_manager_init failed\n");
+        return 1;
+    }
+    host_hal_adc_set_raw(PIN_SLIDER_PB, 2048);
+    host_hal_adc_set_raw(PIN_SLIDER_MOD, 1024);
+    host_hal_adc_set_raw(PIN_SLIDER_VEL, 3072);
+    host_hal_adc_set_raw(PIN_BAT_VSENSE, 2600);
+
+    bench_pb_burst(iters);
+    bench_bat_mv(iters);
+    bench_sliders(iters);
+    return 0;
+}
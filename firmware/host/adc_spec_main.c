@@ -0,0 +1,368 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adc_quiet.h"
+
+/* =========================================================
+ * Host ADC noise spectrum bench
+ *
+ * Replays conversion-rate slider traces ("conv pb" lines, one per
+ * conversion of the pitch-bend pin) through the streamed-ADC frame mean
+ * the way adc_manager publishes it, twice:
+ *
+ *   ungated  every conversion (trimmed frame mean)
+ *   quiet    only the conversions adc_quiet_at() keeps, given the LED PWM
+ *            and row-drive phase recorded in the trace
+ *
+ * and prints one JSON line per mode and trace with the frame-mean noise
+ * inside "#! rest" windows (12-bit LSB):
+ *   rms      standard deviation of the frame means
+ *   bands    RMS per eighth of the frame-rate Nyquist band
+ *   peaks    the largest spectral lines (Hz, sine amplitude)
+ *   kept     share of conversions that entered the mean
+ * -s adds the full spectra ("# spectrum" then "hz ungated quiet" rows).
+ * Exit status is non-zero when a trace cannot be read.
+ *
+ * Trace markers ("#!" lines; emiuet_qsim and the filter bench skip them):
+ *   #! frame <n>                       pb conversions per streamed frame
+ *   #! pwm <rise_us> <period_ns> <high_ns>   adc_manager_set_pwm_phase() arguments
+ *   #! drive <from_us> <until_us>      one row-drive burst (matrix_scan_get_phase())
+ *   #! rest <t0_us> <t1_us>            input held still
+ * ========================================================= */
+
+#define AS_MAX_RESTS   16
+#define AS_FRAME_MAX   64
+#define AS_MAX_PEAKS   5
+#define AS_BANDS       8
+#define AS_GUARD_US    30 /* CONFIG_EMIUET_ADC_QUIET_GUARD_US default */
+#define AS_JITTER_US   3  /* frame-done ISR latency: error of the estimated conversion times */
+
+typedef struct {
+    uint64_t *t_us;
+    uint16_t *raw;
+    size_t n;
+    uint32_t frame_pb;
+    uint64_t pwm_rise_us;
+    uint32_t pwm_period_ns;
+    uint32_t pwm_high_ns;
+    uint64_t (*drive)[2];
+    size_t n_drive;
+    uint64_t rest[AS_MAX_RESTS][2];
+    size_t n_rest;
+} as_trace_t;
+
+typedef struct {
+    double rms;
+    double bands[AS_BANDS];
+    double peak_hz[AS_MAX_PEAKS];
+    double peak_lsb[AS_MAX_PEAKS];
+    size_t n_peaks;
+    double *amp; /* one-sided sine amplitude per bin */
+    size_t bins;
+} as_spectrum_t;
+
+static bool grow(void **p, size_t *cap, size_t n, size_t elem)
+{
+    if (n < *cap) return true;
+    const size_t c = *cap ? *cap * 2u : 1024u;
+    void *q = realloc(*p, c * elem);
+    if (!q) return false;
+    *p = q;
+    *cap = c;
+    return true;
+}
+
+static int load_trace(const char *path, as_trace_t *tr)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return -1;
+    }
+    memset(tr, 0, sizeof(*tr));
+    size_t cap_t = 0, cap_r = 0, cap_d = 0;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long a = 0, b = 0;
+        unsigned long c = 0, d = 0;
+        int v = 0;
+        char arg[16] = {0};
+        if (sscanf(line, "#! frame %lu", &c) == 1) {
+            tr->frame_pb = (uint32_t)c;
+            continue;
+        }
+        if (sscanf(line, "#! pwm %llu %lu %lu", &a, &c, &d) == 3) {
+            tr->pwm_rise_us = a;
+            tr->pwm_period_ns = (uint32_t)c;
+            tr->pwm_high_ns = (uint32_t)d;
+            continue;
+        }
+        if (sscanf(line, "#! drive %llu %llu", &a, &b) == 2) {
+            if (!grow((void **)&tr->drive, &cap_d, tr->n_drive, sizeof(*tr->drive))) break;
+            tr->drive[tr->n_drive][0] = a;
+            tr->drive[tr->n_drive++][1] = b;
+            continue;
+        }
+        if (sscanf(line, "#! rest %llu %llu", &a, &b) == 2 && tr->n_rest < AS_MAX_RESTS) {
+            tr->rest[tr->n_rest][0] = a;
+            tr->rest[tr->n_rest++][1] = b;
+            continue;
+        }
+        if (sscanf(line, "%llu conv %15s %d", &a, arg, &v) != 3 || strcmp(arg, "pb") != 0) continue;
+        if (!grow((void **)&tr->t_us, &cap_t, tr->n, sizeof(*tr->t_us)) ||
+            !grow((void **)&tr->raw, &cap_r, tr->n, sizeof(*tr->raw))) {
+            break;
+        }
+        tr->t_us[tr->n] = a;
+        tr->raw[tr->n++] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+    }
+    fclose(f);
+    if (tr->n < 2 || tr->frame_pb == 0 || tr->frame_pb > AS_FRAME_MAX) {
+        fprintf(stderr, "%s: no conv pb samples or no valid \"#! frame\" line\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void free_trace(as_trace_t *tr)
+{
+    free(tr->t_us);
+    free(tr->raw);
+    free(tr->drive);
+}
+
+/* xorshift32: reproducible ISR latency */
+static uint32_t rng_next(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return x;
+}
+
+/* adc_cont_publish() for one channel: trimmed mean of the kept conversions */
+static double frame_mean(const uint16_t *v, const bool *keep, size_t n)
+{
+    uint32_t sum = 0, cnt = 0;
+    uint16_t lo = 0, hi = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!keep[i]) continue;
+        if (cnt == 0 || v[i] < lo) lo = v[i];
+        if (cnt == 0 || v[i] > hi) hi = v[i];
+        sum += v[i];
+        cnt++;
+    }
+    if (cnt >= 4) {
+        sum -= (uint32_t)lo + hi;
+        cnt -= 2;
+    }
+    return (double)sum / (double)cnt;
+}
+
+/* Frame means of every whole frame inside a rest window; returns the count */
+static size_t frame_means(const as_trace_t *tr, bool gated, uint32_t jitter_us, double *out, size_t *kept,
+                          size_t *total)
+{
+    adc_quiet_t q = {
+        .guard_us = AS_GUARD_US,
+        .pwm_period_ns = tr->pwm_period_ns,
+        .pwm_phase_ns = tr->pwm_period_ns ? (uint32_t)((tr->pwm_rise_us * 1000u) % tr->pwm_period_ns) : 0u,
+        .pwm_high_ns = tr->pwm_high_ns,
+    };
+    uint32_t rng = 0x2545F491u;
+    size_t m = 0, burst = 0;
+    bool keep[AS_FRAME_MAX];
+    const size_t fp = tr->frame_pb;
+
+    for (size_t i0 = 0; i0 + fp <= tr->n; i0 += fp) {
+        const uint64_t t0 = tr->t_us[i0], t1 = tr->t_us[i0 + fp - 1];
+        bool in_rest = false;
+        for (size_t w = 0; w < tr->n_rest; ++w) in_rest |= (t0 >= tr->rest[w][0] && t1 < tr->rest[w][1]);
+        if (!in_rest) continue;
+
+        /* The firmware times a frame from its done stamp, late by the ISR latency */
+        const int64_t late_ns = jitter_us ? (int64_t)(rng_next(&rng) % (jitter_us * 1000u + 1u)) : 0;
+        size_t nq = 0;
+        for (size_t i = 0; i < fp; ++i) {
+            const uint64_t t = tr->t_us[i0 + i];
+            /* the two latest bursts started by then, as the scanner would report them */
+            while (burst < tr->n_drive && tr->drive[burst][0] <= t + ADC_QUIET_SLACK_US) burst++;
+            q.drive_n = (uint8_t)(burst < 2 ? burst : 2);
+            for (size_t k = 0; k < q.drive_n; ++k) {
+                q.drive_from_us[k] = (uint32_t)tr->drive[burst - 1 - k][0];
+                q.drive_until_us[k] = (uint32_t)tr->drive[burst - 1 - k][1];
+            }
+            keep[i] = !gated || adc_quiet_at(&q, (int64_t)t * 1000 + late_ns);
+            nq += keep[i];
+        }
+        if (nq == 0) {
+            for (size_t i = 0; i < fp; ++i) keep[i] = true; /* as adc_cont_publish: never starve a channel */
+            nq = fp;
+        }
+        *kept += nq;
+        *total += fp;
+        out[m++] = frame_mean(&tr->raw[i0], keep, fp);
+    }
+    return m;
+}
+
+static void spectrum(const double *x, size_t n, double fs, as_spectrum_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    if (n < 8) return;
+    double mean = 0.0;
+    for (size_t i = 0; i < n; ++i) mean += x[i];
+    mean /= (double)n;
+    double var = 0.0;
+    for (size_t i = 0; i < n; ++i) var += (x[i] - mean) * (x[i] - mean);
+    s->rms = sqrt(var / (double)n);
+
+    /* Hann-windowed DFT; amplitude normalized to a sine, power to the variance */
+    double *w = malloc(n * sizeof(*w));
+    s->bins = n / 2u + 1u;
+    s->amp = calloc(s->bins, sizeof(*s->amp));
+    double *pow = calloc(s->bins, sizeof(*pow));
+    if (!w || !s->amp || !pow) {
+        free(w);
+        free(pow);
+        return;
+    }
+    double sw = 0.0, sw2 = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        w[i] = 0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)n);
+        sw += w[i];
+        sw2 += w[i] * w[i];
+    }
+    for (size_t k = 1; k < s->bins; ++k) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double ph = 2.0 * M_PI * (double)k * (double)i / (double)n;
+            const double v = (x[i] - mean) * w[i];
+            re += v * cos(ph);
+            im -= v * sin(ph);
+        }
+        const double mag2 = re * re + im * im;
+        s->amp[k] = 2.0 * sqrt(mag2) / sw;
+        pow[k] = ((2u * k == n) ? 1.0 : 2.0) * mag2 / ((double)n * sw2);
+    }
+
+    for (size_t k = 1; k < s->bins; ++k) {
+        size_t b = (k * AS_BANDS) / s->bins;
+        s->bands[b < AS_BANDS ? b : AS_BANDS - 1] += pow[k];
+    }
+    for (size_t b = 0; b < AS_BANDS; ++b) s->bands[b] = sqrt(s->bands[b]);
+
+    /* largest local maxima */
+    for (size_t k = 2; k + 1 < s->bins; ++k) {
+        const double a = s->amp[k];
+        if (a < s->amp[k - 1] || a < s->amp[k + 1]) continue;
+        size_t j;
+        if (s->n_peaks < AS_MAX_PEAKS) {
+            j = s->n_peaks++;
+        } else if (a > s->peak_lsb[AS_MAX_PEAKS - 1u]) {
+            j = AS_MAX_PEAKS - 1u;
+        } else {
+            continue;
+        }
+        for (; j > 0 && s->peak_lsb[j - 1] < a; --j) {
+            s->peak_lsb[j] = s->peak_lsb[j - 1];
+            s->peak_hz[j] = s->peak_hz[j - 1];
+        }
+        s->peak_lsb[j] = a;
+        s->peak_hz[j] = (double)k * fs / (double)n;
+    }
+    free(w);
+    free(pow);
+}
+
+static void print_mode(const char *trace, const char *mode, const as_spectrum_t *s, double fs, size_t frames,
+                       size_t kept, size_t total)
+{
+    printf("{\"trace\":\"%s\",\"mode\":\"%s\",\"frames\":%zu,\"frame_hz\":%.1f,\"kept\":%.3f,\"rms_lsb\":%.3f,"
+           "\"bands\":[",
+           trace,
+           mode,
+           frames,
+           fs,
+           total ? (double)kept / (double)total : 0.0,
+           s->rms);
+    for (size_t b = 0; b < AS_BANDS; ++b) printf("%s%.3f", b ? "," : "", s->bands[b]);
+    printf("],\"peaks\":[");
+    for (size_t p = 0; p < s->n_peaks; ++p) printf("%s[%.1f,%.3f]", p ? "," : "", s->peak_hz[p], s->peak_lsb[p]);
+    printf("]}\n");
+}
+
+static int run_trace(const char *path, uint32_t jitter_us, bool dump)
+{
+    as_trace_t tr;
+    if (load_trace(path, &tr) != 0) return -1;
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    const size_t frames_max = tr.n / tr.frame_pb + 1u;
+    double *x = malloc(frames_max * sizeof(*x));
+    if (!x) {
+        free_trace(&tr);
+        return -1;
+    }
+    /* frame rate from the pb conversion spacing */
+    const double fs = 1e6 * (double)(tr.n - 1u) / ((double)(tr.t_us[tr.n - 1] - tr.t_us[0]) * (double)tr.frame_pb);
+    as_spectrum_t s[2];
+    static const char *const k_modes[2] = {"ungated", "quiet"};
+    for (int g = 0; g < 2; ++g) {
+        size_t kept = 0, total = 0;
+        const size_t m = frame_means(&tr, g == 1, jitter_us, x, &kept, &total);
+        spectrum(x, m, fs, &s[g]);
+        print_mode(name, k_modes[g], &s[g], fs, m, kept, total);
+    }
+    if (dump && s[0].amp && s[1].amp) {
+        printf("# spectrum %s: hz ungated_lsb quiet_lsb\n", name);
+        const size_t bins = s[0].bins < s[1].bins ? s[0].bins : s[1].bins;
+        const double n = (double)(s[0].bins - 1u) * 2.0;
+        for (size_t k = 1; k < bins; ++k) printf("%.1f %.4f %.4f\n", (double)k * fs / n, s[0].amp[k], s[1].amp[k]);
+    }
+    free(s[0].amp);
+    free(s[1].amp);
+    free(x);
+    free_trace(&tr);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t jitter_us = AS_JITTER_US;
+    bool dump = false;
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-'; ++first) {
+        if (strcmp(argv[first], "-j") == 0 && first + 1 < argc) {
+            jitter_us = (uint32_t)strtoul(argv[++first], NULL, 0);
+        } else if (strcmp(argv[first], "-s") == 0) {
+            dump = true;
+        } else {
+            break;
+        }
+    }
+    if (first >= argc) {
+        fprintf(stderr,
+                "usage: %s [-j jitter_us] [-s] trace...\n"
+                "  -j  error of the estimated conversion times (frame-done ISR latency), default %d\n"
+                "  -s  print the full spectra\n",
+                argv[0],
+                AS_JITTER_US);
+        return 2;
+    }
+
+    int rc = 0;
+    for (int a = first; a < argc; ++a) {
+        if (run_trace(argv[a], jitter_us, dump) != 0) rc = 1;
+    }
+    return rc;
+}
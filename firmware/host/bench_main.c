@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "matrix_midi_bridge.h"
+#include "midi_bench.h"
+#include "midi_out.h"
+#include "nvs_flash.h"
+#include "slider.h"
+
+/* =========================================================
+ * Host chord-storm bench
+ *
+ * Boots the firmware core like host_main.c and runs midi_bench_run():
+ * one JSON line per scenario and route on stdout, logs on stderr.
+ * Exit status is non-zero when any route dropped events.
+ * ========================================================= */
+
+int main(int argc, char **argv)
+{
+    uint32_t repeat = CONFIG_EMIUET_MIDI_BENCH_REPEAT;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeat = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-n repeat]\n"
+                    "  -n  strums per scenario, default %d\n",
+                    argv[0],
+                    CONFIG_EMIUET_MIDI_BENCH_REPEAT);
+            return 2;
+        }
+    }
+
+    (void)nvs_flash_init();
+    board_pins_init_early();
+    board_pins_init_matrix_late();
+    matrix_midi_bridge_start(MATRIX_INITIAL_DISCARD_CYCLES);
+    slider_task_start();
+
+    /* Let the discard cycles pass before the first event */
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    const uint32_t drops = midi_bench_run(repeat);
+    return drops ? 1 : 0;
+}
@@ -0,0 +1,284 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slider_filter.h"
+
+/* =========================================================
+ * Host slider filter bench
+ *
+ * Replays ADC traces (emiuet_qsim format, "adc pb" lines) through
+ * candidate slider_filter.h chains, sampled like the slider task does
+ * (latest value every poll period, or "dec_" chains: the mean since the
+ * last poll), and prints one JSON line per chain and trace:
+ *   jitter   output peak-to-peak / RMS inside "#! rest" windows (12-bit LSB)
+ *   step     time from each "#! step" until 90% of the move (ms)
+ *   ramp     lag behind each "#! ramp" (linear move), second half (ms)
+ *   cost     ns per sample of slider_filter_step() on this machine
+ * Exit status is non-zero when a trace cannot be read.
+ * ========================================================= */
+
+#define FB_POLL_MS_DEFAULT 10
+#define FB_MAX_MARKS       32
+#define FB_COST_SAMPLES    20000000u
+
+typedef struct {
+    const char *name;
+    slider_filter_cfg_t cfg;
+    bool decimate; /* feed the mean of every trace sample since the last poll, like adc_manager_read_fine() */
+} fb_preset_t;
+
+/* period_us is filled in from the poll period */
+static const fb_preset_t k_presets[] = {
+    {"ema012", {.ema_alpha = SLIDER_FILTER_ALPHA(0.12f)}, false},
+    /* slider_task's former send deadband (12 of 8192 = 6 LSB), approximated as hysteresis */
+    {"ema012_deadband", {.ema_alpha = SLIDER_FILTER_ALPHA(0.12f), .hyst = 48}, false},
+    {"median3_ema012", {.median = 3, .ema_alpha = SLIDER_FILTER_ALPHA(0.12f)}, false},
+    {"median3_ema025", {.median = 3, .ema_alpha = SLIDER_FILTER_ALPHA(0.25f)}, false},
+    {"median5_ema025", {.median = 5, .ema_alpha = SLIDER_FILTER_ALPHA(0.25f)}, false},
+    {"trim5_ema025", {.trim = 5, .ema_alpha = SLIDER_FILTER_ALPHA(0.25f)}, false},
+    {"median3_ema025_hyst", {.median = 3, .ema_alpha = SLIDER_FILTER_ALPHA(0.25f), .hyst = 24}, false},
+    {"euro", {.euro_fmin_mhz = 500, .euro_beta_mhz = 10000}, false},
+    {"median3_euro", {.median = 3, .euro_fmin_mhz = 500, .euro_beta_mhz = 10000}, false},
+    {"median3_euro_hyst", {.median = 3, .euro_fmin_mhz = 500, .euro_beta_mhz = 10000, .hyst = 16}, false},
+    {"dec_median3_euro_hyst", {.median = 3, .euro_fmin_mhz = 500, .euro_beta_mhz = 10000, .hyst = 8}, true},
+    /* slider.c per-frame chain (run with -p 1); median5 stands in for the
+     * in-frame spike trimming, as this trace's spikes span whole samples
+     */
+    {"frame_euro_hyst", {.median = 5, .euro_fmin_mhz = 500, .euro_beta_mhz = 5000, .hyst = 8}, true},
+};
+
+typedef struct {
+    uint64_t *t_us;
+    uint16_t *raw;
+    size_t n;
+    uint64_t rest[FB_MAX_MARKS][2];
+    size_t n_rest;
+    uint64_t step_t[FB_MAX_MARKS];
+    uint16_t step_raw[FB_MAX_MARKS];
+    size_t n_step;
+    uint64_t ramp_t[FB_MAX_MARKS][2];
+    uint16_t ramp_raw[FB_MAX_MARKS][2];
+    size_t n_ramp;
+} fb_trace_t;
+
+static int load_trace(const char *path, fb_trace_t *tr)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return -1;
+    }
+    size_t cap = 1024;
+    memset(tr, 0, sizeof(*tr));
+    tr->t_us = malloc(cap * sizeof(*tr->t_us));
+    tr->raw = malloc(cap * sizeof(*tr->raw));
+
+    char line[256];
+    while (tr->t_us && tr->raw && fgets(line, sizeof(line), f)) {
+        unsigned long long a = 0, b = 0;
+        int v = 0, w = 0;
+        char arg[16] = {0};
+        if (sscanf(line, "#! rest %llu %llu", &a, &b) == 2 && tr->n_rest < FB_MAX_MARKS) {
+            tr->rest[tr->n_rest][0] = a;
+            tr->rest[tr->n_rest++][1] = b;
+            continue;
+        }
+        if (sscanf(line, "#! step %llu %d", &a, &v) == 2 && tr->n_step < FB_MAX_MARKS) {
+            tr->step_t[tr->n_step] = a;
+            tr->step_raw[tr->n_step++] = (uint16_t)v;
+            continue;
+        }
+        if (sscanf(line, "#! ramp %llu %llu %d %d", &a, &b, &v, &w) == 4 && b > a && tr->n_ramp < FB_MAX_MARKS) {
+            tr->ramp_t[tr->n_ramp][0] = a;
+            tr->ramp_t[tr->n_ramp][1] = b;
+            tr->ramp_raw[tr->n_ramp][0] = (uint16_t)v;
+            tr->ramp_raw[tr->n_ramp++][1] = (uint16_t)w;
+            continue;
+        }
+        if (sscanf(line, "%llu adc %15s %d", &a, arg, &v) != 3 || strcmp(arg, "pb") != 0) continue;
+        if (tr->n == cap) {
+            cap *= 2;
+            uint64_t *t = realloc(tr->t_us, cap * sizeof(*t));
+            uint16_t *r = realloc(tr->raw, cap * sizeof(*r));
+            if (t) tr->t_us = t;
+            if (r) tr->raw = r;
+            if (!t || !r) break;
+        }
+        tr->t_us[tr->n] = a;
+        tr->raw[tr->n++] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+    }
+    fclose(f);
+    if (tr->n == 0) {
+        fprintf(stderr, "%s: no adc pb samples\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void run_preset(const char *trace_name, const fb_trace_t *tr, const fb_preset_t *p, uint32_t poll_ms)
+{
+    const uint64_t poll_us = (uint64_t)poll_ms * 1000u;
+    const uint64_t end_us = tr->t_us[tr->n - 1];
+    const size_t polls = (size_t)(end_us / poll_us) + 1u;
+    uint16_t *out = malloc(polls * sizeof(*out));
+    if (!out) return;
+
+    slider_filter_cfg_t cfg = p->cfg;
+    cfg.period_us = (uint16_t)poll_us;
+    slider_filter_t f;
+    slider_filter_init(&f, &cfg);
+    size_t k = 0;
+    for (size_t i = 0; i < polls; ++i) {
+        const uint64_t t = (uint64_t)i * poll_us;
+        uint32_t sum = 0, n = 0; /* samples since the last poll */
+        while (k + 1 < tr->n && tr->t_us[k + 1] <= t) {
+            sum += tr->raw[++k];
+            n++;
+        }
+        if (n == 0) {
+            sum = tr->raw[k];
+            n = 1;
+        }
+        if (p->decimate) {
+            out[i] = slider_filter_step_q15(&f, slider_filter_fine_to_q15((uint16_t)(((sum << 4) + n / 2u) / n)));
+        } else {
+            out[i] = slider_filter_step(&f, tr->raw[k]);
+        }
+    }
+
+    /* jitter inside rest windows, in 12-bit LSB */
+    double pp_max = 0.0, rms_sum = 0.0;
+    for (size_t w = 0; w < tr->n_rest; ++w) {
+        const size_t i0 = (size_t)((tr->rest[w][0] + poll_us - 1u) / poll_us);
+        const size_t i1 = (size_t)((tr->rest[w][1] - 1u) / poll_us); /* end is exclusive */
+        if (i1 >= polls || i1 <= i0) continue;
+        double mean = 0.0;
+        uint16_t lo = UINT16_MAX, hi = 0;
+        for (size_t i = i0; i <= i1; ++i) {
+            mean += out[i];
+            if (out[i] < lo) lo = out[i];
+            if (out[i] > hi) hi = out[i];
+        }
+        mean /= (double)(i1 - i0 + 1u);
+        double var = 0.0;
+        for (size_t i = i0; i <= i1; ++i) var += (out[i] - mean) * (out[i] - mean);
+        var /= (double)(i1 - i0 + 1u);
+        const double pp = (hi - lo) / 8.0;
+        if (pp > pp_max) pp_max = pp;
+        rms_sum += __builtin_sqrt(var) / 8.0;
+    }
+
+    /* step response: polls until 90% of the way from the pre-step output */
+    double lat_max = 0.0, lat_sum = 0.0;
+    size_t n_lat = 0;
+    for (size_t s = 0; s < tr->n_step; ++s) {
+        const size_t i0 = (size_t)(tr->step_t[s] / poll_us);
+        if (i0 == 0 || i0 >= polls) continue;
+        const int from = out[i0 - 1];
+        const int goal = from + ((int)slider_filter_raw_to_q15(tr->step_raw[s]) - from) * 9 / 10;
+        for (size_t i = i0; i < polls; ++i) {
+            if ((goal >= from && out[i] >= goal) || (goal < from && out[i] <= goal)) {
+                const double ms = ((double)i * (double)poll_us - (double)tr->step_t[s]) / 1000.0;
+                if (ms > lat_max) lat_max = ms;
+                lat_sum += ms;
+                n_lat++;
+                break;
+            }
+        }
+    }
+    /* ramp lag: distance behind the ideal line over the ramp's second half,
+     * converted to time with the ramp slope
+     */
+    double ramp_max = 0.0, ramp_sum = 0.0;
+    for (size_t r = 0; r < tr->n_ramp; ++r) {
+        const double t0 = (double)tr->ramp_t[r][0], t1 = (double)tr->ramp_t[r][1];
+        const double v0 = tr->ramp_raw[r][0], v1 = tr->ramp_raw[r][1];
+        const double slope = (v1 - v0) / (t1 - t0); /* LSB per us */
+        double lag = 0.0;
+        size_t n = 0;
+        for (size_t i = (size_t)((t0 + t1) / 2.0 / (double)poll_us) + 1u; i < polls && (double)i * poll_us < t1; ++i) {
+            const double ideal = v0 + slope * ((double)i * poll_us - t0);
+            lag += (ideal - out[i] / 8.0) / slope / 1000.0;
+            n++;
+        }
+        if (n == 0) continue;
+        lag /= (double)n;
+        if (lag > ramp_max) ramp_max = lag;
+        ramp_sum += lag;
+    }
+    free(out);
+
+    /* cost: the raw trace, looped */
+    slider_filter_init(&f, &cfg);
+    volatile uint16_t sink = 0;
+    const int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < FB_COST_SAMPLES; ++i) sink = slider_filter_step(&f, tr->raw[i % tr->n]);
+    const double ns = (double)(now_ns() - t0) / FB_COST_SAMPLES;
+    (void)sink;
+
+    printf("{\"trace\":\"%s\",\"filter\":\"%s\",\"poll_ms\":%u,"
+           "\"jitter\":{\"pp_max_lsb\":%.2f,\"rms_lsb\":%.2f},"
+           "\"step\":{\"n\":%u,\"t90_mean_ms\":%.1f,\"t90_max_ms\":%.1f},"
+           "\"ramp\":{\"n\":%u,\"lag_mean_ms\":%.1f,\"lag_max_ms\":%.1f},\"ns_per_sample\":%.1f}\n",
+           trace_name,
+           p->name,
+           (unsigned)poll_ms,
+           pp_max,
+           tr->n_rest ? rms_sum / (double)tr->n_rest : 0.0,
+           (unsigned)n_lat,
+           n_lat ? lat_sum / (double)n_lat : 0.0,
+           lat_max,
+           (unsigned)tr->n_ramp,
+           tr->n_ramp ? ramp_sum / (double)tr->n_ramp : 0.0,
+           ramp_max,
+           ns);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t poll_ms = FB_POLL_MS_DEFAULT;
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-'; ++first) {
+        if (strcmp(argv[first], "-p") == 0 && first + 1 < argc) {
+            poll_ms = (uint32_t)strtoul(argv[++first], NULL, 0);
+        } else {
+            break;
+        }
+    }
+    if (first >= argc || poll_ms == 0) {
+        fprintf(stderr,
+                "usage: %s [-p poll_ms] trace...\n"
+                "  -p  slider poll period, default %d\n",
+                argv[0],
+                FB_POLL_MS_DEFAULT);
+        return 2;
+    }
+
+    int rc = 0;
+    for (int a = first; a < argc; ++a) {
+        fb_trace_t tr;
+        if (load_trace(argv[a], &tr) != 0) {
+            rc = 1;
+            continue;
+        }
+        const char *name = strrchr(argv[a], '/');
+        name = name ? name + 1 : argv[a];
+        for (size_t p = 0; p < sizeof(k_presets) / sizeof(k_presets[0]); ++p) {
+            run_preset(name, &tr, &k_presets[p], poll_ms);
+        }
+        free(tr.t_us);
+        free(tr.raw);
+    }
+    return rc;
+}
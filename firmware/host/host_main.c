@@ -0,0 +1,176 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "esp_timer.h"
+#include "host_hal.h"
+#include "matrix_midi_bridge.h"
+#include "midi_out.h"
+#include "nvs_flash.h"
+#include "slider.h"
+
+/* =========================================================
+ * Host pipeline runner
+ *
+ * Boots the firmware core like app_main() (minus UI), then presses and
+ * releases keys through the GPIO matrix model and times each edge until
+ * the matching Note On / Note Off leaves every enabled (modelled) link:
+ *   key GPIO -> matrix scan/debounce -> bridge -> midi_out -> sender task -> sink
+ *
+ * Results go to stdout as one JSON line per sink; logs go to stderr.
+ * Exit status is non-zero when any event did not arrive.
+ * ========================================================= */
+
+#define HOST_EDGE_TIMEOUT_US 200000
+
+typedef struct {
+    int64_t *lat_us;
+    uint32_t n;
+    uint32_t missing;
+} sink_result_t;
+
+/* Edge currently being timed (written by the runner, read by sink callbacks) */
+static _Atomic bool s_edge_on = false;
+static _Atomic int64_t s_edge_hit[HOST_SINK_COUNT];
+
+static void sink_probe(host_sink_id_t sink, const uint8_t *b, size_t len, uint64_t wire_us, void *ctx)
+{
+    (void)ctx;
+    if (len < 3) return;
+    const uint8_t st = (uint8_t)(b[0] & 0xF0u);
+    const bool on = (st == 0x90u) && (b[2] != 0);
+    const bool off = (st == 0x80u) || ((st == 0x90u) && (b[2] == 0));
+    if (!on && !off) return;
+    if (on != atomic_load(&s_edge_on)) return;
+
+    int64_t expected = 0;
+    (void)atomic_compare_exchange_strong(&s_edge_hit[sink], &expected, (int64_t)wire_us);
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    const int64_t x = *(const int64_t *)a;
+    const int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_result(const char *name, sink_result_t *r)
+{
+    if (r->n == 0) {
+        printf("{\"sink\":\"%s\",\"events\":0,\"missing\":%lu}\n", name, (unsigned long)r->missing);
+        return;
+    }
+    qsort(r->lat_us, r->n, sizeof(r->lat_us[0]), cmp_i64);
+    printf("{\"sink\":\"%s\",\"events\":%lu,\"missing\":%lu,\"p50_us\":%lld,\"p99_us\":%lld,\"max_us\":%lld}\n",
+           name,
+           (unsigned long)r->n,
+           (unsigned long)r->missing,
+           (long long)r->lat_us[r->n / 2],
+           (long long)r->lat_us[(r->n * 99u) / 100u],
+           (long long)r->lat_us[r->n - 1]);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n presses] [-r usb,trs]\n"
+            "  -n  key presses to time (each gives a Note On and a Note Off edge), default 200\n"
+            "  -r  output routes, default usb,trs\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t presses = 200;
+    uint32_t routes = MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            presses = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            const char *s = argv[++i];
+            routes = 0;
+            if (strstr(s, "usb")) routes |= MIDI_OUT_ROUTE_USB;
+            if (strstr(s, "trs")) routes |= MIDI_OUT_ROUTE_TRS_UART;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    /* Same bring-up order as app_main()/board_late_init_task(), without UI */
+    (void)nvs_flash_init();
+    board_pins_init_early();
+    board_pins_init_matrix_late();
+    matrix_midi_bridge_start(MATRIX_INITIAL_DISCARD_CYCLES);
+    midi_out_set_routes(routes);
+    slider_task_start();
+
+    /* Let the discard cycles pass before touching keys */
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    const bool want[HOST_SINK_COUNT] = {
+        [HOST_SINK_UART] = (routes & MIDI_OUT_ROUTE_TRS_UART) != 0,
+        [HOST_SINK_USB] = (routes & MIDI_OUT_ROUTE_USB) != 0,
+    };
+    sink_result_t res[HOST_SINK_COUNT] = {0};
+    for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+        res[s].lat_us = calloc((size_t)presses * 2u + 1u, sizeof(int64_t));
+        if (!res[s].lat_us) return 1;
+    }
+
+    host_sink_set_cb(sink_probe, NULL);
+
+    for (uint32_t i = 0; i < presses * 2u; ++i) {
+        const uint32_t k = i / 2u;
+        const int row = (int)(k % MATRIX_NUM_ROWS);
+        const int col = (int)((k / MATRIX_NUM_ROWS) % MATRIX_NUM_COLS);
+        const bool on = (i % 2u) == 0;
+
+        for (int s = 0; s < HOST_SINK_COUNT; ++s) atomic_store(&s_edge_hit[s], 0);
+        atomic_store(&s_edge_on, on);
+        const int64_t t0 = esp_timer_get_time();
+        host_hal_matrix_set_key(row, col, on);
+
+        /* Wait until every enabled sink has seen the edge (or time out) */
+        for (;;) {
+            bool done = true;
+            for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+                if (want[s] && atomic_load(&s_edge_hit[s]) == 0) done = false;
+            }
+            if (done || esp_timer_get_time() - t0 > HOST_EDGE_TIMEOUT_US) break;
+            vTaskDelay(1);
+        }
+
+        for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+            if (!want[s]) continue;
+            const int64_t hit = atomic_load(&s_edge_hit[s]);
+            if (hit == 0) {
+                res[s].missing++;
+            } else {
+                res[s].lat_us[res[s].n++] = hit - t0;
+            }
+        }
+    }
+
+    host_sink_set_cb(NULL, NULL);
+
+    static const char *names[HOST_SINK_COUNT] = {
+        [HOST_SINK_UART] = "trs",
+        [HOST_SINK_USB] = "usb",
+    };
+    uint32_t missing = 0;
+    for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+        if (!want[s]) continue;
+        print_result(names[s], &res[s]);
+        missing += res[s].missing;
+    }
+    for (int s = 0; s < HOST_SINK_COUNT; ++s) free(res[s].lat_us);
+    fflush(stdout);
+    return missing ? 1 : 0;
+}
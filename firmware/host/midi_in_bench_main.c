@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "midi_in.h"
+
+/* =========================================================
+ * Host MIDI input parser bench
+ *
+ * Throughput of the streaming parser (main/midi_in.c) on four streams,
+ * fed in 64-byte chunks (one full-speed USB packet) to counting handlers:
+ *   notes        Note On/Off, every message with its status byte
+ *   running      the same notes under running status
+ *   clock_mixed  running-status notes with a clock byte inside each
+ *   sysex        64-byte SysEx messages
+ * One JSON line per stream on stdout: ns per byte and per message.
+ *
+ * -c runs the correctness checks only (running status, realtime bytes
+ * mid-message and inside SysEx, SysEx truncation, status cancelling);
+ * they also run before the bench. Exits 1 on any failed check.
+ * ========================================================= */
+
+#define MIDIIN_BENCH_DEFAULT_ITERS 2000
+#define MIDIIN_BENCH_STREAM_LEN    16384
+#define MIDIIN_BENCH_CHUNK         64
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* =========================================================
+ * Recording handlers
+ * ========================================================= */
+
+#define REC_MAX 64
+
+typedef enum { REC_MSG, REC_RT, REC_SYSEX } rec_kind_t;
+
+typedef struct {
+    rec_kind_t kind;
+    uint8_t status;
+    uint8_t data[2];
+    uint8_t len;
+    size_t sysex_len;
+    bool truncated;
+} rec_t;
+
+typedef struct {
+    rec_t ev[REC_MAX];
+    size_t n;
+} recorder_t;
+
+static void rec_push(recorder_t *r, rec_t e)
+{
+    if (r->n < REC_MAX) r->ev[r->n++] = e;
+}
+
+static void rec_msg(const midi_in_msg_t *m, void *ctx)
+{
+    rec_push(ctx, (rec_t){.kind = REC_MSG, .status = m->status, .data = {m->data[0], m->data[1]}, .len = m->len});
+}
+
+static void rec_rt(const midi_in_msg_t *m, void *ctx)
+{
+    rec_push(ctx, (rec_t){.kind = REC_RT, .status = m->status, .len = 1});
+}
+
+static void rec_sysex(const uint8_t *data, size_t len, bool truncated, void *ctx)
+{
+    rec_push(ctx, (rec_t){.kind = REC_SYSEX, .sysex_len = len, .truncated = truncated});
+}
+
+/* =========================================================
+ * Checks
+ * ========================================================= */
+
+static int s_checks;
+static int s_failed;
+
+static void expect(const char *check, bool ok)
+{
+    s_checks++;
+    if (ok) return;
+    s_failed++;
+    printf("FAIL %s\n", check);
+}
+
+static bool is_msg(const rec_t *e, uint8_t status, uint8_t d0, uint8_t d1, uint8_t len)
+{
+    return e->kind == REC_MSG && e->status == status && e->len == len && (len < 2 || e->data[0] == d0) &&
+           (len < 3 || e->data[1] == d1);
+}
+
+static bool is_rt(const rec_t *e, uint8_t status)
+{
+    return e->kind == REC_RT && e->status == status;
+}
+
+static bool is_sysex(const rec_t *e, size_t len, bool truncated)
+{
+    return e->kind == REC_SYSEX && e->sysex_len == len && e->truncated == truncated;
+}
+
+static bool same_rec(const recorder_t *a, const recorder_t *b)
+{
+    if (a->n != b->n) return false;
+    for (size_t i = 0; i < a->n; ++i) {
+        const rec_t *x = &a->ev[i];
+        const rec_t *y = &b->ev[i];
+        if (x->kind != y->kind || x->status != y->status || x->len != y->len || x->data[0] != y->data[0] ||
+            x->data[1] != y->data[1] || x->sysex_len != y->sysex_len || x->truncated != y->truncated) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    recorder_t rec;
+    midi_in_handlers_t h;
+    midi_in_parser_t p;
+} checker_t;
+
+static void checker_feed(checker_t *c, const uint8_t *bytes, size_t len)
+{
+    memset(&c->rec, 0, sizeof(c->rec));
+    c->h = (midi_in_handlers_t){.on_msg = rec_msg, .on_realtime = rec_rt, .on_sysex = rec_sysex, .ctx = &c->rec};
+    midi_in_parser_init(&c->p, &c->h);
+    midi_in_parser_feed(&c->p, bytes, len);
+}
+
+static void check_parser(void)
+{
+    static checker_t c;
+    const rec_t *e = c.rec.ev;
+
+    {
+        const uint8_t s[] = {0x90, 0x3C, 0x64, 0x3E, 0x64, 0x40, 0x00};
+        checker_feed(&c, s, sizeof(s));
+        expect("running status: three messages", c.rec.n == 3);
+        expect("running status: first", is_msg(&e[0], 0x90, 0x3C, 0x64, 3));
+        expect("running status: second", is_msg(&e[1], 0x90, 0x3E, 0x64, 3));
+        expect("running status: velocity 0 delivered as is", is_msg(&e[2], 0x90, 0x40, 0x00, 3));
+    }
+    {
+        const uint8_t s[] = {0xC2, 0x05, 0x07, 0xD1, 0x40};
+        checker_feed(&c, s, sizeof(s));
+        expect("running status: 1-byte messages",
+               c.rec.n == 3 && is_msg(&e[0], 0xC2, 0x05, 0, 2) && is_msg(&e[1], 0xC2, 0x07, 0, 2) &&
+                   is_msg(&e[2], 0xD1, 0x40, 0, 2));
+    }
+    {
+        const uint8_t s[] = {0x90, 0xF8, 0x3C, 0xFE, 0x64, 0x3E, 0xFA, 0x64};
+        checker_feed(&c, s, sizeof(s));
+        expect("realtime mid-message: order",
+               c.rec.n == 5 && is_rt(&e[0], 0xF8) && is_rt(&e[1], 0xFE) && is_msg(&e[2], 0x90, 0x3C, 0x64, 3) &&
+                   is_rt(&e[3], 0xFA) && is_msg(&e[4], 0x90, 0x3E, 0x64, 3));
+    }
+    {
+        const uint8_t s[] = {0xF0, 0x7E, 0xF8, 0x01, 0xF7};
+        checker_feed(&c, s, sizeof(s));
+        expect("realtime inside SysEx",
+               c.rec.n == 2 && is_rt(&e[0], 0xF8) && is_sysex(&e[1], 2, false) && c.p.sysex_buf[0] == 0x7E &&
+                   c.p.sysex_buf[1] == 0x01);
+    }
+    {
+        static uint8_t s[CONFIG_EMIUET_MIDI_IN_SYSEX_MAX + 12];
+        size_t n = 0;
+        s[n++] = 0xF0;
+        while (n < sizeof(s) - 1) {
+            s[n] = (uint8_t)(n & 0x7Fu);
+            n++;
+        }
+        s[n++] = 0xF7;
+        checker_feed(&c, s, n);
+        expect("SysEx overflow: truncated at the buffer size",
+               c.rec.n == 1 && is_sysex(&e[0], CONFIG_EMIUET_MIDI_IN_SYSEX_MAX, true) && c.p.sysex_truncated == 1);
+
+        /* The next message parses normally */
+        const uint8_t t[] = {0x80, 0x3C, 0x00};
+        midi_in_parser_feed(&c.p, t, sizeof(t));
+        expect("SysEx overflow: next message intact", c.rec.n == 2 && is_msg(&e[1], 0x80, 0x3C, 0x00, 3));
+    }
+    {
+        const uint8_t s[] = {0xF0, 0x01, 0x02, 0x90, 0x3C, 0x64};
+        checker_feed(&c, s, sizeof(s));
+        expect("SysEx ended by a status byte: truncated, then the message",
+               c.rec.n == 2 && is_sysex(&e[0], 2, true) && is_msg(&e[1], 0x90, 0x3C, 0x64, 3));
+    }
+    {
+        const uint8_t s[] = {0x90, 0x3C, 0x64, 0xF0, 0xF7, 0x3E, 0x64};
+        checker_feed(&c, s, sizeof(s));
+        expect("SysEx cancels running status",
+               c.rec.n == 2 && is_sysex(&e[1], 0, false) && c.p.stray_data == 2);
+    }
+    {
+        const uint8_t s[] = {0x90, 0x3C, 0x64, 0xF3, 0x05, 0x3E, 0x64, 0xF6, 0xF7};
+        checker_feed(&c, s, sizeof(s));
+        expect("system common cancels running status",
+               c.rec.n == 3 && is_msg(&e[1], 0xF3, 0x05, 0, 2) && is_msg(&e[2], 0xF6, 0, 0, 1) &&
+                   c.p.stray_data == 2);
+    }
+    {
+        /* Byte-at-a-time feeding gives the same result as one call */
+        const uint8_t s[] = {0x90, 0x3C, 0x64, 0xF8, 0x3E, 0x64, 0xF0, 0x01, 0xF8, 0xF7, 0xB0, 0x07, 0x7F};
+        checker_feed(&c, s, sizeof(s));
+        recorder_t whole = c.rec;
+        checker_feed(&c, s, 0);
+        for (size_t i = 0; i < sizeof(s); ++i) midi_in_parser_feed(&c.p, &s[i], 1);
+        expect("byte-at-a-time feed matches", whole.n == 6 && same_rec(&c.rec, &whole));
+    }
+}
+
+/* =========================================================
+ * Bench
+ * ========================================================= */
+
+typedef struct {
+    uint32_t msgs;
+    uint32_t rt;
+    uint32_t sysex;
+} counts_t;
+
+static void count_msg(const midi_in_msg_t *m, void *ctx)
+{
+    ((counts_t *)ctx)->msgs++;
+}
+
+static void count_rt(const midi_in_msg_t *m, void *ctx)
+{
+    ((counts_t *)ctx)->rt++;
+}
+
+static void count_sysex(const uint8_t *data, size_t len, bool truncated, void *ctx)
+{
+    ((counts_t *)ctx)->sysex++;
+}
+
+typedef enum { STREAM_NOTES, STREAM_RUNNING, STREAM_CLOCK_MIXED, STREAM_SYSEX, STREAM_COUNT } stream_t;
+
+static const char *const k_stream_name[STREAM_COUNT] = {"notes", "running", "clock_mixed", "sysex"};
+
+/* Whole messages only, so every pass starts on a message boundary */
+static size_t build_stream(stream_t kind, uint8_t *buf, size_t cap)
+{
+    size_t n = 0;
+    uint32_t i = 0;
+    for (;; ++i) {
+        const uint8_t note = (uint8_t)(36 + i % 48);
+        const uint8_t vel = (i & 1u) ? 0 : (uint8_t)(1 + i % 127);
+        uint8_t m[72];
+        size_t len = 0;
+        switch (kind) {
+            case STREAM_NOTES:
+                m[len++] = (i & 1u) ? 0x80 : 0x90;
+                m[len++] = note;
+                m[len++] = vel;
+                break;
+            case STREAM_RUNNING:
+                if (i == 0) m[len++] = 0x90;
+                m[len++] = note;
+                m[len++] = vel;
+                break;
+            case STREAM_CLOCK_MIXED:
+                if (i == 0) m[len++] = 0x90;
+                m[len++] = note;
+                m[len++] = 0xF8;
+                m[len++] = vel;
+                break;
+            case STREAM_SYSEX:
+                m[len++] = 0xF0;
+                for (int k = 0; k < 64; ++k) m[len++] = (uint8_t)((i + k) & 0x7Fu);
+                m[len++] = 0xF7;
+                break;
+            default:
+                return n;
+        }
+        if (n + len > cap) return n;
+        memcpy(&buf[n], m, len);
+        n += len;
+    }
+}
+
+static void bench_stream(stream_t kind, uint32_t iters)
+{
+    static uint8_t buf[MIDIIN_BENCH_STREAM_LEN];
+    static midi_in_parser_t p;
+    const size_t len = build_stream(kind, buf, sizeof(buf));
+
+    counts_t cnt = {0};
+    const midi_in_handlers_t h = {.on_msg = count_msg, .on_realtime = count_rt, .on_sysex = count_sysex, .ctx = &cnt};
+    midi_in_parser_init(&p, &h);
+
+    const int64_t t0 = now_ns();
+    for (uint32_t it = 0; it < iters; ++it) {
+        for (size_t off = 0; off < len; off += MIDIIN_BENCH_CHUNK) {
+            const size_t n = (len - off < MIDIIN_BENCH_CHUNK) ? len - off : MIDIIN_BENCH_CHUNK;
+            midi_in_parser_feed(&p, &buf[off], n);
+        }
+    }
+    const int64_t ns = now_ns() - t0;
+
+    const double bytes = (double)len * iters;
+    const uint64_t msgs = (uint64_t)cnt.msgs + cnt.sysex;
+    printf("{\"bench\":\"midi_in\",\"stream\":\"%s\",\"iters\":%u,\"bytes\":%.0f,\"msgs\":%llu,\"realtime\":%u,"
+           "\"stray\":%u,\"ns_per_byte\":%.2f,\"ns_per_msg\":%.1f,\"mb_per_s\":%.1f}\n",
+           k_stream_name[kind],
+           (unsigned)iters,
+           bytes,
+           (unsigned long long)msgs,
+           (unsigned)cnt.rt,
+           (unsigned)p.stray_data,
+           (double)ns / bytes,
+           msgs ? (double)ns / (double)msgs : 0.0,
+           bytes * 1000.0 / (double)ns);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iters = MIDIIN_BENCH_DEFAULT_ITERS;
+    bool checks_only = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iters = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            checks_only = true;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-n passes] [-c]\n"
+                    "  -n  passes over each %d-byte stream, default %d\n"
+                    "  -c  correctness checks only\n",
+                    argv[0],
+                    MIDIIN_BENCH_STREAM_LEN,
+                    MIDIIN_BENCH_DEFAULT_ITERS);
+            return 2;
+        }
+    }
+    if (iters == 0) iters = 1;
+
+    check_parser();
+    printf("{\"check\":\"midi_in\",\"checks\":%d,\"failed\":%d}\n", s_checks, s_failed);
+    if (s_failed || checks_only) return s_failed ? 1 : 0;
+
+    for (int s = 0; s < STREAM_COUNT; ++s) bench_stream((stream_t)s, iters);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "input_pipeline.h"
+#include "midi_mpe.h"
+#include "midi_out.h"
+#include "note_map.h"
+
+/* =========================================================
+ * Host input-pipeline bench
+ *
+ * Times the key -> MIDI stages (input_pipeline.h) with every stage doing
+ * work: mono on, a velocity source installed and a per-route channel
+ * filter. Each strum is one batch of two keys per string (press), then
+ * one batch releasing them.
+ *   process: stages only (no send)
+ *   run:     stages + hand-off to the midi_out queues
+ * One JSON line per mode on stdout, logs on stderr.
+ * ========================================================= */
+
+#define PIPE_BENCH_DEFAULT_STRUMS 100000
+#define PIPE_BENCH_RUN_STRUMS     500
+
+static uint8_t bench_velocity(const ip_event_t *ev)
+{
+    return (uint8_t)(64 + ev->col * 4);
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Two keys per string, shifted by strum index so the note map is not
+ * hit at a single spot
+ */
+static size_t fill_strum(ip_event_t *ev, uint32_t i, bool pressed)
+{
+    size_t n = 0;
+    for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+        const uint8_t c = (uint8_t)((i + (uint32_t)r) % (MATRIX_NUM_COLS - 3));
+        ev[n++] = (ip_event_t){.row = (uint8_t)r, .col = c, .pressed = pressed};
+        ev[n++] = (ip_event_t){.row = (uint8_t)r, .col = (uint8_t)(c + 3), .pressed = pressed};
+    }
+    return n;
+}
+
+static void report(const char *mode, bool mono, uint32_t strums, uint64_t edges, uint64_t out, int64_t ns)
+{
+    printf("{\"bench\":\"input_pipeline\",\"mode\":\"%s\",\"mono\":%s,\"strums\":%u,"
+           "\"edges\":%llu,\"events_out\":%llu,\"ns_per_edge\":%.1f}\n",
+           mode,
+           mono ? "true" : "false",
+           (unsigned)strums,
+           (unsigned long long)edges,
+           (unsigned long long)out,
+           edges ? (double)ns / (double)edges : 0.0);
+}
+
+static void bench_process(bool mono, uint32_t strums)
+{
+    ip_event_t ev[IP_MAX_EVENTS];
+    uint64_t edges = 0;
+    uint64_t out = 0;
+
+    input_pipeline_set_mono(mono);
+    const int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < strums; ++i) {
+        for (int p = 1; p >= 0; --p) {
+            const size_t n = fill_strum(ev, i, p != 0);
+            edges += n;
+            out += input_pipeline_process(ev, n);
+        }
+    }
+    report("process", mono, strums, edges, out, now_ns() - t0);
+}
+
+/* Paced so the sender tasks keep up: the figure is the caller's cost */
+static void bench_run(bool mono, uint32_t strums)
+{
+    ip_event_t ev[IP_MAX_EVENTS];
+    uint64_t edges = 0;
+    uint64_t out = 0;
+    int64_t ns = 0;
+
+    input_pipeline_set_mono(mono);
+    for (uint32_t i = 0; i < strums; ++i) {
+        for (int p = 1; p >= 0; --p) {
+            const size_t n = fill_strum(ev, i, p != 0);
+            edges += n;
+            const int64_t t0 = now_ns();
+            out += input_pipeline_run(ev, n);
+            ns += now_ns() - t0;
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+    report("run", mono, strums, edges, out, ns);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t strums = PIPE_BENCH_DEFAULT_STRUMS;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            strums = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-n strums]\n"
+                    "  -n  strums for the process-only pass, default %d\n",
+                    argv[0],
+                    PIPE_BENCH_DEFAULT_STRUMS);
+            return 2;
+        }
+    }
+
+    midi_out_init();
+    midi_mpe_init();
+    note_map_init();
+    input_pipeline_init();
+    input_pipeline_set_velocity_source(bench_velocity);
+    input_pipeline_set_route_channels(MIDI_OUT_ROUTE_TRS_UART, 0x00FFu);
+
+    bench_process(false, strums);
+    bench_process(true, strums);
+    bench_run(false, PIPE_BENCH_RUN_STRUMS);
+    bench_run(true, PIPE_BENCH_RUN_STRUMS);
+
+    /* Leave nothing sounding on the sinks */
+    midi_out_panic();
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "board_pins.h"
+#include "host_hal.h"
+#include "host_port.h"
+#include "input_pipeline.h"
+#include "midi_mpe.h"
+#include "midi_out.h"
+#include "note_map.h"
+
+/* =========================================================
+ * Host input-pipeline regression checks
+ *
+ * Held-key counts across a release of all notes: after midi_out_panic()
+ * (directly, or from an MPE, mono or route-channel toggle; a base-channel
+ * change goes through the same call) the next press of a released pitch must sound, and a
+ * key held across the release must not cut it when let go. Taking a
+ * route out releases only that route and keeps the counts.
+ *
+ * A release can also land in the middle of a press (another task, or a
+ * preemption between counting and enqueue). The velocity source stands
+ * in for that point: it runs one of the releases above once, and the wire
+ * must not be left with a sounding note.
+ *
+ * Row 0 col 0 and row 1 col 5 are the same pitch (E4) on channel 0 in
+ * non-MPE mode. Counts are checked with input_pipeline_process(); wire
+ * state is what the UART and USB sinks received. One line per check on
+ * stdout; exits 1 on any failure.
+ * ========================================================= */
+
+/* Time for the senders to drain a few messages onto the modelled links */
+#define PIPE_CHECK_DRAIN_US 100000u
+
+static int s_failed;
+
+static ip_event_t key(uint8_t row, uint8_t col, bool pressed)
+{
+    return (ip_event_t){.row = row, .col = col, .pressed = pressed};
+}
+
+/* One edge through the stages: events out, and the first of them */
+static size_t edge(uint8_t row, uint8_t col, bool pressed, ip_event_t *out)
+{
+    ip_event_t ev[IP_MAX_EVENTS];
+    ev[0] = key(row, col, pressed);
+    const size_t n = input_pipeline_process(ev, 1);
+    if (n > 0 && out) *out = ev[0];
+    return n;
+}
+
+/* Notes sounding per sink and channel, as seen on the wire */
+static _Atomic uint32_t s_wire_on[HOST_SINK_COUNT][16][4];
+
+static void wire_probe(host_sink_id_t sink, const uint8_t *b, size_t len, uint64_t wire_us, void *ctx)
+{
+    (void)wire_us;
+    (void)ctx;
+    if (len != 3) return;
+    const uint8_t st = (uint8_t)(b[0] & 0xF0u);
+    if (st != 0x90u && st != 0x80u) return;
+    _Atomic uint32_t *w = &s_wire_on[sink][b[0] & 0x0Fu][(b[1] >> 5) & 0x03u];
+    const uint32_t bit = 1u << (b[1] & 0x1Fu);
+    if (st == 0x90u && b[2] != 0) {
+        (void)atomic_fetch_or(w, bit);
+    } else {
+        (void)atomic_fetch_and(w, ~bit);
+    }
+}
+
+/* Notes still sounding on a sink after the senders drained */
+static int wire_sounding(host_sink_id_t sink)
+{
+    host_port_sleep_us(PIPE_CHECK_DRAIN_US);
+    int n = 0;
+    for (int ch = 0; ch < 16; ++ch) {
+        for (int i = 0; i < 4; ++i) n += __builtin_popcount(atomic_load(&s_wire_on[sink][ch][i]));
+    }
+    return n;
+}
+
+/* One edge through the stages and out to midi_out: events sent */
+static size_t edge_run(uint8_t row, uint8_t col, bool pressed)
+{
+    ip_event_t ev[IP_MAX_EVENTS];
+    ev[0] = key(row, col, pressed);
+    return input_pipeline_run(ev, 1);
+}
+
+static void expect(const char *check, const char *step, bool ok)
+{
+    if (!ok) s_failed = 1;
+    printf("%s %s: %s\n", ok ? "ok  " : "FAIL", check, step);
+}
+
+typedef void (*release_fn_t)(void);
+
+static void release_mpe_toggle(void)
+{
+    midi_mpe_set_enabled(true);
+    midi_mpe_set_enabled(false);
+}
+
+static void release_mono_toggle(void)
+{
+    input_pipeline_set_mono(true);
+    input_pipeline_set_mono(false);
+}
+
+static void release_route_channels(void)
+{
+    input_pipeline_set_route_channels(MIDI_OUT_ROUTE_TRS_UART, 0xFFFEu);
+    input_pipeline_set_route_channels(MIDI_OUT_ROUTE_TRS_UART, 0xFFFFu);
+}
+
+static void release_panic(void)
+{
+    midi_out_panic();
+}
+
+static void check_same_pitch(const char *check, release_fn_t release)
+{
+    ip_event_t e = {0};
+    input_pipeline_init();
+
+    expect(check, "first key sounds", edge(0, 0, true, &e) == 1 && e.pressed && e.note == 64 && e.channel == 0);
+    release();
+    expect(check, "same pitch on another string sounds", edge(1, 5, true, &e) == 1 && e.pressed && e.note == 64);
+    expect(check, "key held across the release stays silent", edge(0, 0, false, NULL) == 0);
+    expect(check, "last release sends note-off", edge(1, 5, false, &e) == 1 && !e.pressed && e.note == 64);
+}
+
+/* Velocity source that releases all notes once, mid-press */
+static release_fn_t s_mid_press_release;
+
+static uint8_t velocity_releasing(const ip_event_t *ev)
+{
+    (void)ev;
+    const release_fn_t fn = s_mid_press_release;
+    s_mid_press_release = NULL;
+    if (fn) fn();
+    return 100;
+}
+
+static void check_release_mid_press(const char *check, release_fn_t release)
+{
+    input_pipeline_init();
+    input_pipeline_set_velocity_source(velocity_releasing);
+    s_mid_press_release = release;
+
+    expect(check, "press counted before the release goes out", edge_run(0, 0, true) == 1);
+    expect(check, "its note-on is cut on the wire",
+           wire_sounding(HOST_SINK_USB) == 0 && wire_sounding(HOST_SINK_UART) == 0);
+    expect(check, "same pitch on another string sounds", edge_run(1, 5, true) == 1);
+    expect(check, "key pressed across the release stays silent", edge_run(0, 0, false) == 0);
+    expect(check, "last release sends note-off", edge_run(1, 5, false) == 1);
+    expect(check, "nothing left sounding", wire_sounding(HOST_SINK_USB) == 0 && wire_sounding(HOST_SINK_UART) == 0);
+
+    input_pipeline_set_velocity_source(NULL);
+}
+
+/* Taking TRS out releases only TRS; adding it back sends nothing for the
+ * key still held, and the held-key counts carry on across both changes.
+ */
+static void check_route_removed(const char *check)
+{
+    input_pipeline_init();
+
+    expect(check, "first key sounds", edge_run(0, 0, true) == 1);
+    midi_out_set_routes(MIDI_OUT_ROUTE_USB);
+    expect(check, "removed route released, other route still sounding",
+           wire_sounding(HOST_SINK_UART) == 0 && wire_sounding(HOST_SINK_USB) == 1);
+    midi_out_set_routes(MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART);
+    expect(check, "route added back gets nothing for the held key",
+           wire_sounding(HOST_SINK_UART) == 0 && wire_sounding(HOST_SINK_USB) == 1);
+    expect(check, "same pitch on another string is already held", edge_run(1, 5, true) == 0);
+    expect(check, "first release keeps the pitch held", edge_run(0, 0, false) == 0);
+    expect(check, "last release sends note-off", edge_run(1, 5, false) == 1);
+    expect(check, "nothing left sounding", wire_sounding(HOST_SINK_USB) == 0 && wire_sounding(HOST_SINK_UART) == 0);
+}
+
+int main(void)
+{
+    host_sink_set_cb(wire_probe, NULL);
+    midi_out_init();
+    midi_out_set_routes(MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART);
+    midi_mpe_init();
+    note_map_init();
+
+    check_same_pitch("panic", release_panic);
+    check_same_pitch("mpe_toggle", release_mpe_toggle);
+    check_same_pitch("mono_toggle", release_mono_toggle);
+    check_same_pitch("route_channels", release_route_channels);
+    check_release_mid_press("panic_mid_press", release_panic);
+    check_release_mid_press("mpe_toggle_mid_press", release_mpe_toggle);
+    check_release_mid_press("mono_toggle_mid_press", release_mono_toggle);
+    check_release_mid_press("route_channels_mid_press", release_route_channels);
+    check_route_removed("route_removed");
+
+    midi_out_panic();
+    return s_failed;
+}
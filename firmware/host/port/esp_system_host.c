@@ -0,0 +1,99 @@
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "nvs.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "host_port.h"
+
+/* =========================================================
+ * Misc ESP-IDF system services (host port)
+ * ========================================================= */
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_NO_FREE_PAGES: return "ESP_ERR_NVS_NO_FREE_PAGES";
+    case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+/* ---- Logging ---- */
+
+static int s_log_level = -1;
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int log_level(void)
+{
+    if (s_log_level < 0) {
+        const char *env = getenv("EMIUET_HOST_LOG");
+        s_log_level = env ? atoi(env) : ESP_LOG_INFO;
+    }
+    return s_log_level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    (void)level;
+}
+
+void host_log_write(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+    if ((int)level > log_level()) return;
+
+    static const char letters[] = "NEWIDV";
+    va_list ap;
+    va_start(ap, fmt);
+    /* Logs go to stderr; stdout stays machine-readable for the harness */
+    pthread_mutex_lock(&s_log_lock);
+    fprintf(stderr, "%c (%llu) %s: ", letters[level], (unsigned long long)(host_port_now_us() / 1000u), tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&s_log_lock);
+    va_end(ap);
+}
+
+/* ---- Random / delay / cycle counter ---- */
+
+uint32_t esp_random(void)
+{
+    /* xorshift32; deterministic per run so host traces are reproducible */
+    static _Atomic uint32_t s = 0x2545F491u;
+    uint32_t x = s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s = x;
+    return x;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    host_port_busy_us(us);
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
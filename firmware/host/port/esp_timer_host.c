@@ -0,0 +1,161 @@
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_port.h"
+
+/* =========================================================
+ * esp_timer (host port)
+ *
+ * One dispatcher task runs every callback, like the esp_timer task on
+ * the target. Timers sit in a short linked list; the dispatcher sleeps
+ * on its notification until the earliest deadline, so it follows the
+ * port clock in both real and virtual time. Callbacks run without the
+ * list lock held, so they may start/stop timers (including their own).
+ * ========================================================= */
+
+struct esp_timer {
+    esp_timer_cb_t cb;
+    void *arg;
+    uint64_t due_us;
+    uint64_t period_us; /* 0 == one-shot */
+    bool active;
+    struct esp_timer *next;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+static struct esp_timer *s_timers = NULL;
+static TaskHandle_t s_task = NULL;
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)host_port_now_us();
+}
+
+static void dispatcher(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&s_lock);
+        struct esp_timer *next = NULL;
+        for (struct esp_timer *t = s_timers; t; t = t->next) {
+            if (t->active && (!next || t->due_us < next->due_us)) next = t;
+        }
+
+        const uint64_t now = host_port_now_us();
+        if (!next || next->due_us > now) {
+            const uint64_t due = next ? next->due_us : UINT64_MAX;
+            pthread_mutex_unlock(&s_lock);
+            (void)host_port_notify_wait_until(due);
+            continue;
+        }
+
+        if (next->period_us) {
+            next->due_us += next->period_us;
+            /* Like skip_unhandled_events: do not burst to catch up */
+            if (next->due_us <= now) next->due_us = now + next->period_us;
+        } else {
+            next->active = false;
+        }
+
+        esp_timer_cb_t cb = next->cb;
+        void *cb_arg = next->arg;
+        pthread_mutex_unlock(&s_lock);
+        cb(cb_arg);
+    }
+}
+
+static void start_dispatcher(void)
+{
+    /* Same priority as the ESP-IDF esp_timer task */
+    xTaskCreatePinnedToCore(dispatcher, "esp_timer", 4096, NULL, 22, &s_task, 0);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (!args || !args->callback || !out) return ESP_ERR_INVALID_ARG;
+    pthread_once(&s_once, start_dispatcher);
+
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (!t) return ESP_ERR_NO_MEM;
+    t->cb = args->callback;
+    t->arg = args->arg;
+
+    pthread_mutex_lock(&s_lock);
+    t->next = s_timers;
+    s_timers = t;
+    pthread_mutex_unlock(&s_lock);
+
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t t, uint64_t first_us, uint64_t period_us)
+{
+    if (!t) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    if (t->active) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    t->due_us = host_port_now_us() + first_us;
+    t->period_us = period_us;
+    t->active = true;
+    pthread_mutex_unlock(&s_lock);
+    /* Outside s_lock: in virtual time the dispatcher may run right here */
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0) return ESP_ERR_INVALID_ARG;
+    return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    const bool was = timer->active;
+    timer->active = false;
+    pthread_mutex_unlock(&s_lock);
+    return was ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    if (timer->active) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct esp_timer **pp = &s_timers; *pp; pp = &(*pp)->next) {
+        if (*pp == timer) {
+            *pp = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    if (!timer) return false;
+    pthread_mutex_lock(&s_lock);
+    const bool a = timer->active;
+    pthread_mutex_unlock(&s_lock);
+    return a;
+}
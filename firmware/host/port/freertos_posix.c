@@ -0,0 +1,672 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host_port.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* =========================================================
+ * FreeRTOS subset on POSIX threads (host port)
+ *
+ * Real time (default): tasks are free-running pthreads, the OS schedules.
+ *
+ * Virtual time (HOST_PORT_VIRTUAL_TIME): tasks are still pthreads, but
+ * only the holder of a run token executes. The token goes to the highest
+ * priority ready task (FIFO within a priority), including on a
+ * notification to a higher priority task outside a critical section, like
+ * FreeRTOS with zero-cost code. When no task is ready the clock jumps to
+ * the earliest timeout.
+ *
+ * Busy-waits (esp_rom_delay_us) are the only code that takes time, so
+ * they are what the two cores model: a busy task holds its core against
+ * tasks of its priority and below (no time slicing). Pinned tasks run on
+ * their core; a floating task takes the first free core when it wakes
+ * (core 0 first, where ESP-IDF advances the tick) and keeps it until it
+ * blocks.
+ * ========================================================= */
+
+#define HOST_TICK_US (1000000u / configTICK_RATE_HZ)
+#define HOST_CORES   2
+
+struct host_sem;
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    UBaseType_t prio;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *next_all;
+    int state;
+    uint64_t ready_seq;
+    uint64_t wake_us;          /* UINT64_MAX == no timeout */
+    bool wait_notify;
+    struct host_sem *wait_sem;
+    uint32_t crit;             /* critical section nesting (no preemption) */
+    int core;                  /* pinned core, -1 == floating */
+    int on_core;               /* core while ready or busy, -1 == not placed */
+    bool busy;                 /* blocked in a busy-wait: still holds on_core */
+#endif
+};
+
+static _Thread_local struct host_task *t_self = NULL;
+
+#if HOST_PORT_VIRTUAL_TIME
+
+enum { VT_READY = 0, VT_BLOCKED, VT_DEAD };
+
+/* Scheduler state; the run token is s_vt_running */
+static pthread_mutex_t s_vt_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task *s_vt_tasks = NULL;
+static struct host_task *s_vt_running = NULL;
+static uint64_t s_vt_now_us = 0;
+static uint64_t s_vt_seq = 0;
+
+static uint64_t now_us(void)
+{
+    pthread_mutex_lock(&s_vt_lock);
+    const uint64_t t = s_vt_now_us;
+    pthread_mutex_unlock(&s_vt_lock);
+    return t;
+}
+
+#else
+
+static struct timespec s_epoch;
+static pthread_once_t s_epoch_once = PTHREAD_ONCE_INIT;
+
+static void epoch_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &s_epoch);
+}
+
+static uint64_t now_us(void)
+{
+    pthread_once(&s_epoch_once, epoch_init);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - s_epoch.tv_sec) * 1000000u + (uint64_t)((ts.tv_nsec - s_epoch.tv_nsec) / 1000);
+}
+
+#endif
+
+static void task_init_sync(struct host_task *t)
+{
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+    t->notify = 0;
+}
+
+/* =========================================================
+ * Virtual-time scheduler (caller holds s_vt_lock)
+ * ========================================================= */
+
+#if HOST_PORT_VIRTUAL_TIME
+
+static void vt_make_ready(struct host_task *t)
+{
+    t->state = VT_READY;
+    t->wake_us = UINT64_MAX;
+    t->ready_seq = ++s_vt_seq;
+}
+
+static void vt_add(struct host_task *t, int core)
+{
+    t->core = core;
+    t->on_core = core;
+    t->next_all = s_vt_tasks;
+    s_vt_tasks = t;
+    vt_make_ready(t);
+}
+
+/* No busy-waiting task of t's priority or above holds core c */
+static bool vt_core_free_for(const struct host_task *t, int c)
+{
+    for (struct host_task *o = s_vt_tasks; o; o = o->next_all) {
+        if (o != t && o->busy && o->state == VT_BLOCKED && o->on_core == c && o->prio >= t->prio) return false;
+    }
+    return true;
+}
+
+/* Core t would run on now, -1 == none free for it */
+static int vt_place(const struct host_task *t)
+{
+    if (t->on_core >= 0) return vt_core_free_for(t, t->on_core) ? t->on_core : -1;
+    for (int c = 0; c < HOST_CORES; ++c) {
+        if (vt_core_free_for(t, c)) return c;
+    }
+    return -1;
+}
+
+/* Highest priority ready task with a free core; advances the clock while
+ * there is none.
+ */
+static struct host_task *vt_pick(void)
+{
+    for (;;) {
+        struct host_task *best = NULL;
+        int best_core = -1;
+        uint64_t next_wake = UINT64_MAX;
+        for (struct host_task *t = s_vt_tasks; t; t = t->next_all) {
+            if (t->state == VT_READY) {
+                if (best && (t->prio < best->prio || (t->prio == best->prio && t->ready_seq > best->ready_seq))) {
+                    continue;
+                }
+                const int c = vt_place(t);
+                if (c >= 0) {
+                    best = t;
+                    best_core = c;
+                }
+            } else if (t->state == VT_BLOCKED && t->wake_us < next_wake) {
+                next_wake = t->wake_us;
+            }
+        }
+        if (best) {
+            best->on_core = best_core;
+            return best;
+        }
+
+        if (next_wake == UINT64_MAX) {
+            fprintf(stderr, "host_port: every task waits forever at t=%llu us\n", (unsigned long long)s_vt_now_us);
+            abort();
+        }
+        s_vt_now_us = next_wake;
+        for (struct host_task *t = s_vt_tasks; t; t = t->next_all) {
+            if (t->state == VT_BLOCKED && t->wake_us == next_wake) vt_make_ready(t);
+        }
+    }
+}
+
+/* Hand the token to the best task and wait until it comes back */
+static void vt_reschedule(struct host_task *self)
+{
+    struct host_task *next = vt_pick();
+    if (next == self) return;
+    s_vt_running = next;
+    pthread_cond_signal(&next->cond);
+    while (s_vt_running != self) pthread_cond_wait(&self->cond, &s_vt_lock);
+}
+
+static void vt_block_until(struct host_task *self, uint64_t wake_us)
+{
+    self->state = VT_BLOCKED;
+    self->wake_us = wake_us;
+    /* A floating task gives up its core unless it only busy-waits */
+    if (!self->busy && self->core < 0) self->on_core = -1;
+    vt_reschedule(self);
+}
+
+static void vt_yield(struct host_task *self)
+{
+    vt_make_ready(self);
+    vt_reschedule(self);
+}
+
+/* A higher priority task became ready: run it now (the caller keeps its
+ * place at the head of its priority, like a preempted FreeRTOS task).
+ */
+static void vt_maybe_preempt(struct host_task *self)
+{
+    if (self->crit != 0 || s_vt_running != self) return;
+    for (struct host_task *t = s_vt_tasks; t; t = t->next_all) {
+        if (t->state == VT_READY && t->prio > self->prio) {
+            vt_reschedule(self);
+            return;
+        }
+    }
+}
+
+static uint64_t vt_deadline(TickType_t ticks)
+{
+    return (ticks == portMAX_DELAY) ? UINT64_MAX : s_vt_now_us + (uint64_t)ticks * HOST_TICK_US;
+}
+
+#endif
+
+/* Threads not created by xTaskCreate (main, timer dispatcher) get a task
+ * record on first use so notifications work from anywhere.
+ */
+static struct host_task *self_task(void)
+{
+    if (!t_self) {
+        struct host_task *t = calloc(1, sizeof(*t));
+        if (!t) abort();
+        t->thread = pthread_self();
+        t->prio = 1; /* like app_main */
+        strncpy(t->name, "host", sizeof(t->name) - 1);
+        task_init_sync(t);
+        t_self = t;
+#if HOST_PORT_VIRTUAL_TIME
+        /* The first thread to touch the port (main) starts with the token */
+        pthread_mutex_lock(&s_vt_lock);
+        vt_add(t, -1);
+        if (!s_vt_running) s_vt_running = t;
+        while (s_vt_running != t) pthread_cond_wait(&t->cond, &s_vt_lock);
+        pthread_mutex_unlock(&s_vt_lock);
+#endif
+    }
+    return t_self;
+}
+
+static void task_exit_self(void)
+{
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    self->state = VT_DEAD;
+    struct host_task *next = vt_pick();
+    s_vt_running = next;
+    pthread_cond_signal(&next->cond);
+    pthread_mutex_unlock(&s_vt_lock);
+#endif
+    pthread_exit(NULL);
+}
+
+static void *task_trampoline(void *p)
+{
+    struct host_task *t = p;
+    t_self = t;
+#if HOST_PORT_VIRTUAL_TIME
+    pthread_mutex_lock(&s_vt_lock);
+    while (s_vt_running != t) pthread_cond_wait(&t->cond, &s_vt_lock);
+    pthread_mutex_unlock(&s_vt_lock);
+#endif
+    t->fn(t->arg);
+    /* Real FreeRTOS tasks must never return; treat it as self-delete */
+    task_exit_self();
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core_id)
+{
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (!t) return pdFAIL;
+    t->fn = fn;
+    t->arg = arg;
+    t->prio = prio;
+    if (name) strncpy(t->name, name, sizeof(t->name) - 1);
+    task_init_sync(t);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    /* Stack depth is in bytes on ESP-IDF; host frames are larger, keep a floor */
+    size_t stack = (stack_depth < 65536u) ? 65536u : stack_depth;
+    pthread_attr_setstacksize(&attr, stack);
+
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    vt_add(t, (core_id >= 0 && core_id < HOST_CORES) ? (int)core_id : -1);
+#else
+    (void)core_id;
+#endif
+    if (out) *out = t;
+    const int rc = pthread_create(&t->thread, &attr, task_trampoline, t);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+#if HOST_PORT_VIRTUAL_TIME
+        t->state = VT_DEAD; /* stays on the list, never scheduled */
+        pthread_mutex_unlock(&s_vt_lock);
+#else
+        free(t);
+#endif
+        if (out) *out = NULL;
+        return pdFAIL;
+    }
+    pthread_setname_np(t->thread, t->name);
+#if HOST_PORT_VIRTUAL_TIME
+    vt_maybe_preempt(self);
+    pthread_mutex_unlock(&s_vt_lock);
+#endif
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == t_self) {
+        task_exit_self();
+    }
+#if HOST_PORT_VIRTUAL_TIME
+    /* Never scheduled again; its thread stays parked on the token */
+    pthread_mutex_lock(&s_vt_lock);
+    task->state = VT_DEAD;
+    pthread_mutex_unlock(&s_vt_lock);
+#else
+    /* Deferred cancellation: takes effect at the task's next delay/wait */
+    pthread_cancel(task->thread);
+#endif
+}
+
+void host_port_sleep_us(uint64_t us)
+{
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    if (us == 0) {
+        vt_yield(self);
+    } else {
+        vt_block_until(self, s_vt_now_us + us);
+    }
+    pthread_mutex_unlock(&s_vt_lock);
+#else
+    if (us == 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = {.tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000};
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+#endif
+}
+
+void host_port_busy_us(uint64_t us)
+{
+    if (us == 0) return;
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    self->busy = true;
+    vt_block_until(self, s_vt_now_us + us);
+    self->busy = false;
+    pthread_mutex_unlock(&s_vt_lock);
+#else
+    const uint64_t end = now_us() + us;
+    while (now_us() < end) {
+    }
+#endif
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_port_sleep_us((uint64_t)ticks * HOST_TICK_US);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(now_us() / HOST_TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return self_task();
+}
+
+void taskYIELD(void)
+{
+    host_port_sleep_us(0);
+}
+
+/* =========================================================
+ * Task notifications
+ * ========================================================= */
+
+#if HOST_PORT_VIRTUAL_TIME
+
+static uint32_t notify_take(bool clear_on_exit, uint64_t deadline_us, bool wait)
+{
+    struct host_task *t = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    if (t->notify == 0 && wait) {
+        t->wait_notify = true;
+        vt_block_until(t, deadline_us);
+        t->wait_notify = false;
+    }
+    const uint32_t v = t->notify;
+    if (v != 0) t->notify = clear_on_exit ? 0 : v - 1;
+    pthread_mutex_unlock(&s_vt_lock);
+    return v;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_vt_lock);
+    const uint64_t deadline = vt_deadline(ticks);
+    pthread_mutex_unlock(&s_vt_lock);
+    return notify_take(clear_on_exit != pdFALSE, deadline, ticks != 0);
+}
+
+bool host_port_notify_wait_until(uint64_t deadline_us)
+{
+    return notify_take(true, deadline_us, deadline_us > now_us()) != 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (!task) return pdFAIL;
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    task->notify++;
+    if (task->state == VT_BLOCKED && task->wait_notify) vt_make_ready(task);
+    vt_maybe_preempt(self);
+    pthread_mutex_unlock(&s_vt_lock);
+    return pdPASS;
+}
+
+#else
+
+static uint32_t notify_take(bool clear_on_exit, const struct timespec *deadline, bool wait)
+{
+    struct host_task *t = self_task();
+
+    pthread_mutex_lock(&t->lock);
+    while (t->notify == 0 && wait) {
+        int rc;
+        if (!deadline) {
+            rc = pthread_cond_wait(&t->cond, &t->lock);
+        } else {
+            rc = pthread_cond_timedwait(&t->cond, &t->lock, deadline);
+        }
+        if (rc == ETIMEDOUT) break;
+    }
+    const uint32_t v = t->notify;
+    if (v != 0) t->notify = clear_on_exit ? 0 : v - 1;
+    pthread_mutex_unlock(&t->lock);
+    return v;
+}
+
+/* Absolute CLOCK_REALTIME deadline (default condvar clock) us from now */
+static struct timespec realtime_deadline(uint64_t us)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const uint64_t ns = (uint64_t)deadline.tv_nsec + us * 1000u;
+    deadline.tv_sec += (time_t)(ns / 1000000000u);
+    deadline.tv_nsec = (long)(ns % 1000000000u);
+    return deadline;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) return notify_take(clear_on_exit != pdFALSE, NULL, true);
+    const struct timespec deadline = realtime_deadline((uint64_t)ticks * HOST_TICK_US);
+    return notify_take(clear_on_exit != pdFALSE, &deadline, ticks != 0);
+}
+
+bool host_port_notify_wait_until(uint64_t deadline_us)
+{
+    if (deadline_us == UINT64_MAX) return notify_take(true, NULL, true) != 0;
+    const uint64_t now = now_us();
+    const struct timespec deadline = realtime_deadline(deadline_us > now ? deadline_us - now : 0);
+    return notify_take(true, &deadline, deadline_us > now) != 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (!task) return pdFAIL;
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+#endif
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_prio_woken)
+{
+    (void)xTaskNotifyGive(task);
+    if (higher_prio_woken) *higher_prio_woken = pdFALSE;
+}
+
+/* =========================================================
+ * Critical sections: recursive spinlock per portMUX
+ * ========================================================= */
+
+void host_port_enter_critical(portMUX_TYPE *mux)
+{
+    struct host_task *self = self_task();
+    const uintptr_t me = (uintptr_t)self;
+#if HOST_PORT_VIRTUAL_TIME
+    self->crit++;
+#endif
+    if (atomic_load_explicit(&mux->owner, memory_order_relaxed) == me) {
+        mux->count++;
+        return;
+    }
+    uintptr_t expected = 0;
+    while (!atomic_compare_exchange_weak_explicit(&mux->owner, &expected, me,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+        expected = 0;
+        /* The holder may be descheduled (no interrupt masking on the host) */
+        sched_yield();
+    }
+    mux->count = 1;
+}
+
+void host_port_exit_critical(portMUX_TYPE *mux)
+{
+    if (--mux->count == 0) {
+        atomic_store_explicit(&mux->owner, 0, memory_order_release);
+    }
+#if HOST_PORT_VIRTUAL_TIME
+    struct host_task *self = self_task();
+    if (--self->crit == 0) {
+        /* Run anything a notification inside the section made ready */
+        pthread_mutex_lock(&s_vt_lock);
+        vt_maybe_preempt(self);
+        pthread_mutex_unlock(&s_vt_lock);
+    }
+#endif
+}
+
+/* =========================================================
+ * Mutex semaphores
+ * ========================================================= */
+
+#if HOST_PORT_VIRTUAL_TIME
+
+struct host_sem {
+    struct host_task *owner;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct host_sem));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (!sem) return pdFAIL;
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    const uint64_t deadline = vt_deadline(ticks);
+    while (sem->owner) {
+        if (ticks == 0 || s_vt_now_us >= deadline) {
+            pthread_mutex_unlock(&s_vt_lock);
+            return pdFAIL;
+        }
+        self->wait_sem = sem;
+        vt_block_until(self, deadline);
+        self->wait_sem = NULL;
+    }
+    sem->owner = self;
+    pthread_mutex_unlock(&s_vt_lock);
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (!sem) return pdFAIL;
+    struct host_task *self = self_task();
+    pthread_mutex_lock(&s_vt_lock);
+    if (sem->owner != self) {
+        pthread_mutex_unlock(&s_vt_lock);
+        return pdFAIL;
+    }
+    sem->owner = NULL;
+    struct host_task *waiter = NULL;
+    for (struct host_task *t = s_vt_tasks; t; t = t->next_all) {
+        if (t->state == VT_BLOCKED && t->wait_sem == sem && (!waiter || t->prio > waiter->prio)) waiter = t;
+    }
+    if (waiter) vt_make_ready(waiter);
+    vt_maybe_preempt(self);
+    pthread_mutex_unlock(&s_vt_lock);
+    return pdPASS;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+#else
+
+struct host_sem {
+    pthread_mutex_t m;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_sem *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    pthread_mutex_init(&s->m, NULL);
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (!sem) return pdFAIL;
+    if (ticks == portMAX_DELAY) return pthread_mutex_lock(&sem->m) == 0 ? pdPASS : pdFAIL;
+    if (ticks == 0) return pthread_mutex_trylock(&sem->m) == 0 ? pdPASS : pdFAIL;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)ticks * (1000000000u / configTICK_RATE_HZ);
+    deadline.tv_sec += (time_t)(ns / 1000000000u);
+    deadline.tv_nsec = (long)(ns % 1000000000u);
+    return pthread_mutex_timedlock(&sem->m, &deadline) == 0 ? pdPASS : pdFAIL;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (!sem) return pdFAIL;
+    return pthread_mutex_unlock(&sem->m) == 0 ? pdPASS : pdFAIL;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (!sem) return;
+    pthread_mutex_destroy(&sem->m);
+    free(sem);
+}
+
+#endif
+
+uint64_t host_port_now_us(void)
+{
+    return now_us();
+}
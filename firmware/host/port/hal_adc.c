@@ -0,0 +1,246 @@
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_oneshot.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_hal.h"
+#include "host_port.h"
+
+/* =========================================================
+ * ADC oneshot, continuous + calibration stubs (host port)
+ *
+ * ESP32-S3 mapping: GPIO1..10 -> ADC1 ch0..9, GPIO11..20 -> ADC2 ch0..9.
+ * Reads return the raw value last set for the GPIO (default 0).
+ * Continuous mode: a port task fills one frame per frame period and
+ * raises on_conv_done; a frame not read before the next one is replaced
+ * (flush_pool behavior) and raises on_pool_ovf.
+ * ========================================================= */
+
+#define HOST_ADC_CHANNELS 10
+
+struct adc_oneshot_unit_ctx_t {
+    adc_unit_t unit;
+};
+
+struct adc_cali_scheme_t {
+    int unused;
+};
+
+static _Atomic int s_raw[2][HOST_ADC_CHANNELS];
+
+esp_err_t adc_oneshot_io_to_channel(int io_num, adc_unit_t *out_unit, adc_channel_t *out_ch)
+{
+    if (!out_unit || !out_ch) return ESP_ERR_INVALID_ARG;
+    if (io_num >= 1 && io_num <= 10) {
+        *out_unit = ADC_UNIT_1;
+        *out_ch = (adc_channel_t)(io_num - 1);
+        return ESP_OK;
+    }
+    if (io_num >= 11 && io_num <= 20) {
+        *out_unit = ADC_UNIT_2;
+        *out_ch = (adc_channel_t)(io_num - 11);
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *cfg, adc_oneshot_unit_handle_t *out)
+{
+    if (!cfg || !out) return ESP_ERR_INVALID_ARG;
+    struct adc_oneshot_unit_ctx_t *u = calloc(1, sizeof(*u));
+    if (!u) return ESP_ERR_NO_MEM;
+    u->unit = cfg->unit_id;
+    *out = u;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t unit, adc_channel_t ch, const adc_oneshot_chan_cfg_t *cfg)
+{
+    if (!unit || !cfg || (int)ch < 0 || ch >= HOST_ADC_CHANNELS) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t unit, adc_channel_t ch, int *out_raw)
+{
+    if (!unit || !out_raw || (int)ch < 0 || ch >= HOST_ADC_CHANNELS) return ESP_ERR_INVALID_ARG;
+    *out_raw = atomic_load_explicit(&s_raw[unit->unit][ch], memory_order_relaxed);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t *cfg, adc_cali_handle_t *out)
+{
+    if (!cfg || !out) return ESP_ERR_INVALID_ARG;
+    static struct adc_cali_scheme_t s_scheme;
+    *out = &s_scheme;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *out_mv)
+{
+    if (!handle || !out_mv) return ESP_ERR_INVALID_ARG;
+    *out_mv = (raw * 3100) / 4095;
+    return ESP_OK;
+}
+
+void host_hal_adc_set_raw(gpio_num_t gpio, int raw)
+{
+    adc_unit_t unit;
+    adc_channel_t ch;
+    if (adc_oneshot_io_to_channel((int)gpio, &unit, &ch) != ESP_OK) return;
+    if (raw < 0) raw = 0;
+    if (raw > 4095) raw = 4095;
+    atomic_store_explicit(&s_raw[unit][ch], raw, memory_order_relaxed);
+}
+
+/* ---- Continuous mode ---- */
+
+#define HOST_ADC_CONT_FRAME_MAX 1024u
+
+struct adc_continuous_ctx_t {
+    uint32_t frame_size;
+    adc_digi_pattern_config_t pattern[HOST_ADC_CHANNELS];
+    uint32_t pattern_num;
+    uint32_t freq_hz;
+    adc_continuous_evt_cbs_t cbs;
+    void *user;
+    TaskHandle_t task;
+    _Atomic bool running;
+
+    pthread_mutex_t lock;
+    uint8_t frame[HOST_ADC_CONT_FRAME_MAX];
+    bool frame_ready;
+};
+
+static void adc_cont_task(void *arg)
+{
+    struct adc_continuous_ctx_t *h = arg;
+    const uint32_t results = h->frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+    const uint64_t frame_us = ((uint64_t)results * 1000000u) / h->freq_hz;
+    uint8_t frame[HOST_ADC_CONT_FRAME_MAX];
+    uint32_t slot = 0;
+
+    while (atomic_load(&h->running)) {
+        host_port_sleep_us(frame_us ? frame_us : 1u);
+        for (uint32_t i = 0; i < results; ++i) {
+            const adc_digi_pattern_config_t *p = &h->pattern[slot];
+            slot = (slot + 1u) % h->pattern_num;
+            adc_digi_output_data_t d = {.val = 0};
+            d.type2.data = (uint32_t)atomic_load_explicit(&s_raw[p->unit][p->channel], memory_order_relaxed);
+            d.type2.channel = p->channel;
+            d.type2.unit = p->unit;
+            memcpy(&frame[i * SOC_ADC_DIGI_RESULT_BYTES], &d, SOC_ADC_DIGI_RESULT_BYTES);
+        }
+        pthread_mutex_lock(&h->lock);
+        const bool overflow = h->frame_ready;
+        memcpy(h->frame, frame, h->frame_size);
+        h->frame_ready = true;
+        pthread_mutex_unlock(&h->lock);
+
+        if (overflow && h->cbs.on_pool_ovf) {
+            const adc_continuous_evt_data_t ev = {.conv_frame_buffer = NULL, .size = 0};
+            (void)h->cbs.on_pool_ovf(h, &ev, h->user);
+        }
+
+        if (h->cbs.on_conv_done) {
+            const adc_continuous_evt_data_t ev = {.conv_frame_buffer = frame, .size = h->frame_size};
+            (void)h->cbs.on_conv_done(h, &ev, h->user);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *cfg, adc_continuous_handle_t *out)
+{
+    if (!cfg || !out || cfg->conv_frame_size == 0 || cfg->conv_frame_size > HOST_ADC_CONT_FRAME_MAX ||
+        (cfg->conv_frame_size % SOC_ADC_DIGI_RESULT_BYTES) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct adc_continuous_ctx_t *h = calloc(1, sizeof(*h));
+    if (!h) return ESP_ERR_NO_MEM;
+    h->frame_size = cfg->conv_frame_size;
+    pthread_mutex_init(&h->lock, NULL);
+    *out = h;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t h, const adc_continuous_config_t *cfg)
+{
+    if (!h || !cfg || !cfg->adc_pattern || cfg->pattern_num == 0 || cfg->pattern_num > HOST_ADC_CHANNELS ||
+        cfg->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || cfg->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t i = 0; i < cfg->pattern_num; ++i) {
+        if (cfg->adc_pattern[i].unit > ADC_UNIT_2 || cfg->adc_pattern[i].channel >= HOST_ADC_CHANNELS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        h->pattern[i] = cfg->adc_pattern[i];
+    }
+    h->pattern_num = cfg->pattern_num;
+    h->freq_hz = cfg->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t h, const adc_continuous_evt_cbs_t *cbs,
+                                                  void *user_data)
+{
+    if (!h || !cbs) return ESP_ERR_INVALID_ARG;
+    h->cbs = *cbs;
+    h->user = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t h)
+{
+    if (!h || h->pattern_num == 0) return ESP_ERR_INVALID_STATE;
+    if (atomic_exchange(&h->running, true)) return ESP_ERR_INVALID_STATE;
+    /* Above every firmware task: stands in for the DMA engine */
+    if (xTaskCreatePinnedToCore(adc_cont_task, "adc_dma", 4096, h, 23, &h->task, 0) != pdPASS) {
+        atomic_store(&h->running, false);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t h)
+{
+    if (!h || !atomic_exchange(&h->running, false)) return ESP_ERR_INVALID_STATE;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t h, uint8_t *buf, uint32_t length_max, uint32_t *out_length,
+                              uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    if (!h || !buf || !out_length) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&h->lock);
+    if (!h->frame_ready) {
+        pthread_mutex_unlock(&h->lock);
+        *out_length = 0;
+        return ESP_ERR_TIMEOUT;
+    }
+    const uint32_t n = (length_max < h->frame_size) ? length_max - (length_max % SOC_ADC_DIGI_RESULT_BYTES) : h->frame_size;
+    memcpy(buf, h->frame, n);
+    h->frame_ready = false;
+    pthread_mutex_unlock(&h->lock);
+    *out_length = n;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t h)
+{
+    if (!h || atomic_load(&h->running)) return ESP_ERR_INVALID_STATE;
+    /* The task may still be finishing its last frame: leak the context */
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_io_to_channel(int io_num, adc_unit_t *out_unit, adc_channel_t *out_ch)
+{
+    return adc_oneshot_io_to_channel(io_num, out_unit, out_ch);
+}
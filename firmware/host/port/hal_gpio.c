@@ -0,0 +1,87 @@
+#include "driver/gpio.h"
+
+#include <stdatomic.h>
+
+#include "board_pins.h"
+#include "host_hal.h"
+
+/* =========================================================
+ * GPIO driver stub with a key matrix model (host port)
+ *
+ * Output pins remember their level. A matrix column reads low when any
+ * row pin driven low has a pressed key on that column; other inputs read
+ * the level set by host_hal_gpio_set_input() (default high: pull-up).
+ * ========================================================= */
+
+static _Atomic int s_out_level[GPIO_NUM_MAX];
+static _Atomic int s_in_level[GPIO_NUM_MAX];
+static _Atomic bool s_in_level_set[GPIO_NUM_MAX];
+static _Atomic uint16_t s_keys[MATRIX_NUM_ROWS]; /* bit c == column c */
+
+static inline bool pin_valid(gpio_num_t gpio)
+{
+    return gpio >= 0 && gpio < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    if (!cfg) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (!pin_valid(gpio)) return ESP_ERR_INVALID_ARG;
+    atomic_store_explicit(&s_out_level[gpio], level ? 1 : 0, memory_order_relaxed);
+    return ESP_OK;
+}
+
+static int matrix_col_index(gpio_num_t gpio)
+{
+    for (int c = 0; c < MATRIX_NUM_COLS; ++c) {
+        if (MATRIX_COL_PINS[c] == gpio) return c;
+    }
+    return -1;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    if (!pin_valid(gpio)) return 0;
+
+    const int c = matrix_col_index(gpio);
+    if (c >= 0) {
+        for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+            const bool row_low = atomic_load_explicit(&s_out_level[MATRIX_ROW_PINS[r]], memory_order_relaxed) == 0;
+            if (row_low && (atomic_load_explicit(&s_keys[r], memory_order_relaxed) & (1u << c))) return 0;
+        }
+        return 1;
+    }
+
+    if (atomic_load_explicit(&s_in_level_set[gpio], memory_order_relaxed)) {
+        return atomic_load_explicit(&s_in_level[gpio], memory_order_relaxed);
+    }
+    return 1;
+}
+
+void host_hal_matrix_set_key(int row, int col, bool pressed)
+{
+    if (row < 0 || row >= MATRIX_NUM_ROWS || col < 0 || col >= MATRIX_NUM_COLS) return;
+    if (pressed) {
+        (void)atomic_fetch_or(&s_keys[row], (uint16_t)(1u << col));
+    } else {
+        (void)atomic_fetch_and(&s_keys[row], (uint16_t)~(1u << col));
+    }
+}
+
+bool host_hal_matrix_get_key(int row, int col)
+{
+    if (row < 0 || row >= MATRIX_NUM_ROWS || col < 0 || col >= MATRIX_NUM_COLS) return false;
+    return (atomic_load(&s_keys[row]) & (1u << col)) != 0;
+}
+
+void host_hal_gpio_set_input(gpio_num_t gpio, int level)
+{
+    if (!pin_valid(gpio)) return;
+    atomic_store(&s_in_level[gpio], level ? 1 : 0);
+    atomic_store(&s_in_level_set[gpio], true);
+}
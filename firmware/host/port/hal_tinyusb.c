@@ -0,0 +1,175 @@
+#include "tinyusb.h"
+#include "tusb.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "host_hal.h"
+#include "host_port.h"
+
+/* =========================================================
+ * TinyUSB device stub (host port)
+ *
+ * - tinyusb_driver_install() "enumerates" at once (ATTACHED event).
+ * - Device -> host MIDI stream bytes go to the USB sink.
+ * - Host -> device event packets are queued by host_hal_usb_inject().
+ *
+ * Link model: each stream message becomes a 4-byte event packet in a TX
+ * FIFO that the host drains at frame boundaries (1 ms, full speed), up to
+ * the frame budget. A message's wire time is the frame that carries its
+ * packet.
+ * ========================================================= */
+
+#define HOST_USB_RX_PACKETS 256
+#define HOST_USB_TX_FIFO    64u /* CFG_TUD_MIDI_TX_BUFSIZE */
+#define HOST_USB_FRAME_US   1000u
+
+static _Atomic bool s_installed = false;
+static _Atomic bool s_mounted = false;
+static tinyusb_event_cb_t s_event_cb = NULL;
+static void *s_event_arg = NULL;
+
+static pthread_mutex_t s_rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t s_rx[HOST_USB_RX_PACKETS][4];
+static uint32_t s_rx_head = 0;
+static uint32_t s_rx_tail = 0;
+
+static pthread_mutex_t s_tx_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_frame_budget = 64u;
+static uint64_t s_tx_frame = 0; /* frame carrying the newest queued packet */
+static uint32_t s_tx_used = 0;  /* bytes of s_tx_frame's budget taken */
+
+/* Default no-op, like TinyUSB's weak callbacks */
+__attribute__((weak)) void tud_midi_rx_cb(uint8_t itf)
+{
+    (void)itf;
+}
+
+static void emit_event(tinyusb_event_id_t id)
+{
+    if (!s_event_cb) return;
+    tinyusb_event_t ev = {.id = id};
+    s_event_cb(&ev, s_event_arg);
+}
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t *cfg)
+{
+    if (!cfg) return ESP_ERR_INVALID_ARG;
+    if (atomic_exchange(&s_installed, true)) return ESP_ERR_INVALID_STATE;
+    s_event_cb = cfg->event_cb;
+    s_event_arg = cfg->event_arg;
+    atomic_store(&s_mounted, true);
+    emit_event(TINYUSB_EVENT_ATTACHED);
+    return ESP_OK;
+}
+
+bool tud_mounted(void)
+{
+    return atomic_load(&s_mounted);
+}
+
+bool tud_midi_mounted(void)
+{
+    return atomic_load(&s_mounted);
+}
+
+uint32_t tud_midi_stream_write(uint8_t cable_num, const uint8_t *buffer, uint32_t bufsize)
+{
+    (void)cable_num;
+    if (!atomic_load(&s_mounted) || !buffer || bufsize == 0) return 0;
+
+    /* One 4-byte event packet per message. Like TinyUSB, accept whole
+     * messages while the FIFO has room and report the bytes taken.
+     */
+    const uint64_t now = host_port_now_us();
+    uint32_t off = 0;
+    uint32_t msgs = 0;
+    uint32_t msg_off[HOST_USB_TX_FIFO / 4u];
+    uint64_t msg_wire[HOST_USB_TX_FIFO / 4u];
+
+    pthread_mutex_lock(&s_tx_lock);
+    const uint64_t next_frame = now / HOST_USB_FRAME_US + 1u;
+    if (s_tx_frame < next_frame) {
+        s_tx_frame = next_frame;
+        s_tx_used = 0;
+    }
+    while (off < bufsize && msgs < HOST_USB_TX_FIFO / 4u) {
+        uint64_t wire_us = now;
+        if (s_frame_budget) {
+            const uint64_t queued = (s_tx_frame - next_frame) * s_frame_budget + s_tx_used;
+            if (queued + 4u > HOST_USB_TX_FIFO) break;
+            for (uint32_t left = 4u; left;) {
+                if (s_tx_used >= s_frame_budget) {
+                    s_tx_frame++;
+                    s_tx_used = 0;
+                }
+                const uint32_t take = (left < s_frame_budget - s_tx_used) ? left : s_frame_budget - s_tx_used;
+                s_tx_used += take;
+                left -= take;
+            }
+            wire_us = s_tx_frame * HOST_USB_FRAME_US;
+        }
+        uint32_t n = (uint32_t)host_midi_msg_len(buffer[off]);
+        if (n > bufsize - off) n = bufsize - off;
+        msg_off[msgs] = off;
+        msg_wire[msgs++] = wire_us;
+        off += n;
+    }
+    pthread_mutex_unlock(&s_tx_lock);
+
+    for (uint32_t i = 0; i < msgs; ++i) {
+        const uint32_t end = (i + 1u < msgs) ? msg_off[i + 1u] : off;
+        host_sink_write(HOST_SINK_USB, buffer + msg_off[i], end - msg_off[i], msg_wire[i]);
+    }
+    return off;
+}
+
+bool tud_midi_packet_read(uint8_t packet[4])
+{
+    bool ok = false;
+    pthread_mutex_lock(&s_rx_lock);
+    if (s_rx_tail != s_rx_head) {
+        memcpy(packet, s_rx[s_rx_tail % HOST_USB_RX_PACKETS], 4);
+        s_rx_tail++;
+        ok = true;
+    }
+    pthread_mutex_unlock(&s_rx_lock);
+    return ok;
+}
+
+bool tud_control_xfer(uint8_t rhport, const tusb_control_request_t *request, void *buffer, uint16_t len)
+{
+    (void)rhport;
+    (void)request;
+    (void)buffer;
+    (void)len;
+    return true;
+}
+
+void host_hal_usb_set_frame_budget(uint32_t bytes)
+{
+    pthread_mutex_lock(&s_tx_lock);
+    s_frame_budget = bytes;
+    pthread_mutex_unlock(&s_tx_lock);
+}
+
+void host_hal_usb_set_mounted(bool mounted)
+{
+    if (atomic_exchange(&s_mounted, mounted) == mounted) return;
+    emit_event(mounted ? TINYUSB_EVENT_ATTACHED : TINYUSB_EVENT_DETACHED);
+}
+
+bool host_hal_usb_inject(const uint8_t packet[4])
+{
+    pthread_mutex_lock(&s_rx_lock);
+    const bool full = (s_rx_head - s_rx_tail) >= HOST_USB_RX_PACKETS;
+    if (!full) {
+        memcpy(s_rx[s_rx_head % HOST_USB_RX_PACKETS], packet, 4);
+        s_rx_head++;
+    }
+    pthread_mutex_unlock(&s_rx_lock);
+    if (full) return false;
+    tud_midi_rx_cb(0);
+    return true;
+}
@@ -0,0 +1,117 @@
+#include "driver/uart.h"
+
+#include <pthread.h>
+
+#include "host_hal.h"
+#include "host_port.h"
+
+/* =========================================================
+ * UART driver stub (host port): TX bytes go to the UART sink
+ *
+ * Link model: bytes leave at the configured bit rate (start + data +
+ * stop bits). uart_write_bytes() returns once the bytes fit in the TX
+ * ring buffer + hardware FIFO, blocking while they are full.
+ * ========================================================= */
+
+#define HOST_UART_HW_FIFO 128u
+
+typedef struct {
+    bool installed;
+    uint64_t byte_ns;      /* 0 == not configured: no link timing */
+    uint32_t tx_capacity;  /* driver TX buffer + FIFO, bytes */
+    uint64_t wire_free_ns; /* when the last queued byte has left */
+} host_uart_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_uart_t s_uart[UART_NUM_MAX];
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *cfg)
+{
+    if (port < 0 || port >= UART_NUM_MAX || !cfg || cfg->baud_rate <= 0) return ESP_ERR_INVALID_ARG;
+    const uint32_t bits = 1u + (5u + (uint32_t)cfg->data_bits) + (cfg->parity ? 1u : 0u) + (uint32_t)cfg->stop_bits;
+    pthread_mutex_lock(&s_lock);
+    s_uart[port].byte_ns = (uint64_t)bits * 1000000000u / (uint64_t)cfg->baud_rate;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts)
+{
+    (void)tx;
+    (void)rx;
+    (void)rts;
+    (void)cts;
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buf, int tx_buf, int queue_size, void *queue, int intr_flags)
+{
+    (void)rx_buf;
+    (void)queue_size;
+    (void)queue;
+    (void)intr_flags;
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    const bool was = s_uart[port].installed;
+    if (!was) {
+        s_uart[port].installed = true;
+        s_uart[port].tx_capacity = (uint32_t)(tx_buf > 0 ? tx_buf : 0) + HOST_UART_HW_FIFO;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return was ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+    if (port < 0 || port >= UART_NUM_MAX || !src) return -1;
+
+    pthread_mutex_lock(&s_lock);
+    host_uart_t *u = &s_uart[port];
+    if (!u->installed) {
+        pthread_mutex_unlock(&s_lock);
+        return -1;
+    }
+
+    uint64_t start_ns = host_port_now_us() * 1000u;
+    uint64_t byte_ns = 0;
+    if (u->byte_ns) {
+        /* Wait (lock released) until the write fits behind the queued bytes */
+        for (;;) {
+            const uint64_t now_ns = host_port_now_us() * 1000u;
+            if (u->wire_free_ns < now_ns) u->wire_free_ns = now_ns;
+            const uint64_t queued = (u->wire_free_ns - now_ns + u->byte_ns - 1u) / u->byte_ns;
+            if (queued + size <= u->tx_capacity || queued == 0) break;
+            const uint64_t wait_us = ((queued + size - u->tx_capacity) * u->byte_ns + 999u) / 1000u;
+            pthread_mutex_unlock(&s_lock);
+            host_port_sleep_us(wait_us);
+            pthread_mutex_lock(&s_lock);
+        }
+        start_ns = u->wire_free_ns;
+        byte_ns = u->byte_ns;
+        u->wire_free_ns += (uint64_t)size * u->byte_ns;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    /* Each message's wire time is when its own last byte leaves */
+    const uint8_t *b = (const uint8_t *)src;
+    for (size_t off = 0; off < size;) {
+        size_t n = host_midi_msg_len(b[off]);
+        if (n > size - off) n = size - off;
+        off += n;
+        host_sink_write(HOST_SINK_UART, b + off - n, n, (start_ns + (uint64_t)off * byte_ns + 999u) / 1000u);
+    }
+    return (int)size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    (void)ticks;
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    const uint64_t done_us = (s_uart[port].wire_free_ns + 999u) / 1000u;
+    pthread_mutex_unlock(&s_lock);
+    const uint64_t now = host_port_now_us();
+    if (done_us > now) host_port_sleep_us(done_us - now);
+    return ESP_OK;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Virtual time (discrete-event simulation): one task runs at a time, code
+ * takes zero time (busy-waits hold one of two cores) and the clock jumps
+ * to the next wake-up when every task waits. Selected per build target
+ * (see ../CMakeLists.txt).
+ */
+#ifndef HOST_PORT_VIRTUAL_TIME
+#define HOST_PORT_VIRTUAL_TIME 0
+#endif
+
+/* Internal to the host port: one monotonic epoch for ticks, esp_timer and logs */
+uint64_t host_port_now_us(void);
+
+/* Block the calling task for us microseconds (link models) */
+void host_port_sleep_us(uint64_t us);
+
+/* Busy-wait us microseconds (ROM delays); in virtual time the calling
+ * task keeps its core meanwhile.
+ */
+void host_port_busy_us(uint64_t us);
+
+/* Wait for a task notification until host_port_now_us() >= deadline_us
+ * (UINT64_MAX == forever). Clears the count; true if notified.
+ */
+bool host_port_notify_wait_until(uint64_t deadline_us);
@@ -0,0 +1,80 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "host_hal.h"
+
+/* =========================================================
+ * In-memory transport sinks (host port)
+ *
+ * Each sink keeps a byte count and the most recent 64 KiB. The optional
+ * callback sees every write synchronously, for latency probes.
+ * ========================================================= */
+
+#define HOST_SINK_BUF 65536u
+
+typedef struct {
+    uint8_t buf[HOST_SINK_BUF];
+    uint64_t head; /* total bytes written */
+    uint64_t tail; /* total bytes consumed by host_sink_read() */
+} host_sink_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_sink_t s_sinks[HOST_SINK_COUNT];
+static host_sink_cb_t s_cb = NULL;
+static void *s_cb_ctx = NULL;
+
+void host_sink_set_cb(host_sink_cb_t cb, void *ctx)
+{
+    pthread_mutex_lock(&s_lock);
+    s_cb = cb;
+    s_cb_ctx = ctx;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_sink_write(host_sink_id_t sink, const uint8_t *bytes, size_t len, uint64_t wire_us)
+{
+    if (sink >= HOST_SINK_COUNT || !bytes || len == 0) return;
+
+    pthread_mutex_lock(&s_lock);
+    host_sink_t *s = &s_sinks[sink];
+    for (size_t i = 0; i < len; ++i) {
+        s->buf[(s->head + i) % HOST_SINK_BUF] = bytes[i];
+    }
+    s->head += len;
+    if (s->head - s->tail > HOST_SINK_BUF) s->tail = s->head - HOST_SINK_BUF;
+    host_sink_cb_t cb = s_cb;
+    void *ctx = s_cb_ctx;
+    pthread_mutex_unlock(&s_lock);
+
+    if (cb) cb(sink, bytes, len, wire_us, ctx);
+}
+
+uint64_t host_sink_total(host_sink_id_t sink)
+{
+    if (sink >= HOST_SINK_COUNT) return 0;
+    pthread_mutex_lock(&s_lock);
+    const uint64_t n = s_sinks[sink].head;
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+size_t host_sink_read(host_sink_id_t sink, uint8_t *out, size_t max)
+{
+    if (sink >= HOST_SINK_COUNT || !out) return 0;
+    pthread_mutex_lock(&s_lock);
+    host_sink_t *s = &s_sinks[sink];
+    size_t n = 0;
+    while (n < max && s->tail < s->head) {
+        out[n++] = s->buf[s->tail % HOST_SINK_BUF];
+        s->tail++;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+void host_sink_reset(void)
+{
+    pthread_mutex_lock(&s_lock);
+    memset(s_sinks, 0, sizeof(s_sinks));
+    pthread_mutex_unlock(&s_lock);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host port: nanoseconds of CLOCK_MONOTONIC, truncated like the 32-bit CCOUNT */
+uint32_t esp_cpu_get_cycle_count(void);
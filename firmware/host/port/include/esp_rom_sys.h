@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Busy-waits like the ROM routine (keeps scan timing and CPU cost realistic) */
+void esp_rom_delay_us(uint32_t us);
@@ -0,0 +1,53 @@
+#pragma once
+
+/* =========================================================
+ * Host port: FreeRTOS API subset on POSIX threads
+ *
+ * Only what firmware/main uses. Tasks are pthreads, ticks are 1 ms of
+ * CLOCK_MONOTONIC, task notifications are a counter + condvar.
+ * Priorities and core affinity are ignored (the host scheduler decides),
+ * except in virtual time where priorities pick the running task (see
+ * freertos_posix.c); critical sections are recursive spinlocks.
+ * ========================================================= */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define configTICK_RATE_HZ   1000
+#define configMAX_PRIORITIES 25
+#define portNUM_PROCESSORS   2
+#define portTICK_PERIOD_MS   (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY        ((TickType_t)0xFFFFFFFFu)
+#define tskNO_AFFINITY       ((BaseType_t)0x7FFFFFFF)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+
+/* Recursive spinlock, like the ESP-IDF portMUX (owner + nesting count) */
+typedef struct {
+    _Atomic uintptr_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+
+void host_port_enter_critical(portMUX_TYPE *mux);
+void host_port_exit_critical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)     host_port_enter_critical(mux)
+#define portEXIT_CRITICAL(mux)      host_port_exit_critical(mux)
+#define portENTER_CRITICAL_ISR(mux) host_port_enter_critical(mux)
+#define portEXIT_CRITICAL_ISR(mux)  host_port_exit_critical(mux)
+#define portYIELD_FROM_ISR(x)       ((void)(x))
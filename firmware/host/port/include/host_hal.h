@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+
+/* =========================================================
+ * Host HAL control surface
+ *
+ * What the stub drivers expose to a host harness: a key matrix model
+ * behind the GPIO driver, settable ADC inputs, and in-memory sinks for
+ * the transports (UART = TRS MIDI, USB = TinyUSB MIDI stream).
+ * ========================================================= */
+
+/* ---- Key matrix (GPIO) ----
+ * Column pins read low while a pressed key's row pin is driven low,
+ * like the real diode-less active-low matrix.
+ */
+void host_hal_matrix_set_key(int row, int col, bool pressed);
+bool host_hal_matrix_get_key(int row, int col);
+
+/* Level seen by gpio_get_level() on plain input pins (buttons, status) */
+void host_hal_gpio_set_input(gpio_num_t gpio, int level);
+
+/* ---- ADC ---- raw 0..4095 on an ADC-capable GPIO */
+void host_hal_adc_set_raw(gpio_num_t gpio, int raw);
+
+/* ---- Sinks ---- */
+typedef enum {
+    HOST_SINK_UART = 0,
+    HOST_SINK_USB,
+    HOST_SINK_COUNT,
+} host_sink_id_t;
+
+/* Called for every write, in the writer's thread, before it returns.
+ * wire_us is when the last byte leaves the modelled link (port clock).
+ */
+typedef void (*host_sink_cb_t)(host_sink_id_t sink, const uint8_t *bytes, size_t len, uint64_t wire_us, void *ctx);
+
+void host_sink_set_cb(host_sink_cb_t cb, void *ctx);
+
+/* Total bytes written since start / last reset */
+uint64_t host_sink_total(host_sink_id_t sink);
+
+/* Copy out and consume buffered bytes (the sink keeps the last 64 KiB) */
+size_t host_sink_read(host_sink_id_t sink, uint8_t *out, size_t max);
+
+void host_sink_reset(void);
+
+/* Internal: used by the driver stubs. Link models write one MIDI
+ * message at a time, so callbacks see whole messages even when the
+ * firmware hands a transport several at once.
+ */
+void host_sink_write(host_sink_id_t sink, const uint8_t *bytes, size_t len, uint64_t wire_us);
+
+/* Length of the MIDI 1.0 message starting with status byte `st`
+ * (no running status; the firmware never emits it). 1 for non-status bytes.
+ */
+static inline size_t host_midi_msg_len(uint8_t st)
+{
+    switch (st & 0xF0u) {
+        case 0x80u: case 0x90u: case 0xA0u: case 0xB0u: case 0xE0u: return 3;
+        case 0xC0u: case 0xD0u: return 2;
+        case 0xF0u: return (st == 0xF1u || st == 0xF3u) ? 2 : (st == 0xF2u) ? 3 : 1;
+        default: return 1;
+    }
+}
+
+/* ---- Link models ----
+ * UART: bit time from uart_param_config(); uart_write_bytes() blocks while
+ * the driver TX buffer + 128-byte FIFO is full, like the real driver.
+ * USB: the host takes up to `bytes` of event packets per 1 ms frame from a
+ * 64-byte TX FIFO (default 64; 0 == unlimited). A full FIFO makes
+ * tud_midi_stream_write() return 0.
+ */
+void host_hal_usb_set_frame_budget(uint32_t bytes);
+
+/* ---- USB ---- */
+void host_hal_usb_set_mounted(bool mounted);
+
+/* Queue one USB-MIDI 1.0 event packet (host -> device) and run tud_midi_rx_cb() */
+bool host_hal_usb_inject(const uint8_t packet[4]);
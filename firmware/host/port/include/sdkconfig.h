@@ -0,0 +1,113 @@
+#pragma once
+
+/* =========================================================
+ * Host build configuration (stands in for the generated sdkconfig.h)
+ *
+ * Mirrors the Kconfig.projbuild defaults, except that every transport
+ * is enabled so the pipeline can be observed on all sinks. Options that
+ * are off stay undefined here so they can be switched on from CMake
+ * (e.g. -DCONFIG_EMIUET_RT_STATS=1).
+ * ========================================================= */
+
+#define CONFIG_IDF_TARGET_LINUX 1
+
+#ifndef CONFIG_TINYUSB_MIDI_COUNT
+#define CONFIG_TINYUSB_MIDI_COUNT 1
+#endif
+
+/* The UART sink has no console to collide with */
+#ifndef CONFIG_EMIUET_MIDI_TRS_UART_ENABLE
+#define CONFIG_EMIUET_MIDI_TRS_UART_ENABLE 1
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY 7
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY 6
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY 6
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN
+#define CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN 64
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_USB_QUEUE_LEN
+#define CONFIG_EMIUET_MIDI_USB_QUEUE_LEN 1024
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_BLE_QUEUE_LEN
+#define CONFIG_EMIUET_MIDI_BLE_QUEUE_LEN 256
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_USB_CC_BUDGET
+#define CONFIG_EMIUET_MIDI_USB_CC_BUDGET 0
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TRS_CC_BUDGET
+#define CONFIG_EMIUET_MIDI_TRS_CC_BUDGET 1200
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_BLE_CONN_INTERVAL_US
+#define CONFIG_EMIUET_MIDI_BLE_CONN_INTERVAL_US 7500
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_USB_RX_ENABLE
+#define CONFIG_EMIUET_MIDI_USB_RX_ENABLE 1
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY 5
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_IN_SYSEX_MAX
+#define CONFIG_EMIUET_MIDI_IN_SYSEX_MAX 128
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_SCHED_TICK_US
+#define CONFIG_EMIUET_MIDI_SCHED_TICK_US 250
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_SCHED_POOL
+#define CONFIG_EMIUET_MIDI_SCHED_POOL 256
+#endif
+
+#ifndef CONFIG_EMIUET_TASK_PARTITION
+#define CONFIG_EMIUET_TASK_PARTITION 1
+#endif
+
+#ifndef CONFIG_EMIUET_VELOCITY_SLIDER
+#define CONFIG_EMIUET_VELOCITY_SLIDER 1
+#endif
+
+#ifndef CONFIG_EMIUET_MOD_SLIDER
+#define CONFIG_EMIUET_MOD_SLIDER 1
+#endif
+
+#ifndef CONFIG_EMIUET_MOD_CC14
+#define CONFIG_EMIUET_MOD_CC14 0
+#endif
+
+#ifndef CONFIG_EMIUET_SLIDER_CALIB
+#define CONFIG_EMIUET_SLIDER_CALIB 1
+#endif
+
+#ifndef CONFIG_EMIUET_ADC_CONTINUOUS
+#define CONFIG_EMIUET_ADC_CONTINUOUS 1
+#endif
+
+#ifndef CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ
+#define CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ 20000
+#endif
+
+#ifndef CONFIG_EMIUET_ADC_QUIET
+#define CONFIG_EMIUET_ADC_QUIET 1
+#endif
+
+#ifndef CONFIG_EMIUET_ADC_QUIET_GUARD_US
+#define CONFIG_EMIUET_ADC_QUIET_GUARD_US 30
+#endif
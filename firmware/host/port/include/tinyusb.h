@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "tusb.h"
+
+typedef enum {
+    TINYUSB_EVENT_ATTACHED,
+    TINYUSB_EVENT_DETACHED,
+} tinyusb_event_id_t;
+
+typedef struct {
+    tinyusb_event_id_t id;
+} tinyusb_event_t;
+
+typedef void (*tinyusb_event_cb_t)(tinyusb_event_t *event, void *arg);
+
+typedef struct {
+    struct {
+        const tusb_desc_device_t *device;
+        const char **string;
+        int string_count;
+        const uint8_t *full_speed_config;
+        const uint8_t *high_speed_config;
+    } descriptor;
+    struct {
+        int size;
+        int priority;
+        int xCoreID;
+    } task;
+    tinyusb_event_cb_t event_cb;
+    void *event_arg;
+} tinyusb_config_t;
+
+/* Host port: "enumerates" immediately (ATTACHED event, tud_mounted() true) */
+esp_err_t tinyusb_driver_install(const tinyusb_config_t *cfg);
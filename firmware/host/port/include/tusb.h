@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Host port: TinyUSB device API subset (MIDI 1.0 class)
+ *
+ * Descriptors compile but are never parsed. Stream writes land in the USB
+ * sink; host -> device packets are injected with host_hal_usb_inject().
+ * ========================================================= */
+
+#define TUD_OPT_HIGH_SPEED 0
+
+#define TUSB_DESC_DEVICE       0x01
+#define TUSB_DESC_CONFIGURATION 0x02
+#define TUSB_DESC_INTERFACE    0x04
+#define TUSB_DESC_ENDPOINT     0x05
+#define TUSB_DESC_CS_INTERFACE 0x24
+#define TUSB_DESC_CS_ENDPOINT  0x25
+#define TUSB_REQ_GET_DESCRIPTOR 0x06
+#define TUSB_CLASS_AUDIO       0x01
+#define TUSB_XFER_BULK         0x02
+#define AUDIO_SUBCLASS_MIDI_STREAMING 0x03
+#define MIDI_CS_INTERFACE_HEADER 0x01
+
+#define U16_TO_U8S_LE(x) (uint8_t)((x) & 0xFF), (uint8_t)(((x) >> 8) & 0xFF)
+
+typedef struct {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t bcdUSB;
+    uint8_t bDeviceClass;
+    uint8_t bDeviceSubClass;
+    uint8_t bDeviceProtocol;
+    uint8_t bMaxPacketSize0;
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint16_t bcdDevice;
+    uint8_t iManufacturer;
+    uint8_t iProduct;
+    uint8_t iSerialNumber;
+    uint8_t bNumConfigurations;
+} tusb_desc_device_t;
+
+typedef struct {
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} tusb_control_request_t;
+
+#define TUD_CONFIG_DESC_LEN 9
+#define TUD_MIDI_DESC_LEN   9
+
+#define TUD_CONFIG_DESCRIPTOR(config_num, itf_count, stridx, total_len, attr, power_ma) \
+    9, TUSB_DESC_CONFIGURATION, U16_TO_U8S_LE(total_len), itf_count, config_num, stridx, (uint8_t)(0x80 | (attr)), \
+        (uint8_t)((power_ma) / 2)
+
+/* Placeholder interface descriptor (the real macro emits AC + MS interfaces) */
+#define TUD_MIDI_DESCRIPTOR(itfnum, stridx, epout, epin, epsize) \
+    9, TUSB_DESC_INTERFACE, itfnum, 0, 2, TUSB_CLASS_AUDIO, AUDIO_SUBCLASS_MIDI_STREAMING, 0, stridx
+
+bool tud_mounted(void);
+bool tud_midi_mounted(void);
+uint32_t tud_midi_stream_write(uint8_t cable_num, const uint8_t *buffer, uint32_t bufsize);
+bool tud_midi_packet_read(uint8_t packet[4]);
+bool tud_control_xfer(uint8_t rhport, const tusb_control_request_t *request, void *buffer, uint16_t len);
+
+/* Application callback, invoked from the host "USB stack" thread */
+void tud_midi_rx_cb(uint8_t itf);
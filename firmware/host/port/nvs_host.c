@@ -0,0 +1,157 @@
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* =========================================================
+ * NVS (host port)
+ *
+ * Blobs in a small fixed table, lost at exit. A handle is its
+ * namespace index + 1, with bit 31 set when opened read-write; nvs_open()
+ * of an unknown namespace fails read-only and creates it read-write,
+ * as on the target.
+ * ========================================================= */
+
+#define HOST_NVS_NAMESPACES 8
+#define HOST_NVS_ENTRIES    32
+#define HOST_NVS_KEY_MAX    16 /* 15 chars + NUL, as on the target */
+#define HOST_NVS_RW         0x80000000u
+
+typedef struct {
+    int ns; /* namespace index, -1 == free */
+    char key[HOST_NVS_KEY_MAX];
+    void *data;
+    size_t len;
+} host_nvs_entry_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool s_inited = false;
+static char s_ns[HOST_NVS_NAMESPACES][HOST_NVS_KEY_MAX];
+static host_nvs_entry_t s_entries[HOST_NVS_ENTRIES];
+
+esp_err_t nvs_flash_init(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (!s_inited) {
+        for (int i = 0; i < HOST_NVS_ENTRIES; ++i) s_entries[i].ns = -1;
+        s_inited = true;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < HOST_NVS_ENTRIES; ++i) {
+        free(s_entries[i].data);
+        s_entries[i] = (host_nvs_entry_t){.ns = -1};
+    }
+    memset(s_ns, 0, sizeof(s_ns));
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (!name || !out_handle || strlen(name) >= HOST_NVS_KEY_MAX) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&s_lock);
+    esp_err_t err = ESP_OK;
+    int ns = -1;
+    if (!s_inited) {
+        err = ESP_ERR_NVS_NOT_INITIALIZED;
+    } else {
+        for (int i = 0; i < HOST_NVS_NAMESPACES && ns < 0; ++i) {
+            if (strcmp(s_ns[i], name) == 0) ns = i;
+        }
+        for (int i = 0; i < HOST_NVS_NAMESPACES && ns < 0 && open_mode == NVS_READWRITE; ++i) {
+            if (s_ns[i][0] == '\0') {
+                strcpy(s_ns[i], name);
+                ns = i;
+            }
+        }
+        if (ns < 0) err = (open_mode == NVS_READWRITE) ? ESP_ERR_NO_MEM : ESP_ERR_NVS_NOT_FOUND;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (err == ESP_OK) *out_handle = (nvs_handle_t)(ns + 1) | (open_mode == NVS_READWRITE ? HOST_NVS_RW : 0u);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+static host_nvs_entry_t *find_entry(int ns, const char *key)
+{
+    for (int i = 0; i < HOST_NVS_ENTRIES; ++i) {
+        if (s_entries[i].ns == ns && strcmp(s_entries[i].key, key) == 0) return &s_entries[i];
+    }
+    return NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    const int ns = (int)(handle & ~HOST_NVS_RW) - 1;
+    if (ns < 0 || ns >= HOST_NVS_NAMESPACES) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!key || !length) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&s_lock);
+    esp_err_t err = ESP_OK;
+    const host_nvs_entry_t *e = find_entry(ns, key);
+    if (!e) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value && *length < e->len) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        if (out_value) memcpy(out_value, e->data, e->len);
+        *length = e->len;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    const int ns = (int)(handle & ~HOST_NVS_RW) - 1;
+    if (ns < 0 || ns >= HOST_NVS_NAMESPACES || (handle & HOST_NVS_RW) == 0) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!key || !value || strlen(key) >= HOST_NVS_KEY_MAX) return ESP_ERR_INVALID_ARG;
+
+    void *copy = malloc(length ? length : 1u);
+    if (!copy) return ESP_ERR_NO_MEM;
+    memcpy(copy, value, length);
+
+    pthread_mutex_lock(&s_lock);
+    host_nvs_entry_t *e = find_entry(ns, key);
+    for (int i = 0; i < HOST_NVS_ENTRIES && !e; ++i) {
+        if (s_entries[i].ns < 0) {
+            e = &s_entries[i];
+            e->ns = ns;
+            strcpy(e->key, key);
+            e->data = NULL;
+        }
+    }
+    if (e) {
+        free(e->data);
+        e->data = copy;
+        e->len = length;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (!e) {
+        free(copy);
+        return ESP_ERR_NVS_NO_FREE_PAGES;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "host_hal.h"
+#include "host_port.h"
+#include "matrix_midi_bridge.h"
+#include "midi_out.h"
+#include "nvs_flash.h"
+#include "midi_tx_ring.h"
+#include "slider.h"
+
+/* =========================================================
+ * Queue sizing simulation (virtual time)
+ *
+ * Replays an event trace through the real firmware core (matrix scan,
+ * bridge, slider task, midi_out, sender tasks) on the virtual-time port,
+ * with the UART and USB link models. Queues are built at the Kconfig
+ * maximum, so the reported high-water mark is the depth needed for zero
+ * drops under this trace.
+ *
+ * Trace: one event per line, times in us from trace start, '#' comments.
+ *   <t_us> key <row> <col> <0|1>
+ *   <t_us> adc <pb|mod|vel> <raw 0..4095>
+ *   <t_us> routes <usb,trs,ble>
+ *   #! step <t_us> <raw>     pitch-bend slider jump (emiuet_filterbench marker)
+ *
+ * Output: one JSON line per route on stdout (latency = key edge -> last
+ * byte on the modelled link; bend_onset = "#! step" -> first pitch bend
+ * on the link; bend_tx / mod_tx = pitch bends / CC#1 on the link and
+ * their mean rate).
+ * ========================================================= */
+
+#define QSIM_BOOT_US   200000u
+#define QSIM_MAX_EDGES 8192u
+
+/* A note message older than this after its key edge is not attributed to it */
+#define QSIM_MATCH_WINDOW_US 100000u
+
+#define QSIM_MAX_BEND_MARKS 64u
+
+typedef enum { EV_KEY = 0, EV_ADC, EV_ROUTES, EV_BEND_MARK } qsim_ev_kind_t;
+
+typedef struct {
+    uint64_t t_us;
+    uint32_t line;
+    qsim_ev_kind_t kind;
+    int a, b, c;
+} qsim_ev_t;
+
+/* Per sink: key edges waiting for their note, per (on, note), FIFO */
+typedef struct {
+    uint64_t t[QSIM_MAX_EDGES];
+    uint32_t head, tail;
+} edge_fifo_t;
+
+typedef struct {
+    edge_fifo_t *pending[2][128];
+    uint32_t *lat_us;
+    uint32_t n;
+    uint32_t filtered; /* key edges that produced no message */
+    uint32_t unkeyed;  /* note messages without a recent key edge */
+    uint64_t bend_mark; /* pending "#! step" time, 0 = none */
+    uint32_t bend_lat_us[QSIM_MAX_BEND_MARKS];
+    uint32_t n_bend;
+    uint32_t n_bend_tx;
+    uint64_t bend_tx_first_us, bend_tx_last_us;
+    uint32_t n_mod_tx;
+    uint64_t mod_tx_first_us, mod_tx_last_us;
+} sink_acc_t;
+
+static sink_acc_t s_acc[HOST_SINK_COUNT];
+static uint32_t s_edges_cap = 0;
+
+static int cmp_ev(const void *a, const void *b)
+{
+    const qsim_ev_t *x = a;
+    const qsim_ev_t *y = b;
+    if (x->t_us != y->t_us) return (x->t_us > y->t_us) - (x->t_us < y->t_us);
+    return (x->line > y->line) - (x->line < y->line);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t parse_routes(const char *s)
+{
+    uint32_t r = 0;
+    if (strstr(s, "usb")) r |= MIDI_OUT_ROUTE_USB;
+    if (strstr(s, "trs")) r |= MIDI_OUT_ROUTE_TRS_UART;
+    if (strstr(s, "ble")) r |= MIDI_OUT_ROUTE_BLE;
+    return r;
+}
+
+static qsim_ev_t *load_trace(FILE *f, size_t *out_n)
+{
+    size_t n = 0, cap = 256;
+    qsim_ev_t *ev = malloc(cap * sizeof(*ev));
+    char line[256];
+    uint32_t lineno = 0;
+
+    while (ev && fgets(line, sizeof(line), f)) {
+        lineno++;
+        unsigned long long t = 0;
+        char op[16] = {0}, arg[64] = {0};
+        int a = 0, b = 0, c = 0;
+        qsim_ev_t e = {.line = lineno};
+        if (sscanf(line, "#! step %llu", &t) == 1) {
+            e.t_us = t;
+            e.kind = EV_BEND_MARK;
+            goto append;
+        }
+
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        if (sscanf(line, "%llu %15s", &t, op) != 2) continue;
+
+        e.t_us = t;
+        if (strcmp(op, "key") == 0 && sscanf(line, "%*u %*s %d %d %d", &a, &b, &c) == 3) {
+            e.kind = EV_KEY;
+            e.a = a, e.b = b, e.c = c;
+        } else if (strcmp(op, "adc") == 0 && sscanf(line, "%*u %*s %63s %d", arg, &b) == 2) {
+            e.kind = EV_ADC;
+            e.a = strcmp(arg, "mod") == 0 ? PIN_SLIDER_MOD : strcmp(arg, "vel") == 0 ? PIN_SLIDER_VEL : PIN_SLIDER_PB;
+            e.b = b;
+        } else if (strcmp(op, "routes") == 0 && sscanf(line, "%*u %*s %63s", arg) == 1) {
+            e.kind = EV_ROUTES;
+            e.a = (int)parse_routes(arg);
+        } else {
+            fprintf(stderr, "trace:%u: ignored: %s", lineno, line);
+            continue;
+        }
+
+    append:
+        if (n == cap) {
+            cap *= 2;
+            qsim_ev_t *grown = realloc(ev, cap * sizeof(*ev));
+            if (!grown) {
+                free(ev);
+                return NULL;
+            }
+            ev = grown;
+        }
+        ev[n++] = e;
+    }
+    if (ev) qsort(ev, n, sizeof(*ev), cmp_ev);
+    *out_n = n;
+    return ev;
+}
+
+static edge_fifo_t *fifo_for(sink_acc_t *acc, int on, uint8_t note)
+{
+    if (!acc->pending[on][note]) acc->pending[on][note] = calloc(1, sizeof(edge_fifo_t));
+    return acc->pending[on][note];
+}
+
+static void sink_probe(host_sink_id_t sink, const uint8_t *b, size_t len, uint64_t wire_us, void *ctx)
+{
+    (void)ctx;
+    if (len < 3) return;
+    const uint8_t st = (uint8_t)(b[0] & 0xF0u);
+    if (st == 0xE0u) {
+        sink_acc_t *acc = &s_acc[sink];
+        if (acc->n_bend_tx++ == 0) acc->bend_tx_first_us = wire_us;
+        acc->bend_tx_last_us = wire_us;
+        if (acc->bend_mark && host_port_now_us() >= acc->bend_mark && acc->n_bend < QSIM_MAX_BEND_MARKS) {
+            acc->bend_lat_us[acc->n_bend++] = (uint32_t)(wire_us - acc->bend_mark);
+        }
+        acc->bend_mark = 0;
+        return;
+    }
+    if (st == 0xB0u && (b[1] & 0x7Fu) == 1u) {
+        sink_acc_t *acc = &s_acc[sink];
+        if (acc->n_mod_tx++ == 0) acc->mod_tx_first_us = wire_us;
+        acc->mod_tx_last_us = wire_us;
+        return;
+    }
+    if (st != 0x90u && st != 0x80u) return;
+    const int on = (st == 0x90u) && (b[2] != 0);
+
+    /* The message belongs to the newest edge of this note so far; older
+     * unconsumed edges were swallowed by debounce (or the note was held).
+     */
+    sink_acc_t *acc = &s_acc[sink];
+    edge_fifo_t *q = acc->pending[on][b[1] & 0x7Fu];
+    const uint64_t now = host_port_now_us();
+    if (!q || q->tail == q->head || q->t[q->tail % QSIM_MAX_EDGES] > now) {
+        acc->unkeyed++;
+        return;
+    }
+    uint64_t t0 = 0;
+    while (q->tail != q->head && q->t[q->tail % QSIM_MAX_EDGES] <= now) {
+        t0 = q->t[q->tail++ % QSIM_MAX_EDGES];
+        acc->filtered++;
+    }
+    acc->filtered--;
+    if (now - t0 > QSIM_MATCH_WINDOW_US) {
+        /* No recent edge: matrix ghosting or a held duplicate note */
+        acc->filtered++;
+        acc->unkeyed++;
+        return;
+    }
+    if (acc->n < s_edges_cap) acc->lat_us[acc->n++] = (uint32_t)(wire_us - t0);
+}
+
+static void print_tx_rate(const char *key, uint32_t n, uint64_t first_us, uint64_t last_us)
+{
+    if (n < 2) return;
+    const uint64_t span_us = last_us - first_us;
+    printf(",\"%s\":{\"n\":%lu,\"per_s\":%lu}", key, (unsigned long)n,
+           (unsigned long)(span_us ? ((uint64_t)(n - 1u) * 1000000u) / span_us : 0u));
+}
+
+static void report(const char *name, host_sink_id_t sink, uint32_t route, uint32_t q_len)
+{
+    sink_acc_t *acc = &s_acc[sink];
+    for (int on = 0; on < 2; ++on) {
+        for (int note = 0; note < 128; ++note) {
+            const edge_fifo_t *q = acc->pending[on][note];
+            if (q) acc->filtered += q->head - q->tail;
+        }
+    }
+
+    midi_out_stats_t st;
+    (void)midi_out_get_stats(route, &st);
+
+    printf("{\"route\":\"%s\",\"events\":%lu,\"filtered\":%lu,\"unkeyed\":%lu", name, (unsigned long)acc->n,
+           (unsigned long)acc->filtered, (unsigned long)acc->unkeyed);
+    if (acc->n) {
+        qsort(acc->lat_us, acc->n, sizeof(acc->lat_us[0]), cmp_u32);
+        printf(",\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu",
+               (unsigned long)acc->lat_us[acc->n / 2u],
+               (unsigned long)acc->lat_us[(acc->n * 99u) / 100u],
+               (unsigned long)acc->lat_us[acc->n - 1u]);
+    }
+    if (acc->n_bend) {
+        qsort(acc->bend_lat_us, acc->n_bend, sizeof(acc->bend_lat_us[0]), cmp_u32);
+        printf(",\"bend_onset\":{\"n\":%lu,\"p50_us\":%lu,\"max_us\":%lu}",
+               (unsigned long)acc->n_bend,
+               (unsigned long)acc->bend_lat_us[acc->n_bend / 2u],
+               (unsigned long)acc->bend_lat_us[acc->n_bend - 1u]);
+    }
+    print_tx_rate("bend_tx", acc->n_bend_tx, acc->bend_tx_first_us, acc->bend_tx_last_us);
+    print_tx_rate("mod_tx", acc->n_mod_tx, acc->mod_tx_first_us, acc->mod_tx_last_us);
+    /* q_need: ring capacity (power of two) that holds the high-water mark */
+    printf(",\"q_hwm\":%lu,\"q_need\":%lu,\"q_sim\":%lu,\"saturated\":%s"
+           ",\"drop\":{\"queue\":%lu,\"write\":%lu},\"coalesce\":{\"pb\":%lu,\"cc1\":%lu}}\n",
+           (unsigned long)st.q_hwm,
+           (unsigned long)MIDI_TX_RING_CAP(st.q_hwm),
+           (unsigned long)q_len,
+           st.q_hwm >= q_len ? "true" : "false",
+           (unsigned long)st.drop_queue,
+           (unsigned long)st.drop_write,
+           (unsigned long)st.coalesce_pb,
+           (unsigned long)st.coalesce_cc1);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-u bytes_per_frame] [-d drain_ms] [-r usb,trs] trace|-\n"
+            "  -u  USB bytes the host takes per 1 ms frame (0 == unlimited), default 64\n"
+            "  -d  simulated time after the last event, default 500 ms\n"
+            "  -r  initial output routes, default usb,trs\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    uint32_t drain_ms = 500;
+    uint32_t routes = MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            host_hal_usb_set_frame_budget((uint32_t)strtoul(argv[++i], NULL, 0));
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            drain_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            routes = parse_routes(argv[++i]);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else if (!path && strcmp(argv[i], "-") == 0) {
+            path = "-";
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+    size_t n_ev = 0;
+    qsim_ev_t *ev = load_trace(f, &n_ev);
+    if (f != stdin) fclose(f);
+    if (!ev) return 1;
+
+    s_edges_cap = (uint32_t)n_ev + 1u;
+    for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+        s_acc[s].lat_us = calloc(s_edges_cap, sizeof(uint32_t));
+        if (!s_acc[s].lat_us) return 1;
+    }
+
+    /* Same bring-up as host_main.c */
+    (void)nvs_flash_init();
+    board_pins_init_early();
+    board_pins_init_matrix_late();
+    matrix_midi_bridge_start(MATRIX_INITIAL_DISCARD_CYCLES);
+    midi_out_set_routes(routes);
+    slider_task_start();
+    host_sink_set_cb(sink_probe, NULL);
+    host_port_sleep_us(QSIM_BOOT_US);
+    midi_out_reset_stats();
+
+    const uint64_t t_base = host_port_now_us();
+    for (size_t i = 0; i < n_ev; ++i) {
+        const uint64_t due = t_base + ev[i].t_us;
+        const uint64_t now = host_port_now_us();
+        if (due > now) host_port_sleep_us(due - now);
+
+        switch (ev[i].kind) {
+            case EV_KEY: {
+                const uint8_t note = matrix_midi_bridge_note_for(ev[i].a, ev[i].b);
+                if (note > 127u) break;
+                const int on = ev[i].c != 0;
+                const host_sink_id_t sinks[2] = {HOST_SINK_USB, HOST_SINK_UART};
+                const uint32_t bits[2] = {MIDI_OUT_ROUTE_USB, MIDI_OUT_ROUTE_TRS_UART};
+                for (int k = 0; k < 2; ++k) {
+                    if ((routes & bits[k]) == 0) continue;
+                    edge_fifo_t *q = fifo_for(&s_acc[sinks[k]], on, note);
+                    if (q && q->head - q->tail < QSIM_MAX_EDGES) q->t[q->head++ % QSIM_MAX_EDGES] = due;
+                }
+                host_hal_matrix_set_key(ev[i].a, ev[i].b, on);
+                break;
+            }
+            case EV_ADC:
+                host_hal_adc_set_raw((gpio_num_t)ev[i].a, ev[i].b);
+                break;
+            case EV_ROUTES:
+                routes = (uint32_t)ev[i].a;
+                midi_out_set_routes(routes);
+                break;
+            case EV_BEND_MARK:
+                /* set before the sample that moves the slider (same time, earlier line) */
+                s_acc[HOST_SINK_USB].bend_mark = due;
+                s_acc[HOST_SINK_UART].bend_mark = due;
+                break;
+        }
+    }
+    host_port_sleep_us((uint64_t)drain_ms * 1000u);
+    host_sink_set_cb(NULL, NULL);
+
+    fprintf(stderr, "qsim: %zu events, %.3f s simulated\n", n_ev, (double)(host_port_now_us() - t_base) / 1e6);
+    report("usb", HOST_SINK_USB, MIDI_OUT_ROUTE_USB, MIDI_TX_RING_CAP(CONFIG_EMIUET_MIDI_USB_QUEUE_LEN));
+    report("trs", HOST_SINK_UART, MIDI_OUT_ROUTE_TRS_UART, MIDI_TX_RING_CAP(CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN));
+    fflush(stdout);
+
+    for (int s = 0; s < HOST_SINK_COUNT; ++s) {
+        for (int on = 0; on < 2; ++on) {
+            for (int note = 0; note < 128; ++note) free(s_acc[s].pending[on][note]);
+        }
+        free(s_acc[s].lat_us);
+    }
+    free(ev);
+    return 0;
+}
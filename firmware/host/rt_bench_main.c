@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "host_hal.h"
+#include "host_port.h"
+#include "matrix_midi_bridge.h"
+#include "midi_out.h"
+#include "nvs_flash.h"
+#include "rt_stats.h"
+#include "slider.h"
+#include "task_layout.h"
+
+/* =========================================================
+ * Core-0 stall bench (virtual time)
+ *
+ * Runs the scan, bridge, slider and sender tasks with their task_layout.h
+ * placement while the rt_stats.c injector holds core 0 for 20 ms about
+ * every 100 ms, above every task. The stimulus toggles one key every
+ * RT_BENCH_EDGE_US, cycling over the matrix, so most scan passes carry an
+ * edge. Built twice: emiuet_rtbench (CONFIG_EMIUET_TASK_PARTITION=1) and
+ * emiuet_rtbench_float (=0, music tasks float).
+ *   key_to_enq_us   column read -> MIDI event enqueued (RT_STAT_KEY_TO_ENQUEUE)
+ *   scan_period_us  start-to-start of full matrix scans
+ * p50/p99 are histogram bucket upper bounds, max is exact; over counts
+ * samples past the histogram (1 ms for key_to_enq, 25.6 ms for the scan
+ * period). One JSON line on stdout, logs on stderr. Runs are deterministic.
+ * ========================================================= */
+
+#define RT_BENCH_BOOT_US 200000u
+#define RT_BENCH_EDGE_US 2000u
+
+static void print_summary(const char *key, const rt_stats_summary_t *s)
+{
+    printf(",\"%s\":{\"n\":%lu,\"over\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}", key, (unsigned long)s->n,
+           (unsigned long)s->over, (unsigned long)s->p50_us, (unsigned long)s->p99_us, (unsigned long)s->max_us);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 60;
+    bool stress = true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            stress = false;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-t seconds] [-q]\n"
+                    "  -t  simulated run time, default 60 s\n"
+                    "  -q  quiet: no stall injector (baseline)\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    /* Same bring-up as qsim_main.c */
+    (void)nvs_flash_init();
+    board_pins_init_early();
+    board_pins_init_matrix_late();
+    matrix_midi_bridge_start(MATRIX_INITIAL_DISCARD_CYCLES);
+    midi_out_set_routes(MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART);
+    slider_task_start();
+    if (stress) rt_stats_stress_start();
+    host_port_sleep_us(RT_BENCH_BOOT_US);
+
+    rt_stats_summary_t key, scan;
+    rt_stats_take(RT_STAT_KEY_TO_ENQUEUE, &key);
+    rt_stats_take(RT_STAT_SCAN_PERIOD, &scan);
+
+    const uint64_t end = host_port_now_us() + (uint64_t)seconds * 1000000u;
+    uint32_t k = 0;
+    while (host_port_now_us() < end) {
+        const int row = (int)(k % MATRIX_NUM_ROWS);
+        const int col = (int)((k / MATRIX_NUM_ROWS) % MATRIX_NUM_COLS);
+        host_hal_matrix_set_key(row, col, !host_hal_matrix_get_key(row, col));
+        k++;
+        host_port_sleep_us(RT_BENCH_EDGE_US);
+    }
+
+    rt_stats_take(RT_STAT_KEY_TO_ENQUEUE, &key);
+    rt_stats_take(RT_STAT_SCAN_PERIOD, &scan);
+
+    printf("{\"bench\":\"rt\",\"partition\":%d,\"stress\":%s,\"seconds\":%lu,\"edges\":%lu",
+           (int)CONFIG_EMIUET_TASK_PARTITION, stress ? "true" : "false", (unsigned long)seconds, (unsigned long)k);
+    print_summary("key_to_enq_us", &key);
+    print_summary("scan_period_us", &scan);
+    printf("}\n");
+    return key.n ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "midi_sched.h"
+
+/* =========================================================
+ * Host MIDI scheduler bench
+ *
+ * Runs midi_sched_bench_run() (main/midi_sched.c) with the pool at the
+ * Kconfig maximum: each pass posts its events at random due times over
+ * the spread, so up to ~4000 are pending at once, then waits for all of
+ * them. Insert cost should not grow with the pending count (timer wheel);
+ * lateness is bounded by the tick plus the esp_timer task's wake-up.
+ *   insert_ns  per post (the host port's cycle counter is in ns)
+ *   late_us    due -> dispatch, 16 us buckets (p50/p99) and max
+ * One JSON line per pass on stdout, logs on stderr. Host lateness is the
+ * Linux scheduler's; the device figures come from the same code with
+ * CONFIG_EMIUET_MIDI_SCHED_BENCH.
+ * ========================================================= */
+
+typedef struct {
+    uint32_t events;
+    uint32_t spread_ms;
+} sched_pass_t;
+
+static const sched_pass_t k_passes[] = {
+    {256, 100},
+    {1024, 500},
+    {CONFIG_EMIUET_MIDI_SCHED_POOL - 16, 2000},
+};
+
+int main(int argc, char **argv)
+{
+    uint32_t repeat = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeat = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-n repeat]\n"
+                    "  -n  runs of every pass, default 1\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (!midi_sched_init()) {
+        fprintf(stderr, "midi_sched_init failed\n");
+        return 1;
+    }
+
+    int missing = 0;
+    for (uint32_t rep = 0; rep < repeat; ++rep) {
+        for (size_t i = 0; i < sizeof(k_passes) / sizeof(k_passes[0]); ++i) {
+            midi_sched_bench_result_t r;
+            midi_sched_bench_run(k_passes[i].events, k_passes[i].spread_ms, &r);
+            printf("{\"bench\":\"midi_sched\",\"events\":%u,\"spread_ms\":%u,\"tick_us\":%d,\"pending_peak\":%u,"
+                   "\"insert_ns\":{\"avg\":%u,\"max\":%u},\"late_us\":{\"p50\":%u,\"p99\":%u,\"max\":%u},"
+                   "\"fired\":%u}\n",
+                   (unsigned)r.posted,
+                   (unsigned)k_passes[i].spread_ms,
+                   (int)CONFIG_EMIUET_MIDI_SCHED_TICK_US,
+                   (unsigned)r.pending_peak,
+                   (unsigned)r.insert_cyc_avg,
+                   (unsigned)r.insert_cyc_max,
+                   (unsigned)r.late_us_p50,
+                   (unsigned)r.late_us_p99,
+                   (unsigned)r.late_us_max,
+                   (unsigned)r.fired);
+            if (r.fired != r.posted || r.posted != k_passes[i].events) missing = 1;
+        }
+    }
+    return missing;
+}
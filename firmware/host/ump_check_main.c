@@ -0,0 +1,207 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "midi_ump.h"
+
+/* =========================================================
+ * Host UMP encoding checks
+ *
+ * The USB MIDI 2.0 path (CONFIG_EMIUET_MIDI_USB_UMP) is off by default,
+ * so nothing else exercises main/midi_ump.c off-target:
+ *   scale     Min-Center-Max upscaling, exact at min, center and max
+ *   midi2     structured messages -> MIDI 2.0 Channel Voice UMPs,
+ *             including velocity-0 Note On -> Note Off
+ *   midi1     MIDI 1.0 bytes -> MIDI 1.0 / system UMPs
+ *   input     received UMPs -> MIDI 1.0 bytes for the input parser,
+ *             and 7/14-bit values surviving the up/down round trip
+ * One line per failed check on stdout plus a summary; exits 1 on failure.
+ * ========================================================= */
+
+static int s_checks;
+static int s_failed;
+
+static void expect_u32(const char *what, uint32_t got, uint32_t want)
+{
+    s_checks++;
+    if (got == want) return;
+    s_failed++;
+    printf("FAIL %s: got 0x%08" PRIx32 ", want 0x%08" PRIx32 "\n", what, got, want);
+}
+
+static void expect_bytes(const char *what, const uint8_t *got, size_t got_len, const uint8_t *want, size_t want_len)
+{
+    s_checks++;
+    if (got_len == want_len && memcmp(got, want, want_len) == 0) return;
+    s_failed++;
+    printf("FAIL %s: got", what);
+    for (size_t i = 0; i < got_len; ++i) printf(" %02x", got[i]);
+    printf(", want");
+    for (size_t i = 0; i < want_len; ++i) printf(" %02x", want[i]);
+    printf("\n");
+}
+
+static size_t to_midi1(uint32_t w0, uint32_t w1, uint8_t out[MIDI_UMP_MIDI1_BYTES_MAX])
+{
+    const uint32_t w[2] = {w0, w1};
+    return midi_ump_to_midi1_bytes(w, midi_ump_word_count(w0), out);
+}
+
+static void check_scale(void)
+{
+    expect_u32("14->32 min", midi_ump_value_14_to_32(0), 0x00000000u);
+    expect_u32("14->32 center", midi_ump_value_14_to_32(8192), 0x80000000u);
+    expect_u32("14->32 max", midi_ump_value_14_to_32(16383), 0xFFFFFFFFu);
+    expect_u32("7->16 min", midi_ump_velocity_7_to_16(0), 0x0000u);
+    expect_u32("7->16 center", midi_ump_velocity_7_to_16(64), 0x8000u);
+    expect_u32("7->16 max", midi_ump_velocity_7_to_16(127), 0xFFFFu);
+    expect_u32("7->32 center", midi_ump_value_7_to_32(64), 0x80000000u);
+    expect_u32("7->32 max", midi_ump_value_7_to_32(127), 0xFFFFFFFFu);
+
+    /* Monotonic over the whole 14-bit range */
+    uint32_t prev = 0;
+    int bad = 0;
+    for (uint32_t v = 1; v <= 16383u; ++v) {
+        const uint32_t up = midi_ump_value_14_to_32((uint16_t)v);
+        if (up <= prev) bad++;
+        prev = up;
+    }
+    expect_u32("14->32 monotonic (violations)", (uint32_t)bad, 0);
+}
+
+static void check_midi2(void)
+{
+    uint32_t w[MIDI_UMP_MAX_WORDS];
+
+    midi_msg_t on = {.type = MIDI_MSG_NOTE_ON, .channel = 3};
+    on.data.note.note = 60;
+    on.data.note.velocity = 127;
+    expect_u32("note on words", (uint32_t)midi_ump_encode_midi2(&on, 0, w), 2);
+    expect_u32("note on w0", w[0], 0x40933C00u);
+    expect_u32("note on w1", w[1], 0xFFFF0000u);
+
+    /* MIDI 1.0 velocity 0 means Note Off; MIDI 2.0 has no such rule */
+    on.data.note.velocity = 0;
+    (void)midi_ump_encode_midi2(&on, 2, w);
+    expect_u32("note on vel 0 -> note off w0", w[0], 0x42833C00u);
+    expect_u32("note on vel 0 -> note off w1", w[1], 0x80000000u);
+
+    /* hires velocity 0 is a real MIDI 2.0 Note On */
+    on.hires = true;
+    on.data.note.velocity16 = 0;
+    (void)midi_ump_encode_midi2(&on, 0, w);
+    expect_u32("hires note on vel 0 stays on", w[0] >> 20 & 0xFu, 0x9u);
+
+    midi_msg_t pb = {.type = MIDI_MSG_PITCH_BEND, .channel = 0};
+    pb.data.pitchbend.value = 8192;
+    (void)midi_ump_encode_midi2(&pb, 0, w);
+    expect_u32("pitch bend w0", w[0], 0x40E00000u);
+    expect_u32("pitch bend center", w[1], 0x80000000u);
+    pb.data.pitchbend.value = 16383;
+    (void)midi_ump_encode_midi2(&pb, 0, w);
+    expect_u32("pitch bend max", w[1], 0xFFFFFFFFu);
+
+    midi_msg_t cc = {.type = MIDI_MSG_CC, .channel = 15};
+    cc.data.cc.cc = 1;
+    cc.data.cc.value = 127;
+    (void)midi_ump_encode_midi2(&cc, 0, w);
+    expect_u32("cc w0", w[0], 0x40BF0100u);
+    expect_u32("cc max", w[1], 0xFFFFFFFFu);
+
+    midi_msg_t pc = {.type = MIDI_MSG_PROGRAM_CHANGE, .channel = 1};
+    pc.data.program.program = 5;
+    (void)midi_ump_encode_midi2(&pc, 0, w);
+    expect_u32("program w0", w[0], 0x40C10000u);
+    expect_u32("program w1", w[1], 0x05000000u);
+}
+
+static void check_midi1(void)
+{
+    uint32_t w = 0;
+    const uint8_t note[] = {0x90, 0x40, 0x7F};
+    expect_u32("midi1 note words", (uint32_t)midi_ump_encode_midi1_bytes(note, 3, 1, &w), 1);
+    expect_u32("midi1 note", w, 0x2190407Fu);
+
+    const uint8_t clock[] = {0xF8};
+    (void)midi_ump_encode_midi1_bytes(clock, 1, 0, &w);
+    expect_u32("system clock", w, 0x10F80000u);
+
+    const uint8_t sysex[] = {0xF0, 0x7E, 0xF7};
+    expect_u32("sysex rejected", (uint32_t)midi_ump_encode_midi1_bytes(sysex, 3, 0, &w), 0);
+}
+
+static void check_input(void)
+{
+    uint8_t b[MIDI_UMP_MIDI1_BYTES_MAX];
+    size_t n;
+
+    n = to_midi1(0x40923C00u, 0xFFFF0000u, b);
+    expect_bytes("midi2 note on", b, n, (const uint8_t[]){0x92, 0x3C, 0x7F}, 3);
+    n = to_midi1(0x40923C00u, 0x00000000u, b);
+    expect_bytes("midi2 note on vel 0 stays on", b, n, (const uint8_t[]){0x92, 0x3C, 0x01}, 3);
+    n = to_midi1(0x40823C00u, 0x80000000u, b);
+    expect_bytes("midi2 note off", b, n, (const uint8_t[]){0x82, 0x3C, 0x40}, 3);
+    n = to_midi1(0x40B50700u, 0xFFFFFFFFu, b);
+    expect_bytes("midi2 cc", b, n, (const uint8_t[]){0xB5, 0x07, 0x7F}, 3);
+    n = to_midi1(0x40E00000u, 0x80000000u, b);
+    expect_bytes("midi2 pitch bend center", b, n, (const uint8_t[]){0xE0, 0x00, 0x40}, 3);
+    n = to_midi1(0x40C10000u, 0x05000000u, b);
+    expect_bytes("midi2 program", b, n, (const uint8_t[]){0xC1, 0x05}, 2);
+    n = to_midi1(0x40D00000u, 0xFFFFFFFFu, b);
+    expect_bytes("midi2 channel pressure", b, n, (const uint8_t[]){0xD0, 0x7F}, 2);
+    n = to_midi1(0x40003C00u, 0x12345678u, b);
+    expect_bytes("midi2 per-note controller dropped", b, n, NULL, 0);
+
+    /* MIDI 1.0 UMPs: pad bytes of short messages must not reach the parser */
+    n = to_midi1(0x20C30500u, 0, b);
+    expect_bytes("midi1 program", b, n, (const uint8_t[]){0xC3, 0x05}, 2);
+    n = to_midi1(0x10F80000u, 0, b);
+    expect_bytes("system clock", b, n, (const uint8_t[]){0xF8}, 1);
+    n = to_midi1(0x10F21020u, 0, b);
+    expect_bytes("song position", b, n, (const uint8_t[]){0xF2, 0x10, 0x20}, 3);
+
+    /* SysEx7: complete, then start / continue / end */
+    n = to_midi1(0x30037E7Fu, 0x09000000u, b);
+    expect_bytes("sysex complete", b, n, (const uint8_t[]){0xF0, 0x7E, 0x7F, 0x09, 0xF7}, 5);
+    n = to_midi1(0x30160102u, 0x03040506u, b);
+    expect_bytes("sysex start", b, n, (const uint8_t[]){0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06}, 7);
+    n = to_midi1(0x30220708u, 0x00000000u, b);
+    expect_bytes("sysex continue", b, n, (const uint8_t[]){0x07, 0x08}, 2);
+    n = to_midi1(0x30310900u, 0x00000000u, b);
+    expect_bytes("sysex end", b, n, (const uint8_t[]){0x09, 0xF7}, 2);
+
+    n = to_midi1(0x00000000u, 0, b);
+    expect_bytes("utility dropped", b, n, NULL, 0);
+
+    /* Up then down gives the MIDI 1.0 value back */
+    int bad = 0;
+    for (uint32_t v = 0; v <= 16383u; ++v) {
+        midi_msg_t m = {.type = MIDI_MSG_PITCH_BEND, .channel = 0};
+        m.data.pitchbend.value = (uint16_t)v;
+        uint32_t w[MIDI_UMP_MAX_WORDS];
+        (void)midi_ump_encode_midi2(&m, 0, w);
+        n = midi_ump_to_midi1_bytes(w, 2, b);
+        if (n != 3 || (uint32_t)(b[1] | (b[2] << 7)) != v) bad++;
+    }
+    for (uint32_t v = 1; v <= 127u; ++v) {
+        midi_msg_t m = {.type = MIDI_MSG_NOTE_ON, .channel = 0};
+        m.data.note.note = 60;
+        m.data.note.velocity = (uint8_t)v;
+        uint32_t w[MIDI_UMP_MAX_WORDS];
+        (void)midi_ump_encode_midi2(&m, 0, w);
+        n = midi_ump_to_midi1_bytes(w, 2, b);
+        if (n != 3 || b[2] != v) bad++;
+    }
+    expect_u32("14-bit bend and 7-bit velocity round trip (mismatches)", (uint32_t)bad, 0);
+}
+
+int main(void)
+{
+    check_scale();
+    check_midi2();
+    check_midi1();
+    check_input();
+
+    printf("{\"check\":\"ump\",\"checks\":%d,\"failed\":%d}\n", s_checks, s_failed);
+    return s_failed ? 1 : 0;
+}
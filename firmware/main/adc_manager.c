@@ -1,14 +1,39 @@
 #include "adc_manager.h"
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_continuous.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "adc_quiet.h"
+#include "board_pins.h"
+#include "matrix_scan.h"
+#include "task_layout.h"
+
+/* Defensive defaults for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_ADC_CONTINUOUS
+#define CONFIG_EMIUET_ADC_CONTINUOUS 1
+#endif
+#ifndef CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ
+#define CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ 20000
+#endif
+#ifndef CONFIG_EMIUET_ADC_QUIET
+#define CONFIG_EMIUET_ADC_QUIET 1
+#endif
+#ifndef CONFIG_EMIUET_ADC_QUIET_GUARD_US
+#define CONFIG_EMIUET_ADC_QUIET_GUARD_US 30
+#endif
 
 static const char *TAG = "adc_manager";
 
@@ -26,9 +51,71 @@ static bool s_cali2_ok;
 
 /* Track which channels have been configured per unit.
  * Channel indices are small (<= 9 on ESP32-S3), so a bitmask works.
+ * Set under s_lock, tested without it.
  */
-static uint32_t s_cfg_mask_unit1;
-static uint32_t s_cfg_mask_unit2;
+static _Atomic uint32_t s_cfg_mask_unit1;
+static _Atomic uint32_t s_cfg_mask_unit2;
+
+/* =========================================================
+ * Quiet windows (adc_quiet.h)
+ *
+ * The LED PWM phase comes from adc_manager_set_pwm_phase(), the row-drive
+ * phase from the matrix scanner. Streamed conversions cannot be placed
+ * (the DMA engine free-runs), so the ones that land near an edge are left
+ * out of the frame mean; oneshot conversions (battery sense) wait for a
+ * quiet window before they start.
+ * ========================================================= */
+
+/* Longest a oneshot read waits for a quiet window: past a scan burst */
+#define ADC_QUIET_ONESHOT_WAIT_US 1000
+/* Conservative oneshot conversion time (sample + 12-bit conversion) */
+#define ADC_QUIET_ONESHOT_CONV_US 20
+
+static _Atomic uint32_t s_pwm_period_ns;
+static _Atomic uint32_t s_pwm_phase_ns;
+static _Atomic uint32_t s_pwm_high_ns;
+
+static void quiet_snapshot(adc_quiet_t *q)
+{
+    *q = (adc_quiet_t){
+        .guard_us = CONFIG_EMIUET_ADC_QUIET_GUARD_US,
+        .pwm_period_ns = atomic_load_explicit(&s_pwm_period_ns, memory_order_relaxed),
+        .pwm_phase_ns = atomic_load_explicit(&s_pwm_phase_ns, memory_order_relaxed),
+        .pwm_high_ns = atomic_load_explicit(&s_pwm_high_ns, memory_order_relaxed),
+    };
+    matrix_scan_phase_t ph;
+    if (matrix_scan_get_phase(&ph)) {
+        for (int k = 0; k < 2; ++k) {
+            q->drive_from_us[k] = ph.from_us[k];
+            q->drive_until_us[k] = ph.until_us[k];
+        }
+        q->drive_n = ph.n;
+        q->driving = ph.driving;
+    }
+}
+
+/* Until a whole conversion fits before the next edge window, bounded.
+ * `q` is the caller's snapshot taken at *q_us (-1: none yet); it is
+ * retaken once older than the slack, so a batch of fast reads shares it.
+ */
+static void oneshot_wait_quiet(adc_quiet_t *q, int64_t *q_us)
+{
+#if CONFIG_EMIUET_ADC_QUIET
+    for (uint32_t waited = 0;; waited += 2) {
+        const int64_t now_us = esp_timer_get_time();
+        if (*q_us < 0 || now_us - *q_us > ADC_QUIET_SLACK_US) {
+            quiet_snapshot(q);
+            *q_us = now_us;
+        }
+        if (adc_quiet_span(q, now_us * 1000, ADC_QUIET_ONESHOT_CONV_US * 1000u)) return;
+        if (waited >= ADC_QUIET_ONESHOT_WAIT_US) return;
+        esp_rom_delay_us(2);
+    }
+#else
+    (void)q;
+    (void)q_us;
+#endif
+}
 
 static adc_oneshot_unit_handle_t unit_handle_for(adc_unit_t unit)
 {
@@ -47,8 +134,8 @@ static bool ensure_channel_configured_locked(adc_unit_t unit, adc_channel_t ch)
     adc_oneshot_unit_handle_t handle = unit_handle_for(unit);
     if (!handle) return false;
 
-    uint32_t *mask = (unit == ADC_UNIT_1) ? &s_cfg_mask_unit1 : &s_cfg_mask_unit2;
-    if ((uint32_t)ch < 32U && ((*mask) & (1U << (uint32_t)ch))) {
+    _Atomic uint32_t *mask = (unit == ADC_UNIT_1) ? &s_cfg_mask_unit1 : &s_cfg_mask_unit2;
+    if ((uint32_t)ch < 32U && (atomic_load(mask) & (1U << (uint32_t)ch))) {
         return true;
     }
 
@@ -64,11 +151,285 @@ static bool ensure_channel_configured_locked(adc_unit_t unit, adc_channel_t ch)
     }
 
     if ((uint32_t)ch < 32U) {
-        (*mask) |= (1U << (uint32_t)ch);
+        (void)atomic_fetch_or(mask, 1U << (uint32_t)ch);
     }
     return true;
 }
 
+/* =========================================================
+ * Continuous (DMA) sampling
+ *
+ * The slider pins (all ADC1) are converted round-robin by the ADC's DMA
+ * engine at CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ. Each completed frame wakes
+ * a reader task that averages the frame per channel and publishes the
+ * result in one atomic word, so reading a slider is a load: no lock, no
+ * conversion wait, and a higher rate costs no CPU per read.
+ *
+ * The task also keeps running per-channel sums and counts (under a
+ * sequence counter) so adc_manager_read_fine() can decimate every
+ * conversion since the previous read into one oversampled value.
+ *
+ * ADC1 then belongs to the DMA driver; ADC2 (battery sense) stays on
+ * oneshot, as ADC2 has no DMA mode on the ESP32-S3.
+ *
+ * Conversion times: the frame-done ISR stamps the clock and counts
+ * conversions; the task counts what it reads, so each conversion's start
+ * is the stamp minus the conversions behind it, in sample periods. A
+ * pool overflow (the task fell behind) breaks that count: frames go
+ * ungated until the next drain resynchronizes it.
+ * ========================================================= */
+
+#define ADC_CONT_CH_MAX     10
+#define ADC_CONT_PINS       3
+/* Frames complete at >= 1 kHz so a frame listener (slider task) sees a
+ * move within a millisecond: 18 conversions (0.9 ms) at 20 kHz.
+ */
+#define ADC_CONT_FRAME_MIN_HZ 1000
+#define ADC_CONT_FRAME_CONV                                                                                            \
+    ((CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ / ADC_CONT_FRAME_MIN_HZ / ADC_CONT_PINS) > 0                                   \
+         ? (CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ / ADC_CONT_FRAME_MIN_HZ / ADC_CONT_PINS) * ADC_CONT_PINS                 \
+         : ADC_CONT_PINS)
+#define ADC_CONT_FRAME_BYTES (ADC_CONT_FRAME_CONV * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_CONT_CONV_NS     (1000000000u / CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ)
+
+static adc_continuous_handle_t s_cont;
+static TaskHandle_t s_cont_task;
+static uint32_t s_cont_mask; /* ADC1 channels in the pattern */
+static _Atomic(TaskHandle_t) s_frame_listener;
+static _Atomic int s_cont_raw[ADC_CONT_CH_MAX] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+/* Running totals (wrap freely; readers take differences). Odd seq = update in progress. */
+static _Atomic uint32_t s_cont_seq;
+static _Atomic uint32_t s_cont_sum[ADC_CONT_CH_MAX];
+static _Atomic uint32_t s_cont_cnt[ADC_CONT_CH_MAX];
+/* adc_manager_read_fine() window, owned by the one reader per pin */
+static uint32_t s_fine_sum[ADC_CONT_CH_MAX];
+static uint32_t s_fine_cnt[ADC_CONT_CH_MAX];
+static uint16_t s_fine_last[ADC_CONT_CH_MAX];
+/* Frame-done stamp (low 32 bits, us) and conversions done, from the ISR; odd seq = update in progress */
+static _Atomic uint32_t s_done_seq;
+static _Atomic uint32_t s_done_us;
+static _Atomic uint32_t s_done_conv;
+static _Atomic uint32_t s_pool_ovf;
+
+static bool adc_cont_on_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user)
+{
+    (void)handle;
+    (void)user;
+    const uint32_t now = (uint32_t)esp_timer_get_time();
+    (void)atomic_fetch_add_explicit(&s_done_seq, 1u, memory_order_relaxed);
+    atomic_store_explicit(&s_done_us, now, memory_order_release);
+    atomic_store_explicit(&s_done_conv,
+                          atomic_load_explicit(&s_done_conv, memory_order_relaxed) +
+                              edata->size / SOC_ADC_DIGI_RESULT_BYTES,
+                          memory_order_release);
+    (void)atomic_fetch_add_explicit(&s_done_seq, 1u, memory_order_release);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_cont_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool adc_cont_on_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user)
+{
+    (void)handle;
+    (void)edata;
+    (void)user;
+    (void)atomic_fetch_add_explicit(&s_pool_ovf, 1u, memory_order_relaxed);
+    return false;
+}
+
+/* Frame mean per channel: a box filter over ~CONV/channels samples, minus
+ * the lowest and highest conversion, so a single-conversion spike never
+ * reaches the sliders (no median stage, and no frames of delay, needed).
+ * With `end_ns` known (>= 0, the end of the last conversion) conversions
+ * outside the quiet windows are left out, unless that leaves a channel
+ * with none.
+ */
+static void adc_cont_publish(const uint8_t *buf, uint32_t len, int64_t end_ns, const adc_quiet_t *q)
+{
+    uint32_t sum[ADC_CONT_CH_MAX] = {0};
+    uint16_t cnt[ADC_CONT_CH_MAX] = {0};
+    uint16_t lo[ADC_CONT_CH_MAX], hi[ADC_CONT_CH_MAX];
+    /* the same over the quiet conversions only */
+    uint32_t qsum[ADC_CONT_CH_MAX] = {0};
+    uint16_t qcnt[ADC_CONT_CH_MAX] = {0};
+    uint16_t qlo[ADC_CONT_CH_MAX], qhi[ADC_CONT_CH_MAX];
+    const uint32_t n = len / SOC_ADC_DIGI_RESULT_BYTES;
+    for (uint32_t i = 0; i < n; ++i) {
+        const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&buf[i * SOC_ADC_DIGI_RESULT_BYTES];
+        const uint32_t ch = d->type2.channel;
+        if (d->type2.unit != 0 || ch >= ADC_CONT_CH_MAX) continue;
+        const uint16_t v = (uint16_t)d->type2.data;
+        if (cnt[ch] == 0 || v < lo[ch]) lo[ch] = v;
+        if (cnt[ch] == 0 || v > hi[ch]) hi[ch] = v;
+        sum[ch] += v;
+        cnt[ch]++;
+        if (end_ns < 0 || !adc_quiet_at(q, end_ns - (int64_t)(n - i) * ADC_CONT_CONV_NS)) continue;
+        if (qcnt[ch] == 0 || v < qlo[ch]) qlo[ch] = v;
+        if (qcnt[ch] == 0 || v > qhi[ch]) qhi[ch] = v;
+        qsum[ch] += v;
+        qcnt[ch]++;
+    }
+    for (uint32_t ch = 0; ch < ADC_CONT_CH_MAX; ++ch) {
+        if (cnt[ch] == 0) continue;
+        if (qcnt[ch] > 0) {
+            sum[ch] = qsum[ch];
+            cnt[ch] = qcnt[ch];
+            lo[ch] = qlo[ch];
+            hi[ch] = qhi[ch];
+        }
+        if (cnt[ch] >= 4) {
+            sum[ch] -= (uint32_t)lo[ch] + hi[ch];
+            cnt[ch] -= 2;
+        }
+        atomic_store_explicit(&s_cont_raw[ch], (int)((sum[ch] + cnt[ch] / 2u) / cnt[ch]), memory_order_relaxed);
+    }
+
+    /* seqlock without fences: release stores keep the odd seq ahead of the data */
+    (void)atomic_fetch_add_explicit(&s_cont_seq, 1u, memory_order_relaxed);
+    for (uint32_t ch = 0; ch < ADC_CONT_CH_MAX; ++ch) {
+        if (cnt[ch] == 0) continue;
+        atomic_store_explicit(&s_cont_sum[ch],
+                              atomic_load_explicit(&s_cont_sum[ch], memory_order_relaxed) + sum[ch],
+                              memory_order_release);
+        atomic_store_explicit(&s_cont_cnt[ch],
+                              atomic_load_explicit(&s_cont_cnt[ch], memory_order_relaxed) + cnt[ch],
+                              memory_order_release);
+    }
+    (void)atomic_fetch_add_explicit(&s_cont_seq, 1u, memory_order_release);
+}
+
+/* End of conversion number `read_conv` (s_done_conv's count), in ns on
+ * the full clock: the latest stamp minus the conversions done after it.
+ * -1 when the count cannot be trusted.
+ */
+static int64_t adc_cont_end_ns(uint32_t read_conv)
+{
+    uint32_t seq, stamp, done;
+    do {
+        seq = atomic_load_explicit(&s_done_seq, memory_order_acquire);
+        stamp = atomic_load_explicit(&s_done_us, memory_order_acquire);
+        done = atomic_load_explicit(&s_done_conv, memory_order_acquire);
+    } while ((seq & 1u) || seq != atomic_load_explicit(&s_done_seq, memory_order_relaxed));
+
+    const uint32_t behind = done - read_conv;
+    if (done == 0 || behind > ADC_CONT_FRAME_CONV * 4u) return -1; /* past the pool: count is off */
+    const int64_t now = esp_timer_get_time();
+    const int64_t stamp_us = now - (int64_t)(uint32_t)((uint32_t)now - stamp);
+    return stamp_us * 1000 - (int64_t)behind * ADC_CONT_CONV_NS;
+}
+
+static void adc_cont_task(void *arg)
+{
+    (void)arg;
+    uint8_t buf[ADC_CONT_FRAME_BYTES];
+    uint32_t read_conv = 0; /* in s_done_conv's count */
+    uint32_t seen_ovf = 0;
+    bool timed = false;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        adc_quiet_t q;
+        quiet_snapshot(&q);
+        bool fresh = false;
+        while (1) {
+            const uint32_t done = atomic_load_explicit(&s_done_conv, memory_order_acquire);
+            uint32_t len = 0;
+            if (adc_continuous_read(s_cont, buf, sizeof(buf), &len, 0) != ESP_OK || len == 0) {
+                /* drained: every conversion up to `done` was read or dropped */
+                read_conv = done;
+                seen_ovf = atomic_load_explicit(&s_pool_ovf, memory_order_relaxed);
+                timed = true;
+                break;
+            }
+            read_conv += len / SOC_ADC_DIGI_RESULT_BYTES;
+            if (atomic_load_explicit(&s_pool_ovf, memory_order_relaxed) != seen_ovf) timed = false;
+            const bool gate = CONFIG_EMIUET_ADC_QUIET && timed;
+            adc_cont_publish(buf, len, gate ? adc_cont_end_ns(read_conv) : -1, &q);
+            fresh = true;
+        }
+        const TaskHandle_t listener = atomic_load_explicit(&s_frame_listener, memory_order_acquire);
+        if (fresh && listener) (void)xTaskNotifyGive(listener);
+    }
+}
+
+static bool adc_cont_start(void)
+{
+    static const gpio_num_t pins[ADC_CONT_PINS] = {PIN_SLIDER_PB, PIN_SLIDER_MOD, PIN_SLIDER_VEL};
+    adc_digi_pattern_config_t pattern[ADC_CONT_PINS];
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < ADC_CONT_PINS; ++i) {
+        adc_unit_t unit;
+        adc_channel_t ch;
+        if (adc_continuous_io_to_channel((int)pins[i], &unit, &ch) != ESP_OK || unit != ADC_UNIT_1 ||
+            (uint32_t)ch >= ADC_CONT_CH_MAX) {
+            ESP_LOGW(TAG, "gpio %d is not an ADC1 pin; continuous mode off", (int)pins[i]);
+            return false;
+        }
+        pattern[i] = (adc_digi_pattern_config_t){
+            .atten = ADC_ATTEN_DB_12,
+            .channel = (uint8_t)ch,
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+        mask |= 1u << (uint32_t)ch;
+    }
+
+    const adc_continuous_handle_cfg_t hcfg = {
+        .max_store_buf_size = ADC_CONT_FRAME_BYTES * 4,
+        .conv_frame_size = ADC_CONT_FRAME_BYTES,
+        .flags = {.flush_pool = 1}, /* only the newest frames matter */
+    };
+    const adc_continuous_config_t ccfg = {
+        .pattern_num = ADC_CONT_PINS,
+        .adc_pattern = pattern,
+        .sample_freq_hz = CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    const adc_continuous_evt_cbs_t cbs = {.on_conv_done = adc_cont_on_done, .on_pool_ovf = adc_cont_on_ovf};
+
+    esp_err_t err = adc_continuous_new_handle(&hcfg, &s_cont);
+    if (err == ESP_OK) err = adc_continuous_config(s_cont, &ccfg);
+    if (err == ESP_OK) err = adc_continuous_register_event_callbacks(s_cont, &cbs, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "adc_continuous setup failed: %s", esp_err_to_name(err));
+        if (s_cont) (void)adc_continuous_deinit(s_cont);
+        s_cont = NULL;
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(adc_cont_task, "adc_cont", TASK_ADC_CONT_STACK, NULL, TASK_ADC_CONT_PRIO, &s_cont_task,
+                                TASK_ADC_CONT_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "adc_cont task create failed");
+        (void)adc_continuous_deinit(s_cont);
+        s_cont = NULL;
+        return false;
+    }
+    err = adc_continuous_start(s_cont);
+    if (err != ESP_OK) {
+        /* the reader task stays parked on its notification */
+        ESP_LOGW(TAG, "adc_continuous_start failed: %s", esp_err_to_name(err));
+        (void)adc_continuous_deinit(s_cont);
+        s_cont = NULL;
+        return false;
+    }
+
+    /* First frame before anyone reads (a few ms), so sliders never see a gap */
+    for (int i = 0; i < 20; ++i) {
+        bool ready = true;
+        for (uint32_t ch = 0; ch < ADC_CONT_CH_MAX; ++ch) {
+            if ((mask & (1u << ch)) && atomic_load(&s_cont_raw[ch]) < 0) ready = false;
+        }
+        if (ready) break;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    s_cont_mask = mask;
+    ESP_LOGI(TAG, "continuous ADC1 mask=0x%03lx at %d Hz, quiet guard %d us", (unsigned long)mask,
+             CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ, CONFIG_EMIUET_ADC_QUIET ? CONFIG_EMIUET_ADC_QUIET_GUARD_US : -1);
+    return true;
+}
+
 static void try_init_cali_for_unit(adc_unit_t unit, adc_cali_handle_t *out_handle, bool *out_ok)
 {
     *out_ok = false;
@@ -108,7 +469,9 @@ bool adc_manager_init(void)
         .ulp_mode = ADC_ULP_MODE_DISABLE,
     };
 
-    esp_err_t err1 = adc_oneshot_new_unit(&init1, &s_unit1);
+    /* ADC1 goes either to the DMA driver (sliders) or to oneshot */
+    const bool cont = CONFIG_EMIUET_ADC_CONTINUOUS ? adc_cont_start() : false;
+    esp_err_t err1 = cont ? ESP_OK : adc_oneshot_new_unit(&init1, &s_unit1);
     esp_err_t err2 = adc_oneshot_new_unit(&init2, &s_unit2);
 
     if (err1 != ESP_OK || err2 != ESP_OK) {
@@ -134,9 +497,45 @@ bool adc_manager_is_enabled(void)
     return s_enabled;
 }
 
-esp_err_t adc_manager_read_raw(gpio_num_t gpio, int *out_raw)
+bool adc_manager_is_streamed(gpio_num_t gpio)
 {
-    if (!out_raw) return ESP_ERR_INVALID_ARG;
+    adc_unit_t unit;
+    adc_channel_t ch;
+    if (s_cont_mask == 0 || adc_oneshot_io_to_channel((int)gpio, &unit, &ch) != ESP_OK) return false;
+    return unit == ADC_UNIT_1 && (s_cont_mask & (1u << (uint32_t)ch)) != 0;
+}
+
+uint32_t adc_manager_frame_period_us(void)
+{
+    if (s_cont_mask == 0) return 0;
+    return (uint32_t)(((uint64_t)ADC_CONT_FRAME_CONV * 1000000u) / CONFIG_EMIUET_ADC_CONT_SAMPLE_HZ);
+}
+
+void adc_manager_set_pwm_phase(int64_t rise_us, uint32_t period_ns, uint32_t high_ns)
+{
+    const uint32_t phase = period_ns ? (uint32_t)(((uint64_t)rise_us * 1000u) % period_ns) : 0u;
+    /* Independent words: a frame may see a mix of old and new, which only
+     * gates it against one stale edge.
+     */
+    atomic_store_explicit(&s_pwm_phase_ns, phase, memory_order_relaxed);
+    atomic_store_explicit(&s_pwm_high_ns, high_ns, memory_order_relaxed);
+    atomic_store_explicit(&s_pwm_period_ns, period_ns, memory_order_relaxed);
+}
+
+void adc_manager_set_frame_listener(TaskHandle_t task)
+{
+    atomic_store_explicit(&s_frame_listener, task, memory_order_release);
+}
+
+static bool channel_configured(adc_unit_t unit, adc_channel_t ch)
+{
+    const uint32_t mask = atomic_load(unit == ADC_UNIT_1 ? &s_cfg_mask_unit1 : &s_cfg_mask_unit2);
+    return (uint32_t)ch < 32U && (mask & (1U << (uint32_t)ch)) != 0;
+}
+
+esp_err_t adc_manager_chan_open(gpio_num_t gpio, adc_chan_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
     if (!s_inited) {
         (void)adc_manager_init();
     }
@@ -149,64 +548,142 @@ esp_err_t adc_manager_read_raw(gpio_num_t gpio, int *out_raw)
         return err;
     }
 
-    if (xSemaphoreTake(s_lock, portMAX_DELAY) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
-    }
-
-    bool ok = ensure_channel_configured_locked(unit, ch);
-    if (!ok) {
+    const bool streamed = unit == ADC_UNIT_1 && (s_cont_mask & (1u << (uint32_t)ch)) != 0;
+    if (!streamed && !channel_configured(unit, ch)) {
+        if (xSemaphoreTake(s_lock, portMAX_DELAY) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        const bool ok = ensure_channel_configured_locked(unit, ch);
         xSemaphoreGive(s_lock);
-        return ESP_FAIL;
+        if (!ok) return ESP_FAIL;
     }
 
-    adc_oneshot_unit_handle_t handle = unit_handle_for(unit);
-    int raw = 0;
-    err = adc_oneshot_read(handle, ch, &raw);
-    xSemaphoreGive(s_lock);
+    const bool cali_ok = (unit == ADC_UNIT_1) ? s_cali1_ok : s_cali2_ok;
+    *out = (adc_chan_t){
+        .gpio = gpio,
+        .unit = unit,
+        .channel = ch,
+        .cali = cali_ok ? ((unit == ADC_UNIT_1) ? s_cali1 : s_cali2) : NULL,
+        .streamed = streamed,
+        .open = true,
+    };
+    return ESP_OK;
+}
 
-    if (err != ESP_OK) {
-        return err;
+static int raw_to_mv(const adc_chan_t *c, int raw)
+{
+    int mv = 0;
+    if (c->cali && adc_cali_raw_to_voltage(c->cali, raw, &mv) == ESP_OK) {
+        return mv;
     }
 
-    *out_raw = raw;
-    return ESP_OK;
+    /* Fallback approximation: 12-bit raw to 0..3300mV.
+     * (Calibration is recommended for accuracy.)
+     */
+    if (raw < 0) raw = 0;
+    if (raw > 4095) raw = 4095;
+    return (raw * 3300) / 4095;
 }
 
-esp_err_t adc_manager_read_mv(gpio_num_t gpio, int *out_mv)
+esp_err_t adc_manager_chan_read(const adc_chan_t *chans, size_t count, size_t rounds, int *out_raw, int *out_mv)
 {
-    if (!out_mv) return ESP_ERR_INVALID_ARG;
+    if (!chans || !out_raw || count == 0) return ESP_ERR_INVALID_ARG;
 
-    adc_unit_t unit;
-    adc_channel_t ch;
-    esp_err_t err = adc_oneshot_io_to_channel((int)gpio, &unit, &ch);
-    if (err != ESP_OK) {
-        return err;
+    bool oneshot = false;
+    for (size_t k = 0; k < count; ++k) {
+        if (!chans[k].open) return ESP_ERR_INVALID_ARG;
+        oneshot |= !chans[k].streamed;
     }
 
-    int raw = 0;
-    err = adc_manager_read_raw(gpio, &raw);
+    /* One lock for every oneshot conversion of the batch */
+    if (oneshot && xSemaphoreTake(s_lock, portMAX_DELAY) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    adc_quiet_t q;
+    int64_t q_us = -1;
+    esp_err_t err = ESP_OK;
+    for (size_t r = 0; r < rounds && err == ESP_OK; ++r) {
+        for (size_t k = 0; k < count && err == ESP_OK; ++k) {
+            const adc_chan_t *c = &chans[k];
+            int *dst = &out_raw[r * count + k];
+            if (c->streamed) {
+                *dst = atomic_load_explicit(&s_cont_raw[c->channel], memory_order_relaxed);
+                if (*dst < 0) err = ESP_ERR_INVALID_STATE; /* no frame yet */
+                continue;
+            }
+            oneshot_wait_quiet(&q, &q_us);
+            err = adc_oneshot_read(unit_handle_for(c->unit), c->channel, dst);
+        }
+    }
+    if (oneshot) {
+        xSemaphoreGive(s_lock);
+    }
     if (err != ESP_OK) {
         return err;
     }
 
-    int mv = 0;
-    adc_cali_handle_t cali = (unit == ADC_UNIT_1) ? s_cali1 : s_cali2;
-    bool cali_ok = (unit == ADC_UNIT_1) ? s_cali1_ok : s_cali2_ok;
-
-    if (cali_ok) {
-        err = adc_cali_raw_to_voltage(cali, raw, &mv);
-        if (err == ESP_OK) {
-            *out_mv = mv;
-            return ESP_OK;
+    /* Calibration outside the lock, in one pass */
+    if (out_mv) {
+        for (size_t i = 0; i < rounds * count; ++i) {
+            out_mv[i] = raw_to_mv(&chans[i % count], out_raw[i]);
         }
     }
+    return ESP_OK;
+}
 
-    /* Fallback approximation: 12-bit raw to 0..3300mV.
-     * (Calibration is recommended for accuracy.)
-     */
-    if (raw < 0) raw = 0;
-    if (raw > 4095) raw = 4095;
-    mv = (raw * 3300) / 4095;
-    *out_mv = mv;
+esp_err_t adc_manager_chan_read_fine(const adc_chan_t *c, uint16_t *out_fine)
+{
+    if (!c || !out_fine || !c->open) return ESP_ERR_INVALID_ARG;
+    if (!c->streamed) return ESP_ERR_NOT_SUPPORTED;
+    const uint32_t ch = c->channel;
+
+    uint32_t seq, sum, cnt;
+    do {
+        seq = atomic_load_explicit(&s_cont_seq, memory_order_acquire);
+        sum = atomic_load_explicit(&s_cont_sum[ch], memory_order_acquire);
+        cnt = atomic_load_explicit(&s_cont_cnt[ch], memory_order_acquire);
+    } while ((seq & 1u) || seq != atomic_load_explicit(&s_cont_seq, memory_order_relaxed));
+
+    const uint32_t n = cnt - s_fine_cnt[ch];
+    if (n == 0) {
+        /* no conversion since the last read (or none yet) */
+        if (cnt == 0) return ESP_ERR_INVALID_STATE;
+        *out_fine = s_fine_last[ch];
+        return ESP_OK;
+    }
+    const uint32_t d = sum - s_fine_sum[ch];
+    s_fine_sum[ch] = sum;
+    s_fine_cnt[ch] = cnt;
+    s_fine_last[ch] = (uint16_t)((((uint64_t)d << 4) + n / 2u) / n);
+    *out_fine = s_fine_last[ch];
     return ESP_OK;
 }
+
+/* Per-GPIO entry points: resolve, then one read */
+
+esp_err_t adc_manager_read_raw(gpio_num_t gpio, int *out_raw)
+{
+    if (!out_raw) return ESP_ERR_INVALID_ARG;
+    adc_chan_t c;
+    const esp_err_t err = adc_manager_chan_open(gpio, &c);
+    return (err == ESP_OK) ? adc_manager_chan_read(&c, 1, 1, out_raw, NULL) : err;
+}
+
+esp_err_t adc_manager_read_fine(gpio_num_t gpio, uint16_t *out_fine)
+{
+    if (!out_fine) return ESP_ERR_INVALID_ARG;
+    if (!adc_manager_is_streamed(gpio)) return ESP_ERR_NOT_SUPPORTED;
+    adc_chan_t c;
+    const esp_err_t err = adc_manager_chan_open(gpio, &c);
+    return (err == ESP_OK) ? adc_manager_chan_read_fine(&c, out_fine) : err;
+}
+
+esp_err_t adc_manager_read_mv(gpio_num_t gpio, int *out_mv)
+{
+    if (!out_mv) return ESP_ERR_INVALID_ARG;
+    adc_chan_t c;
+    esp_err_t err = adc_manager_chan_open(gpio, &c);
+    int raw = 0;
+    if (err == ESP_OK) err = adc_manager_chan_read(&c, 1, 1, &raw, out_mv);
+    return err;
+}
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "driver/gpio.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_oneshot.h"
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,7 +18,7 @@ extern "C" {
 /* Centralized ADC ownership for Emiuet.
  *
  * Rationale:
- * - Only this module creates adc_oneshot unit handles.
+ * - Only this module creates adc_oneshot / adc_continuous handles.
  * - Other modules (slider, OLED, etc.) only request reads.
  * - Eliminates boot-order dependent failures ("adc1 already in use").
  */
@@ -20,11 +26,79 @@ extern "C" {
 bool adc_manager_init(void);
 bool adc_manager_is_enabled(void);
 
+/* True when the pin is sampled continuously (DMA): reads are then a
+ * lock-free load of the latest frame mean and need no oversampling.
+ */
+bool adc_manager_is_streamed(gpio_num_t gpio);
+
+/* Streamed frames complete at >= 1 kHz; 0 when nothing is streamed. */
+uint32_t adc_manager_frame_period_us(void);
+
+/* Notify `task` (xTaskNotifyGive) after every completed frame, so slider
+ * logic can run per frame instead of on a timer. NULL stops it.
+ */
+void adc_manager_set_frame_listener(TaskHandle_t task);
+
+/* Noise-aware sampling (CONFIG_EMIUET_ADC_QUIET): a PWM output that couples
+ * into the analog inputs (the status LED) rises at rise_us (esp_timer
+ * clock) and every period_ns after, staying high for high_ns. Conversions
+ * near its edges, or near the matrix row-drive bursts, are left out of
+ * the streamed frame means; oneshot reads wait for a quiet window.
+ * Call again whenever the duty changes; period_ns == 0 forgets the PWM.
+ */
+void adc_manager_set_pwm_phase(int64_t rise_us, uint32_t period_ns, uint32_t high_ns);
+
+/* A GPIO resolved once to its ADC unit, channel and calibration, so
+ * repeated reads skip the lookup. Fill with adc_manager_chan_open();
+ * a zeroed one is not open. Plain data: copy it freely.
+ */
+typedef struct {
+    gpio_num_t gpio;
+    adc_unit_t unit;
+    adc_channel_t channel;
+    adc_cali_handle_t cali; /* NULL: linear approximation */
+    bool streamed;          /* reads are loads of the latest frame mean */
+    bool open;
+} adc_chan_t;
+
+/* Resolve `gpio` and configure its oneshot channel if it needs one. Fails
+ * for non-ADC pins, and for ADC1 pins that are not streamed while
+ * continuous mode owns ADC1.
+ */
+esp_err_t adc_manager_chan_open(gpio_num_t gpio, adc_chan_t *out);
+
+/* `rounds` reads of each of `count` channels, round-robin:
+ * out_raw[r * count + k] is channel k in round r. Every oneshot
+ * conversion of the batch runs under one lock acquisition (each still
+ * waits for a quiet window); streamed channels read the latest frame mean
+ * each round. out_mv (optional, same layout) gets millivolts, calibrated
+ * after the lock is released.
+ */
+esp_err_t adc_manager_chan_read(const adc_chan_t *chans, size_t count, size_t rounds, int *out_raw, int *out_mv);
+
+/* adc_manager_read_fine() on an open channel */
+esp_err_t adc_manager_chan_read_fine(const adc_chan_t *chan, uint16_t *out_fine);
+
+/* The per-GPIO reads below resolve the pin on every call; pins read
+ * often should keep an adc_chan_t instead.
+ */
+
 /* Read raw ADC code for a given GPIO (ADC-capable pin).
  * Uses adc_oneshot_io_to_channel() to map GPIO -> (unit, channel).
+ * Streamed pins return the latest published value without blocking;
+ * other ADC1 pins are not readable while continuous mode owns ADC1.
  */
 esp_err_t adc_manager_read_raw(gpio_num_t gpio, int *out_raw);
 
+/* Oversampled read of a streamed pin: the mean of every conversion since
+ * the previous call (decimation to the caller's poll rate), as a 16-bit
+ * code (12-bit raw << 4, fraction kept). At 20 kHz over three pins that
+ * is ~66 conversions per 10 ms (about 14 effective bits over the ADC
+ * noise), ~6 per 0.9 ms frame. One caller per pin: the call advances that pin's window.
+ * ESP_ERR_NOT_SUPPORTED for pins that are not streamed.
+ */
+esp_err_t adc_manager_read_fine(gpio_num_t gpio, uint16_t *out_fine);
+
 /* Read millivolts for a given GPIO.
  * Uses ADC calibration if available, otherwise a linear approximation.
  */
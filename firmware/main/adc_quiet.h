@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Quiet windows for ADC conversions
+ *
+ * The status LED PWM (GPIO6) and the matrix row drive couple into the
+ * slider and battery-sense traces (pinout-v3 §4.3). Each edge leaves a
+ * transient that the input RC (100 R + 0.1 uF, 10 us) needs a few time
+ * constants to settle, so a conversion is noisy when it starts within
+ *
+ *   [edge - ADC_QUIET_SLACK_US, edge + guard_us]
+ *
+ * of a PWM edge, or inside a row-drive burst widened the same way. The
+ * slack covers the error in a conversion's estimated time. Pure integer
+ * code: adc_manager uses it, the host spectrum bench replays it.
+ * ========================================================= */
+
+#define ADC_QUIET_SLACK_US 4
+
+typedef struct {
+    uint32_t guard_us;
+
+    /* PWM: rising edge where t_ns % period_ns == phase_ns, falling edge
+     * high_ns later. No edges when period_ns == 0, or the output is
+     * constant (high_ns == 0 or >= period_ns).
+     */
+    uint32_t pwm_period_ns;
+    uint32_t pwm_phase_ns;
+    uint32_t pwm_high_ns;
+
+    /* Row-drive bursts, latest first (matrix_scan_phase_t), low 32 bits of
+     * the microsecond clock.
+     */
+    uint32_t drive_from_us[2];
+    uint32_t drive_until_us[2];
+    uint8_t drive_n;
+    bool driving; /* burst 0 has not ended */
+} adc_quiet_t;
+
+/* A span starting `since_ns` after an edge (mod period) and lasting
+ * len_ns: does it touch that edge's window, or the next one's?
+ */
+static inline bool adc_quiet_near_edge(uint32_t since_ns, uint32_t period_ns, uint32_t guard_ns, uint32_t len_ns)
+{
+    return since_ns <= guard_ns || period_ns - since_ns <= ADC_QUIET_SLACK_US * 1000u + len_ns;
+}
+
+/* No edge window overlaps [t_ns, t_ns + len_ns]; len_ns well under the
+ * PWM period. One division and one modulo.
+ */
+static inline bool adc_quiet_span(const adc_quiet_t *q, int64_t t_ns, uint32_t len_ns)
+{
+    const uint32_t t_us = (uint32_t)(t_ns / 1000);
+    const uint32_t end_us = t_us + (len_ns + 999u) / 1000u;
+    for (uint8_t k = 0; k < q->drive_n && k < 2; ++k) {
+        const bool open = (k == 0) && q->driving;
+        if ((int32_t)(end_us - (q->drive_from_us[k] - ADC_QUIET_SLACK_US)) >= 0 &&
+            (open || (int32_t)(q->drive_until_us[k] + q->guard_us - t_us) >= 0)) {
+            return false;
+        }
+    }
+
+    const uint32_t period = q->pwm_period_ns;
+    if (period == 0 || q->pwm_high_ns == 0 || q->pwm_high_ns >= period) return true;
+    const uint32_t guard_ns = q->guard_us * 1000u;
+    /* t_ns >= 0 (time since boot) */
+    const uint32_t rise = (uint32_t)(((uint64_t)t_ns + period - q->pwm_phase_ns) % period);
+    const uint32_t fall = (rise >= q->pwm_high_ns) ? rise - q->pwm_high_ns : rise + period - q->pwm_high_ns;
+    return !adc_quiet_near_edge(rise, period, guard_ns, len_ns) && !adc_quiet_near_edge(fall, period, guard_ns, len_ns);
+}
+
+/* A conversion starting at t_ns */
+static inline bool adc_quiet_at(const adc_quiet_t *q, int64_t t_ns)
+{
+    return adc_quiet_span(q, t_ns, 0);
+}
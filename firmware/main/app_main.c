@@ -1,15 +1,41 @@
 
 #include <stdio.h>
 
+#include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "nvs_flash.h"
 
 #include "board_pins.h"
+#include "ui_buttons.h"
 #include "ui_led_status.h"
 #include "ui_oled.h"
 
 #include "matrix_midi_bridge.h"
+#include "midi_bench.h"
+#include "midi_sched.h"
+#include "rt_stats.h"
 #include "slider.h"
+#include "task_layout.h"
+
+static const char *TAG = "app_main";
+
+/* Default NVS partition, shared by every component that stores settings.
+ * A partition left by an older layout, or full, is erased: the usual
+ * ESP-IDF recovery, decided here for all of its users.
+ */
+static void nvs_init(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition stale (%s); erasing", esp_err_to_name(err));
+        err = nvs_flash_erase();
+        if (err == ESP_OK) err = nvs_flash_init();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS unavailable (%s); settings are not stored", esp_err_to_name(err));
+    }
+}
 
 static void board_late_init_task(void *arg)
 {
@@ -32,8 +58,22 @@ static void board_late_init_task(void *arg)
      * reacting to boot-time strapping states or keys held during boot.
      */
     matrix_midi_bridge_start(MATRIX_INITIAL_DISCARD_CYCLES);
+    /* Octave buttons act on the note map the bridge just built */
+    ui_buttons_start();
     /* Start slider polling task (pitch-bend) */
     slider_task_start();
+    /* Development only: latency histograms (no-op unless CONFIG_EMIUET_RT_STATS) */
+    rt_stats_start();
+
+#if CONFIG_EMIUET_MIDI_SCHED_BENCH
+    /* Development only: measure scheduler insert cost / dispatch lateness */
+    midi_sched_bench_run(CONFIG_EMIUET_MIDI_SCHED_POOL - 16, 2000, NULL);
+#endif
+
+#if CONFIG_EMIUET_MIDI_BENCH
+    /* Development only: key -> wire latency under chord storms */
+    midi_bench_run(CONFIG_EMIUET_MIDI_BENCH_REPEAT);
+#endif
 
     /* One-shot task */
     vTaskDelete(NULL);
@@ -43,6 +83,9 @@ void app_main(void)
 {
     printf("Emiuet firmware: boot\n");
 
+    /* Before any task that loads settings (slider calibration) */
+    nvs_init();
+
     /* Stage 1: safe pins only (LED/buttons/power status, etc.) */
     board_pins_init_early();
 
@@ -51,7 +94,8 @@ void app_main(void)
     oled_demo_start();
 
     /* Stage 2: matrix pins after boot delay (strapping pins safety) */
-    xTaskCreate(board_late_init_task, "board_late_init", 8192, NULL, 5, NULL);
+    xTaskCreatePinnedToCore(board_late_init_task, "board_late_init", TASK_BOARD_INIT_STACK, NULL,
+                            TASK_BOARD_INIT_PRIO, NULL, TASK_BOARD_INIT_CORE);
 
     // app_main can return; tasks keep running.
 }
@@ -0,0 +1,369 @@
+#include "input_pipeline.h"
+
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "midi_mpe.h"
+#include "midi_out.h"
+#include "note_map.h"
+
+/* Defensive default for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_GUITAR_MONO
+#define CONFIG_EMIUET_GUITAR_MONO 0
+#endif
+
+static const char *TAG = "input_pipeline";
+
+#define IP_DEFAULT_VELOCITY 100
+#define IP_ALL_ROUTES (MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART | MIDI_OUT_ROUTE_BLE)
+
+/* =========================================================
+ * State
+ *
+ * Each row's edges come from one producer at a time (scan task or that
+ * string's simulator), so per-row state is plain; state shared across
+ * rows is atomic.
+ *
+ * Releasing all notes (midi_out_panic(): panic, MPE toggle, mono, channel
+ * filters) only bumps s_epoch, from whichever task releases. Producers
+ * read it once per run and apply the reset themselves: held-note state
+ * tagged with an older epoch reads as empty, and a key pressed before
+ * the bump releases silently (its note-off already went out). A run that
+ * straddles a bump sends a note-off after each of its note-ons, which
+ * may have reached midi_out after the release.
+ * ========================================================= */
+
+static _Atomic uint32_t s_epoch;
+
+/* Held keys per (channel, note), one nibble each (at most 6 strings can
+ * hold the same pitch), four notes per word under a 16-bit epoch tag.
+ * In non-MPE mode all strings share a channel and the layout overlaps
+ * (row 0 col 0 == row 1 col 5 == E4): only the first press sends note-on
+ * and only the last release sends note-off. In MPE mode each string has
+ * its own channel, so counts stay 0/1.
+ */
+static _Atomic uint32_t s_note_refs[16][128 / 4];
+
+/* Note and channel each held key started with (note | channel << 8 |
+ * epoch << 16), so its release matches the note-on even if the octave,
+ * tuning or MPE layout changed in between.
+ */
+static _Atomic uint32_t s_key_sounding[MATRIX_NUM_ROWS][MATRIX_NUM_COLS];
+
+/* Per-string mono mode: held keys as seen by the pipeline (hardware and
+ * simulator edges alike) and the sounding column (-1 == none) per row,
+ * valid for the epoch in s_row_epoch.
+ */
+static _Atomic bool s_mono = CONFIG_EMIUET_GUITAR_MONO;
+static uint16_t s_row_keys[MATRIX_NUM_ROWS];
+static int8_t s_mono_col[MATRIX_NUM_ROWS];
+static uint16_t s_row_epoch[MATRIX_NUM_ROWS];
+
+static _Atomic(ip_velocity_fn_t) s_velocity_fn = NULL;
+
+static _Atomic uint16_t s_route_channels[MIDI_OUT_ROUTE_COUNT] = {0xFFFFu, 0xFFFFu, 0xFFFFu};
+
+#define IP_MAX_STAGES 8
+static ip_stage_fn_t s_stages[IP_MAX_STAGES];
+static size_t s_num_stages = 0;
+
+static inline uint32_t entry_pack(note_map_entry_t e, uint16_t epoch)
+{
+    return (uint32_t)e.note | ((uint32_t)e.channel << 8) | ((uint32_t)epoch << 16);
+}
+
+static inline note_map_entry_t entry_unpack(uint32_t v)
+{
+    return (note_map_entry_t){.note = (uint8_t)(v & 0xFFu), .channel = (uint8_t)((v >> 8) & 0xFFu)};
+}
+
+/* Tag a is newer than tag b (16-bit wrap) */
+static inline bool epoch_newer(uint16_t a, uint16_t b)
+{
+    return (int16_t)(uint16_t)(a - b) > 0;
+}
+
+/* Count one press/release of (ch, note) in `epoch`. True on a 0->1 or
+ * 1->0 edge. Counts of an older epoch read as 0; a run behind a newer
+ * epoch counts nothing (its presses are cut, its keys release silently).
+ */
+static bool note_ref_update(uint8_t ch, uint8_t note, bool pressed, uint16_t epoch)
+{
+    _Atomic uint32_t *w = &s_note_refs[ch & 0x0Fu][(note & 0x7Fu) >> 2];
+    const uint32_t shift = (uint32_t)(note & 0x03u) * 4u;
+    const uint32_t one = 1u << shift;
+
+    uint32_t cur = atomic_load(w);
+    uint32_t next;
+    uint32_t count;
+    do {
+        const uint16_t tag = (uint16_t)(cur >> 16);
+        if (epoch_newer(tag, epoch)) return false;
+        const uint32_t counts = (tag == epoch) ? (cur & 0xFFFFu) : 0u;
+        count = (counts >> shift) & 0x0Fu;
+        if (!pressed && count == 0) return false; /* release without a counted press */
+        next = ((uint32_t)epoch << 16) | (pressed ? counts + one : counts - one);
+    } while (!atomic_compare_exchange_weak(w, &cur, next));
+    return pressed ? count == 0 : count == 1;
+}
+
+/* Held-note reset posted by midi_out_panic() (release listener): runs on
+ * the releasing task, so it only moves the epoch.
+ */
+static void post_reset(void)
+{
+    (void)atomic_fetch_add(&s_epoch, 1u);
+}
+
+/* =========================================================
+ * Stages
+ * ========================================================= */
+
+/* Key tracking, out-of-range drop and (mono) per-string highest-fret
+ * priority. In mono mode a row's edges collapse into at most two key
+ * edges: press of the new sounding fret first, then release of the old
+ * one (legato), so later stages see ordinary presses and releases.
+ */
+static size_t stage_mono(ip_event_t *ev, size_t n)
+{
+    const uint16_t epoch = ev[0].epoch;
+    uint32_t rows = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const ip_event_t e = ev[i];
+        if (e.row >= MATRIX_NUM_ROWS || e.col >= MATRIX_NUM_COLS) continue;
+        if (s_row_epoch[e.row] != epoch) {
+            /* Released since this row's last run: nothing sounds */
+            s_row_epoch[e.row] = epoch;
+            s_mono_col[e.row] = -1;
+        }
+        if (e.pressed) {
+            s_row_keys[e.row] |= (uint16_t)(1u << e.col);
+        } else {
+            s_row_keys[e.row] &= (uint16_t)~(1u << e.col);
+        }
+        rows |= 1u << e.row;
+        ev[k++] = e;
+    }
+    if (!atomic_load_explicit(&s_mono, memory_order_relaxed)) return k;
+
+    /* input no longer needed: rows holds everything the rewrite uses */
+    k = 0;
+    for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+        if ((rows & (1u << r)) == 0) continue;
+        const uint32_t mask = s_row_keys[r];
+        const int col = mask ? 31 - __builtin_clz(mask) : -1;
+        const int old = s_mono_col[r];
+        if (col == old) continue;
+        if (col >= 0) ev[k++] = (ip_event_t){.row = (uint8_t)r, .col = (uint8_t)col, .pressed = true, .epoch = epoch};
+        if (old >= 0) ev[k++] = (ip_event_t){.row = (uint8_t)r, .col = (uint8_t)old, .pressed = false, .epoch = epoch};
+        s_mono_col[r] = (int8_t)col;
+    }
+    return k;
+}
+
+/* Presses take (note, channel) from the current note map and remember it;
+ * releases reuse what their press got. Silent keys, and keys pressed
+ * before the last release of all notes, are dropped.
+ */
+static size_t stage_note_map(ip_event_t *ev, size_t n)
+{
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ip_event_t e = ev[i];
+        note_map_entry_t m;
+        if (e.pressed) {
+            m = note_map_lookup(e.row, e.col);
+            atomic_store_explicit(&s_key_sounding[e.row][e.col], entry_pack(m, e.epoch), memory_order_relaxed);
+        } else {
+            const uint32_t v = atomic_load_explicit(&s_key_sounding[e.row][e.col], memory_order_relaxed);
+            m = ((uint16_t)(v >> 16) == e.epoch) ? entry_unpack(v) : (note_map_entry_t){.note = NOTE_MAP_SILENT};
+        }
+        if (m.note == NOTE_MAP_SILENT) continue;
+        e.note = m.note;
+        e.channel = m.channel;
+        ev[k++] = e;
+    }
+    return k;
+}
+
+static size_t stage_velocity(ip_event_t *ev, size_t n)
+{
+    const ip_velocity_fn_t fn = atomic_load_explicit(&s_velocity_fn, memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+        if (!ev[i].pressed) {
+            ev[i].velocity = 0;
+        } else if (fn) {
+            const uint8_t v = fn(&ev[i]) & 0x7Fu;
+            ev[i].velocity = v ? v : 1; /* velocity 0 would read as note-off */
+        } else {
+            ev[i].velocity = IP_DEFAULT_VELOCITY;
+        }
+    }
+    return n;
+}
+
+/* Channel voice sharing: drop edges that do not change whether (channel,
+ * note) sounds. Presses also point MPE pitch bend at their string.
+ */
+static size_t stage_channel(ip_event_t *ev, size_t n)
+{
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const ip_event_t e = ev[i];
+        if (e.pressed) midi_mpe_note_activity(e.row);
+        if (!note_ref_update(e.channel, e.note, e.pressed, e.epoch)) continue;
+        ev[k++] = e;
+    }
+    return k;
+}
+
+/* Routes each event goes to, from the per-route channel masks. Events no
+ * route accepts are dropped (their note state is still counted).
+ */
+static size_t stage_route(ip_event_t *ev, size_t n)
+{
+    uint16_t masks[MIDI_OUT_ROUTE_COUNT];
+    for (int ri = 0; ri < MIDI_OUT_ROUTE_COUNT; ++ri) {
+        masks[ri] = atomic_load_explicit(&s_route_channels[ri], memory_order_relaxed);
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t routes = 0;
+        for (int ri = 0; ri < MIDI_OUT_ROUTE_COUNT; ++ri) {
+            if (masks[ri] & (1u << ev[i].channel)) routes |= (uint8_t)(1u << ri);
+        }
+        if (routes == 0) continue;
+        ev[k] = ev[i];
+        ev[k++].routes = routes;
+    }
+    return k;
+}
+
+/* =========================================================
+ * API
+ * ========================================================= */
+
+void input_pipeline_init(void)
+{
+    /* matrix_scan_start() forgets held keys; forget their counts too.
+     * No producer runs yet, so the state is cleared directly.
+     */
+    for (int ch = 0; ch < 16; ++ch) {
+        for (int i = 0; i < 128 / 4; ++i) atomic_store(&s_note_refs[ch][i], 0);
+    }
+    for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+        for (int c = 0; c < MATRIX_NUM_COLS; ++c) atomic_store(&s_key_sounding[r][c], 0);
+        s_row_keys[r] = 0;
+        s_mono_col[r] = -1;
+        s_row_epoch[r] = 0;
+    }
+    atomic_store(&s_epoch, 1u);
+
+    /* Whoever releases all notes (panic, MPE toggle, base channel, mono,
+     * channel filters), the counts must follow: otherwise a key matching
+     * a still-counted pitch would never send its note-on.
+     */
+    midi_out_set_release_listener(post_reset);
+
+    s_num_stages = 0;
+    s_stages[s_num_stages++] = stage_mono;
+    s_stages[s_num_stages++] = stage_note_map;
+    s_stages[s_num_stages++] = stage_velocity;
+    s_stages[s_num_stages++] = stage_channel;
+    s_stages[s_num_stages++] = stage_route;
+}
+
+size_t input_pipeline_process(ip_event_t *ev, size_t n)
+{
+    if (!ev) return 0;
+    if (n > IP_MAX_EVENTS) n = IP_MAX_EVENTS;
+    const uint16_t epoch = (uint16_t)atomic_load(&s_epoch);
+    for (size_t i = 0; i < n; ++i) ev[i].epoch = epoch;
+    for (size_t s = 0; s < s_num_stages && n > 0; ++s) n = s_stages[s](ev, n);
+    return n;
+}
+
+/* Note-offs for the presses of a run that straddled a release of all
+ * notes: their note-ons may have been queued after it.
+ */
+static void cut_presses(const ip_event_t *ev, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (!ev[i].pressed) continue;
+        midi_msg_t off = {.type = MIDI_MSG_NOTE_OFF, .channel = ev[i].channel};
+        off.data.note.note = ev[i].note;
+        (void)midi_out_send_batch_to(ev[i].routes, &off, 1);
+    }
+}
+
+size_t input_pipeline_run(ip_event_t *ev, size_t n)
+{
+    n = input_pipeline_process(ev, n);
+    if (n == 0) return 0;
+    const uint16_t epoch = ev[0].epoch;
+
+    /* One batch per route set. A (channel, note) always maps to the same
+     * set, so per-note order holds across batches.
+     */
+    midi_msg_t msgs[IP_MAX_EVENTS];
+    uint32_t pending = 0;
+    for (size_t i = 0; i < n; ++i) pending |= 1u << ev[i].routes;
+    while (pending) {
+        const uint8_t routes = (uint8_t)__builtin_ctz(pending);
+        pending &= pending - 1u;
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (ev[i].routes != routes) continue;
+            msgs[k] = (midi_msg_t){
+                .type = ev[i].pressed ? MIDI_MSG_NOTE_ON : MIDI_MSG_NOTE_OFF,
+                .channel = ev[i].channel,
+            };
+            msgs[k].data.note.note = ev[i].note;
+            msgs[k++].data.note.velocity = ev[i].velocity;
+        }
+        if (routes == IP_ALL_ROUTES) {
+            (void)midi_out_send_batch(msgs, k);
+        } else {
+            (void)midi_out_send_batch_to(routes, msgs, k);
+        }
+    }
+
+    if ((uint16_t)atomic_load(&s_epoch) != epoch) cut_presses(ev, n);
+    return n;
+}
+
+void input_pipeline_set_mono(bool en)
+{
+    if (atomic_exchange(&s_mono, en) == en) return;
+    /* Held notes were counted under the other mode: start over. The
+     * release posts a new epoch, so runs that start later see the new
+     * mode and a run already under way has its presses cut.
+     */
+    midi_out_panic();
+    ESP_LOGI(TAG, "per-string mono %s", en ? "on" : "off");
+}
+
+bool input_pipeline_get_mono(void)
+{
+    return atomic_load(&s_mono);
+}
+
+void input_pipeline_set_velocity_source(ip_velocity_fn_t fn)
+{
+    atomic_store_explicit(&s_velocity_fn, fn, memory_order_release);
+}
+
+void input_pipeline_set_route_channels(uint32_t route, uint16_t ch_mask)
+{
+    if (route == 0 || (route & (route - 1u)) != 0 || route > MIDI_OUT_ROUTE_BLE) return;
+    const int ri = __builtin_ctz(route);
+    if (atomic_exchange(&s_route_channels[ri], ch_mask) == ch_mask) return;
+    /* Notes now filtered out would never get their note-off. Mask first,
+     * then release, as input_pipeline_set_mono() does.
+     */
+    midi_out_panic();
+    ESP_LOGI(TAG, "route 0x%lx channels=0x%04x", (unsigned long)route, (unsigned)ch_mask);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_pins.h"
+
+/* =========================================================
+ * Key -> MIDI input pipeline
+ *
+ * Key edges pass through a fixed list of stages assembled at init:
+ *
+ *   mono      per-string highest-fret priority (when enabled)
+ *   note map  key -> note/channel (note_map.h); releases reuse the
+ *             entry their press started with
+ *   velocity  velocity from the installed source (default: fixed)
+ *   channel   per-channel voice sharing (first press on / last release
+ *             off) and the MPE pitch-bend target
+ *   route     per-route channel filter
+ *
+ * Events travel by value in one caller-provided array; a stage edits,
+ * drops or (mono) rewrites them in place. No heap, no queues between
+ * stages. The last step hands the result to midi_out as one batch per
+ * route set.
+ * ========================================================= */
+
+/* Most events one run handles (one per key; mono emits at most two per string) */
+#define IP_MAX_EVENTS (MATRIX_NUM_ROWS * MATRIX_NUM_COLS)
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+    uint8_t note;     /* note map stage */
+    uint8_t channel;  /* note map stage, 0..15 */
+    uint8_t velocity; /* velocity stage; note-off velocity on release */
+    uint8_t routes;   /* route stage: midi_out_routes_t bits */
+    uint16_t epoch;   /* held-note epoch of the run (set on entry) */
+} ip_event_t;
+
+/* A stage: process ev[0..n) in place (capacity IP_MAX_EVENTS), return the new count */
+typedef size_t (*ip_stage_fn_t)(ip_event_t *ev, size_t n);
+
+/* Velocity source: note-on velocity (1..127) for a press */
+typedef uint8_t (*ip_velocity_fn_t)(const ip_event_t *ev);
+
+/* Build the stage list and clear held-note state. Call before key events
+ * flow. Every midi_out_panic() starts a new held-note epoch: the next run
+ * of each producer treats keys held so far as released.
+ */
+void input_pipeline_init(void);
+
+/* Run all stages without sending (benchmarks, tests). ev holds IP_MAX_EVENTS. */
+size_t input_pipeline_process(ip_event_t *ev, size_t n);
+
+/* Run all stages and send the result; returns the messages handed to
+ * midi_out. n <= IP_MAX_EVENTS; ev is clobbered.
+ */
+size_t input_pipeline_run(ip_event_t *ev, size_t n);
+
+/* Per-string mono mode. Switching releases all sounding notes. */
+void input_pipeline_set_mono(bool en);
+bool input_pipeline_get_mono(void);
+
+/* NULL restores the fixed default velocity. */
+void input_pipeline_set_velocity_source(ip_velocity_fn_t fn);
+
+/* Channels (bit c == channel c, 0-based) a route receives notes on;
+ * default all. Changing it releases all sounding notes.
+ */
+void input_pipeline_set_route_channels(uint32_t route, uint16_t ch_mask);
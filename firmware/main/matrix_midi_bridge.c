@@ -1,9 +1,14 @@
+#include "matrix_midi_bridge.h"
 #include "matrix_scan.h"
+#include "board_pins.h"
 #include "midi_out.h"
 #include "midi_mpe.h"
+#include "note_map.h"
+#include "input_pipeline.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "sdkconfig.h"
+#include <stdatomic.h>
 #include <stdlib.h>
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -19,34 +24,51 @@ static void on_key_event(int row, int col, bool pressed);
 
 static const char *TAG = "matrix_midi";
 
-/* Default base notes for strings Str1..Str6 (row 0..5)
- * Assumes Str1 is high E (E4=64) and Str6 is low E (E2=40)
+/* Key edges go through the input pipeline (input_pipeline.h): note map,
+ * mono, velocity, channel sharing and route filtering all live there.
  */
-static const uint8_t string_base_note[6] = {64, 59, 55, 50, 45, 40};
 
-/* Base MIDI channel for non-MPE mode - use midi_mpe_default_channel() */
+uint8_t matrix_midi_bridge_note_for(int row, int col)
+{
+    return note_map_lookup(row, col).note;
+}
 
 static void on_key_event(int row, int col, bool pressed)
 {
-    if (row < 0 || row >= 6 || col < 0 || col >= 13) return;
-
-    uint8_t note = string_base_note[row] + col;
-    if (pressed) {
-        /* remember activity for MPE pitch-bend routing */
-        midi_mpe_note_activity(row);
+    if (row < 0 || row >= MATRIX_NUM_ROWS || col < 0 || col >= MATRIX_NUM_COLS) return;
+    ip_event_t ev[IP_MAX_EVENTS];
+    ev[0] = (ip_event_t){.row = (uint8_t)row, .col = (uint8_t)col, .pressed = pressed};
+    input_pipeline_run(ev, 1);
+}
 
-        uint8_t ch = midi_mpe_is_enabled() ? midi_mpe_channel_for_row(row) : midi_mpe_default_channel();
-        midi_send_note_on(ch, note, 100);
-    } else {
-        uint8_t ch = midi_mpe_is_enabled() ? midi_mpe_channel_for_row(row) : midi_mpe_default_channel();
-        midi_send_note_off(ch, note, 0);
+/* A scan cycle's edges (e.g. a strummed chord) go out as one batch */
+static void on_key_batch(const matrix_event_t *mev, size_t n)
+{
+    ip_event_t ev[IP_MAX_EVENTS];
+    if (n > IP_MAX_EVENTS) n = IP_MAX_EVENTS;
+    for (size_t i = 0; i < n; ++i) {
+        ev[i] = (ip_event_t){.row = mev[i].row, .col = mev[i].col, .pressed = mev[i].pressed};
     }
+    input_pipeline_run(ev, n);
+}
+
+void matrix_midi_bridge_set_mono(bool en)
+{
+    input_pipeline_set_mono(en);
+}
+
+bool matrix_midi_bridge_get_mono(void)
+{
+    return input_pipeline_get_mono();
 }
 
 void matrix_midi_bridge_start(int discard_cycles)
 {
     midi_out_init();
     midi_mpe_init();
+    note_map_init();
+    input_pipeline_init();
+    matrix_scan_set_batch_cb(on_key_batch);
     matrix_scan_start(on_key_event, discard_cycles);
 
 #if CONFIG_MATRIX_SIM_ENABLED_DEFAULT
@@ -1,5 +1,17 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /* matrix -> MIDI bridge API */
 void matrix_midi_bridge_start(int discard_cycles);
 void matrix_midi_bridge_stop(void);
+
+/* MIDI note a key plays (0xFF when out of range) */
+uint8_t matrix_midi_bridge_note_for(int row, int col);
+
+/* Per-string mono ("guitar") mode: each row sounds only its highest held
+ * fret. Switching releases all sounding notes.
+ */
+void matrix_midi_bridge_set_mono(bool en);
+bool matrix_midi_bridge_get_mono(void);
@@ -1,5 +1,7 @@
 #include "matrix_scan.h"
 #include "board_pins.h"
+#include "rt_stats.h"
+#include "task_layout.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
@@ -9,6 +11,7 @@
  * issues at compile time.
  */
 extern void esp_rom_delay_us(uint32_t us);
+#include <stdatomic.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,16 +20,80 @@ extern void esp_rom_delay_us(uint32_t us);
 #include "esp_random.h"
 
 static matrix_event_cb_t g_cb = NULL;
+static matrix_batch_cb_t g_batch_cb = NULL;
 static TaskHandle_t g_scan_task = NULL;
 
-/* per-key debounce counters and hardware-observed state */
+/* per-key debounce counters (scan task only) */
 static uint8_t key_state[MATRIX_NUM_ROWS][MATRIX_NUM_COLS];
-static bool hw_pressed[MATRIX_NUM_ROWS][MATRIX_NUM_COLS];
+
+/* Stable pressed state as one bitmask per row (bit c == column c).
+ * Written by the scan task / simulator on the music core and read by the
+ * UI on the I/O core without any shared lock.
+ */
+_Static_assert(MATRIX_NUM_COLS <= 16, "row mask is 16 bits");
+static _Atomic uint16_t hw_mask[MATRIX_NUM_ROWS];
 /* simulator-provided pressed state (visible when sim_enabled) */
-static bool sim_pressed[MATRIX_NUM_ROWS][MATRIX_NUM_COLS];
-static bool sim_enabled = false;
-/* mutex to protect access to hw_pressed/sim_pressed/effective reads */
-static portMUX_TYPE s_matrix_mux = portMUX_INITIALIZER_UNLOCKED;
+static _Atomic uint16_t sim_mask[MATRIX_NUM_ROWS];
+static _Atomic bool sim_enabled = false;
+
+static inline bool mask_test(uint16_t m, int c) { return (m & (uint16_t)(1u << c)) != 0; }
+
+static inline void mask_write(_Atomic uint16_t *m, int c, bool pressed)
+{
+    if (pressed) {
+        (void)atomic_fetch_or(m, (uint16_t)(1u << c));
+    } else {
+        (void)atomic_fetch_and(m, (uint16_t)~(1u << c));
+    }
+}
+
+/* Row-drive phase (matrix_scan_get_phase()): written by the scan task
+ * only, under a sequence counter (odd = update in progress).
+ */
+static _Atomic uint32_t s_phase_seq;
+static _Atomic uint32_t s_phase_from[2];
+static _Atomic uint32_t s_phase_until[2];
+static _Atomic uint32_t s_phase_period;
+static _Atomic uint8_t s_phase_n; /* bursts recorded, 0..2 */
+static _Atomic bool s_phase_driving;
+
+static void phase_begin_write(void)
+{
+    (void)atomic_fetch_add_explicit(&s_phase_seq, 1u, memory_order_relaxed);
+}
+
+static void phase_end_write(void)
+{
+    (void)atomic_fetch_add_explicit(&s_phase_seq, 1u, memory_order_release);
+}
+
+/* The rows are about to be driven: start a burst */
+static void phase_burst_start(void)
+{
+    const uint32_t now = (uint32_t)esp_timer_get_time();
+    const uint8_t n = atomic_load_explicit(&s_phase_n, memory_order_relaxed);
+    const uint32_t prev = atomic_load_explicit(&s_phase_from[0], memory_order_relaxed);
+    phase_begin_write();
+    atomic_store_explicit(&s_phase_from[1], prev, memory_order_release);
+    atomic_store_explicit(&s_phase_until[1], atomic_load_explicit(&s_phase_until[0], memory_order_relaxed),
+                          memory_order_release);
+    atomic_store_explicit(&s_phase_from[0], now, memory_order_release);
+    atomic_store_explicit(&s_phase_until[0], now, memory_order_release);
+    atomic_store_explicit(&s_phase_period, n > 0 ? now - prev : 0u, memory_order_release);
+    atomic_store_explicit(&s_phase_n, n < 2 ? (uint8_t)(n + 1) : n, memory_order_release);
+    atomic_store_explicit(&s_phase_driving, true, memory_order_release);
+    phase_end_write();
+}
+
+/* Last row released: the lines are static until the next burst */
+static void phase_burst_end(void)
+{
+    const uint32_t now = (uint32_t)esp_timer_get_time();
+    phase_begin_write();
+    atomic_store_explicit(&s_phase_until[0], now, memory_order_release);
+    atomic_store_explicit(&s_phase_driving, false, memory_order_release);
+    phase_end_write();
+}
 
 /* Number of full matrix cycles to discard after start */
 static int g_discard_cycles = 0;
@@ -52,23 +119,39 @@ static void scan_task(void *arg)
     (void)arg;
     TickType_t delay = pdMS_TO_TICKS(MATRIX_DEBOUNCE_MS);
     if (delay == 0) delay = 1;
+    int64_t last_cycle_us = 0;
+    /* Edges of the current cycle (batch callback only) */
+    matrix_event_t batch[MATRIX_NUM_ROWS * MATRIX_NUM_COLS];
+    size_t batch_n = 0;
+#if CONFIG_EMIUET_RT_STATS
+    int64_t batch_read_us = 0;
+#endif
 
     while (1) {
+#if CONFIG_EMIUET_RT_STATS
+        const int64_t cycle_us = esp_timer_get_time();
+        if (last_cycle_us != 0) rt_stats_record(RT_STAT_SCAN_PERIOD, (uint32_t)(cycle_us - last_cycle_us));
+        last_cycle_us = cycle_us;
+#else
+        (void)last_cycle_us;
+#endif
+
         /* If requested, perform a capture pass immediately after discard to
          * adopt the current physical state as initial stable_pressed values.
          */
+        phase_burst_start();
         if (g_capture_after_discard) {
             for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
                 select_row(r);
                 esp_rom_delay_us(50);
+                uint16_t m = 0;
                 for (int c = 0; c < MATRIX_NUM_COLS; ++c) {
                     int level = gpio_get_level(MATRIX_COL_PINS[c]);
                     bool pressed = (level == 0);
-                    portENTER_CRITICAL(&s_matrix_mux);
-                    hw_pressed[r][c] = pressed;
+                    if (pressed) m |= (uint16_t)(1u << c);
                     key_state[r][c] = pressed ? MATRIX_DEBOUNCE_COUNT : 0;
-                    portEXIT_CRITICAL(&s_matrix_mux);
                 }
+                atomic_store(&hw_mask[r], m);
                 deselect_rows();
             }
             g_capture_after_discard = false;
@@ -78,6 +161,10 @@ static void scan_task(void *arg)
             select_row(r);
             /* small settle */
             esp_rom_delay_us(50);
+#if CONFIG_EMIUET_RT_STATS
+            const int64_t row_read_us = esp_timer_get_time();
+#endif
+            uint16_t row_mask = atomic_load(&hw_mask[r]);
 
             for (int c = 0; c < MATRIX_NUM_COLS; ++c) {
                 int level = gpio_get_level(MATRIX_COL_PINS[c]);
@@ -89,9 +176,11 @@ static void scan_task(void *arg)
                     continue;
                 }
 
-                /* update counter with saturation */
+                /* update counter, saturating at the threshold so release
+                 * debounce does not grow with hold time
+                 */
                 if (pressed) {
-                    if (key_state[r][c] < 0xFE) key_state[r][c]++;
+                    if (key_state[r][c] < MATRIX_DEBOUNCE_COUNT) key_state[r][c]++;
                 } else {
                     if (key_state[r][c] > 0) key_state[r][c]--;
                 }
@@ -99,26 +188,46 @@ static void scan_task(void *arg)
                 /* Debounce transition logic: only trigger on change of hw_pressed */
                 bool changed = false;
                 bool cb_val = false;
-                portENTER_CRITICAL(&s_matrix_mux);
-                if (!hw_pressed[r][c] && key_state[r][c] >= MATRIX_DEBOUNCE_COUNT) {
-                    hw_pressed[r][c] = true;
+                const bool was = mask_test(row_mask, c);
+                if (!was && key_state[r][c] >= MATRIX_DEBOUNCE_COUNT) {
                     changed = true;
                     cb_val = true;
-                } else if (hw_pressed[r][c] && key_state[r][c] == 0) {
-                    hw_pressed[r][c] = false;
+                } else if (was && key_state[r][c] == 0) {
                     changed = true;
                     cb_val = false;
                 }
-                portEXIT_CRITICAL(&s_matrix_mux);
 
-                if (changed && g_cb) {
-                    g_cb(r, c, cb_val);
+                if (changed) {
+                    /* Only this task writes hw_mask; publish before the callback */
+                    row_mask = cb_val ? (uint16_t)(row_mask | (1u << c)) : (uint16_t)(row_mask & ~(1u << c));
+                    atomic_store(&hw_mask[r], row_mask);
+                    if (g_batch_cb) {
+#if CONFIG_EMIUET_RT_STATS
+                        if (batch_n == 0) batch_read_us = row_read_us;
+#endif
+                        batch[batch_n++] = (matrix_event_t){.row = (uint8_t)r, .col = (uint8_t)c, .pressed = cb_val};
+                    } else if (g_cb) {
+                        g_cb(r, c, cb_val);
+#if CONFIG_EMIUET_RT_STATS
+                        rt_stats_record(RT_STAT_KEY_TO_ENQUEUE, (uint32_t)(esp_timer_get_time() - row_read_us));
+#endif
+                    }
                 }
             }
 
             deselect_rows();
             taskYIELD();
         }
+        phase_burst_end();
+
+        if (batch_n > 0) {
+            g_batch_cb(batch, batch_n);
+#if CONFIG_EMIUET_RT_STATS
+            /* Oldest edge of the batch: worst case for the cycle */
+            rt_stats_record(RT_STAT_KEY_TO_ENQUEUE, (uint32_t)(esp_timer_get_time() - batch_read_us));
+#endif
+            batch_n = 0;
+        }
 
         /* completed one full matrix cycle; if discarding, decrement counter */
         if (g_discard_cycles > 0) {
@@ -138,10 +247,18 @@ void matrix_scan_start(matrix_event_cb_t cb, int discard_cycles)
     if (g_scan_task) return;
     g_cb = cb;
     memset(key_state, 0, sizeof(key_state));
-    memset(hw_pressed, 0, sizeof(hw_pressed));
-    memset(sim_pressed, 0, sizeof(sim_pressed));
+    for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+        atomic_store(&hw_mask[r], 0);
+        atomic_store(&sim_mask[r], 0);
+    }
     g_discard_cycles = (discard_cycles > 0) ? discard_cycles : 0;
-    xTaskCreate(scan_task, "matrix_scan", 4096, NULL, 10, &g_scan_task);
+    xTaskCreatePinnedToCore(scan_task, "matrix_scan", TASK_MATRIX_SCAN_STACK, NULL, TASK_MATRIX_SCAN_PRIO,
+                            &g_scan_task, TASK_MATRIX_SCAN_CORE);
+}
+
+void matrix_scan_set_batch_cb(matrix_batch_cb_t cb)
+{
+    g_batch_cb = cb;
 }
 
 void matrix_scan_stop(void)
@@ -150,36 +267,47 @@ void matrix_scan_stop(void)
     vTaskDelete(g_scan_task);
     g_scan_task = NULL;
     g_cb = NULL;
+    g_batch_cb = NULL;
+}
+
+bool matrix_scan_get_phase(matrix_scan_phase_t *out)
+{
+    if (!out) return false;
+    uint32_t seq;
+    do {
+        seq = atomic_load_explicit(&s_phase_seq, memory_order_acquire);
+        out->from_us[0] = atomic_load_explicit(&s_phase_from[0], memory_order_acquire);
+        out->from_us[1] = atomic_load_explicit(&s_phase_from[1], memory_order_acquire);
+        out->until_us[0] = atomic_load_explicit(&s_phase_until[0], memory_order_acquire);
+        out->until_us[1] = atomic_load_explicit(&s_phase_until[1], memory_order_acquire);
+        out->period_us = atomic_load_explicit(&s_phase_period, memory_order_acquire);
+        out->n = atomic_load_explicit(&s_phase_n, memory_order_acquire);
+        out->driving = atomic_load_explicit(&s_phase_driving, memory_order_acquire);
+    } while ((seq & 1u) || seq != atomic_load_explicit(&s_phase_seq, memory_order_relaxed));
+    return out->n > 0;
+}
+
+uint16_t matrix_scan_get_row_mask(int row)
+{
+    if (row < 0 || row >= MATRIX_NUM_ROWS) return 0;
+    return atomic_load(&sim_enabled) ? atomic_load(&sim_mask[row]) : atomic_load(&hw_mask[row]);
 }
 
 bool matrix_scan_is_pressed(int row, int col)
 {
     if (row < 0 || row >= MATRIX_NUM_ROWS || col < 0 || col >= MATRIX_NUM_COLS) return false;
-    bool val = false;
-    portENTER_CRITICAL(&s_matrix_mux);
-    if (sim_enabled) {
-        val = sim_pressed[row][col];
-    } else {
-        val = hw_pressed[row][col];
-    }
-    portEXIT_CRITICAL(&s_matrix_mux);
-    return val;
+    return mask_test(matrix_scan_get_row_mask(row), col);
 }
 
 void matrix_scan_set_sim_enabled(bool en)
 {
-    portENTER_CRITICAL(&s_matrix_mux);
-    sim_enabled = en;
-    portEXIT_CRITICAL(&s_matrix_mux);
+    atomic_store(&sim_enabled, en);
 }
 
 void matrix_scan_set_sim_state(int row, int col, bool pressed)
 {
     if (row < 0 || row >= MATRIX_NUM_ROWS || col < 0 || col >= MATRIX_NUM_COLS) return;
-    portENTER_CRITICAL(&s_matrix_mux);
-    sim_pressed[row][col] = pressed;
-    portEXIT_CRITICAL(&s_matrix_mux);
-    /* invoke callback outside critical section */
+    mask_write(&sim_mask[row], col, pressed);
     if (g_cb) g_cb(row, col, pressed);
 }
 
@@ -216,16 +344,29 @@ static void matrix_scan_set_sim_state_multi(int row, const int *cols, int n, boo
 {
     if (row < 0 || row >= MATRIX_NUM_ROWS || n <= 0) return;
 
-    portENTER_CRITICAL(&s_matrix_mux);
+    uint16_t m = 0;
     for (int i = 0; i < n; ++i) {
         int c = cols[i];
         if (c < 0 || c >= MATRIX_NUM_COLS) continue;
-        sim_pressed[row][c] = pressed;
+        m |= (uint16_t)(1u << c);
+    }
+    /* One atomic update so readers never see half a chord */
+    if (pressed) {
+        (void)atomic_fetch_or(&sim_mask[row], m);
+    } else {
+        (void)atomic_fetch_and(&sim_mask[row], (uint16_t)~m);
     }
-    portEXIT_CRITICAL(&s_matrix_mux);
 
-    /* callbacks outside critical section */
-    if (g_cb) {
+    if (g_batch_cb) {
+        matrix_event_t ev[MATRIX_NUM_COLS];
+        size_t k = 0;
+        for (int i = 0; i < n && k < MATRIX_NUM_COLS; ++i) {
+            int c = cols[i];
+            if (c < 0 || c >= MATRIX_NUM_COLS) continue;
+            ev[k++] = (matrix_event_t){.row = (uint8_t)row, .col = (uint8_t)c, .pressed = pressed};
+        }
+        if (k > 0) g_batch_cb(ev, k);
+    } else if (g_cb) {
         for (int i = 0; i < n; ++i) {
             int c = cols[i];
             if (c < 0 || c >= MATRIX_NUM_COLS) continue;
@@ -276,10 +417,7 @@ static void sim_string_task(void *arg)
 
     while (1) {
         /* Only act when sim is enabled */
-        bool se = false;
-        portENTER_CRITICAL(&s_matrix_mux);
-        se = sim_enabled;
-        portEXIT_CRITICAL(&s_matrix_mux);
+        const bool se = atomic_load(&sim_enabled);
 
         if (!se) {
             /* Ensure nothing left stuck when sim gets disabled */
@@ -337,7 +475,8 @@ void matrix_sim_start(void)
         if (!s_sim_tasks[r]) {
             char name[16];
             snprintf(name, sizeof(name), "sim_row_%d", r);
-            xTaskCreate(sim_string_task, name, 4096, (void *)(intptr_t)r, 5, &s_sim_tasks[r]);
+            xTaskCreatePinnedToCore(sim_string_task, name, TASK_MATRIX_SIM_STACK, (void *)(intptr_t)r,
+                                    TASK_MATRIX_SIM_PRIO, &s_sim_tasks[r], TASK_MATRIX_SIM_CORE);
         }
     }
 }
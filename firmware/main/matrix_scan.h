@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -15,14 +16,54 @@
 
 typedef void (*matrix_event_cb_t)(int row, int col, bool pressed);
 
+/* One debounced edge */
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+} matrix_event_t;
+
+/* All edges of one scan cycle (or one multi-key simulator update), in
+ * scan order. n >= 1.
+ */
+typedef void (*matrix_batch_cb_t)(const matrix_event_t *ev, size_t n);
+
 /* Start scanning. discard_cycles: number of full matrix cycles to ignore after start
  * (used to avoid acting on strapping-pin states during boot). */
 void matrix_scan_start(matrix_event_cb_t cb, int discard_cycles);
 void matrix_scan_stop(void);
 
+/* Optional: deliver edges per scan cycle instead of one callback per edge.
+ * While set, the event callback only sees single simulator edges
+ * (matrix_scan_set_sim_state()). Set before matrix_scan_start().
+ */
+void matrix_scan_set_batch_cb(matrix_batch_cb_t cb);
+
 /* Query the current stable pressed state for a key. Returns true if pressed. */
 bool matrix_scan_is_pressed(int row, int col);
 
+/* Stable pressed state of a whole row (bit c == column c), lock-free.
+ * Reflects the simulator when sim is enabled.
+ */
+uint16_t matrix_scan_get_row_mask(int row);
+
+/* Row-drive phase. The row lines couple into the slider and battery-sense
+ * traces (pinout-v3 §4.3); each scan cycle drives them in one burst
+ * (about 0.4 ms every MATRIX_DEBOUNCE_MS) and leaves them static in
+ * between, so analog sampling can avoid the bursts. Times are the low 32
+ * bits of esp_timer_get_time(); compare them by difference.
+ */
+typedef struct {
+    uint32_t from_us[2];  /* burst starts, latest first */
+    uint32_t until_us[2]; /* burst ends (until_us[0] is stale while driving) */
+    uint32_t period_us;   /* start to start of the last two bursts, 0 until known */
+    uint8_t n;            /* valid entries, 0..2 */
+    bool driving;         /* the latest burst is still running */
+} matrix_scan_phase_t;
+
+/* Lock-free snapshot, callable from any task. False before the first burst. */
+bool matrix_scan_get_phase(matrix_scan_phase_t *out);
+
 /* Simulator control: enable/disable simulated presses. When enabled,
  * `matrix_scan_is_pressed()` returns simulated state instead of hardware.
  */
@@ -0,0 +1,387 @@
+#include "midi_bench.h"
+
+#if CONFIG_EMIUET_MIDI_BENCH
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "matrix_scan.h"
+#include "midi_mpe.h"
+#include "task_layout.h"
+
+static const char *TAG = "midi_bench";
+
+/* Latency samples kept per route and kind (counts continue past this) */
+#define MIDI_BENCH_SAMPLES 1024
+
+/* Spacing between strings within one strum */
+#define MIDI_BENCH_STRUM_GAP_US 1500
+
+enum { BENCH_ROUTE_USB = 0, BENCH_ROUTE_TRS, BENCH_ROUTE_BLE, BENCH_ROUTE_COUNT };
+enum { BENCH_KIND_NOTE = 0, BENCH_KIND_BEND, BENCH_KIND_COUNT };
+
+typedef struct {
+    _Atomic uint32_t n;
+    uint32_t lat_us[MIDI_BENCH_SAMPLES];
+} bench_series_t;
+
+typedef struct {
+    /* Send timestamps (low 32 bits of esp_timer, 0 == none) */
+    _Atomic uint32_t note_t0[2][128]; /* [on][note] */
+    _Atomic uint32_t pb_t0[16];       /* latest bend per channel */
+    bench_series_t series[BENCH_ROUTE_COUNT][BENCH_KIND_COUNT];
+} bench_state_t;
+
+static bench_state_t *s_state = NULL;
+static _Atomic bool s_recording = false;
+
+/* Probes currently running. stop_recording() waits for zero, so the
+ * reporter owns s_state afterwards (seq_cst on both sides).
+ */
+static _Atomic uint32_t s_probes_busy = 0;
+
+/* Set by the bench task around a simulated key event, so the note's t0
+ * includes the matrix callback and bridge.
+ */
+static _Atomic uint32_t s_inject_t0 = 0;
+
+static inline uint32_t now32(void)
+{
+    const uint32_t t = (uint32_t)esp_timer_get_time();
+    return t ? t : 1u;
+}
+
+/* =========================================================
+ * Probes
+ * ========================================================= */
+
+static inline bool probe_enter(void)
+{
+    atomic_fetch_add(&s_probes_busy, 1u);
+    if (atomic_load(&s_recording)) return true;
+    atomic_fetch_sub(&s_probes_busy, 1u);
+    return false;
+}
+
+static inline void probe_exit(void)
+{
+    atomic_fetch_sub(&s_probes_busy, 1u);
+}
+
+static void stop_recording(void)
+{
+    atomic_store(&s_recording, false);
+    while (atomic_load(&s_probes_busy) != 0) vTaskDelay(1);
+}
+
+void midi_bench_probe_send(const midi_msg_t *msg)
+{
+    if (!msg || !probe_enter()) return;
+
+    const uint32_t inj = atomic_load_explicit(&s_inject_t0, memory_order_relaxed);
+    const uint32_t t0 = inj ? inj : now32();
+
+    switch (msg->type) {
+        case MIDI_MSG_NOTE_ON: {
+            const int on = msg->data.note.velocity != 0;
+            atomic_store_explicit(&s_state->note_t0[on][msg->data.note.note & 0x7Fu], t0, memory_order_relaxed);
+            break;
+        }
+        case MIDI_MSG_NOTE_OFF:
+            atomic_store_explicit(&s_state->note_t0[0][msg->data.note.note & 0x7Fu], t0, memory_order_relaxed);
+            break;
+        case MIDI_MSG_PITCH_BEND:
+            atomic_store_explicit(&s_state->pb_t0[msg->channel & 0x0Fu], t0, memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
+    probe_exit();
+}
+
+static int route_index(uint32_t route)
+{
+    switch (route) {
+        case MIDI_OUT_ROUTE_USB: return BENCH_ROUTE_USB;
+        case MIDI_OUT_ROUTE_TRS_UART: return BENCH_ROUTE_TRS;
+        case MIDI_OUT_ROUTE_BLE: return BENCH_ROUTE_BLE;
+        default: return -1;
+    }
+}
+
+static void record(int ri, int kind, uint32_t t0)
+{
+    if (t0 == 0) return;
+    bench_series_t *s = &s_state->series[ri][kind];
+    const uint32_t i = atomic_fetch_add_explicit(&s->n, 1u, memory_order_relaxed);
+    if (i < MIDI_BENCH_SAMPLES) s->lat_us[i] = now32() - t0;
+}
+
+static void probe_wire_msg(int ri, uint8_t status, uint8_t d1, uint8_t d2)
+{
+    const uint8_t type = (uint8_t)(status & 0xF0u);
+    if (type == 0x90u || type == 0x80u) {
+        const int on = (type == 0x90u) && (d2 != 0);
+        record(ri, BENCH_KIND_NOTE, atomic_load_explicit(&s_state->note_t0[on][d1 & 0x7Fu], memory_order_relaxed));
+    } else if (type == 0xE0u) {
+        record(ri, BENCH_KIND_BEND, atomic_load_explicit(&s_state->pb_t0[status & 0x0Fu], memory_order_relaxed));
+    }
+}
+
+void midi_bench_probe_wire(uint32_t route, const uint8_t *bytes, size_t len)
+{
+    const int ri = route_index(route);
+    if (!bytes || len < 3 || ri < 0 || !probe_enter()) return;
+    probe_wire_msg(ri, bytes[0], bytes[1], bytes[2]);
+    probe_exit();
+}
+
+void midi_bench_probe_wire_ump(uint32_t route, const uint32_t *words, size_t n)
+{
+    const int ri = route_index(route);
+    if (!words || n == 0 || ri < 0) return;
+
+    /* MT2 (MIDI 1.0) and MT4 (MIDI 2.0) share status/index in word 0.
+     * A MIDI 2.0 Note On is never a Note Off, whatever its velocity.
+     */
+    const uint32_t mt = (words[0] >> 28) & 0x0Fu;
+    if (mt != 0x2u && mt != 0x4u) return;
+    const uint8_t status = (uint8_t)(words[0] >> 16);
+    const uint8_t d1 = (uint8_t)((words[0] >> 8) & 0x7Fu);
+    const uint8_t d2 = (mt == 0x4u) ? 0x7Fu : (uint8_t)(words[0] & 0x7Fu);
+    if (!probe_enter()) return;
+    probe_wire_msg(ri, status, d1, d2);
+    probe_exit();
+}
+
+/* =========================================================
+ * Scenarios
+ * ========================================================= */
+
+/* Fret per string (row 0 == Str1, high E) */
+static const uint8_t k_chords[][MATRIX_NUM_ROWS] = {
+    {0, 1, 0, 2, 3, 0}, /* C */
+    {0, 1, 2, 2, 0, 0}, /* Am */
+    {1, 1, 2, 3, 3, 1}, /* F (barre) */
+    {3, 0, 0, 0, 2, 3}, /* G */
+};
+
+static void bench_key(int row, int col, bool pressed)
+{
+    atomic_store_explicit(&s_inject_t0, now32(), memory_order_relaxed);
+    matrix_scan_set_sim_state(row, col, pressed);
+    atomic_store_explicit(&s_inject_t0, 0, memory_order_relaxed);
+}
+
+/* One down-strum, hold, up-strum release. route_cycle != NULL switches
+ * routes every second key event (route changes mid-phrase).
+ */
+static void strum_once(const uint8_t *frets, const uint32_t *route_cycle, uint32_t *route_i)
+{
+    for (int r = MATRIX_NUM_ROWS - 1; r >= 0; --r) {
+        bench_key(r, frets[r], true);
+        if (route_cycle && ((*route_i)++ % 2u) == 1u) midi_out_set_routes(route_cycle[(*route_i / 2u) % 3u]);
+        esp_rom_delay_us(MIDI_BENCH_STRUM_GAP_US);
+    }
+    vTaskDelay(pdMS_TO_TICKS(40));
+    for (int r = 0; r < MATRIX_NUM_ROWS; ++r) {
+        bench_key(r, frets[r], false);
+        if (route_cycle && ((*route_i)++ % 2u) == 1u) midi_out_set_routes(route_cycle[(*route_i / 2u) % 3u]);
+        esp_rom_delay_us(MIDI_BENCH_STRUM_GAP_US);
+    }
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+static void scenario_strum6(uint32_t repeat)
+{
+    for (uint32_t i = 0; i < repeat; ++i) {
+        strum_once(k_chords[i % (sizeof(k_chords) / sizeof(k_chords[0]))], NULL, NULL);
+    }
+}
+
+static void scenario_route_flip(uint32_t repeat)
+{
+    static const uint32_t cycle[3] = {
+        MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART,
+        MIDI_OUT_ROUTE_USB,
+        MIDI_OUT_ROUTE_TRS_UART,
+    };
+    uint32_t route_i = 0;
+    for (uint32_t i = 0; i < repeat; ++i) {
+        strum_once(k_chords[i % (sizeof(k_chords) / sizeof(k_chords[0]))], cycle, &route_i);
+    }
+}
+
+static _Atomic bool s_bend_run = false;
+static _Atomic bool s_bend_done = false;
+
+/* Stands in for the slider task: sweeps the bend once per tick */
+static void bench_bend_task(void *arg)
+{
+    (void)arg;
+    int v = 0;
+    int step = 256;
+    while (atomic_load(&s_bend_run)) {
+        midi_mpe_apply_pitchbend((uint16_t)v);
+        v += step;
+        if (v >= 16383 || v <= 0) {
+            step = -step;
+            v = (v < 0) ? 0 : (v > 16383 ? 16383 : v);
+        }
+        vTaskDelay(1);
+    }
+    atomic_store(&s_bend_done, true);
+    vTaskDelete(NULL);
+}
+
+static void scenario_legato_bend(uint32_t repeat)
+{
+    atomic_store(&s_bend_run, true);
+    atomic_store(&s_bend_done, false);
+    if (xTaskCreatePinnedToCore(bench_bend_task, "bench_bend", TASK_MIDI_BENCH_BEND_STACK, NULL,
+                                TASK_MIDI_BENCH_BEND_PRIO, NULL, TASK_MIDI_BENCH_BEND_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "failed to create bend task; legato without bend");
+        atomic_store(&s_bend_done, true);
+    }
+
+    /* Hammer-on / pull-off runs on string 3: new fret down, then old fret up */
+    const int row = 2;
+    int prev = 0;
+    bench_key(row, prev, true);
+    for (uint32_t i = 1; i < repeat * 4u; ++i) {
+        const uint32_t phase = i % 14u;
+        const int fret = (int)(phase <= 7u ? phase : 14u - phase);
+        if (fret == prev) continue;
+        bench_key(row, fret, true);
+        esp_rom_delay_us(1000);
+        bench_key(row, prev, false);
+        prev = fret;
+        vTaskDelay(pdMS_TO_TICKS(25));
+    }
+    bench_key(row, prev, false);
+
+    atomic_store(&s_bend_run, false);
+    while (!atomic_load(&s_bend_done)) vTaskDelay(1);
+    midi_mpe_apply_pitchbend(0);
+}
+
+typedef struct {
+    const char *name;
+    uint32_t routes;
+    void (*run)(uint32_t repeat);
+} bench_scenario_t;
+
+static const bench_scenario_t k_scenarios[] = {
+    {"strum6", MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART, scenario_strum6},
+    {"legato_bend", MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART, scenario_legato_bend},
+    {"route_flip", MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART, scenario_route_flip},
+};
+
+/* =========================================================
+ * Reporting
+ * ========================================================= */
+
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_series(const char *key, bench_series_t *s)
+{
+    const uint32_t n = atomic_load(&s->n);
+    const uint32_t kept = (n < MIDI_BENCH_SAMPLES) ? n : MIDI_BENCH_SAMPLES;
+    if (kept == 0) {
+        printf("\"%s\":{\"n\":%lu}", key, (unsigned long)n);
+        return;
+    }
+    qsort(s->lat_us, kept, sizeof(s->lat_us[0]), cmp_u32);
+    printf("\"%s\":{\"n\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu}",
+           key,
+           (unsigned long)n,
+           (unsigned long)s->lat_us[kept / 2u],
+           (unsigned long)s->lat_us[(kept * 99u) / 100u],
+           (unsigned long)s->lat_us[kept - 1u]);
+}
+
+static uint32_t report(const char *bench, uint32_t routes)
+{
+    static const struct {
+        uint32_t route;
+        const char *name;
+    } k_routes[BENCH_ROUTE_COUNT] = {
+        [BENCH_ROUTE_USB] = {MIDI_OUT_ROUTE_USB, "usb"},
+        [BENCH_ROUTE_TRS] = {MIDI_OUT_ROUTE_TRS_UART, "trs"},
+        [BENCH_ROUTE_BLE] = {MIDI_OUT_ROUTE_BLE, "ble"},
+    };
+
+    uint32_t drops = 0;
+    for (int ri = 0; ri < BENCH_ROUTE_COUNT; ++ri) {
+        if ((routes & k_routes[ri].route) == 0) continue;
+        midi_out_stats_t st;
+        (void)midi_out_get_stats(k_routes[ri].route, &st);
+        drops += st.drop_queue + st.drop_write;
+
+        printf("{\"bench\":\"%s\",\"route\":\"%s\",", bench, k_routes[ri].name);
+        print_series("note", &s_state->series[ri][BENCH_KIND_NOTE]);
+        printf(",");
+        print_series("bend", &s_state->series[ri][BENCH_KIND_BEND]);
+        printf(",\"drop\":{\"queue\":%lu,\"write\":%lu},\"coalesce\":{\"pb\":%lu,\"cc1\":%lu},\"q_hwm\":%lu}\n",
+               (unsigned long)st.drop_queue,
+               (unsigned long)st.drop_write,
+               (unsigned long)st.coalesce_pb,
+               (unsigned long)st.coalesce_cc1,
+               (unsigned long)st.q_hwm);
+    }
+    fflush(stdout);
+    return drops;
+}
+
+uint32_t midi_bench_run(uint32_t repeat)
+{
+    if (repeat == 0) repeat = 1;
+    s_state = calloc(1, sizeof(*s_state));
+    if (!s_state) {
+        ESP_LOGE(TAG, "no memory for bench state (%u bytes)", (unsigned)sizeof(bench_state_t));
+        return 0;
+    }
+
+    const uint32_t saved_routes = midi_out_get_routes();
+    uint32_t drops = 0;
+
+    for (size_t i = 0; i < sizeof(k_scenarios) / sizeof(k_scenarios[0]); ++i) {
+        const bench_scenario_t *sc = &k_scenarios[i];
+
+        midi_out_set_routes(sc->routes);
+        vTaskDelay(pdMS_TO_TICKS(100));
+
+        memset(s_state, 0, sizeof(*s_state));
+        midi_out_reset_stats();
+        atomic_store(&s_recording, true);
+
+        sc->run(repeat);
+
+        /* Let the slowest transport (TRS, ~1 ms per message) drain */
+        vTaskDelay(pdMS_TO_TICKS(200));
+        stop_recording();
+
+        drops += report(sc->name, sc->routes);
+    }
+
+    midi_out_set_routes(saved_routes);
+    free(s_state);
+    s_state = NULL;
+    return drops;
+}
+
+#endif /* CONFIG_EMIUET_MIDI_BENCH */
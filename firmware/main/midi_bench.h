@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "midi_out.h"
+#include "sdkconfig.h"
+
+/* =========================================================
+ * MIDI storm benchmark (development only)
+ *
+ * Drives scripted worst cases through the matrix simulator API and
+ * measures event -> wire latency per route:
+ * - strum6:      six-string down/up strums
+ * - legato_bend: fast hammer-on/pull-off legato while the bend moves
+ * - route_flip:  strums while the output routes change mid-phrase
+ *
+ * "Wire" is the moment a backend hands bytes to its transport (UART
+ * driver / TinyUSB). Each scenario prints one JSON line per route with
+ * note and bend latency (p50/p99/max), drops, coalesce counts and the
+ * queue high-water mark.
+ *
+ * The probes below are no-ops unless CONFIG_EMIUET_MIDI_BENCH is set.
+ * ========================================================= */
+
+/* Defensive defaults for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_MIDI_BENCH
+#define CONFIG_EMIUET_MIDI_BENCH 0
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_BENCH_REPEAT
+#define CONFIG_EMIUET_MIDI_BENCH_REPEAT 50
+#endif
+
+#if CONFIG_EMIUET_MIDI_BENCH
+
+/* Run all scenarios (blocking). repeat scales every scenario.
+ * Returns the total number of dropped events across routes.
+ */
+uint32_t midi_bench_run(uint32_t repeat);
+
+/* midi_out_send() accepted a message */
+void midi_bench_probe_send(const midi_msg_t *msg);
+
+/* A backend handed bytes / UMP words to its transport */
+void midi_bench_probe_wire(uint32_t route, const uint8_t *bytes, size_t len);
+void midi_bench_probe_wire_ump(uint32_t route, const uint32_t *words, size_t n);
+
+#else
+
+static inline void midi_bench_probe_send(const midi_msg_t *msg) { (void)msg; }
+
+static inline void midi_bench_probe_wire(uint32_t route, const uint8_t *bytes, size_t len)
+{
+    (void)route;
+    (void)bytes;
+    (void)len;
+}
+
+static inline void midi_bench_probe_wire_ump(uint32_t route, const uint32_t *words, size_t n)
+{
+    (void)route;
+    (void)words;
+    (void)n;
+}
+
+#endif
@@ -0,0 +1,277 @@
+#include "midi_in.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+/* =========================================================
+ * Streaming parser
+ * ========================================================= */
+
+static inline bool is_realtime(uint8_t b) { return b >= 0xF8u; }
+static inline bool is_status(uint8_t b) { return (b & 0x80u) != 0; }
+
+/* Number of data bytes following a status byte (0xFF == not a short message) */
+static uint8_t data_len_for_status(uint8_t status)
+{
+    switch (status & 0xF0u) {
+        case 0x80u: /* Note Off */
+        case 0x90u: /* Note On */
+        case 0xA0u: /* Poly Pressure */
+        case 0xB0u: /* CC */
+        case 0xE0u: /* Pitch Bend */
+            return 2;
+        case 0xC0u: /* Program Change */
+        case 0xD0u: /* Channel Pressure */
+            return 1;
+        default:
+            break;
+    }
+
+    switch (status) {
+        case 0xF1u: /* MTC quarter frame */
+        case 0xF3u: /* Song Select */
+            return 1;
+        case 0xF2u: /* Song Position */
+            return 2;
+        case 0xF6u: /* Tune Request */
+            return 0;
+        default:
+            /* F4/F5 undefined, F0/F7 handled separately */
+            return 0xFFu;
+    }
+}
+
+static void emit_msg(midi_in_parser_t *p, uint8_t status, const uint8_t *data, uint8_t n)
+{
+    p->msgs++;
+    if (!p->handlers || !p->handlers->on_msg) return;
+
+    midi_in_msg_t m = {
+        .status = status,
+        .len = (uint8_t)(1u + n),
+    };
+    if (n > 0) m.data[0] = data[0];
+    if (n > 1) m.data[1] = data[1];
+    p->handlers->on_msg(&m, p->handlers->ctx);
+}
+
+static void emit_realtime(midi_in_parser_t *p, uint8_t status)
+{
+    p->msgs++;
+    if (!p->handlers || !p->handlers->on_realtime) return;
+
+    const midi_in_msg_t m = {
+        .status = status,
+        .len = 1,
+    };
+    p->handlers->on_realtime(&m, p->handlers->ctx);
+}
+
+static void end_sysex(midi_in_parser_t *p, bool terminated)
+{
+    const bool truncated = p->sysex_overflow || !terminated;
+    p->sysex_msgs++;
+    if (truncated) p->sysex_truncated++;
+
+    if (p->handlers && p->handlers->on_sysex) {
+        p->handlers->on_sysex(p->sysex_buf, p->sysex_len, truncated, p->handlers->ctx);
+    }
+
+    p->in_sysex = false;
+    p->sysex_overflow = false;
+    p->sysex_len = 0;
+}
+
+void midi_in_parser_reset(midi_in_parser_t *p)
+{
+    if (!p) return;
+    p->status = 0;
+    p->data_count = 0;
+    p->data_needed = 0;
+    p->in_sysex = false;
+    p->sysex_overflow = false;
+    p->sysex_len = 0;
+}
+
+void midi_in_parser_init(midi_in_parser_t *p, const midi_in_handlers_t *handlers)
+{
+    if (!p) return;
+    memset(p, 0, sizeof(*p));
+    p->handlers = handlers;
+}
+
+static void feed_byte(midi_in_parser_t *p, uint8_t b)
+{
+    /* Realtime bytes may appear anywhere (even inside SysEx) and must not
+     * disturb the message being assembled.
+     */
+    if (is_realtime(b)) {
+        emit_realtime(p, b);
+        return;
+    }
+
+    if (is_status(b)) {
+        /* Any non-realtime status byte terminates a pending SysEx. */
+        if (p->in_sysex) {
+            end_sysex(p, b == 0xF7u);
+            if (b == 0xF7u) return;
+        } else if (b == 0xF7u) {
+            /* Stray EOX */
+            return;
+        }
+
+        p->data_count = 0;
+
+        if (b == 0xF0u) {
+            p->status = 0; /* SysEx cancels running status */
+            p->in_sysex = true;
+            p->sysex_overflow = false;
+            p->sysex_len = 0;
+            return;
+        }
+
+        const uint8_t needed = data_len_for_status(b);
+        if (needed == 0xFFu) {
+            /* Undefined system common: ignore and cancel running status */
+            p->status = 0;
+            return;
+        }
+
+        if (needed == 0) {
+            /* Tune Request: complete immediately, cancels running status */
+            p->status = 0;
+            emit_msg(p, b, NULL, 0);
+            return;
+        }
+
+        p->status = b;
+        p->data_needed = needed;
+        return;
+    }
+
+    /* Data byte */
+    if (p->in_sysex) {
+        if (p->sysex_len < sizeof(p->sysex_buf)) {
+            p->sysex_buf[p->sysex_len++] = b;
+        } else {
+            p->sysex_overflow = true;
+        }
+        return;
+    }
+
+    if (p->status == 0) {
+        p->stray_data++;
+        return;
+    }
+
+    p->data[p->data_count++] = b;
+    if (p->data_count < p->data_needed) return;
+
+    const uint8_t status = p->status;
+    p->data_count = 0;
+    /* Running status applies to channel messages only. */
+    if (status >= 0xF0u) p->status = 0;
+    emit_msg(p, status, p->data, p->data_needed);
+}
+
+void midi_in_parser_feed(midi_in_parser_t *p, const uint8_t *bytes, size_t len)
+{
+    if (!p || !bytes) return;
+    for (size_t i = 0; i < len; ++i) {
+        feed_byte(p, bytes[i]);
+    }
+    p->bytes += (uint32_t)len;
+}
+
+/* =========================================================
+ * Global dispatch
+ * ========================================================= */
+
+static const midi_in_handlers_t *s_handlers[MIDI_IN_MAX_HANDLERS];
+static portMUX_TYPE s_handlers_mux = portMUX_INITIALIZER_UNLOCKED;
+
+bool midi_in_register_handlers(const midi_in_handlers_t *handlers)
+{
+    if (!handlers) return false;
+
+    bool ok = false;
+    portENTER_CRITICAL(&s_handlers_mux);
+    for (int i = 0; i < MIDI_IN_MAX_HANDLERS; ++i) {
+        if (s_handlers[i] == handlers) {
+            ok = true;
+            break;
+        }
+    }
+    for (int i = 0; !ok && i < MIDI_IN_MAX_HANDLERS; ++i) {
+        if (s_handlers[i] == NULL) {
+            s_handlers[i] = handlers;
+            ok = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_handlers_mux);
+    return ok;
+}
+
+void midi_in_unregister_handlers(const midi_in_handlers_t *handlers)
+{
+    portENTER_CRITICAL(&s_handlers_mux);
+    for (int i = 0; i < MIDI_IN_MAX_HANDLERS; ++i) {
+        if (s_handlers[i] == handlers) s_handlers[i] = NULL;
+    }
+    portEXIT_CRITICAL(&s_handlers_mux);
+}
+
+/* Snapshot the table so handlers run outside the critical section. */
+static int snapshot_handlers(const midi_in_handlers_t *out[MIDI_IN_MAX_HANDLERS])
+{
+    int n = 0;
+    portENTER_CRITICAL(&s_handlers_mux);
+    for (int i = 0; i < MIDI_IN_MAX_HANDLERS; ++i) {
+        if (s_handlers[i]) out[n++] = s_handlers[i];
+    }
+    portEXIT_CRITICAL(&s_handlers_mux);
+    return n;
+}
+
+static void dispatch_msg(const midi_in_msg_t *msg, void *ctx)
+{
+    (void)ctx;
+    const midi_in_handlers_t *hs[MIDI_IN_MAX_HANDLERS];
+    const int n = snapshot_handlers(hs);
+    for (int i = 0; i < n; ++i) {
+        if (hs[i]->on_msg) hs[i]->on_msg(msg, hs[i]->ctx);
+    }
+}
+
+static void dispatch_realtime(const midi_in_msg_t *msg, void *ctx)
+{
+    (void)ctx;
+    const midi_in_handlers_t *hs[MIDI_IN_MAX_HANDLERS];
+    const int n = snapshot_handlers(hs);
+    for (int i = 0; i < n; ++i) {
+        if (hs[i]->on_realtime) hs[i]->on_realtime(msg, hs[i]->ctx);
+    }
+}
+
+static void dispatch_sysex(const uint8_t *data, size_t len, bool truncated, void *ctx)
+{
+    (void)ctx;
+    const midi_in_handlers_t *hs[MIDI_IN_MAX_HANDLERS];
+    const int n = snapshot_handlers(hs);
+    for (int i = 0; i < n; ++i) {
+        if (hs[i]->on_sysex) hs[i]->on_sysex(data, len, truncated, hs[i]->ctx);
+    }
+}
+
+static const midi_in_handlers_t s_dispatch = {
+    .on_msg = dispatch_msg,
+    .on_realtime = dispatch_realtime,
+    .on_sysex = dispatch_sysex,
+    .ctx = NULL,
+};
+
+const midi_in_handlers_t *midi_in_dispatch_handlers(void)
+{
+    return &s_dispatch;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+/* =========================================================
+ * MIDI input (host -> device)
+ *
+ * Goals:
+ * - Streaming, byte-at-a-time parser with no heap and no blocking.
+ * - Running status, realtime bytes interleaved mid-message and SysEx
+ *   reassembly into a fixed buffer.
+ * - Transport-agnostic: backends (USB today) only feed bytes; consumers
+ *   (host configuration, clock sync, monitoring) register handlers.
+ * ========================================================= */
+
+/* Defensive default for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_MIDI_IN_SYSEX_MAX
+#define CONFIG_EMIUET_MIDI_IN_SYSEX_MAX 128
+#endif
+
+/* Maximum number of handler sets that can be registered at once. */
+#define MIDI_IN_MAX_HANDLERS 4
+
+/* One complete short message (channel voice/mode, system common or realtime). */
+typedef struct {
+	uint8_t status;  /* full status byte (channel in low nibble for 0x80..0xEF) */
+	uint8_t data[2];
+	uint8_t len;     /* total bytes including status (1..3) */
+} midi_in_msg_t;
+
+typedef void (*midi_in_msg_cb_t)(const midi_in_msg_t *msg, void *ctx);
+
+/* data/len exclude the framing F0/F7 bytes.
+ * truncated == true when the message exceeded the buffer or was terminated
+ * by another status byte instead of F7.
+ */
+typedef void (*midi_in_sysex_cb_t)(const uint8_t *data, size_t len, bool truncated, void *ctx);
+
+typedef struct {
+	midi_in_msg_cb_t on_msg;      /* channel voice/mode and system common */
+	midi_in_msg_cb_t on_realtime; /* 0xF8..0xFF, delivered as soon as the byte arrives */
+	midi_in_sysex_cb_t on_sysex;  /* complete (or truncated) SysEx payload */
+	void *ctx;
+} midi_in_handlers_t;
+
+typedef struct {
+	/* Parser state */
+	uint8_t status;       /* status of the message being assembled (0 == none) */
+	uint8_t data[2];
+	uint8_t data_count;
+	uint8_t data_needed;
+	bool in_sysex;
+	bool sysex_overflow;
+	size_t sysex_len;
+	uint8_t sysex_buf[CONFIG_EMIUET_MIDI_IN_SYSEX_MAX];
+
+	const midi_in_handlers_t *handlers;
+
+	/* Stats (monotonic; owned by the feeding task) */
+	uint32_t bytes;
+	uint32_t msgs;
+	uint32_t sysex_msgs;
+	uint32_t sysex_truncated;
+	uint32_t stray_data;
+} midi_in_parser_t;
+
+/* Initialize a parser. handlers may be NULL (bytes are parsed and counted only). */
+void midi_in_parser_init(midi_in_parser_t *p, const midi_in_handlers_t *handlers);
+
+/* Drop any partial message and running status (e.g. on cable unplug). */
+void midi_in_parser_reset(midi_in_parser_t *p);
+
+/* Feed raw MIDI bytes. Handlers are invoked synchronously from this call. */
+void midi_in_parser_feed(midi_in_parser_t *p, const uint8_t *bytes, size_t len);
+
+/* =========================================================
+ * Global dispatch (shared by all input transports)
+ * ========================================================= */
+
+/* Register a handler set. The struct must stay valid while registered.
+ * Handlers run in the receiving transport task; keep them short and
+ * never block (same rule as the MIDI output path).
+ */
+bool midi_in_register_handlers(const midi_in_handlers_t *handlers);
+void midi_in_unregister_handlers(const midi_in_handlers_t *handlers);
+
+/* Handler set that fans out to every registered handler set.
+ * Transports pass this to midi_in_parser_init().
+ */
+const midi_in_handlers_t *midi_in_dispatch_handlers(void);
@@ -1,6 +1,8 @@
 
 #include "midi_mpe.h"
 #include "midi_out.h"
+#include "note_map.h"
+#include <stdatomic.h>
 #include <stdbool.h>
 #include "esp_log.h"
 
@@ -8,17 +10,33 @@ static const char *TAG = "midi_mpe";
 
 #define MPE_NUM_STRINGS 6
 
-static bool g_mpe_enabled = false;
-static int g_last_active_row = -1; /* -1 == no last-active row (reset state) */
+/* Routing state is read by the scan task and the slider task (and any
+ * other producer) concurrently, so it lives in atomics.
+ */
+static _Atomic bool g_mpe_enabled = false;
 /* Internal: 0-based MIDI channel used as the base for per-string mapping.
  * 0 == MIDI channel 1.
  * Default is 1 (i.e., MIDI channel 2) to match common MPE member-channel layout.
  */
-static uint8_t g_mpe_base_channel_ch0 = 1;
+static _Atomic uint8_t g_mpe_base_channel_ch0 = 1;
+
+/* Pitch-bend target: last-active row and lock flag in one word so that
+ * "update row unless locked" is a single atomic step.
+ * - bits 0..7: row (0..5), PB_ROW_NONE == no last-active row (reset state)
+ * - bit 8: locked. When set, note activity will NOT update the row. This is
+ *   used to lock the pitch-bend target while a bend is in progress.
+ */
+#define PB_ROW_NONE 0xFFu
+#define PB_LOCKED   0x100u
+#define PB_STATE_INIT ((uint32_t)PB_ROW_NONE)
 
-/* When true, note activity will NOT update g_last_active_row. This is used
- * to lock the pitch-bend target while a bend is in progress. */
-static bool g_pb_locked = false;
+static _Atomic uint32_t g_pb_state = PB_STATE_INIT;
+
+static inline int pb_state_row(uint32_t st)
+{
+    const uint32_t row = st & 0xFFu;
+    return (row == PB_ROW_NONE) ? -1 : (int)row;
+}
 
 /* Internal default non-MPE channel (0-based): 0 == MIDI channel 1 */
 static const uint8_t g_default_channel_ch0 = 0;
@@ -43,63 +61,100 @@ static inline uint8_t ch0_to_ch1(uint8_t ch0_15)
 
 void midi_mpe_init(void)
 {
-    g_mpe_enabled = false;
-    g_last_active_row = -1;
-    g_pb_locked = false;
+    atomic_store(&g_mpe_enabled, false);
+    atomic_store(&g_pb_state, PB_STATE_INIT);
 }
 
 void midi_mpe_set_enabled(bool en)
 {
-    g_mpe_enabled = en;
+    /* Held notes' note-offs would go to the new channels: release them now.
+     * Switch before releasing: a press run that starts after the release's
+     * held-note epoch sees the new channels, and one already under way is
+     * cut by input_pipeline once the epoch moves.
+     */
+    if (atomic_exchange(&g_mpe_enabled, en) != en) {
+        note_map_rebuild();
+        midi_out_panic();
+    }
 }
 
 bool midi_mpe_is_enabled(void)
 {
-    return g_mpe_enabled;
+    return atomic_load(&g_mpe_enabled);
 }
 
 void midi_mpe_note_activity(int row)
 {
     /* Update last-active row only when not locked. If locked, keep the
      * existing target until unlocked by slider logic. */
-    if (!g_pb_locked && row >= 0 && row < MPE_NUM_STRINGS) g_last_active_row = row;
+    if (row < 0 || row >= MPE_NUM_STRINGS) return;
+
+    uint32_t st = atomic_load(&g_pb_state);
+    while ((st & PB_LOCKED) == 0) {
+        if (atomic_compare_exchange_weak(&g_pb_state, &st, (uint32_t)row)) break;
+    }
 }
 
 /* bend_value: 0..16383 (14-bit). Interpretation: 8192 == center.
  * This device uses upward-only bends: callers should map controller input
  * such that 0 -> center (8192) and max -> 16383.
  */
-void midi_mpe_apply_pitchbend(uint16_t bend_value)
+static uint8_t pitchbend_target_channel(void)
 {
     uint8_t channel_ch0 = g_default_channel_ch0;
-    if (g_mpe_enabled) {
-        if (g_last_active_row >= 0) {
-            channel_ch0 = midi_mpe_channel_for_row(g_last_active_row);
+    if (atomic_load(&g_mpe_enabled)) {
+        /* One snapshot: the row can't change between the check and the use */
+        const int row = pb_state_row(atomic_load(&g_pb_state));
+        if (row >= 0) {
+            channel_ch0 = midi_mpe_channel_for_row(row);
         } else {
             /* No last-active string selected: fall back to default channel */
             channel_ch0 = g_default_channel_ch0;
         }
     }
+    return channel_ch0;
+}
+
+void midi_mpe_apply_pitchbend(uint16_t bend_value)
+{
+    const uint8_t channel_ch0 = pitchbend_target_channel();
 
     midi_send_pitchbend(channel_ch0, bend_value);
     ESP_LOGD(TAG, "apply_pitchbend ch0=%d(ch%d) value=%d", (int)channel_ch0, (int)ch0_to_ch1(channel_ch0), (int)bend_value);
 }
 
+void midi_mpe_apply_pitchbend_hr(uint32_t bend_value32)
+{
+    const uint8_t channel_ch0 = pitchbend_target_channel();
+
+    midi_send_pitchbend_hr(channel_ch0, bend_value32);
+    ESP_LOGD(TAG, "apply_pitchbend_hr ch0=%d(ch%d) value32=0x%08lx", (int)channel_ch0, (int)ch0_to_ch1(channel_ch0),
+             (unsigned long)bend_value32);
+}
+
 int midi_mpe_get_last_active_channel(void)
 {
-    if (g_last_active_row < 0) return -1;
-    return (int)midi_mpe_channel_for_row(g_last_active_row);
+    const int row = pb_state_row(atomic_load(&g_pb_state));
+    if (row < 0) return -1;
+    return (int)midi_mpe_channel_for_row(row);
 }
 
 void midi_mpe_lock_pitchbend_target(bool locked)
 {
-    g_pb_locked = locked;
+    if (locked) {
+        (void)atomic_fetch_or(&g_pb_state, PB_LOCKED);
+    } else {
+        (void)atomic_fetch_and(&g_pb_state, ~PB_LOCKED);
+    }
     ESP_LOGD(TAG, "pb_lock set=%d", locked);
 }
 
 void midi_mpe_reset_pitchbend_target(void)
 {
-    g_last_active_row = -1;
+    /* Keep the lock bit, clear the row */
+    uint32_t st = atomic_load(&g_pb_state);
+    while (!atomic_compare_exchange_weak(&g_pb_state, &st, (st & PB_LOCKED) | PB_ROW_NONE)) {
+    }
     ESP_LOGD(TAG, "pb target reset");
 }
 
@@ -113,19 +168,24 @@ void midi_mpe_set_base_channel(uint8_t base_ch1_16)
     const uint8_t max_base_ch1_16 = (uint8_t)(16 - (MPE_NUM_STRINGS - 1)); /* 11 */
     if (base_ch1_16 < 1) base_ch1_16 = 1;
     if (base_ch1_16 > max_base_ch1_16) base_ch1_16 = max_base_ch1_16;
-    g_mpe_base_channel_ch0 = (uint8_t)(base_ch1_16 - 1);
+    if (atomic_exchange(&g_mpe_base_channel_ch0, (uint8_t)(base_ch1_16 - 1)) != (uint8_t)(base_ch1_16 - 1) &&
+        midi_mpe_is_enabled()) {
+        /* Same switch-then-release order as midi_mpe_set_enabled() */
+        note_map_rebuild();
+        midi_out_panic();
+    }
 }
 
 uint8_t midi_mpe_get_base_channel(void)
 {
-    return ch0_to_ch1(g_mpe_base_channel_ch0);
+    return ch0_to_ch1(atomic_load(&g_mpe_base_channel_ch0));
 }
 
 uint8_t midi_mpe_channel_for_row(int row)
 {
     if (row < 0) return g_default_channel_ch0;
     /* Map row 0.. to base..base+rows-1; keep within 0..15 */
-    uint32_t ch = (uint32_t)g_mpe_base_channel_ch0 + (uint32_t)row;
+    uint32_t ch = (uint32_t)atomic_load(&g_mpe_base_channel_ch0) + (uint32_t)row;
     if (ch > 15) ch = 15;
     return (uint8_t)ch;
 }
@@ -15,6 +15,12 @@ bool midi_mpe_is_enabled(void);
 /* Apply pitch bend value (0..16383) to currently active string/channel */
 void midi_mpe_apply_pitchbend(uint16_t bend_value);
 
+/* Same as midi_mpe_apply_pitchbend() with a 32-bit value
+ * (0x80000000 == center). MIDI 2.0 routes get the full value, MIDI 1.0
+ * routes get the upper 14 bits.
+ */
+void midi_mpe_apply_pitchbend_hr(uint32_t bend_value32);
+
 /* Register which string (row) was last active (0..5) */
 void midi_mpe_note_activity(int row);
 
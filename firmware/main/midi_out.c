@@ -1,49 +1,123 @@
 #include "midi_out.h"
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <string.h>
 
 #include "esp_log.h"
 #include "sdkconfig.h"
 
+#include "midi_bench.h"
+#include "midi_tx_ring.h"
+#include "midi_ump.h"
+
 /* Backends */
 bool midi_out_usb_init(void);
 bool midi_out_usb_send_bytes(const uint8_t *bytes, size_t len);
+bool midi_out_usb_ump_active(void);
+bool midi_out_usb_send_ump(const uint32_t *words, size_t n);
+size_t midi_out_usb_send_batch(const midi_tx_item_t *items, size_t n);
 
 bool midi_out_uart_trs_init(void);
 bool midi_out_uart_trs_send_bytes(const uint8_t *bytes, size_t len);
+size_t midi_out_uart_trs_send_batch(const midi_tx_item_t *items, size_t n);
 
 bool midi_out_ble_init(void);
 bool midi_out_ble_send_bytes(const uint8_t *bytes, size_t len);
+size_t midi_out_ble_send_batch(const midi_tx_item_t *items, size_t n);
+
+void midi_out_usb_get_stats(midi_out_stats_t *out);
+void midi_out_usb_reset_stats(void);
+void midi_out_uart_trs_get_stats(midi_out_stats_t *out);
+void midi_out_uart_trs_reset_stats(void);
+void midi_out_ble_get_stats(midi_out_stats_t *out);
+void midi_out_ble_reset_stats(void);
 
 static const char *TAG = "midi_out";
 
 static bool s_inited = false;
-static uint32_t s_routes = MIDI_OUT_ROUTE_USB; /* default: USB only */
+/* Read by every producer task; written by configuration */
+static _Atomic uint32_t s_routes = MIDI_OUT_ROUTE_USB; /* default: USB only */
 
 static inline uint8_t clamp_ch(uint8_t ch) { return (ch > 15) ? 15 : ch; }
 
-static bool send_bytes_to_routes(uint32_t routes, const uint8_t *bytes, size_t len)
+/* UMP group used for all MIDI 2.0 output (single function block). */
+#define MIDI_OUT_UMP_GROUP 0
+
+/* =========================================================
+ * Active notes
+ *
+ * One 128-bit set per route (index == route bit) and channel, updated at
+ * enqueue. Conservative: a note-on sets its bit even if the backend
+ * dropped it, and a note-off clears it only once queued. A flush may
+ * then send a spare note-off but never leaves a note hanging.
+ * ========================================================= */
+
+static _Atomic uint32_t s_active[MIDI_OUT_ROUTE_COUNT][16][4];
+
+static _Atomic(midi_out_release_fn_t) s_release_listener = NULL;
+
+static inline int route_index(uint32_t route)
+{
+    return __builtin_ctz(route);
+}
+
+static void track_note(uint32_t route, const uint8_t *b, size_t len, bool queued)
+{
+    if (len != 3) return;
+    const uint8_t st = (uint8_t)(b[0] & 0xF0u);
+    if (st != 0x90u && st != 0x80u) return;
+
+    _Atomic uint32_t *w = &s_active[route_index(route)][b[0] & 0x0Fu][(b[1] >> 5) & 0x03u];
+    const uint32_t bit = 1u << (b[1] & 0x1Fu);
+    const bool on = (st == 0x90u) && (b[2] != 0);
+    if (on || !queued) {
+        (void)atomic_fetch_or(w, bit);
+    } else {
+        (void)atomic_fetch_and(w, ~bit);
+    }
+}
+
+static bool send_bytes_to_routes(uint32_t routes, const midi_msg_t *msg, const uint8_t *bytes, size_t len)
 {
     bool ok = false;
     if ((routes & MIDI_OUT_ROUTE_TRS_UART) != 0) {
-        ok |= midi_out_uart_trs_send_bytes(bytes, len);
+        const bool r = midi_out_uart_trs_send_bytes(bytes, len);
+        track_note(MIDI_OUT_ROUTE_TRS_UART, bytes, len, r);
+        ok |= r;
     }
     if ((routes & MIDI_OUT_ROUTE_USB) != 0) {
-        ok |= midi_out_usb_send_bytes(bytes, len);
+        /* The host picks the protocol (USB alt setting). Only when it chose
+         * MIDI 2.0 do we send UMP; otherwise the MIDI 1.0 bytes are the fallback.
+         */
+        uint32_t words[MIDI_UMP_MAX_WORDS];
+        const size_t n = midi_out_usb_ump_active()
+                             ? midi_ump_encode_midi2(msg, MIDI_OUT_UMP_GROUP, words)
+                             : 0;
+        const bool r = (n > 0) ? midi_out_usb_send_ump(words, n) : midi_out_usb_send_bytes(bytes, len);
+        track_note(MIDI_OUT_ROUTE_USB, bytes, len, r);
+        ok |= r;
     }
     if ((routes & MIDI_OUT_ROUTE_BLE) != 0) {
-        ok |= midi_out_ble_send_bytes(bytes, len);
+        const bool r = midi_out_ble_send_bytes(bytes, len);
+        track_note(MIDI_OUT_ROUTE_BLE, bytes, len, r);
+        ok |= r;
     }
     return ok;
 }
 
-static bool encode_and_send(const midi_msg_t *msg)
+/* Longest MIDI 1.0 encoding of one message (a 14-bit CC pair) */
+#define MIDI_OUT_MSG_BYTES_MAX 6
+
+static inline bool is_cc_pair(const midi_msg_t *msg)
 {
-    if (!msg) return false;
+    return msg->type == MIDI_MSG_CC && msg->data.cc.pair14 && msg->data.cc.cc < 32u;
+}
 
+/* MIDI 1.0 bytes of msg; 0 for unsupported types */
+static size_t encode_msg(const midi_msg_t *msg, uint8_t bytes[MIDI_OUT_MSG_BYTES_MAX])
+{
     uint8_t ch = clamp_ch(msg->channel);
-    uint8_t bytes[3] = {0};
     size_t len = 0;
 
     switch (msg->type) {
@@ -66,6 +140,12 @@ static bool encode_and_send(const midi_msg_t *msg)
             bytes[1] = msg->data.cc.cc & 0x7Fu;
             bytes[2] = msg->data.cc.value & 0x7Fu;
             len = 3;
+            if (is_cc_pair(msg)) {
+                bytes[3] = bytes[0];
+                bytes[4] = (uint8_t)(bytes[1] + 32u);
+                bytes[5] = msg->data.cc.value_lsb & 0x7Fu;
+                len = 6;
+            }
             break;
 
         case MIDI_MSG_PITCH_BEND: {
@@ -91,10 +171,115 @@ static bool encode_and_send(const midi_msg_t *msg)
             break;
 
         default:
-            return false;
+            return 0;
+    }
+
+    return len;
+}
+
+static bool encode_and_send(uint32_t routes, const midi_msg_t *msg)
+{
+    if (!msg) return false;
+
+    uint8_t bytes[MIDI_OUT_MSG_BYTES_MAX] = {0};
+    const size_t len = encode_msg(msg, bytes);
+    if (len == 0) return false;
+
+    return send_bytes_to_routes(routes, msg, bytes, len);
+}
+
+static void track_notes(uint32_t route, const midi_tx_item_t *items, size_t n, bool queued)
+{
+    for (size_t i = 0; i < n; ++i) track_note(route, items[i].bytes, items[i].len, queued);
+}
+
+/* One chunk (n <= MIDI_OUT_BATCH_MAX) against a single routes snapshot,
+ * so a route change never splits a chord. Like encode_and_send(), true
+ * when some route took every message.
+ */
+static bool encode_and_send_batch(uint32_t routes, const midi_msg_t *msgs, size_t n)
+{
+    midi_tx_item_t items[MIDI_OUT_BATCH_MAX];
+    const midi_msg_t *src[MIDI_OUT_BATCH_MAX];
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t bytes[MIDI_OUT_MSG_BYTES_MAX] = {0};
+        const size_t len = encode_msg(&msgs[i], bytes);
+        if (len == 0 || len > sizeof(items[0].bytes)) continue;
+        midi_bench_probe_send(&msgs[i]);
+        items[count].len = (uint8_t)len;
+        memcpy(items[count].bytes, bytes, len);
+        src[count++] = &msgs[i];
     }
+    if (count == 0) return false;
 
-    return send_bytes_to_routes(s_routes, bytes, len);
+    bool ok = false;
+    if ((routes & MIDI_OUT_ROUTE_TRS_UART) != 0) {
+        const bool r = midi_out_uart_trs_send_batch(items, count) == count;
+        track_notes(MIDI_OUT_ROUTE_TRS_UART, items, count, r);
+        ok |= r;
+    }
+    if ((routes & MIDI_OUT_ROUTE_USB) != 0) {
+        if (midi_out_usb_ump_active()) {
+            /* MIDI 2.0 messages take the per-message UMP path */
+            bool all = true;
+            for (size_t i = 0; i < count; ++i) {
+                all &= send_bytes_to_routes(MIDI_OUT_ROUTE_USB, src[i], items[i].bytes, items[i].len);
+            }
+            ok |= all;
+        } else {
+            const bool r = midi_out_usb_send_batch(items, count) == count;
+            track_notes(MIDI_OUT_ROUTE_USB, items, count, r);
+            ok |= r;
+        }
+    }
+    if ((routes & MIDI_OUT_ROUTE_BLE) != 0) {
+        const bool r = midi_out_ble_send_batch(items, count) == count;
+        track_notes(MIDI_OUT_ROUTE_BLE, items, count, r);
+        ok |= r;
+    }
+    return ok && count == n;
+}
+
+/* Note-off for every tracked note of the given routes, batched per route.
+ * Cost is O(sounding notes), not 16 x 128 blanket messages.
+ */
+static void release_notes(uint32_t routes)
+{
+    for (int ri = 0; ri < MIDI_OUT_ROUTE_COUNT; ++ri) {
+        const uint32_t route = 1u << ri;
+        if ((routes & route) == 0) continue;
+
+        midi_msg_t offs[MIDI_OUT_BATCH_MAX];
+        size_t n = 0;
+        for (uint8_t ch = 0; ch < 16; ++ch) {
+            for (uint8_t w = 0; w < 4; ++w) {
+                uint32_t bits = atomic_exchange(&s_active[ri][ch][w], 0);
+                while (bits) {
+                    const uint8_t note = (uint8_t)(w * 32u + (uint32_t)__builtin_ctz(bits));
+                    bits &= bits - 1u;
+                    offs[n] = (midi_msg_t){.type = MIDI_MSG_NOTE_OFF, .channel = ch};
+                    offs[n].data.note.note = note;
+                    if (++n == MIDI_OUT_BATCH_MAX) {
+                        (void)encode_and_send_batch(route, offs, n);
+                        n = 0;
+                    }
+                }
+            }
+        }
+        if (n > 0) (void)encode_and_send_batch(route, offs, n);
+    }
+}
+
+/* A send that read the routes before midi_out_set_routes() took one out
+ * may have queued a note-on there after its release. Release such routes
+ * again; only a send straddling the change finds any.
+ */
+static void release_removed(uint32_t routes)
+{
+    const uint32_t gone = routes & ~atomic_load(&s_routes);
+    if (gone != 0) release_notes(gone);
 }
 
 void midi_out_init_ex(const midi_out_config_t *cfg)
@@ -133,13 +318,20 @@ void midi_out_set_routes(uint32_t routes)
         ESP_LOGW(TAG, "midi_out_set_routes(routes=0) ignored");
         return;
     }
-    s_routes = routes;
-    ESP_LOGI(TAG, "midi_out routes=0x%08lx", (unsigned long)s_routes);
+    const uint32_t old = atomic_exchange(&s_routes, routes);
+    ESP_LOGI(TAG, "midi_out routes=0x%08lx", (unsigned long)routes);
+
+    /* Later note-offs will not reach routes taken out, so release their
+     * notes now. Other routes keep sounding, and held-key counts stay: a
+     * route added back gets nothing for keys already held, only a spare
+     * note-off when they are released.
+     */
+    if (s_inited && (old & ~routes) != 0) release_notes(old & ~routes);
 }
 
 uint32_t midi_out_get_routes(void)
 {
-    return s_routes;
+    return atomic_load(&s_routes);
 }
 
 bool midi_out_send(const midi_msg_t *msg)
@@ -148,7 +340,10 @@ bool midi_out_send(const midi_msg_t *msg)
         midi_out_init_ex(NULL);
     }
 
-    bool ok = encode_and_send(msg);
+    midi_bench_probe_send(msg);
+    const uint32_t routes = atomic_load(&s_routes);
+    bool ok = encode_and_send(routes, msg);
+    release_removed(routes);
     if (!ok) {
         /* keep logs light; detailed backend errors are logged there */
         ESP_LOGD(TAG, "midi_out_send failed type=%d ch=%d", (int)msg->type, (int)msg->channel);
@@ -156,6 +351,88 @@ bool midi_out_send(const midi_msg_t *msg)
     return ok;
 }
 
+bool midi_out_send_batch(const midi_msg_t *msgs, size_t n)
+{
+    return midi_out_send_batch_to(MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART | MIDI_OUT_ROUTE_BLE, msgs, n);
+}
+
+bool midi_out_send_batch_to(uint32_t routes, const midi_msg_t *msgs, size_t n)
+{
+    if (!msgs) return false;
+    if (!s_inited) {
+        midi_out_init_ex(NULL);
+    }
+
+    routes &= atomic_load(&s_routes);
+    if (routes == 0) return false;
+
+    bool ok = true;
+    for (size_t off = 0; off < n;) {
+        if (is_cc_pair(&msgs[off])) {
+            /* A 14-bit pair does not fit a queue item; it goes to the
+             * backends' coalesced CC path on its own, in order.
+             */
+            uint8_t bytes[MIDI_OUT_MSG_BYTES_MAX] = {0};
+            const size_t len = encode_msg(&msgs[off], bytes);
+            midi_bench_probe_send(&msgs[off]);
+            ok &= send_bytes_to_routes(routes, &msgs[off], bytes, len);
+            off++;
+            continue;
+        }
+        size_t chunk = 0;
+        while (off + chunk < n && chunk < MIDI_OUT_BATCH_MAX && !is_cc_pair(&msgs[off + chunk])) chunk++;
+        ok &= encode_and_send_batch(routes, &msgs[off], chunk);
+        off += chunk;
+    }
+    release_removed(routes);
+    if (!ok) {
+        ESP_LOGD(TAG, "midi_out_send_batch incomplete n=%u", (unsigned)n);
+    }
+    return ok;
+}
+
+void midi_out_panic(void)
+{
+    /* Listener first: a note-on queued after the release below is then
+     * seen by its producer as straddling it.
+     */
+    const midi_out_release_fn_t fn = atomic_load_explicit(&s_release_listener, memory_order_acquire);
+    if (fn) fn();
+
+    if (s_inited) release_notes(MIDI_OUT_ROUTE_USB | MIDI_OUT_ROUTE_TRS_UART | MIDI_OUT_ROUTE_BLE);
+}
+
+void midi_out_set_release_listener(midi_out_release_fn_t fn)
+{
+    atomic_store_explicit(&s_release_listener, fn, memory_order_release);
+}
+
+bool midi_out_get_stats(uint32_t route, midi_out_stats_t *out)
+{
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    switch (route) {
+        case MIDI_OUT_ROUTE_USB:
+            midi_out_usb_get_stats(out);
+            return true;
+        case MIDI_OUT_ROUTE_TRS_UART:
+            midi_out_uart_trs_get_stats(out);
+            return true;
+        case MIDI_OUT_ROUTE_BLE:
+            midi_out_ble_get_stats(out);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void midi_out_reset_stats(void)
+{
+    midi_out_usb_reset_stats();
+    midi_out_uart_trs_reset_stats();
+    midi_out_ble_reset_stats();
+}
+
 /* =========================================================
  * Compatibility wrappers
  * ========================================================= */
@@ -193,6 +470,22 @@ void midi_send_cc(uint8_t channel, uint8_t cc, uint8_t value)
     (void)midi_out_send(&m);
 }
 
+void midi_send_cc14(uint8_t channel, uint8_t cc, uint16_t value14)
+{
+    if (value14 > 16383) value14 = 16383;
+    midi_msg_t m = {
+        .type = MIDI_MSG_CC,
+        .channel = channel,
+        .hires = true,
+    };
+    m.data.cc.cc = cc;
+    m.data.cc.value = (uint8_t)(value14 >> 7);
+    m.data.cc.value_lsb = (uint8_t)(value14 & 0x7Fu);
+    m.data.cc.pair14 = true;
+    m.data.cc.value32 = midi_ump_value_14_to_32(value14);
+    (void)midi_out_send(&m);
+}
+
 void midi_send_pitchbend(uint8_t channel, uint16_t value)
 {
     midi_msg_t m = {
@@ -203,6 +496,18 @@ void midi_send_pitchbend(uint8_t channel, uint16_t value)
     (void)midi_out_send(&m);
 }
 
+void midi_send_pitchbend_hr(uint8_t channel, uint32_t value32)
+{
+    midi_msg_t m = {
+        .type = MIDI_MSG_PITCH_BEND,
+        .channel = channel,
+        .hires = true,
+    };
+    m.data.pitchbend.value = (uint16_t)(value32 >> 18); /* upper 14 bits */
+    m.data.pitchbend.value32 = value32;
+    (void)midi_out_send(&m);
+}
+
 void midi_send_ch_pressure(uint8_t channel, uint8_t value)
 {
     midi_msg_t m = {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* =========================================================
@@ -18,6 +19,8 @@ typedef enum {
 	MIDI_OUT_ROUTE_BLE = 1u << 2,
 } midi_out_routes_t;
 
+#define MIDI_OUT_ROUTE_COUNT 3
+
 typedef struct {
 	uint32_t routes; /* bitmask of midi_out_routes_t */
 } midi_out_config_t;
@@ -34,17 +37,32 @@ typedef enum {
 typedef struct {
 	midi_msg_type_t type;
 	uint8_t channel; /* 0..15 */
+	/* When true, the 16/32-bit fields below are authoritative for routes that
+	 * carry MIDI 2.0 (UMP). MIDI 1.0 routes always use the 7/14-bit fields,
+	 * so producers must fill both.
+	 */
+	bool hires;
 	union {
 		struct {
 			uint8_t note;
 			uint8_t velocity;
+			uint16_t velocity16; /* MIDI 2.0 velocity (hires) */
+			uint8_t attr_type;   /* MIDI 2.0 per-note attribute type (0 == none) */
+			uint16_t attr_data;  /* MIDI 2.0 per-note attribute data */
 		} note;
 		struct {
 			uint8_t cc;
 			uint8_t value;
+			uint32_t value32; /* MIDI 2.0 controller value (hires) */
+			/* 14-bit controller (cc < 32): value is the MSB and value_lsb
+			 * goes out on cc + 32 right behind it, as one message.
+			 */
+			bool pair14;
+			uint8_t value_lsb;
 		} cc;
 		struct {
-			uint16_t value; /* 0..16383 (14-bit), 8192 == center */
+			uint16_t value;   /* 0..16383 (14-bit), 8192 == center */
+			uint32_t value32; /* MIDI 2.0 32-bit bend (hires), 0x80000000 == center */
 		} pitchbend;
 		struct {
 			uint8_t value; /* 0..127 */
@@ -70,12 +88,61 @@ uint32_t midi_out_get_routes(void);
 /* Send a structured MIDI message to all active routes. */
 bool midi_out_send(const midi_msg_t *msg);
 
+/* Send several messages (e.g. one scan cycle's note changes) in order.
+ * Each backend reserves queue space once and wakes its sender once, and
+ * the sender hands the group to its transport in as few writes as it can.
+ * Returns true when every message reached at least one route.
+ */
+bool midi_out_send_batch(const midi_msg_t *msgs, size_t n);
+
+/* As midi_out_send_batch(), limited to the active routes among `routes`. */
+bool midi_out_send_batch_to(uint32_t routes, const midi_msg_t *msgs, size_t n);
+
+/* Messages handed to a backend per call; larger batches are split. */
+#define MIDI_OUT_BATCH_MAX 32
+
+/* Note-off for every note still sounding on any route (tracked per route
+ * and channel at enqueue). midi_out_set_routes() does the same for just
+ * the routes it takes out. Callers changing the note -> channel mapping
+ * (e.g. MPE toggle) call it right after the change.
+ */
+void midi_out_panic(void);
+
+/* Called by every midi_out_panic() before its note-offs are queued, so
+ * state above midi_out that tracks sounding notes (input_pipeline's
+ * held-key counts) starts over. It runs on the releasing task: it should
+ * only post the reset for the state's owner. One listener; NULL clears it.
+ */
+typedef void (*midi_out_release_fn_t)(void);
+void midi_out_set_release_listener(midi_out_release_fn_t fn);
+
+/* Per-route transport counters (since init or the last reset) */
+typedef struct {
+	uint32_t q_hwm;        /* discrete-event queue high-water mark */
+	uint32_t drop_queue;   /* queue full at enqueue */
+	uint32_t drop_write;   /* transport write failed */
+	uint32_t coalesce_pb;  /* pitch bend values replaced before sending */
+	uint32_t coalesce_cc1; /* CC#1 values replaced before sending */
+} midi_out_stats_t;
+
+/* Copy counters of one route (a single midi_out_routes_t bit). */
+bool midi_out_get_stats(uint32_t route, midi_out_stats_t *out);
+void midi_out_reset_stats(void);
+
 /* =========================================================
  * Compatibility wrappers (existing call sites)
  * ========================================================= */
 void midi_send_note_on(uint8_t channel, uint8_t note, uint8_t velocity);
 void midi_send_note_off(uint8_t channel, uint8_t note, uint8_t velocity);
 void midi_send_cc(uint8_t channel, uint8_t cc, uint8_t value);
+/* 14-bit controller (cc 0..31, value 0..16383) as an MSB/LSB pair on
+ * MIDI 1.0 routes; UMP routes receive one 32-bit control change.
+ */
+void midi_send_cc14(uint8_t channel, uint8_t cc, uint16_t value14);
 void midi_send_pitchbend(uint8_t channel, uint16_t value);
+/* 32-bit pitch bend (0x80000000 == center). MIDI 1.0 routes receive the
+ * upper 14 bits; UMP routes receive the full value.
+ */
+void midi_send_pitchbend_hr(uint8_t channel, uint32_t value32);
 void midi_send_ch_pressure(uint8_t channel, uint8_t value);
 void midi_send_program_change(uint8_t channel, uint8_t program);
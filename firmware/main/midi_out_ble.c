@@ -1,8 +1,10 @@
 #include "midi_out.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "sdkconfig.h"
 
@@ -18,9 +20,15 @@
 #define CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY 6
 #endif
 
+#ifndef CONFIG_EMIUET_MIDI_BLE_CONN_INTERVAL_US
+#define CONFIG_EMIUET_MIDI_BLE_CONN_INTERVAL_US 7500
+#endif
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+
+#include "midi_tx_ring.h"
+#include "task_layout.h"
 
 static const char *TAG = "midi_out_ble";
 
@@ -32,36 +40,29 @@ static const char *TAG = "midi_out_ble";
  * Actual BLE-MIDI transport will be implemented later.
  */
 
-typedef struct {
-    uint8_t len;
-    uint8_t bytes[3];
-} midi_tx_item_t;
+/* Discrete events per notification: a default 20-byte ATT payload holds
+ * the BLE-MIDI header plus four timestamped 3-byte messages.
+ */
+#define BLE_TX_BATCH 4
 
 static bool s_inited = false;
-static QueueHandle_t s_ble_q = NULL;
 static TaskHandle_t s_ble_tx_task = NULL;
-static portMUX_TYPE s_ble_coalesce_mux = portMUX_INITIALIZER_UNLOCKED;
 
-static bool s_ble_pb_pending[16] = {0};
-static uint8_t s_ble_pb_lsb[16] = {0};
-static uint8_t s_ble_pb_msb[16] = {0};
+MIDI_TX_RING_STORAGE(s_ble_q, midi_tx_item_t, CONFIG_EMIUET_MIDI_BLE_QUEUE_LEN);
+static midi_tx_ring_t s_ble_ring;
 
-static bool s_ble_cc1_pending[16] = {0};
-static uint8_t s_ble_cc1_val[16] = {0};
+/* Latest-wins cells: pitch bend (lsb | msb << 7), CC#1 (7-bit) */
+static midi_tx_latest_t s_ble_pb_latest[16];
+static midi_tx_latest_t s_ble_cc1_latest[16];
 
-static uint32_t s_ble_drop_queue = 0;
-static uint32_t s_ble_drop_send = 0;
-static uint32_t s_ble_coalesce_pb = 0;
-static uint32_t s_ble_coalesce_cc1 = 0;
-static uint32_t s_ble_q_hwm = 0;
+static _Atomic uint32_t s_ble_drop_queue = 0;
+static _Atomic uint32_t s_ble_drop_send = 0;
+static _Atomic uint32_t s_ble_coalesce_pb = 0;
+static _Atomic uint32_t s_ble_coalesce_cc1 = 0;
 static TickType_t s_ble_last_stats_log_tick = 0;
 
-static inline void ble_maybe_update_hwm(void)
-{
-    if (!s_ble_q) return;
-    const UBaseType_t used = uxQueueMessagesWaiting(s_ble_q);
-    if (used > s_ble_q_hwm) s_ble_q_hwm = (uint32_t)used;
-}
+/* Next connection event (sender task only) */
+static int64_t s_ble_next_conn_event_us = 0;
 
 static void ble_maybe_log_stats(void)
 {
@@ -72,7 +73,7 @@ static void ble_maybe_log_stats(void)
     if (s_ble_drop_queue || s_ble_drop_send || s_ble_coalesce_pb || s_ble_coalesce_cc1) {
         ESP_LOGW(TAG,
                  "stats q_hwm=%lu drop{q=%lu send=%lu} coalesce{pb=%lu cc1=%lu}",
-                 (unsigned long)s_ble_q_hwm,
+                 (unsigned long)midi_tx_ring_hwm(&s_ble_ring),
                  (unsigned long)s_ble_drop_queue,
                  (unsigned long)s_ble_drop_send,
                  (unsigned long)s_ble_coalesce_pb,
@@ -86,11 +87,6 @@ static inline bool is_pitchbend_3(const uint8_t *b, size_t len)
     return (len == 3) && ((b[0] & 0xF0u) == 0xE0u);
 }
 
-static inline bool is_cc1_3(const uint8_t *b, size_t len)
-{
-    return (len == 3) && ((b[0] & 0xF0u) == 0xB0u) && ((b[1] & 0x7Fu) == 1u);
-}
-
 static bool ble_send_lowlevel(const uint8_t *bytes, size_t len)
 {
     (void)bytes;
@@ -108,46 +104,45 @@ static bool ble_send_lowlevel(const uint8_t *bytes, size_t len)
 static void ble_flush_coalesced_once(void)
 {
     for (int ch = 0; ch < 16; ++ch) {
-        bool pb = false;
-        uint8_t pb_lsb = 0;
-        uint8_t pb_msb = 0;
-
-        portENTER_CRITICAL(&s_ble_coalesce_mux);
-        pb = s_ble_pb_pending[ch];
-        if (pb) {
-            pb_lsb = s_ble_pb_lsb[ch];
-            pb_msb = s_ble_pb_msb[ch];
-            s_ble_pb_pending[ch] = false;
-        }
-        portEXIT_CRITICAL(&s_ble_coalesce_mux);
-
-        if (pb) {
-            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), pb_lsb, pb_msb};
+        uint32_t pb_v = 0;
+        if (midi_tx_latest_take(&s_ble_pb_latest[ch], &pb_v)) {
+            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), (uint8_t)(pb_v & 0x7Fu), (uint8_t)((pb_v >> 7) & 0x7Fu)};
             if (!ble_send_lowlevel(b, sizeof(b))) {
                 s_ble_drop_send++;
             }
         }
 
-        bool cc1 = false;
-        uint8_t cc1_v = 0;
-
-        portENTER_CRITICAL(&s_ble_coalesce_mux);
-        cc1 = s_ble_cc1_pending[ch];
-        if (cc1) {
-            cc1_v = s_ble_cc1_val[ch];
-            s_ble_cc1_pending[ch] = false;
-        }
-        portEXIT_CRITICAL(&s_ble_coalesce_mux);
-
-        if (cc1) {
-            uint8_t b[3] = {(uint8_t)(0xB0u | (uint8_t)ch), 1u, (uint8_t)(cc1_v & 0x7Fu)};
-            if (!ble_send_lowlevel(b, sizeof(b))) {
+        uint32_t cc1_v = 0;
+        if (midi_tx_latest_take(&s_ble_cc1_latest[ch], &cc1_v)) {
+            uint8_t b[6];
+            if (!ble_send_lowlevel(b, midi_tx_cc1_encode((uint8_t)ch, cc1_v, b))) {
                 s_ble_drop_send++;
             }
         }
     }
 }
 
+/* Coalesced values go out once per connection event: a notification
+ * carries the newest bend rather than a backlog of stale ones. The grid
+ * is a timer on the configured interval until the transport can take
+ * the stack's connection-event callback instead. Returns the us until
+ * the next event when it is not due yet.
+ */
+static uint32_t ble_flush_coalesced_at_conn_event(void)
+{
+    const int64_t now = esp_timer_get_time();
+    if (now < s_ble_next_conn_event_us) return (uint32_t)(s_ble_next_conn_event_us - now);
+
+    ble_flush_coalesced_once();
+    const int64_t interval = CONFIG_EMIUET_MIDI_BLE_CONN_INTERVAL_US;
+    if (s_ble_next_conn_event_us == 0 || now - s_ble_next_conn_event_us >= interval) {
+        s_ble_next_conn_event_us = now + interval; /* idle gap: restart the grid */
+    } else {
+        s_ble_next_conn_event_us += interval;
+    }
+    return 0;
+}
+
 static void ble_tx_task(void *arg)
 {
     (void)arg;
@@ -155,27 +150,37 @@ static void ble_tx_task(void *arg)
     int sent_since_flush = 0;
 
     while (1) {
-        midi_tx_item_t item = {0};
-        if (s_ble_q && xQueueReceive(s_ble_q, &item, pdMS_TO_TICKS(10)) == pdTRUE) {
-            ble_maybe_update_hwm();
-            if (!ble_send_lowlevel(item.bytes, item.len)) {
-                s_ble_drop_send++;
+        midi_tx_item_t items[BLE_TX_BATCH];
+        const size_t n = midi_tx_ring_peek_n(&s_ble_ring, items, BLE_TX_BATCH);
+        if (n > 0) {
+            /* One packet per group; the packetizer will add header/timestamps */
+            uint8_t buf[BLE_TX_BATCH * 3];
+            size_t len = 0;
+            for (size_t i = 0; i < n; ++i) {
+                memcpy(&buf[len], items[i].bytes, items[i].len);
+                len += items[i].len;
+            }
+            midi_tx_ring_pop_n(&s_ble_ring, n);
+
+            if (!ble_send_lowlevel(buf, len)) {
+                s_ble_drop_send += (uint32_t)n;
             } else {
-                sent_since_flush++;
+                sent_since_flush += (int)n;
             }
 
             if (sent_since_flush >= FLUSH_EVERY_N_EVENTS) {
                 sent_since_flush = 0;
-                ble_flush_coalesced_once();
+                (void)ble_flush_coalesced_at_conn_event();
             }
 
             ble_maybe_log_stats();
             continue;
         }
 
-        ble_flush_coalesced_once();
+        midi_tx_ring_clear_kick(&s_ble_ring);
+        const uint32_t wait_us = ble_flush_coalesced_at_conn_event();
         ble_maybe_log_stats();
-        taskYIELD();
+        midi_tx_ring_wait(&s_ble_ring, midi_tx_budget_ticks(wait_us, pdMS_TO_TICKS(10)));
     }
 }
 
@@ -186,33 +191,46 @@ bool midi_out_ble_init(void)
     /* Keep BLE transport stubbed for now; we still set up the non-blocking path. */
     ESP_LOGI(TAG, "BLE-MIDI transport not implemented yet (stub)");
 
-    if (s_ble_q == NULL) {
-        s_ble_q = xQueueCreate(CONFIG_EMIUET_MIDI_BLE_QUEUE_LEN, sizeof(midi_tx_item_t));
-        if (s_ble_q == NULL) {
-            ESP_LOGW(TAG, "failed to create BLE queue");
-            return false;
-        }
-    }
+    MIDI_TX_RING_INIT(&s_ble_ring, s_ble_q);
 
     if (s_ble_tx_task == NULL) {
         BaseType_t ok = xTaskCreatePinnedToCore(ble_tx_task,
                                                "midi_ble_tx",
-                                               4096,
+                                               TASK_MIDI_BLE_TX_STACK,
                                                NULL,
-                                               CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY,
+                                               TASK_MIDI_BLE_TX_PRIO,
                                                &s_ble_tx_task,
-                                               0);
+                                               TASK_MIDI_BLE_TX_CORE);
         if (ok != pdPASS) {
             s_ble_tx_task = NULL;
             ESP_LOGW(TAG, "failed to create BLE sender task");
             return false;
         }
+        midi_tx_ring_set_consumer(&s_ble_ring, s_ble_tx_task);
     }
 
     s_inited = true;
     return true;
 }
 
+void midi_out_ble_get_stats(midi_out_stats_t *out)
+{
+    out->q_hwm = midi_tx_ring_hwm(&s_ble_ring);
+    out->drop_queue = s_ble_drop_queue;
+    out->drop_write = s_ble_drop_send;
+    out->coalesce_pb = s_ble_coalesce_pb;
+    out->coalesce_cc1 = s_ble_coalesce_cc1;
+}
+
+void midi_out_ble_reset_stats(void)
+{
+    midi_tx_ring_reset_hwm(&s_ble_ring);
+    s_ble_drop_queue = 0;
+    s_ble_drop_send = 0;
+    s_ble_coalesce_pb = 0;
+    s_ble_coalesce_cc1 = 0;
+}
+
 bool midi_out_ble_send_bytes(const uint8_t *bytes, size_t len)
 {
     if (!s_inited) return false;
@@ -220,37 +238,54 @@ bool midi_out_ble_send_bytes(const uint8_t *bytes, size_t len)
 
     if (is_pitchbend_3(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_ble_coalesce_mux);
-        if (s_ble_pb_pending[ch]) s_ble_coalesce_pb++;
-        s_ble_pb_pending[ch] = true;
-        s_ble_pb_lsb[ch] = (uint8_t)(bytes[1] & 0x7Fu);
-        s_ble_pb_msb[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_ble_coalesce_mux);
+        const uint32_t v = (uint32_t)(bytes[1] & 0x7Fu) | ((uint32_t)(bytes[2] & 0x7Fu) << 7);
+        if (midi_tx_latest_put(&s_ble_pb_latest[ch], v)) s_ble_coalesce_pb++;
+        midi_tx_ring_wake(&s_ble_ring);
         return true;
     }
 
-    if (is_cc1_3(bytes, len)) {
+    if (midi_tx_is_cc1(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_ble_coalesce_mux);
-        if (s_ble_cc1_pending[ch]) s_ble_coalesce_cc1++;
-        s_ble_cc1_pending[ch] = true;
-        s_ble_cc1_val[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_ble_coalesce_mux);
+        if (midi_tx_latest_put(&s_ble_cc1_latest[ch], midi_tx_cc1_value(bytes, len))) s_ble_coalesce_cc1++;
+        midi_tx_ring_wake(&s_ble_ring);
         return true;
     }
 
-    if (!s_ble_q) return false;
     midi_tx_item_t item = {0};
     item.len = (uint8_t)((len > 3) ? 3 : len);
     for (size_t i = 0; i < item.len; ++i) item.bytes[i] = bytes[i];
 
-    if (xQueueSendToBack(s_ble_q, &item, 0) != pdTRUE) {
+    if (!midi_tx_ring_push(&s_ble_ring, &item)) {
         s_ble_drop_queue++;
-        ble_maybe_update_hwm();
-        ble_maybe_log_stats();
         return false;
     }
-
-    ble_maybe_update_hwm();
     return true;
 }
+
+size_t midi_out_ble_send_batch(const midi_tx_item_t *items, size_t n)
+{
+    if (!s_inited) return 0;
+    if (!items || n == 0) return 0;
+
+    midi_tx_item_t discrete[MIDI_OUT_BATCH_MAX];
+    size_t nd = 0;
+    size_t taken = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t *b = items[i].bytes;
+        if (is_pitchbend_3(b, items[i].len)) {
+            const uint32_t v = (uint32_t)(b[1] & 0x7Fu) | ((uint32_t)(b[2] & 0x7Fu) << 7);
+            if (midi_tx_latest_put(&s_ble_pb_latest[b[0] & 0x0Fu], v)) s_ble_coalesce_pb++;
+            taken++;
+        } else if (midi_tx_is_cc1(b, items[i].len)) {
+            if (midi_tx_latest_put(&s_ble_cc1_latest[b[0] & 0x0Fu], midi_tx_cc1_value(b, items[i].len))) s_ble_coalesce_cc1++;
+            taken++;
+        } else if (nd < MIDI_OUT_BATCH_MAX) {
+            discrete[nd++] = items[i];
+        }
+    }
+
+    const size_t queued = midi_tx_ring_push_n(&s_ble_ring, discrete, nd);
+    s_ble_drop_queue += (uint32_t)(n - taken - queued);
+    if (queued == 0 && taken) midi_tx_ring_wake(&s_ble_ring);
+    return taken + queued;
+}
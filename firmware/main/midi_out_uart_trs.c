@@ -1,6 +1,7 @@
 #include "midi_out.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "board_pins.h"
 #include "sdkconfig.h"
@@ -25,12 +26,20 @@
 #define CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN 64
 #endif
 
+#ifndef CONFIG_EMIUET_MIDI_TRS_CC_BUDGET
+#define CONFIG_EMIUET_MIDI_TRS_CC_BUDGET 1200
+#endif
+
 #include "esp_log.h"
 
 #include "driver/uart.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+
+#include "midi_bench.h"
+#include "midi_tx_ring.h"
+#include "task_layout.h"
 
 static const char *TAG = "midi_out_uart_trs";
 
@@ -49,39 +58,33 @@ static const char *TAG = "midi_out_uart_trs";
 
 #define MIDI_TRS_COALESCE_CHANNELS 16
 
-typedef struct {
-    uint8_t len;
-    uint8_t bytes[3];
-} midi_tx_item_t;
+/* Discrete events handed to the UART driver per write */
+#define TRS_TX_BATCH 8
 
 static bool s_inited = false;
 static bool s_enabled = false;
-static QueueHandle_t s_q = NULL;
 static TaskHandle_t s_task = NULL;
-static portMUX_TYPE s_coalesce_mux = portMUX_INITIALIZER_UNLOCKED;
-
-/* Coalesce state (per-channel) */
-static bool s_pb_pending[MIDI_TRS_COALESCE_CHANNELS] = {0};
-static uint8_t s_pb_lsb[MIDI_TRS_COALESCE_CHANNELS] = {0};
-static uint8_t s_pb_msb[MIDI_TRS_COALESCE_CHANNELS] = {0};
-
-static bool s_cc1_pending[MIDI_TRS_COALESCE_CHANNELS] = {0};
-static uint8_t s_cc1_val[MIDI_TRS_COALESCE_CHANNELS] = {0};
-
-/* Stats */
-static uint32_t s_drop_queue = 0;
-static uint32_t s_drop_write = 0;
-static uint32_t s_coalesce_pb = 0;
-static uint32_t s_coalesce_cc1 = 0;
-static uint32_t s_q_hwm = 0;
-static TickType_t s_last_stats_log_tick = 0;
 
-static inline void maybe_update_hwm(void)
-{
-    if (!s_q) return;
-    const UBaseType_t used = uxQueueMessagesWaiting(s_q);
-    if (used > s_q_hwm) s_q_hwm = (uint32_t)used;
-}
+/* Discrete events: lock-free MPSC ring drained by the sender task */
+MIDI_TX_RING_STORAGE(s_q, midi_tx_item_t, CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN);
+static midi_tx_ring_t s_ring;
+
+/* Coalesce state (per-channel latest-wins cells)
+ * - pitch bend: 14-bit value (lsb | msb << 7)
+ * - CC#1: 7-bit value
+ */
+static midi_tx_latest_t s_pb_latest[MIDI_TRS_COALESCE_CHANNELS];
+static midi_tx_latest_t s_cc1_latest[MIDI_TRS_COALESCE_CHANNELS];
+
+/* Bytes/s the coalesced values may use (sender task only) */
+static midi_tx_budget_t s_cc_budget;
+
+/* Stats (atomic: updated from producers on both cores) */
+static _Atomic uint32_t s_drop_queue = 0;
+static _Atomic uint32_t s_drop_write = 0;
+static _Atomic uint32_t s_coalesce_pb = 0;
+static _Atomic uint32_t s_coalesce_cc1 = 0;
+static TickType_t s_last_stats_log_tick = 0;
 
 static void maybe_log_stats(void)
 {
@@ -92,7 +95,7 @@ static void maybe_log_stats(void)
     if (s_drop_queue || s_drop_write || s_coalesce_pb || s_coalesce_cc1) {
         ESP_LOGW(TAG,
                  "stats q_hwm=%lu drop{q=%lu write=%lu} coalesce{pb=%lu cc1=%lu}",
-                 (unsigned long)s_q_hwm,
+                 (unsigned long)midi_tx_ring_hwm(&s_ring),
                  (unsigned long)s_drop_queue,
                  (unsigned long)s_drop_write,
                  (unsigned long)s_coalesce_pb,
@@ -106,60 +109,61 @@ static inline bool is_pitchbend_3(const uint8_t *b, size_t len)
     return (len == 3) && ((b[0] & 0xF0u) == 0xE0u);
 }
 
-static inline bool is_cc1_3(const uint8_t *b, size_t len)
-{
-    return (len == 3) && ((b[0] & 0xF0u) == 0xB0u) && ((b[1] & 0x7Fu) == 1u);
-}
-
 static bool trs_uart_write_bytes(const uint8_t *bytes, size_t len)
 {
     if (!bytes || len == 0) return false;
     int written = uart_write_bytes(MIDI_TRS_UART_PORT, (const char *)bytes, len);
-    return written == (int)len;
+    if (written != (int)len) return false;
+    midi_bench_probe_wire(MIDI_OUT_ROUTE_TRS_UART, bytes, len);
+    return true;
 }
 
-static void trs_flush_coalesced_once(void)
+static bool trs_uart_write_batch(const uint8_t *buf, size_t len, const midi_tx_item_t *items, size_t n)
+{
+    int written = uart_write_bytes(MIDI_TRS_UART_PORT, (const char *)buf, len);
+    if (written != (int)len) return false;
+    for (size_t i = 0; i < n; ++i) {
+        midi_bench_probe_wire(MIDI_OUT_ROUTE_TRS_UART, items[i].bytes, items[i].len);
+    }
+    return true;
+}
+
+/* Returns the bytes written */
+static uint32_t trs_flush_coalesced_once(void)
 {
     /* Flush coalesced continuous values. We keep this bounded and quick. */
+    uint32_t bytes = 0;
     for (int ch = 0; ch < MIDI_TRS_COALESCE_CHANNELS; ++ch) {
-        bool pb = false;
-        uint8_t pb_lsb = 0;
-        uint8_t pb_msb = 0;
-
-        portENTER_CRITICAL(&s_coalesce_mux);
-        pb = s_pb_pending[ch];
-        if (pb) {
-            pb_lsb = s_pb_lsb[ch];
-            pb_msb = s_pb_msb[ch];
-            s_pb_pending[ch] = false;
-        }
-        portEXIT_CRITICAL(&s_coalesce_mux);
-
-        if (pb) {
-            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), pb_lsb, pb_msb};
+        uint32_t pb_v = 0;
+        if (midi_tx_latest_take(&s_pb_latest[ch], &pb_v)) {
+            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), (uint8_t)(pb_v & 0x7Fu), (uint8_t)((pb_v >> 7) & 0x7Fu)};
             if (!trs_uart_write_bytes(b, sizeof(b))) {
                 s_drop_write++;
             }
+            bytes += sizeof(b);
         }
 
-        bool cc1 = false;
-        uint8_t cc1_v = 0;
-
-        portENTER_CRITICAL(&s_coalesce_mux);
-        cc1 = s_cc1_pending[ch];
-        if (cc1) {
-            cc1_v = s_cc1_val[ch];
-            s_cc1_pending[ch] = false;
-        }
-        portEXIT_CRITICAL(&s_coalesce_mux);
-
-        if (cc1) {
-            uint8_t b[3] = {(uint8_t)(0xB0u | (uint8_t)ch), 1u, (uint8_t)(cc1_v & 0x7Fu)};
-            if (!trs_uart_write_bytes(b, sizeof(b))) {
+        uint32_t cc1_v = 0;
+        if (midi_tx_latest_take(&s_cc1_latest[ch], &cc1_v)) {
+            uint8_t b[6];
+            const size_t len = midi_tx_cc1_encode((uint8_t)ch, cc1_v, b);
+            if (!trs_uart_write_bytes(b, len)) {
                 s_drop_write++;
             }
+            bytes += (uint32_t)len;
         }
     }
+    return bytes;
+}
+
+/* Flush when the CC budget allows: bends are resampled to what it carries,
+ * the newest value winning. Returns the us until the next flush may run.
+ */
+static uint32_t trs_flush_coalesced_budgeted(void)
+{
+    const uint32_t wait_us = midi_tx_budget_wait_us(&s_cc_budget, esp_timer_get_time());
+    if (wait_us == 0) midi_tx_budget_spend(&s_cc_budget, trs_flush_coalesced_once());
+    return wait_us;
 }
 
 static void trs_sender_task(void *arg)
@@ -173,23 +177,30 @@ static void trs_sender_task(void *arg)
     int sent_since_flush = 0;
 
     while (1) {
-        midi_tx_item_t item = {0};
-
-        /* Wait for discrete events; if none arrive, periodically flush coalesced values. */
-        if (s_q && xQueueReceive(s_q, &item, pdMS_TO_TICKS(1)) == pdTRUE) {
-            maybe_update_hwm();
-
-            /* Single sender task owns the UART; no mutex required. */
-            bool ok = trs_uart_write_bytes(item.bytes, item.len);
+        midi_tx_item_t items[TRS_TX_BATCH];
+
+        /* Drain discrete events; when idle, flush coalesced values and sleep until kicked. */
+        const size_t n = midi_tx_ring_peek_n(&s_ring, items, TRS_TX_BATCH);
+        if (n > 0) {
+            /* Single sender task owns the UART; no mutex required.
+             * A chord goes to the driver in one write.
+             */
+            uint8_t buf[TRS_TX_BATCH * 3];
+            size_t len = 0;
+            for (size_t i = 0; i < n; ++i) {
+                memcpy(&buf[len], items[i].bytes, items[i].len);
+                len += items[i].len;
+            }
+            midi_tx_ring_pop_n(&s_ring, n);
 
-            if (!ok) {
-                s_drop_write++;
+            if (!trs_uart_write_batch(buf, len, items, n)) {
+                s_drop_write += (uint32_t)n;
             }
 
-            sent_since_flush++;
+            sent_since_flush += (int)n;
             if (sent_since_flush >= FLUSH_EVERY_N_EVENTS) {
                 sent_since_flush = 0;
-                trs_flush_coalesced_once();
+                (void)trs_flush_coalesced_budgeted();
             }
 
             maybe_log_stats();
@@ -197,10 +208,14 @@ static void trs_sender_task(void *arg)
         }
 
         /* Idle path: flush continuous updates promptly. */
-        trs_flush_coalesced_once();
+        midi_tx_ring_clear_kick(&s_ring);
+        const uint32_t wait_us = trs_flush_coalesced_budgeted();
         maybe_log_stats();
 
-        taskYIELD();
+        /* Anything pushed after the kick was cleared wakes us immediately;
+         * a flush held back by the budget bounds the sleep.
+         */
+        midi_tx_ring_wait(&s_ring, midi_tx_budget_ticks(wait_us, pdMS_TO_TICKS(10)));
     }
 }
 
@@ -266,27 +281,24 @@ bool midi_out_uart_trs_init(void)
         return false;
     }
 
-    s_q = xQueueCreate(CONFIG_EMIUET_MIDI_TRS_QUEUE_LEN, sizeof(midi_tx_item_t));
-    if (s_q == NULL) {
-        s_enabled = false;
-        ESP_LOGE(TAG, "failed to create queue");
-        return false;
-    }
+    MIDI_TX_RING_INIT(&s_ring, s_q);
+    midi_tx_budget_init(&s_cc_budget, CONFIG_EMIUET_MIDI_TRS_CC_BUDGET, 3 * 4);
 
     if (s_task == NULL) {
         BaseType_t ok = xTaskCreatePinnedToCore(trs_sender_task,
                                                "midi_trs_tx",
-                                               4096,
+                                               TASK_MIDI_TRS_TX_STACK,
                                                NULL,
-                                               CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY,
+                                               TASK_MIDI_TRS_TX_PRIO,
                                                &s_task,
-                                               0);
+                                               TASK_MIDI_TRS_TX_CORE);
         if (ok != pdPASS) {
             s_task = NULL;
             s_enabled = false;
             ESP_LOGE(TAG, "failed to create sender task");
             return false;
         }
+        midi_tx_ring_set_consumer(&s_ring, s_task);
     }
 
     s_enabled = true;
@@ -296,6 +308,24 @@ bool midi_out_uart_trs_init(void)
 #endif
 }
 
+void midi_out_uart_trs_get_stats(midi_out_stats_t *out)
+{
+    out->q_hwm = midi_tx_ring_hwm(&s_ring);
+    out->drop_queue = s_drop_queue;
+    out->drop_write = s_drop_write;
+    out->coalesce_pb = s_coalesce_pb;
+    out->coalesce_cc1 = s_coalesce_cc1;
+}
+
+void midi_out_uart_trs_reset_stats(void)
+{
+    midi_tx_ring_reset_hwm(&s_ring);
+    s_drop_queue = 0;
+    s_drop_write = 0;
+    s_coalesce_pb = 0;
+    s_coalesce_cc1 = 0;
+}
+
 bool midi_out_uart_trs_send_bytes(const uint8_t *bytes, size_t len)
 {
     if (!s_enabled) return false;
@@ -304,37 +334,57 @@ bool midi_out_uart_trs_send_bytes(const uint8_t *bytes, size_t len)
     /* Coalesce continuous controllers to prevent queue saturation. */
     if (is_pitchbend_3(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_coalesce_mux);
-        if (s_pb_pending[ch]) s_coalesce_pb++;
-        s_pb_pending[ch] = true;
-        s_pb_lsb[ch] = (uint8_t)(bytes[1] & 0x7Fu);
-        s_pb_msb[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_coalesce_mux);
+        const uint32_t v = (uint32_t)(bytes[1] & 0x7Fu) | ((uint32_t)(bytes[2] & 0x7Fu) << 7);
+        if (midi_tx_latest_put(&s_pb_latest[ch], v)) s_coalesce_pb++;
+        midi_tx_ring_wake(&s_ring);
         return true;
     }
 
-    if (is_cc1_3(bytes, len)) {
+    if (midi_tx_is_cc1(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_coalesce_mux);
-        if (s_cc1_pending[ch]) s_coalesce_cc1++;
-        s_cc1_pending[ch] = true;
-        s_cc1_val[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_coalesce_mux);
+        if (midi_tx_latest_put(&s_cc1_latest[ch], midi_tx_cc1_value(bytes, len))) s_coalesce_cc1++;
+        midi_tx_ring_wake(&s_ring);
         return true;
     }
 
-    if (!s_q) return false;
     midi_tx_item_t item = {0};
     item.len = (uint8_t)((len > 3) ? 3 : len);
     for (size_t i = 0; i < item.len; ++i) item.bytes[i] = bytes[i];
 
-    if (xQueueSendToBack(s_q, &item, 0) != pdTRUE) {
+    if (!midi_tx_ring_push(&s_ring, &item)) {
         s_drop_queue++;
-        maybe_update_hwm();
-        maybe_log_stats();
         return false;
     }
-
-    maybe_update_hwm();
     return true;
 }
+
+size_t midi_out_uart_trs_send_batch(const midi_tx_item_t *items, size_t n)
+{
+    if (!s_enabled) return 0;
+    if (!items || n == 0) return 0;
+
+    /* Continuous controllers go to their cells; the rest is queued with
+     * one reservation so the chord stays contiguous in the ring.
+     */
+    midi_tx_item_t discrete[MIDI_OUT_BATCH_MAX];
+    size_t nd = 0;
+    size_t taken = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t *b = items[i].bytes;
+        if (is_pitchbend_3(b, items[i].len)) {
+            const uint32_t v = (uint32_t)(b[1] & 0x7Fu) | ((uint32_t)(b[2] & 0x7Fu) << 7);
+            if (midi_tx_latest_put(&s_pb_latest[b[0] & 0x0Fu], v)) s_coalesce_pb++;
+            taken++;
+        } else if (midi_tx_is_cc1(b, items[i].len)) {
+            if (midi_tx_latest_put(&s_cc1_latest[b[0] & 0x0Fu], midi_tx_cc1_value(b, items[i].len))) s_coalesce_cc1++;
+            taken++;
+        } else if (nd < MIDI_OUT_BATCH_MAX) {
+            discrete[nd++] = items[i];
+        }
+    }
+
+    const size_t queued = midi_tx_ring_push_n(&s_ring, discrete, nd);
+    s_drop_queue += (uint32_t)(n - taken - queued);
+    if (queued == 0 && taken) midi_tx_ring_wake(&s_ring);
+    return taken + queued;
+}
@@ -1,8 +1,10 @@
 #include "midi_out.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 /* Defensive defaults for newly introduced Kconfig symbols.
  * This prevents build failures when the build directory has a stale sdkconfig.h.
@@ -12,15 +14,36 @@
 #define CONFIG_EMIUET_MIDI_USB_QUEUE_LEN 1024
 #endif
 
+#ifndef CONFIG_EMIUET_MIDI_USB_CC_BUDGET
+#define CONFIG_EMIUET_MIDI_USB_CC_BUDGET 0
+#endif
+
 #ifndef CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY
 #define CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY 6
 #endif
 
+#ifndef CONFIG_EMIUET_MIDI_USB_RX_ENABLE
+#define CONFIG_EMIUET_MIDI_USB_RX_ENABLE 1
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY 5
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_USB_UMP
+#define CONFIG_EMIUET_MIDI_USB_UMP 0
+#endif
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/semphr.h"
 
+#include "midi_bench.h"
+#include "midi_in.h"
+#include "midi_tx_ring.h"
+#include "task_layout.h"
+#include "midi_ump.h"
+
 static const char *TAG = "midi_out_usb";
 
 /*
@@ -36,6 +59,23 @@ static const char *TAG = "midi_out_usb";
 #include "tusb.h"
 #include "class/midi/midi_device.h"
 
+/* Optional USB MIDI 2.0 (UMP).
+ * TinyUSB's built-in MIDI class is MIDI 1.0 only; the UMP path needs the
+ * USB MIDI 2.0 class driver (tusb_ump, "ump_device.h") registered as an
+ * application class driver. It then owns both alternate settings:
+ *   alt 0: USB MIDI 1.0 (fallback, any host)
+ *   alt 1: USB MIDI 2.0 / UMP (selected by MIDI 2.0 capable hosts)
+ */
+#if CONFIG_EMIUET_MIDI_USB_UMP
+#if !__has_include("ump_device.h")
+#error "CONFIG_EMIUET_MIDI_USB_UMP requires the USB MIDI 2.0 class driver (ump_device.h)"
+#endif
+#include "ump_device.h"
+#define EMUIET_USB_UMP 1
+#else
+#define EMUIET_USB_UMP 0
+#endif
+
 /* Some TinyUSB versions (including the one bundled via ESP-IDF 5.3.x managed component)
  * don't provide tud_midi_ready(). Provide a local shim so we can log the state using the
  * name requested, without changing descriptors or the send path.
@@ -113,38 +153,114 @@ static const uint8_t s_desc_configuration[] = {
     TUD_MIDI_DESCRIPTOR(EMUIET_USB_ITF_NUM_MIDI, 0, EMUIET_USB_EP_MIDI_OUT, EMUIET_USB_EP_MIDI_IN, EMUIET_USB_MIDI_EP_SIZE)
 };
 
+#if EMUIET_USB_UMP
+/* USB MIDI 2.0 descriptor constants (USB MIDI 2.0 spec, appendix A) */
+#define EMUIET_USB_MIDI_BCDMSC_2_0       0x0200
+#define EMUIET_USB_MS_GENERAL_2_0        0x02
+#define EMUIET_USB_CS_GR_TRM_BLOCK       0x26
+#define EMUIET_USB_GR_TRM_BLOCK_HEADER   0x01
+#define EMUIET_USB_GR_TRM_BLOCK          0x02
+#define EMUIET_USB_GTB_PROTOCOL_MIDI2    0x11
+
+/* MIDI Streaming interface number (TUD_MIDI_DESCRIPTOR puts AC at itfnum, MS at itfnum+1) */
+#define EMUIET_USB_ITF_NUM_MIDI_STREAMING (EMUIET_USB_ITF_NUM_MIDI + 1)
+
+#define EMUIET_USB_UMP_ALT1_DESC_LEN (9 + 7 + 7 + 5 + 7 + 5)
+
+/* Same MIDI 1.0 function as s_desc_configuration (alt 0), plus alt 1 for UMP. */
+static const uint8_t s_desc_configuration_ump[] = {
+    TUD_CONFIG_DESCRIPTOR(1, EMUIET_USB_ITF_NUM_TOTAL, 0,
+                          (TUD_CONFIG_DESC_LEN + TUD_MIDI_DESC_LEN + EMUIET_USB_UMP_ALT1_DESC_LEN), 0x00, 100),
+    TUD_MIDI_DESCRIPTOR(EMUIET_USB_ITF_NUM_MIDI, 0, EMUIET_USB_EP_MIDI_OUT, EMUIET_USB_EP_MIDI_IN, EMUIET_USB_MIDI_EP_SIZE),
+
+    /* MS interface, alternate setting 1: USB MIDI 2.0 */
+    9, TUSB_DESC_INTERFACE, EMUIET_USB_ITF_NUM_MIDI_STREAMING, 1, 2,
+    TUSB_CLASS_AUDIO, AUDIO_SUBCLASS_MIDI_STREAMING, 0, 0,
+    /* CS MS header (bcdMSC 2.0; wTotalLength covers this header only) */
+    7, TUSB_DESC_CS_INTERFACE, MIDI_CS_INTERFACE_HEADER, U16_TO_U8S_LE(EMUIET_USB_MIDI_BCDMSC_2_0), U16_TO_U8S_LE(7),
+    /* Bulk OUT + CS endpoint (one Group Terminal Block, id 1) */
+    7, TUSB_DESC_ENDPOINT, EMUIET_USB_EP_MIDI_OUT, TUSB_XFER_BULK, U16_TO_U8S_LE(EMUIET_USB_MIDI_EP_SIZE), 0,
+    5, TUSB_DESC_CS_ENDPOINT, EMUIET_USB_MS_GENERAL_2_0, 1, 1,
+    /* Bulk IN + CS endpoint */
+    7, TUSB_DESC_ENDPOINT, EMUIET_USB_EP_MIDI_IN, TUSB_XFER_BULK, U16_TO_U8S_LE(EMUIET_USB_MIDI_EP_SIZE), 0,
+    5, TUSB_DESC_CS_ENDPOINT, EMUIET_USB_MS_GENERAL_2_0, 1, 1,
+};
+
+/* Group Terminal Block descriptor (fetched by the host with a class-specific
+ * GET_DESCRIPTOR once alt 1 is known): one bidirectional block on group 1
+ * speaking MIDI 2.0 protocol.
+ */
+static const uint8_t s_desc_gtb[] = {
+    5, EMUIET_USB_CS_GR_TRM_BLOCK, EMUIET_USB_GR_TRM_BLOCK_HEADER, U16_TO_U8S_LE(5 + 13),
+    13, EMUIET_USB_CS_GR_TRM_BLOCK, EMUIET_USB_GR_TRM_BLOCK,
+    1,    /* bGrpTrmBlkID */
+    0x00, /* bidirectional */
+    0,    /* first group (group 1) */
+    1,    /* number of groups */
+    0,    /* iBlockItem */
+    EMUIET_USB_GTB_PROTOCOL_MIDI2,
+    U16_TO_U8S_LE(0), /* wMaxInputBandwidth: unknown */
+    U16_TO_U8S_LE(0), /* wMaxOutputBandwidth: unknown */
+};
+
+bool tud_ump_get_req_itf_cb(uint8_t rhport, tusb_control_request_t const *request)
+{
+    if (request->bRequest != TUSB_REQ_GET_DESCRIPTOR) return false;
+    if ((request->wValue >> 8) != EMUIET_USB_CS_GR_TRM_BLOCK) return false;
+
+    uint16_t len = (uint16_t)sizeof(s_desc_gtb);
+    if (len > request->wLength) len = request->wLength;
+    return tud_control_xfer(rhport, request, (void *)(uintptr_t)s_desc_gtb, len);
+}
+#endif /* EMUIET_USB_UMP */
+
 static bool s_inited = false;
 static TaskHandle_t s_usb_state_task_handle = NULL;
 
-typedef struct {
-    uint8_t len;
-    uint8_t bytes[3];
-} midi_tx_item_t;
-
-static QueueHandle_t s_usb_q = NULL;
 static TaskHandle_t s_usb_tx_task_handle = NULL;
-static portMUX_TYPE s_usb_coalesce_mux = portMUX_INITIALIZER_UNLOCKED;
 
-static bool s_usb_pb_pending[16] = {0};
-static uint8_t s_usb_pb_lsb[16] = {0};
-static uint8_t s_usb_pb_msb[16] = {0};
+/* Discrete events: lock-free MPSC ring drained by the sender task */
+MIDI_TX_RING_STORAGE(s_usb_q, midi_tx_item_t, CONFIG_EMIUET_MIDI_USB_QUEUE_LEN);
+static midi_tx_ring_t s_usb_ring;
 
-static bool s_usb_cc1_pending[16] = {0};
-static uint8_t s_usb_cc1_val[16] = {0};
+/* Discrete events per stream write: 16 event packets fill one 64-byte
+ * full-speed bulk packet.
+ */
+#define USB_TX_BATCH 16
 
-static uint32_t s_usb_drop_queue = 0;
-static uint32_t s_usb_drop_write = 0;
-static uint32_t s_usb_coalesce_pb = 0;
-static uint32_t s_usb_coalesce_cc1 = 0;
-static uint32_t s_usb_q_hwm = 0;
-static TickType_t s_usb_last_stats_log_tick = 0;
+/* Latest-wins cells: pitch bend (lsb | msb << 7), CC#1 (7-bit) */
+static midi_tx_latest_t s_usb_pb_latest[16];
+static midi_tx_latest_t s_usb_cc1_latest[16];
 
-static inline void usb_maybe_update_hwm(void)
-{
-    if (!s_usb_q) return;
-    const UBaseType_t used = uxQueueMessagesWaiting(s_usb_q);
-    if (used > s_usb_q_hwm) s_usb_q_hwm = (uint32_t)used;
-}
+#if EMUIET_USB_UMP
+/* MIDI 2.0 items are queued separately so MIDI 1.0-only builds keep the
+ * compact 4-byte queue entries. Same consumer task as s_usb_ring.
+ */
+typedef struct {
+    uint8_t n;
+    uint32_t words[MIDI_UMP_MAX_WORDS];
+} ump_tx_item_t;
+
+MIDI_TX_RING_STORAGE(s_usb_ump_q, ump_tx_item_t, CONFIG_EMIUET_MIDI_USB_QUEUE_LEN);
+static midi_tx_ring_t s_usb_ump_ring;
+
+/* Latest-wins 32-bit pitch bend per channel (same policy as the 14-bit path).
+ * The full 32-bit value doesn't fit next to a pending bit, so the value is
+ * published first and the flag second; a consumer may resend a newer value
+ * twice but never loses one.
+ */
+static _Atomic uint32_t s_usb_ump_pb_val[16];
+static _Atomic bool s_usb_ump_pb_pending[16];
+/* 32-bit CC#1 (MIDI 2.0 control change), same latest-wins scheme */
+static _Atomic uint32_t s_usb_ump_cc1_val[16];
+static _Atomic bool s_usb_ump_cc1_pending[16];
+#endif
+
+static _Atomic uint32_t s_usb_drop_queue = 0;
+static _Atomic uint32_t s_usb_drop_write = 0;
+static _Atomic uint32_t s_usb_coalesce_pb = 0;
+static _Atomic uint32_t s_usb_coalesce_cc1 = 0;
+static TickType_t s_usb_last_stats_log_tick = 0;
 
 static void usb_maybe_log_stats(void)
 {
@@ -155,7 +271,7 @@ static void usb_maybe_log_stats(void)
     if (s_usb_drop_queue || s_usb_drop_write || s_usb_coalesce_pb || s_usb_coalesce_cc1) {
         ESP_LOGW(TAG,
                  "stats q_hwm=%lu drop{q=%lu write=%lu} coalesce{pb=%lu cc1=%lu}",
-                 (unsigned long)s_usb_q_hwm,
+                 (unsigned long)midi_tx_ring_hwm(&s_usb_ring),
                  (unsigned long)s_usb_drop_queue,
                  (unsigned long)s_usb_drop_write,
                  (unsigned long)s_usb_coalesce_pb,
@@ -169,74 +285,162 @@ static inline bool is_pitchbend_3(const uint8_t *b, size_t len)
     return (len == 3) && ((b[0] & 0xF0u) == 0xE0u);
 }
 
-static inline bool is_cc1_3(const uint8_t *b, size_t len)
+#if EMUIET_USB_UMP
+/* True when the host selected the USB MIDI 2.0 alternate setting. */
+static inline bool usb_ump_selected(void)
 {
-    return (len == 3) && ((b[0] & 0xF0u) == 0xB0u) && ((b[1] & 0x7Fu) == 1u);
+    return tud_ump_n_mounted(0) && (tud_alt_setting(0) == 1);
 }
 
+static bool usb_send_ump_lowlevel(const uint32_t *words, size_t n)
+{
+    if (!s_inited) return false;
+    if (!words || n == 0) return false;
+    if (!tud_mounted()) return false;
+
+    uint32_t buf[MIDI_UMP_MAX_WORDS];
+    for (size_t i = 0; i < n && i < MIDI_UMP_MAX_WORDS; ++i) buf[i] = words[i];
+    if (tud_ump_write(0, buf, (uint32_t)n) != n) return false;
+    midi_bench_probe_wire_ump(MIDI_OUT_ROUTE_USB, buf, n);
+    return true;
+}
+#endif
+
 static bool usb_send_lowlevel(const uint8_t *bytes, size_t len)
 {
     if (!s_inited) return false;
     if (!bytes || len == 0) return false;
     if (!tud_mounted()) return false;
 
+#if EMUIET_USB_UMP
+    /* The UMP driver owns the endpoint in both alt settings; MIDI 1.0 bytes
+     * travel as MIDI 1.0 UMPs (the driver converts to USB-MIDI 1.0 event
+     * packets while alt 0 is selected).
+     */
+    uint32_t w[2]; /* one message, or a 14-bit CC pair */
+    size_t n = 0;
+    for (size_t off = 0; off < len && n < 2; off += 3) {
+        const size_t m = (len - off < 3) ? len - off : 3;
+        if (midi_ump_encode_midi1_bytes(&bytes[off], m, 0, &w[n]) != 1) return false;
+        n++;
+    }
+    return usb_send_ump_lowlevel(w, n);
+#else
     uint32_t written = tud_midi_stream_write(0, bytes, (uint32_t)len);
-    return written == len;
+    if (written != len) return false;
+    midi_bench_probe_wire(MIDI_OUT_ROUTE_USB, bytes, len);
+    return true;
+#endif
 }
 
-static void usb_flush_coalesced_once(void)
+/* Send up to n queued items; returns how many went out (a prefix).
+ * TinyUSB's stream write takes whole messages only, so a short write
+ * still ends on an item boundary.
+ */
+static size_t usb_send_items(const midi_tx_item_t *items, size_t n)
 {
+#if EMUIET_USB_UMP
+    size_t i = 0;
+    while (i < n && usb_send_lowlevel(items[i].bytes, items[i].len)) i++;
+    return i;
+#else
+    if (!s_inited || !tud_mounted()) return 0;
+
+    uint8_t buf[USB_TX_BATCH * 3];
+    size_t len = 0;
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(&buf[len], items[i].bytes, items[i].len);
+        len += items[i].len;
+    }
+
+    const uint32_t written = tud_midi_stream_write(0, buf, (uint32_t)len);
+    size_t done = 0;
+    for (size_t i = 0, off = 0; i < n && off + items[i].len <= written; off += items[i].len, ++i) {
+        midi_bench_probe_wire(MIDI_OUT_ROUTE_USB, items[i].bytes, items[i].len);
+        done++;
+    }
+    return done;
+#endif
+}
+
+/* Bytes/s the coalesced values may use; 0 == every value (sender task only) */
+static midi_tx_budget_t s_usb_cc_budget;
+
+/* Returns the bytes written (USB-MIDI 1.0 stream bytes or UMP words * 4) */
+static uint32_t usb_flush_coalesced_once(void)
+{
+    uint32_t bytes = 0;
     for (int ch = 0; ch < 16; ++ch) {
-        bool pb = false;
-        uint8_t pb_lsb = 0;
-        uint8_t pb_msb = 0;
-
-        portENTER_CRITICAL(&s_usb_coalesce_mux);
-        pb = s_usb_pb_pending[ch];
-        if (pb) {
-            pb_lsb = s_usb_pb_lsb[ch];
-            pb_msb = s_usb_pb_msb[ch];
-            s_usb_pb_pending[ch] = false;
+#if EMUIET_USB_UMP
+        if (atomic_exchange(&s_usb_ump_pb_pending[ch], false)) {
+            const uint32_t ump_pb_val = atomic_load(&s_usb_ump_pb_val[ch]);
+            const midi_msg_t m = {
+                .type = MIDI_MSG_PITCH_BEND,
+                .channel = (uint8_t)ch,
+                .hires = true,
+                .data.pitchbend.value32 = ump_pb_val,
+            };
+            uint32_t w[MIDI_UMP_MAX_WORDS];
+            const size_t n = midi_ump_encode_midi2(&m, 0, w);
+            if (!usb_send_ump_lowlevel(w, n)) {
+                /* Value cell still holds this (or a newer) bend: just re-arm */
+                atomic_store(&s_usb_ump_pb_pending[ch], true);
+                s_usb_drop_write++;
+                return bytes;
+            }
+            bytes += (uint32_t)(n * 4u);
         }
-        portEXIT_CRITICAL(&s_usb_coalesce_mux);
+        if (atomic_exchange(&s_usb_ump_cc1_pending[ch], false)) {
+            const midi_msg_t m = {
+                .type = MIDI_MSG_CC,
+                .channel = (uint8_t)ch,
+                .hires = true,
+                .data.cc = {.cc = 1u, .value32 = atomic_load(&s_usb_ump_cc1_val[ch])},
+            };
+            uint32_t w[MIDI_UMP_MAX_WORDS];
+            const size_t n = midi_ump_encode_midi2(&m, 0, w);
+            if (!usb_send_ump_lowlevel(w, n)) {
+                atomic_store(&s_usb_ump_cc1_pending[ch], true);
+                s_usb_drop_write++;
+                return bytes;
+            }
+            bytes += (uint32_t)(n * 4u);
+        }
+#endif
 
-        if (pb) {
-            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), pb_lsb, pb_msb};
+        uint32_t pb_v = 0;
+        if (midi_tx_latest_take(&s_usb_pb_latest[ch], &pb_v)) {
+            uint8_t b[3] = {(uint8_t)(0xE0u | (uint8_t)ch), (uint8_t)(pb_v & 0x7Fu), (uint8_t)((pb_v >> 7) & 0x7Fu)};
             if (!usb_send_lowlevel(b, sizeof(b))) {
                 /* Keep pending on failure to avoid losing latest value. */
-                portENTER_CRITICAL(&s_usb_coalesce_mux);
-                s_usb_pb_pending[ch] = true;
-                s_usb_pb_lsb[ch] = pb_lsb;
-                s_usb_pb_msb[ch] = pb_msb;
-                portEXIT_CRITICAL(&s_usb_coalesce_mux);
+                midi_tx_latest_restore(&s_usb_pb_latest[ch], pb_v);
                 s_usb_drop_write++;
-                return;
+                return bytes;
             }
+            bytes += sizeof(b);
         }
 
-        bool cc1 = false;
-        uint8_t cc1_v = 0;
-
-        portENTER_CRITICAL(&s_usb_coalesce_mux);
-        cc1 = s_usb_cc1_pending[ch];
-        if (cc1) {
-            cc1_v = s_usb_cc1_val[ch];
-            s_usb_cc1_pending[ch] = false;
-        }
-        portEXIT_CRITICAL(&s_usb_coalesce_mux);
-
-        if (cc1) {
-            uint8_t b[3] = {(uint8_t)(0xB0u | (uint8_t)ch), 1u, (uint8_t)(cc1_v & 0x7Fu)};
-            if (!usb_send_lowlevel(b, sizeof(b))) {
-                portENTER_CRITICAL(&s_usb_coalesce_mux);
-                s_usb_cc1_pending[ch] = true;
-                s_usb_cc1_val[ch] = cc1_v;
-                portEXIT_CRITICAL(&s_usb_coalesce_mux);
+        uint32_t cc1_v = 0;
+        if (midi_tx_latest_take(&s_usb_cc1_latest[ch], &cc1_v)) {
+            uint8_t b[6];
+            const size_t len = midi_tx_cc1_encode((uint8_t)ch, cc1_v, b);
+            if (!usb_send_lowlevel(b, len)) {
+                midi_tx_latest_restore(&s_usb_cc1_latest[ch], cc1_v);
                 s_usb_drop_write++;
-                return;
+                return bytes;
             }
+            bytes += (uint32_t)len;
         }
     }
+    return bytes;
+}
+
+/* Flush when the CC budget allows. Returns the us until it may run next. */
+static uint32_t usb_flush_coalesced_budgeted(void)
+{
+    const uint32_t wait_us = midi_tx_budget_wait_us(&s_usb_cc_budget, esp_timer_get_time());
+    if (wait_us == 0) midi_tx_budget_spend(&s_usb_cc_budget, usb_flush_coalesced_once());
+    return wait_us;
 }
 
 static void midi_out_usb_tx_task(void *arg)
@@ -252,13 +456,32 @@ static void midi_out_usb_tx_task(void *arg)
             continue;
         }
 
-        /* Discrete events: peek+send+pop so we don't drop on transient failure. */
-        midi_tx_item_t item = {0};
-        if (s_usb_q && xQueuePeek(s_usb_q, &item, pdMS_TO_TICKS(1)) == pdTRUE) {
-            usb_maybe_update_hwm();
-            if (usb_send_lowlevel(item.bytes, item.len)) {
-                (void)xQueueReceive(s_usb_q, &item, 0);
+#if EMUIET_USB_UMP
+        /* MIDI 2.0 discrete events (only present while alt 1 is selected). */
+        ump_tx_item_t uitem = {0};
+        if (midi_tx_ring_peek(&s_usb_ump_ring, &uitem)) {
+            if (usb_send_ump_lowlevel(uitem.words, uitem.n)) {
+                midi_tx_ring_pop(&s_usb_ump_ring);
                 sent_since_flush++;
+            } else {
+                s_usb_drop_write++;
+                usb_maybe_log_stats();
+                vTaskDelay(pdMS_TO_TICKS(1));
+            }
+            continue;
+        }
+#endif
+
+        /* Discrete events: peek+send+pop so we don't drop on transient failure.
+         * Contiguous events (a chord) go out in one stream write.
+         */
+        midi_tx_item_t items[USB_TX_BATCH];
+        const size_t n = midi_tx_ring_peek_n(&s_usb_ring, items, USB_TX_BATCH);
+        if (n > 0) {
+            const size_t sent = usb_send_items(items, n);
+            if (sent > 0) {
+                midi_tx_ring_pop_n(&s_usb_ring, sent);
+                sent_since_flush += (int)sent;
             } else {
                 s_usb_drop_write++;
                 usb_maybe_log_stats();
@@ -268,17 +491,22 @@ static void midi_out_usb_tx_task(void *arg)
 
             if (sent_since_flush >= FLUSH_EVERY_N_EVENTS) {
                 sent_since_flush = 0;
-                usb_flush_coalesced_once();
+                (void)usb_flush_coalesced_budgeted();
             }
 
             usb_maybe_log_stats();
             continue;
         }
 
-        /* Idle path */
-        usb_flush_coalesced_once();
+        /* Idle path: re-check after clearing the kick so no push is missed. */
+        midi_tx_ring_clear_kick(&s_usb_ring);
+        if (midi_tx_ring_peek_n(&s_usb_ring, items, 1)) continue;
+#if EMUIET_USB_UMP
+        if (midi_tx_ring_peek(&s_usb_ump_ring, &uitem)) continue;
+#endif
+        const uint32_t wait_us = usb_flush_coalesced_budgeted();
         usb_maybe_log_stats();
-        taskYIELD();
+        midi_tx_ring_wait(&s_usb_ring, midi_tx_budget_ticks(wait_us, pdMS_TO_TICKS(10)));
     }
 }
 
@@ -327,6 +555,127 @@ static void midi_out_usb_state_task(void *arg)
     }
 }
 
+/* =========================================================
+ * USB-MIDI input (host -> device)
+ *
+ * The descriptor has always declared EMUIET_USB_EP_MIDI_OUT; this task drains
+ * it so TinyUSB's RX FIFO never stalls the host and feeds the streaming parser.
+ * ========================================================= */
+#if CONFIG_EMIUET_MIDI_USB_RX_ENABLE
+
+static TaskHandle_t s_usb_rx_task_handle = NULL;
+static midi_in_parser_t s_usb_rx_parser;
+static TickType_t s_usb_rx_last_stats_log_tick = 0;
+
+#if EMUIET_USB_UMP
+/* One received UMP into the parser; the input path stays MIDI 1.0 */
+static void usb_rx_feed_ump(const uint32_t *w, size_t n)
+{
+    uint8_t out[MIDI_UMP_MIDI1_BYTES_MAX];
+    const size_t len = midi_ump_to_midi1_bytes(w, n, out);
+    if (len > 0) midi_in_parser_feed(&s_usb_rx_parser, out, len);
+}
+
+/* UMP driver callback (tud_task context) */
+void tud_ump_rx_cb(uint8_t itf)
+{
+    (void)itf;
+    if (s_usb_rx_task_handle) xTaskNotifyGive(s_usb_rx_task_handle);
+}
+#else
+/* Payload bytes per USB-MIDI 1.0 event packet, indexed by Code Index Number.
+ * CIN 0x0/0x1 are reserved (cable events) and carry no MIDI bytes.
+ */
+static const uint8_t s_usb_cin_len[16] = {
+    0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1,
+};
+
+/* TinyUSB callback (tud_task context): wake the RX task instead of parsing here
+ * so the USB stack task never runs user handlers.
+ */
+void tud_midi_rx_cb(uint8_t itf)
+{
+    (void)itf;
+    if (s_usb_rx_task_handle) xTaskNotifyGive(s_usb_rx_task_handle);
+}
+#endif
+
+static void usb_rx_maybe_log_stats(void)
+{
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t interval = pdMS_TO_TICKS(1000);
+    if (s_usb_rx_last_stats_log_tick != 0 && (now - s_usb_rx_last_stats_log_tick) < interval) return;
+
+    const midi_in_parser_t *p = &s_usb_rx_parser;
+    if (p->sysex_truncated || p->stray_data) {
+        ESP_LOGW(TAG,
+                 "rx stats bytes=%lu msgs=%lu sysex{n=%lu trunc=%lu} stray=%lu",
+                 (unsigned long)p->bytes,
+                 (unsigned long)p->msgs,
+                 (unsigned long)p->sysex_msgs,
+                 (unsigned long)p->sysex_truncated,
+                 (unsigned long)p->stray_data);
+    }
+    s_usb_rx_last_stats_log_tick = now;
+}
+
+static void midi_in_usb_rx_task(void *arg)
+{
+    (void)arg;
+    bool was_mounted = false;
+
+    midi_in_parser_init(&s_usb_rx_parser, midi_in_dispatch_handlers());
+
+    while (1) {
+        /* Woken by tud_midi_rx_cb(); the timeout only covers a missed notify. */
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+
+        if (!tud_mounted()) {
+            /* Never splice a half message from a previous session. */
+            if (was_mounted) midi_in_parser_reset(&s_usb_rx_parser);
+            was_mounted = false;
+            continue;
+        }
+        was_mounted = true;
+
+#if EMUIET_USB_UMP
+        uint32_t words[4];
+        while (tud_ump_read(0, words, 1) == 1) {
+            const size_t n = midi_ump_word_count(words[0]);
+            if (n > 1 && tud_ump_read(0, &words[1], (uint32_t)(n - 1)) != n - 1) break;
+            usb_rx_feed_ump(words, n);
+        }
+#else
+        uint8_t packet[4];
+        while (tud_midi_packet_read(packet)) {
+            const uint8_t len = s_usb_cin_len[packet[0] & 0x0Fu];
+            if (len > 0) midi_in_parser_feed(&s_usb_rx_parser, &packet[1], len);
+        }
+#endif
+
+        usb_rx_maybe_log_stats();
+    }
+}
+
+static void midi_in_usb_start(void)
+{
+    if (s_usb_rx_task_handle != NULL) return;
+
+    BaseType_t ok = xTaskCreatePinnedToCore(midi_in_usb_rx_task,
+                                           "midi_usb_rx",
+                                           TASK_MIDI_USB_RX_STACK,
+                                           NULL,
+                                           TASK_MIDI_USB_RX_PRIO,
+                                           &s_usb_rx_task_handle,
+                                           TASK_MIDI_USB_RX_CORE);
+    if (ok != pdPASS) {
+        s_usb_rx_task_handle = NULL;
+        ESP_LOGW(TAG, "failed to create USB MIDI receive task");
+    }
+}
+
+#endif /* CONFIG_EMIUET_MIDI_USB_RX_ENABLE */
+
 bool midi_out_usb_init(void)
 {
     if (s_inited) return true;
@@ -343,16 +692,23 @@ bool midi_out_usb_init(void)
     tinyusb_config_t cfg = TINYUSB_DEFAULT_CONFIG();
     cfg.descriptor.device = &s_desc_device;
     cfg.descriptor.string = s_string_desc;
+#if EMUIET_USB_UMP
+    cfg.descriptor.full_speed_config = s_desc_configuration_ump;
+#if (TUD_OPT_HIGH_SPEED)
+    cfg.descriptor.high_speed_config = s_desc_configuration_ump;
+#endif
+#else
     cfg.descriptor.full_speed_config = s_desc_configuration;
 #if (TUD_OPT_HIGH_SPEED)
     cfg.descriptor.high_speed_config = s_desc_configuration;
+#endif
 #endif
 
-    /* Ensure the TinyUSB stack task (which runs tud_task() in a loop) is pinned to CPU0.
+    /* Ensure the TinyUSB stack task (which runs tud_task() in a loop) is pinned to the I/O core.
      * This keeps USB enumeration progressing even after app_main() returns.
      */
-    cfg.task.xCoreID = 0;
-    cfg.task.priority = 5;
+    cfg.task.xCoreID = TASK_TINYUSB_CORE;
+    cfg.task.priority = TASK_TINYUSB_PRIO;
     cfg.event_cb = midi_out_usb_event_cb;
     cfg.event_arg = NULL;
 
@@ -365,11 +721,11 @@ bool midi_out_usb_init(void)
     if (s_usb_state_task_handle == NULL) {
         BaseType_t ok = xTaskCreatePinnedToCore(midi_out_usb_state_task,
                                                "usb_state",
-                                               2048,
+                                               TASK_USB_STATE_STACK,
                                                NULL,
-                                               5,
+                                               TASK_USB_STATE_PRIO,
                                                &s_usb_state_task_handle,
-                                               0);
+                                               TASK_USB_STATE_CORE);
         if (ok != pdPASS) {
             s_usb_state_task_handle = NULL;
             ESP_LOGW(TAG, "Failed to start USB state monitor task");
@@ -379,28 +735,31 @@ bool midi_out_usb_init(void)
     s_inited = true;
     ESP_LOGI(TAG, "USB-MIDI backend initialized");
 
-    if (s_usb_q == NULL) {
-        s_usb_q = xQueueCreate(CONFIG_EMIUET_MIDI_USB_QUEUE_LEN, sizeof(midi_tx_item_t));
-        if (s_usb_q == NULL) {
-            ESP_LOGE(TAG, "failed to create USB MIDI queue");
-            return true;
-        }
-    }
+    MIDI_TX_RING_INIT(&s_usb_ring, s_usb_q);
+    midi_tx_budget_init(&s_usb_cc_budget, CONFIG_EMIUET_MIDI_USB_CC_BUDGET, 3 * 4);
+#if EMUIET_USB_UMP
+    MIDI_TX_RING_INIT(&s_usb_ump_ring, s_usb_ump_q);
+#endif
 
     if (s_usb_tx_task_handle == NULL) {
         BaseType_t ok = xTaskCreatePinnedToCore(midi_out_usb_tx_task,
                                                "midi_usb_tx",
-                                               4096,
+                                               TASK_MIDI_USB_TX_STACK,
                                                NULL,
-                                               CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY,
+                                               TASK_MIDI_USB_TX_PRIO,
                                                &s_usb_tx_task_handle,
-                                               0);
+                                               TASK_MIDI_USB_TX_CORE);
         if (ok != pdPASS) {
             s_usb_tx_task_handle = NULL;
             ESP_LOGW(TAG, "failed to create USB MIDI sender task");
         }
+        midi_tx_ring_set_consumer(&s_usb_ring, s_usb_tx_task_handle);
     }
 
+#if CONFIG_EMIUET_MIDI_USB_RX_ENABLE
+    midi_in_usb_start();
+#endif
+
     return true;
 }
 
@@ -412,43 +771,134 @@ bool midi_out_usb_send_bytes(const uint8_t *bytes, size_t len)
     /* Coalesce continuous controllers to prevent queue saturation. */
     if (is_pitchbend_3(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_usb_coalesce_mux);
-        if (s_usb_pb_pending[ch]) s_usb_coalesce_pb++;
-        s_usb_pb_pending[ch] = true;
-        s_usb_pb_lsb[ch] = (uint8_t)(bytes[1] & 0x7Fu);
-        s_usb_pb_msb[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_usb_coalesce_mux);
+        const uint32_t v = (uint32_t)(bytes[1] & 0x7Fu) | ((uint32_t)(bytes[2] & 0x7Fu) << 7);
+        if (midi_tx_latest_put(&s_usb_pb_latest[ch], v)) s_usb_coalesce_pb++;
+        midi_tx_ring_wake(&s_usb_ring);
         return true;
     }
 
-    if (is_cc1_3(bytes, len)) {
+    if (midi_tx_is_cc1(bytes, len)) {
         const uint8_t ch = (uint8_t)(bytes[0] & 0x0Fu);
-        portENTER_CRITICAL(&s_usb_coalesce_mux);
-        if (s_usb_cc1_pending[ch]) s_usb_coalesce_cc1++;
-        s_usb_cc1_pending[ch] = true;
-        s_usb_cc1_val[ch] = (uint8_t)(bytes[2] & 0x7Fu);
-        portEXIT_CRITICAL(&s_usb_coalesce_mux);
+        if (midi_tx_latest_put(&s_usb_cc1_latest[ch], midi_tx_cc1_value(bytes, len))) s_usb_coalesce_cc1++;
+        midi_tx_ring_wake(&s_usb_ring);
         return true;
     }
 
-    if (!s_usb_q) {
-        /* If init didn't create queue for some reason, fall back to direct send. */
-        return usb_send_lowlevel(bytes, len);
-    }
-
     midi_tx_item_t item = {0};
     item.len = (uint8_t)((len > 3) ? 3 : len);
     for (size_t i = 0; i < item.len; ++i) item.bytes[i] = bytes[i];
 
-    if (xQueueSendToBack(s_usb_q, &item, 0) != pdTRUE) {
+    if (!midi_tx_ring_push(&s_usb_ring, &item)) {
         s_usb_drop_queue++;
-        usb_maybe_update_hwm();
-        usb_maybe_log_stats();
         return false;
     }
+    return true;
+}
+
+size_t midi_out_usb_send_batch(const midi_tx_item_t *items, size_t n)
+{
+    if (!s_inited) return 0;
+    if (!items || n == 0) return 0;
+
+    /* Same split as midi_out_usb_send_bytes(); discrete events share one
+     * reservation so the sender can put the chord in one transfer.
+     */
+    midi_tx_item_t discrete[MIDI_OUT_BATCH_MAX];
+    size_t nd = 0;
+    size_t taken = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t *b = items[i].bytes;
+        if (is_pitchbend_3(b, items[i].len)) {
+            const uint32_t v = (uint32_t)(b[1] & 0x7Fu) | ((uint32_t)(b[2] & 0x7Fu) << 7);
+            if (midi_tx_latest_put(&s_usb_pb_latest[b[0] & 0x0Fu], v)) s_usb_coalesce_pb++;
+            taken++;
+        } else if (midi_tx_is_cc1(b, items[i].len)) {
+            if (midi_tx_latest_put(&s_usb_cc1_latest[b[0] & 0x0Fu], midi_tx_cc1_value(b, items[i].len))) s_usb_coalesce_cc1++;
+            taken++;
+        } else if (nd < MIDI_OUT_BATCH_MAX) {
+            discrete[nd++] = items[i];
+        }
+    }
+
+    const size_t queued = midi_tx_ring_push_n(&s_usb_ring, discrete, nd);
+    s_usb_drop_queue += (uint32_t)(n - taken - queued);
+    if (queued == 0 && taken) midi_tx_ring_wake(&s_usb_ring);
+    return taken + queued;
+}
+
+void midi_out_usb_get_stats(midi_out_stats_t *out)
+{
+    out->q_hwm = midi_tx_ring_hwm(&s_usb_ring);
+#if EMUIET_USB_UMP
+    if (midi_tx_ring_hwm(&s_usb_ump_ring) > out->q_hwm) out->q_hwm = midi_tx_ring_hwm(&s_usb_ump_ring);
+#endif
+    out->drop_queue = s_usb_drop_queue;
+    out->drop_write = s_usb_drop_write;
+    out->coalesce_pb = s_usb_coalesce_pb;
+    out->coalesce_cc1 = s_usb_coalesce_cc1;
+}
+
+void midi_out_usb_reset_stats(void)
+{
+    midi_tx_ring_reset_hwm(&s_usb_ring);
+#if EMUIET_USB_UMP
+    midi_tx_ring_reset_hwm(&s_usb_ump_ring);
+#endif
+    s_usb_drop_queue = 0;
+    s_usb_drop_write = 0;
+    s_usb_coalesce_pb = 0;
+    s_usb_coalesce_cc1 = 0;
+}
+
+bool midi_out_usb_ump_active(void)
+{
+#if EMUIET_USB_UMP
+    return s_inited && usb_ump_selected();
+#else
+    return false;
+#endif
+}
+
+bool midi_out_usb_send_ump(const uint32_t *words, size_t n)
+{
+#if EMUIET_USB_UMP
+    if (!s_inited) return false;
+    if (!words || n == 0 || n > MIDI_UMP_MAX_WORDS) return false;
+
+    /* Coalesce 32-bit pitch bend and CC#1 exactly like the MIDI 1.0 path. */
+    const uint32_t mt = (words[0] >> 28) & 0x0Fu;
+    const uint8_t op = (uint8_t)((words[0] >> 20) & 0x0Fu);
+    if (mt == MIDI_UMP_MT_MIDI2_CV && op == 0xEu && n == 2) {
+        const uint8_t ch = (uint8_t)((words[0] >> 16) & 0x0Fu);
+        atomic_store(&s_usb_ump_pb_val[ch], words[1]);
+        if (atomic_exchange(&s_usb_ump_pb_pending[ch], true)) s_usb_coalesce_pb++;
+        midi_tx_ring_wake(&s_usb_ring);
+        return true;
+    }
+    if (mt == MIDI_UMP_MT_MIDI2_CV && op == 0xBu && n == 2 && ((words[0] >> 8) & 0x7Fu) == 1u) {
+        const uint8_t ch = (uint8_t)((words[0] >> 16) & 0x0Fu);
+        atomic_store(&s_usb_ump_cc1_val[ch], words[1]);
+        if (atomic_exchange(&s_usb_ump_cc1_pending[ch], true)) s_usb_coalesce_cc1++;
+        midi_tx_ring_wake(&s_usb_ring);
+        return true;
+    }
 
-    usb_maybe_update_hwm();
+    ump_tx_item_t item = {0};
+    item.n = (uint8_t)n;
+    for (size_t i = 0; i < n; ++i) item.words[i] = words[i];
+
+    if (!midi_tx_ring_push(&s_usb_ump_ring, &item)) {
+        s_usb_drop_queue++;
+        return false;
+    }
+    /* The UMP ring has no consumer of its own; wake the USB sender task */
+    midi_tx_ring_wake(&s_usb_ring);
     return true;
+#else
+    (void)words;
+    (void)n;
+    return false;
+#endif
 }
 
 #else
@@ -467,4 +917,32 @@ bool midi_out_usb_send_bytes(const uint8_t *bytes, size_t len)
     return false;
 }
 
+size_t midi_out_usb_send_batch(const midi_tx_item_t *items, size_t n)
+{
+    (void)items;
+    (void)n;
+    return 0;
+}
+
+bool midi_out_usb_ump_active(void)
+{
+    return false;
+}
+
+void midi_out_usb_get_stats(midi_out_stats_t *out)
+{
+    (void)out;
+}
+
+void midi_out_usb_reset_stats(void)
+{
+}
+
+bool midi_out_usb_send_ump(const uint32_t *words, size_t n)
+{
+    (void)words;
+    (void)n;
+    return false;
+}
+
 #endif
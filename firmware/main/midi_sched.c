@@ -0,0 +1,503 @@
+#include "midi_sched.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS || CONFIG_EMIUET_MIDI_SCHED_BENCH
+#include "esp_cpu.h"
+#endif
+
+static const char *TAG = "midi_sched";
+
+/* =========================================================
+ * Wheel geometry
+ *
+ * Level 0: 256 slots x 1 tick
+ * Level 1:  64 slots x 256 ticks
+ * Level 2:  64 slots x 16384 ticks
+ * With the default 250 us tick that is 64 ms / 4.1 s / 262 s. Events
+ * further out are parked in the last level and re-placed on cascade.
+ * ========================================================= */
+
+#define SCHED_TICK_US ((int64_t)CONFIG_EMIUET_MIDI_SCHED_TICK_US)
+
+#define SCHED_L0_BITS 8
+#define SCHED_L1_BITS 6
+#define SCHED_L2_BITS 6
+
+#define SCHED_L0_SLOTS (1u << SCHED_L0_BITS)
+#define SCHED_L1_SLOTS (1u << SCHED_L1_BITS)
+#define SCHED_L2_SLOTS (1u << SCHED_L2_BITS)
+
+#define SCHED_L1_SHIFT SCHED_L0_BITS
+#define SCHED_L2_SHIFT (SCHED_L0_BITS + SCHED_L1_BITS)
+#define SCHED_SPAN_TICKS (1ull << (SCHED_L2_SHIFT + SCHED_L2_BITS))
+
+/* Slot ids: level 0 first, then level 1, then level 2 */
+#define SCHED_L1_BASE SCHED_L0_SLOTS
+#define SCHED_L2_BASE (SCHED_L0_SLOTS + SCHED_L1_SLOTS)
+#define SCHED_NUM_SLOTS (SCHED_L0_SLOTS + SCHED_L1_SLOTS + SCHED_L2_SLOTS)
+
+#define SCHED_NIL 0xFFFFu
+
+#if CONFIG_EMIUET_MIDI_SCHED_POOL >= SCHED_NIL
+#error "CONFIG_EMIUET_MIDI_SCHED_POOL must fit 16-bit indices"
+#endif
+
+#define SCHED_F_BENCH 0x01u
+
+typedef struct {
+    midi_msg_t msg;
+    int64_t due_us;
+    uint64_t due_tick;
+    uint16_t next;
+    uint16_t prev;
+    uint16_t slot;  /* SCHED_NIL when free or being dispatched */
+    uint16_t gen;
+    uint8_t flags;
+} sched_event_t;
+
+static sched_event_t s_pool[CONFIG_EMIUET_MIDI_SCHED_POOL];
+static uint16_t s_slot_head[SCHED_NUM_SLOTS];
+static uint16_t s_free_head = SCHED_NIL;
+static uint32_t s_pending = 0;
+
+/* Last tick whose level-0 slot was processed */
+static uint64_t s_cur_tick = 0;
+
+static esp_timer_handle_t s_timer = NULL;
+static bool s_timer_running = false;
+static bool s_inited = false;
+
+static portMUX_TYPE s_sched_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* Stats (written under s_sched_mux or by the timer task) */
+static uint32_t s_drop_pool = 0;
+static uint32_t s_pending_hwm = 0;
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+static uint32_t s_ins_count = 0;
+static uint32_t s_ins_cycles_max = 0;
+static uint64_t s_ins_cycles_sum = 0;
+static uint32_t s_late_count = 0;
+static uint32_t s_late_us_max = 0;
+static uint64_t s_late_us_sum = 0;
+static int64_t s_last_stats_log_us = 0;
+#endif
+
+#if CONFIG_EMIUET_MIDI_SCHED_BENCH
+/* Lateness histogram for bench events: 16 us buckets up to 4 ms + overflow */
+#define SCHED_BENCH_BUCKET_US 16
+#define SCHED_BENCH_BUCKETS 256
+static uint32_t s_bench_hist[SCHED_BENCH_BUCKETS + 1];
+static _Atomic uint32_t s_bench_fired = 0; /* timer task -> bench caller */
+static uint32_t s_bench_late_max = 0;
+#endif
+
+/* =========================================================
+ * Intrusive lists (called with s_sched_mux held)
+ * ========================================================= */
+
+static inline void slot_push(uint16_t slot, uint16_t idx)
+{
+    sched_event_t *ev = &s_pool[idx];
+    ev->slot = slot;
+    ev->prev = SCHED_NIL;
+    ev->next = s_slot_head[slot];
+    if (ev->next != SCHED_NIL) s_pool[ev->next].prev = idx;
+    s_slot_head[slot] = idx;
+}
+
+static inline void slot_unlink(uint16_t idx)
+{
+    sched_event_t *ev = &s_pool[idx];
+    if (ev->prev != SCHED_NIL) {
+        s_pool[ev->prev].next = ev->next;
+    } else {
+        s_slot_head[ev->slot] = ev->next;
+    }
+    if (ev->next != SCHED_NIL) s_pool[ev->next].prev = ev->prev;
+    ev->slot = SCHED_NIL;
+    ev->next = SCHED_NIL;
+    ev->prev = SCHED_NIL;
+}
+
+static inline void event_free(uint16_t idx)
+{
+    sched_event_t *ev = &s_pool[idx];
+    ev->gen++;
+    ev->slot = SCHED_NIL;
+    ev->next = s_free_head;
+    s_free_head = idx;
+    s_pending--;
+}
+
+/* Pick the level/slot from the distance to the current tick. */
+static void wheel_place(uint16_t idx)
+{
+    sched_event_t *ev = &s_pool[idx];
+    uint64_t due = ev->due_tick;
+    uint64_t delta = (due > s_cur_tick) ? (due - s_cur_tick) : 0;
+
+    if (delta < SCHED_L0_SLOTS) {
+        slot_push((uint16_t)(due & (SCHED_L0_SLOTS - 1u)), idx);
+        return;
+    }
+    if (delta < (1ull << SCHED_L2_SHIFT)) {
+        slot_push((uint16_t)(SCHED_L1_BASE + ((due >> SCHED_L1_SHIFT) & (SCHED_L1_SLOTS - 1u))), idx);
+        return;
+    }
+    if (delta >= SCHED_SPAN_TICKS) {
+        /* Out of range: park in the farthest level-2 slot, re-placed on cascade */
+        due = s_cur_tick + SCHED_SPAN_TICKS - 1u;
+    }
+    slot_push((uint16_t)(SCHED_L2_BASE + ((due >> SCHED_L2_SHIFT) & (SCHED_L2_SLOTS - 1u))), idx);
+}
+
+static void wheel_cascade(uint16_t slot)
+{
+    uint16_t idx = s_slot_head[slot];
+    s_slot_head[slot] = SCHED_NIL;
+    while (idx != SCHED_NIL) {
+        const uint16_t next = s_pool[idx].next;
+        wheel_place(idx);
+        idx = next;
+    }
+}
+
+/* Advance to the next tick; returns that tick's due events as a chain
+ * linked through .next (slot already cleared, so they can't be cancelled).
+ */
+static uint16_t wheel_advance_one(void)
+{
+    s_cur_tick++;
+    const uint64_t t = s_cur_tick;
+
+    if ((t & (SCHED_L0_SLOTS - 1u)) == 0) {
+        if (((t >> SCHED_L1_SHIFT) & (SCHED_L1_SLOTS - 1u)) == 0) {
+            wheel_cascade((uint16_t)(SCHED_L2_BASE + ((t >> SCHED_L2_SHIFT) & (SCHED_L2_SLOTS - 1u))));
+        }
+        wheel_cascade((uint16_t)(SCHED_L1_BASE + ((t >> SCHED_L1_SHIFT) & (SCHED_L1_SLOTS - 1u))));
+    }
+
+    const uint16_t slot = (uint16_t)(t & (SCHED_L0_SLOTS - 1u));
+    const uint16_t head = s_slot_head[slot];
+    s_slot_head[slot] = SCHED_NIL;
+    for (uint16_t idx = head; idx != SCHED_NIL; idx = s_pool[idx].next) {
+        s_pool[idx].slot = SCHED_NIL;
+    }
+    return head;
+}
+
+/* =========================================================
+ * Dispatch (esp_timer task)
+ * ========================================================= */
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+static void sched_maybe_log_stats(int64_t now_us)
+{
+    if (s_last_stats_log_us != 0 && (now_us - s_last_stats_log_us) < 1000000) return;
+    s_last_stats_log_us = now_us;
+    if (s_ins_count == 0 && s_late_count == 0 && s_drop_pool == 0) return;
+
+    ESP_LOGI(TAG,
+             "stats pending_hwm=%lu drop{pool=%lu} insert_cyc{avg=%lu max=%lu} late_us{avg=%lu max=%lu}",
+             (unsigned long)s_pending_hwm,
+             (unsigned long)s_drop_pool,
+             (unsigned long)(s_ins_count ? (s_ins_cycles_sum / s_ins_count) : 0),
+             (unsigned long)s_ins_cycles_max,
+             (unsigned long)(s_late_count ? (s_late_us_sum / s_late_count) : 0),
+             (unsigned long)s_late_us_max);
+}
+#endif
+
+static void dispatch_chain(uint16_t head, int64_t now_us)
+{
+    uint16_t idx = head;
+    while (idx != SCHED_NIL) {
+        sched_event_t *ev = &s_pool[idx];
+        const uint16_t next = ev->next;
+        const int64_t late = now_us - ev->due_us;
+        const uint32_t late_us = (late > 0) ? (uint32_t)late : 0;
+        (void)late_us;
+
+#if CONFIG_EMIUET_MIDI_SCHED_BENCH
+        if (ev->flags & SCHED_F_BENCH) {
+            const uint32_t b = late_us / SCHED_BENCH_BUCKET_US;
+            s_bench_hist[(b < SCHED_BENCH_BUCKETS) ? b : SCHED_BENCH_BUCKETS]++;
+            if (late_us > s_bench_late_max) s_bench_late_max = late_us;
+            s_bench_fired++;
+        } else
+#endif
+        {
+            (void)midi_out_send(&ev->msg);
+        }
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+        s_late_count++;
+        s_late_us_sum += late_us;
+        if (late_us > s_late_us_max) s_late_us_max = late_us;
+#endif
+
+        portENTER_CRITICAL(&s_sched_mux);
+        event_free(idx);
+        portEXIT_CRITICAL(&s_sched_mux);
+        idx = next;
+    }
+}
+
+static void sched_timer_cb(void *arg)
+{
+    (void)arg;
+    const int64_t now_us = esp_timer_get_time();
+    const uint64_t target = (uint64_t)(now_us / SCHED_TICK_US);
+
+    for (;;) {
+        uint16_t head = SCHED_NIL;
+        bool more = false;
+
+        portENTER_CRITICAL(&s_sched_mux);
+        if (s_pending == 0) {
+            /* Nothing left to walk; jump straight to now */
+            if (s_cur_tick < target) s_cur_tick = target;
+        } else if (s_cur_tick < target) {
+            head = wheel_advance_one();
+            more = (s_cur_tick < target);
+        }
+        portEXIT_CRITICAL(&s_sched_mux);
+
+        if (head != SCHED_NIL) dispatch_chain(head, now_us);
+        if (!more) break;
+    }
+
+    portENTER_CRITICAL(&s_sched_mux);
+    if (s_pending == 0 && s_timer_running) {
+        (void)esp_timer_stop(s_timer);
+        s_timer_running = false;
+    }
+    portEXIT_CRITICAL(&s_sched_mux);
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+    sched_maybe_log_stats(now_us);
+#endif
+}
+
+/* =========================================================
+ * Public API
+ * ========================================================= */
+
+bool midi_sched_init(void)
+{
+    if (s_inited) return true;
+
+    portENTER_CRITICAL(&s_sched_mux);
+    for (int i = 0; i < SCHED_NUM_SLOTS; ++i) s_slot_head[i] = SCHED_NIL;
+    s_free_head = SCHED_NIL;
+    for (int i = CONFIG_EMIUET_MIDI_SCHED_POOL - 1; i >= 0; --i) {
+        s_pool[i].slot = SCHED_NIL;
+        s_pool[i].next = s_free_head;
+        s_free_head = (uint16_t)i;
+    }
+    s_pending = 0;
+    portEXIT_CRITICAL(&s_sched_mux);
+
+    const esp_timer_create_args_t args = {
+        .callback = sched_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "midi_sched",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&args, &s_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "esp_timer_create failed; scheduler disabled");
+        return false;
+    }
+
+    s_inited = true;
+    ESP_LOGI(TAG, "init tick=%dus pool=%d", (int)CONFIG_EMIUET_MIDI_SCHED_TICK_US, (int)CONFIG_EMIUET_MIDI_SCHED_POOL);
+    return true;
+}
+
+static midi_sched_handle_t sched_post(int64_t due_us, const midi_msg_t *msg, uint8_t flags)
+{
+    if (!msg) return MIDI_SCHED_HANDLE_INVALID;
+    if (!s_inited && !midi_sched_init()) return MIDI_SCHED_HANDLE_INVALID;
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+#endif
+
+    /* Round up so an event never fires before its time */
+    const uint64_t due_tick = (due_us > 0) ? (uint64_t)((due_us + SCHED_TICK_US - 1) / SCHED_TICK_US) : 0;
+    midi_sched_handle_t h = MIDI_SCHED_HANDLE_INVALID;
+
+    portENTER_CRITICAL(&s_sched_mux);
+    const uint16_t idx = s_free_head;
+    if (idx == SCHED_NIL) {
+        s_drop_pool++;
+    } else {
+        if (!s_timer_running) {
+            /* Wheel is empty while stopped: resync to now before placing */
+            s_cur_tick = (uint64_t)(esp_timer_get_time() / SCHED_TICK_US);
+            if (esp_timer_start_periodic(s_timer, (uint64_t)SCHED_TICK_US) == ESP_OK) {
+                s_timer_running = true;
+            }
+        }
+
+        sched_event_t *ev = &s_pool[idx];
+        s_free_head = ev->next;
+        ev->msg = *msg;
+        ev->due_us = due_us;
+        ev->due_tick = (due_tick > s_cur_tick) ? due_tick : (s_cur_tick + 1u);
+        ev->flags = flags;
+        wheel_place(idx);
+
+        s_pending++;
+        if (s_pending > s_pending_hwm) s_pending_hwm = s_pending;
+        h = ((uint32_t)ev->gen << 16) | (uint32_t)(idx + 1u);
+
+#if CONFIG_EMIUET_MIDI_SCHED_STATS
+        const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+        s_ins_count++;
+        s_ins_cycles_sum += cyc;
+        if (cyc > s_ins_cycles_max) s_ins_cycles_max = cyc;
+#endif
+    }
+    portEXIT_CRITICAL(&s_sched_mux);
+
+    return h;
+}
+
+midi_sched_handle_t midi_sched_post_at(int64_t due_us, const midi_msg_t *msg)
+{
+    return sched_post(due_us, msg, 0);
+}
+
+midi_sched_handle_t midi_sched_post_in(uint32_t delay_us, const midi_msg_t *msg)
+{
+    return sched_post(esp_timer_get_time() + (int64_t)delay_us, msg, 0);
+}
+
+bool midi_sched_cancel(midi_sched_handle_t h)
+{
+    if (h == MIDI_SCHED_HANDLE_INVALID || !s_inited) return false;
+
+    const uint32_t idx1 = h & 0xFFFFu;
+    const uint16_t gen = (uint16_t)(h >> 16);
+    if (idx1 == 0 || idx1 > CONFIG_EMIUET_MIDI_SCHED_POOL) return false;
+    const uint16_t idx = (uint16_t)(idx1 - 1u);
+
+    bool ok = false;
+    portENTER_CRITICAL(&s_sched_mux);
+    sched_event_t *ev = &s_pool[idx];
+    if (ev->gen == gen && ev->slot != SCHED_NIL) {
+        slot_unlink(idx);
+        event_free(idx);
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_sched_mux);
+    return ok;
+}
+
+uint32_t midi_sched_pending(void)
+{
+    portENTER_CRITICAL(&s_sched_mux);
+    const uint32_t n = s_pending;
+    portEXIT_CRITICAL(&s_sched_mux);
+    return n;
+}
+
+/* =========================================================
+ * On-device benchmark
+ * ========================================================= */
+
+#if CONFIG_EMIUET_MIDI_SCHED_BENCH
+static uint32_t bench_percentile_us(uint32_t total, uint32_t pct)
+{
+    if (total == 0) return 0;
+    const uint32_t want = (total * pct + 99u) / 100u;
+    uint32_t acc = 0;
+    for (int b = 0; b <= SCHED_BENCH_BUCKETS; ++b) {
+        acc += s_bench_hist[b];
+        if (acc >= want) return (uint32_t)(b + 1) * SCHED_BENCH_BUCKET_US;
+    }
+    return s_bench_late_max;
+}
+
+void midi_sched_bench_run(uint32_t n_events, uint32_t spread_ms, midi_sched_bench_result_t *out)
+{
+    if (!midi_sched_init()) return;
+    if (spread_ms == 0) spread_ms = 1;
+
+    memset(s_bench_hist, 0, sizeof(s_bench_hist));
+    s_bench_fired = 0;
+    s_bench_late_max = 0;
+
+    const midi_msg_t msg = {
+        .type = MIDI_MSG_NOTE_OFF,
+        .channel = 0,
+    };
+
+    /* xorshift32: deterministic spread, no libc rand() state */
+    uint32_t rng = 0x2545F491u;
+    uint32_t posted = 0;
+    uint32_t cyc_max = 0;
+    uint64_t cyc_sum = 0;
+    const int64_t t0 = esp_timer_get_time() + 1000; /* leave time to post everything */
+
+    for (uint32_t i = 0; i < n_events; ++i) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const int64_t due = t0 + (int64_t)(rng % (spread_ms * 1000u));
+
+        const uint32_t c0 = esp_cpu_get_cycle_count();
+        const midi_sched_handle_t h = sched_post(due, &msg, SCHED_F_BENCH);
+        const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+        if (h == MIDI_SCHED_HANDLE_INVALID) break;
+
+        posted++;
+        cyc_sum += cyc;
+        if (cyc > cyc_max) cyc_max = cyc;
+    }
+
+    const uint32_t pending_after_post = midi_sched_pending();
+
+    /* Wait for everything to fire (spread + generous margin) */
+    const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(spread_ms + 1000);
+    while (s_bench_fired < posted && (int32_t)(deadline - xTaskGetTickCount()) > 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    const uint32_t fired = s_bench_fired;
+    const midi_sched_bench_result_t r = {
+        .posted = posted,
+        .fired = fired,
+        .pending_peak = pending_after_post,
+        .insert_cyc_avg = (uint32_t)(posted ? (cyc_sum / posted) : 0),
+        .insert_cyc_max = cyc_max,
+        .late_us_p50 = bench_percentile_us(fired, 50),
+        .late_us_p99 = bench_percentile_us(fired, 99),
+        .late_us_max = s_bench_late_max,
+    };
+    ESP_LOGI(TAG,
+             "bench events=%lu pending_peak=%lu tick=%dus insert_cyc{avg=%lu max=%lu} "
+             "late_us{p50<=%lu p99<=%lu max=%lu} fired=%lu",
+             (unsigned long)r.posted,
+             (unsigned long)r.pending_peak,
+             (int)CONFIG_EMIUET_MIDI_SCHED_TICK_US,
+             (unsigned long)r.insert_cyc_avg,
+             (unsigned long)r.insert_cyc_max,
+             (unsigned long)r.late_us_p50,
+             (unsigned long)r.late_us_p99,
+             (unsigned long)r.late_us_max,
+             (unsigned long)r.fired);
+    if (out) *out = r;
+}
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "midi_out.h"
+#include "sdkconfig.h"
+
+/* =========================================================
+ * Timed MIDI event scheduler
+ *
+ * Goals:
+ * - Post a structured MIDI message for a future time (strum spreading,
+ *   delayed note-off, arpeggios) without per-feature tasks.
+ * - O(1) post and cancel: hierarchical timer wheel over a fixed event pool
+ *   (no heap after init, no unbounded loops in the caller).
+ * - One esp_timer drives the wheel and runs only while events are pending.
+ *   Due events are handed to midi_out_send() (non-blocking enqueue).
+ *
+ * Times are in esp_timer_get_time() microseconds. Dispatch happens on the
+ * first wheel tick at or after the due time, so lateness is bounded by
+ * CONFIG_EMIUET_MIDI_SCHED_TICK_US plus esp_timer task latency.
+ * ========================================================= */
+
+/* Defensive defaults for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_MIDI_SCHED_TICK_US
+#define CONFIG_EMIUET_MIDI_SCHED_TICK_US 250
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_SCHED_POOL
+#define CONFIG_EMIUET_MIDI_SCHED_POOL 256
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_SCHED_STATS
+#define CONFIG_EMIUET_MIDI_SCHED_STATS 0
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_SCHED_BENCH
+#define CONFIG_EMIUET_MIDI_SCHED_BENCH 0
+#endif
+
+/* Opaque handle: pool index + generation, so a stale handle never cancels
+ * a recycled event. 0 == invalid.
+ */
+typedef uint32_t midi_sched_handle_t;
+
+#define MIDI_SCHED_HANDLE_INVALID ((midi_sched_handle_t)0)
+
+/* Create the driving timer. Idempotent; posting also initializes lazily. */
+bool midi_sched_init(void);
+
+/* Schedule msg for absolute time due_us (esp_timer_get_time() base).
+ * Times in the past are dispatched on the next tick.
+ * Returns MIDI_SCHED_HANDLE_INVALID when the pool is exhausted.
+ */
+midi_sched_handle_t midi_sched_post_at(int64_t due_us, const midi_msg_t *msg);
+
+/* Schedule msg delay_us from now. */
+midi_sched_handle_t midi_sched_post_in(uint32_t delay_us, const midi_msg_t *msg);
+
+/* Cancel a pending event. Returns false if it already fired or the handle
+ * is stale/invalid.
+ */
+bool midi_sched_cancel(midi_sched_handle_t h);
+
+/* Number of pending events. */
+uint32_t midi_sched_pending(void);
+
+#if CONFIG_EMIUET_MIDI_SCHED_BENCH
+typedef struct {
+    uint32_t posted;
+    uint32_t fired;
+    uint32_t pending_peak;   /* pending right after the last post */
+    uint32_t insert_cyc_avg; /* CPU cycles (host port: ns) */
+    uint32_t insert_cyc_max;
+    uint32_t late_us_p50;    /* upper bound of its 16 us bucket */
+    uint32_t late_us_p99;
+    uint32_t late_us_max;
+} midi_sched_bench_result_t;
+
+/* Blocking benchmark: posts n_events (bounded by the pool) spread over
+ * spread_ms, waits for all to fire and logs insert cost (CPU cycles) and
+ * dispatch lateness (p50/p99/max); out (optional) gets the figures.
+ * Bench events are not sent to MIDI.
+ */
+void midi_sched_bench_run(uint32_t n_events, uint32_t spread_ms, midi_sched_bench_result_t *out);
+#endif
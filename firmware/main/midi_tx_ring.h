@@ -0,0 +1,408 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* =========================================================
+ * MIDI transmit ring (shared by the output backends)
+ *
+ * Goals:
+ * - Multi-producer / single-consumer, lock-free on the producer side:
+ *   producers on either core reserve a slot with one CAS on the head index
+ *   (per-slot sequence numbers, D. Vyukov's bounded queue). No spinlock,
+ *   no FreeRTOS queue critical section.
+ * - Producers only touch the scheduler when the consumer actually sleeps
+ *   (waiting flag + task notification).
+ * - Latest-wins cells for continuous controllers (pitch bend / CC#1) are a
+ *   single atomic word per channel.
+ *
+ * The consumer (backend sender task) may peek, try to send and only then
+ * pop, so a transient transport failure does not lose the event.
+ * ========================================================= */
+
+/* Discrete MIDI 1.0 event (channel voice / system common, no SysEx) */
+typedef struct {
+    uint8_t len;
+    uint8_t bytes[3];
+} midi_tx_item_t;
+
+/* Ring capacity: next power of two >= n (Kconfig queue lengths are <= 2048) */
+#define MIDI_TX_RING_CAP(n)                                                             \
+    ((n) <= 16 ? 16u : (n) <= 32 ? 32u : (n) <= 64 ? 64u : (n) <= 128 ? 128u :          \
+     (n) <= 256 ? 256u : (n) <= 512 ? 512u : (n) <= 1024 ? 1024u : 2048u)
+
+/* Static storage for a ring named `name` holding at least min_len items. */
+#define MIDI_TX_RING_STORAGE(name, item_type, min_len)                       \
+    static _Atomic uint32_t name##_seq[MIDI_TX_RING_CAP(min_len)];           \
+    static item_type name##_items[MIDI_TX_RING_CAP(min_len)]
+
+#define MIDI_TX_RING_INIT(ring, name)                                                       \
+    midi_tx_ring_init((ring), name##_seq, (uint8_t *)name##_items, sizeof(name##_items[0]), \
+                      (uint32_t)(sizeof(name##_seq) / sizeof(name##_seq[0])))
+
+typedef struct {
+    _Atomic uint32_t *seq;
+    uint8_t *items;
+    uint32_t item_size;
+    uint32_t mask;
+
+    _Atomic uint32_t head; /* next slot to reserve (producers) */
+    _Atomic uint32_t tail; /* next slot to consume (consumer) */
+    _Atomic uint32_t hwm;  /* max observed depth */
+
+    _Atomic bool waiting;  /* consumer is (about to be) blocked */
+    _Atomic bool kicked;   /* new work since the consumer last looked */
+    TaskHandle_t consumer;
+} midi_tx_ring_t;
+
+static inline void midi_tx_ring_init(midi_tx_ring_t *r, _Atomic uint32_t *seq, uint8_t *items,
+                                     size_t item_size, uint32_t capacity)
+{
+    r->seq = seq;
+    r->items = items;
+    r->item_size = (uint32_t)item_size;
+    r->mask = capacity - 1u;
+    for (uint32_t i = 0; i < capacity; ++i) atomic_init(&seq[i], i);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->hwm, 0);
+    atomic_init(&r->waiting, false);
+    atomic_init(&r->kicked, false);
+    r->consumer = NULL;
+}
+
+static inline void midi_tx_ring_set_consumer(midi_tx_ring_t *r, TaskHandle_t consumer)
+{
+    r->consumer = consumer;
+}
+
+/* Producer side: tell the consumer there is new work (ring item or a
+ * latest-wins cell update). Notifies only when the consumer sleeps.
+ */
+static inline void midi_tx_ring_wake(midi_tx_ring_t *r)
+{
+    atomic_store(&r->kicked, true);
+    if (atomic_exchange(&r->waiting, false) && r->consumer) {
+        xTaskNotifyGive(r->consumer);
+    }
+}
+
+static inline void midi_tx_ring_note_depth(midi_tx_ring_t *r, uint32_t head_after)
+{
+    /* Depth high-water mark (lock-free max). Signed: between publishing
+     * and this load, later producers' items and ours may all have been
+     * consumed, leaving tail past head_after.
+     */
+    const int32_t ahead = (int32_t)(head_after - atomic_load_explicit(&r->tail, memory_order_relaxed));
+    if (ahead <= 0) return;
+    const uint32_t depth = (uint32_t)ahead;
+    uint32_t hwm = atomic_load_explicit(&r->hwm, memory_order_relaxed);
+    while (depth > hwm &&
+           !atomic_compare_exchange_weak_explicit(&r->hwm, &hwm, depth, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* Producer side: enqueue one item without waking the consumer. */
+static inline bool midi_tx_ring_push_quiet(midi_tx_ring_t *r, const void *item)
+{
+    uint32_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t idx;
+
+    for (;;) {
+        idx = pos & r->mask;
+        const uint32_t seq = atomic_load_explicit(&r->seq[idx], memory_order_acquire);
+        const int32_t dif = (int32_t)(seq - pos);
+        if (dif == 0) {
+            /* Slot free for this lap: try to reserve it */
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1u,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            /* pos reloaded by the failed CAS (another producer won) */
+        } else if (dif < 0) {
+            return false; /* full */
+        } else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(&r->items[idx * r->item_size], item, r->item_size);
+    atomic_store_explicit(&r->seq[idx], pos + 1u, memory_order_release);
+    midi_tx_ring_note_depth(r, pos + 1u);
+    return true;
+}
+
+/* Producer side: enqueue one item. Never blocks; false when full. */
+static inline bool midi_tx_ring_push(midi_tx_ring_t *r, const void *item)
+{
+    if (!midi_tx_ring_push_quiet(r, item)) return false;
+    midi_tx_ring_wake(r);
+    return true;
+}
+
+/* Producer side: enqueue n items (e.g. a chord) with one reservation and
+ * at most one wakeup. The slots are consecutive, so the consumer sees the
+ * batch in order and without other producers' items in between.
+ * When the batch does not fit, queues as many as fit one by one.
+ * Returns the number of items queued.
+ */
+static inline size_t midi_tx_ring_push_n(midi_tx_ring_t *r, const void *items, size_t n)
+{
+    if (n == 0) return 0;
+    const uint8_t *src = (const uint8_t *)items;
+
+    if (n <= (size_t)r->mask + 1u) {
+        uint32_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        for (;;) {
+            const uint32_t last = pos + (uint32_t)n - 1u;
+            const int32_t dif0 = (int32_t)(atomic_load_explicit(&r->seq[pos & r->mask], memory_order_acquire) - pos);
+            const int32_t difl = (int32_t)(atomic_load_explicit(&r->seq[last & r->mask], memory_order_acquire) - last);
+            if (dif0 < 0 || difl < 0) break; /* not enough room: fall back below */
+            if (dif0 > 0 || difl > 0) {
+                pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+                continue;
+            }
+            /* First and last slot free for this lap => all between are (in-order consumer) */
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + (uint32_t)n,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                for (uint32_t i = 0; i < (uint32_t)n; ++i) {
+                    const uint32_t idx = (pos + i) & r->mask;
+                    memcpy(&r->items[idx * r->item_size], src + (size_t)i * r->item_size, r->item_size);
+                    atomic_store_explicit(&r->seq[idx], pos + i + 1u, memory_order_release);
+                }
+                midi_tx_ring_note_depth(r, pos + (uint32_t)n);
+                midi_tx_ring_wake(r);
+                return n;
+            }
+        }
+    }
+
+    size_t queued = 0;
+    while (queued < n && midi_tx_ring_push_quiet(r, src + queued * r->item_size)) queued++;
+    if (queued) midi_tx_ring_wake(r);
+    return queued;
+}
+
+/* Consumer side: copy the oldest item without removing it. */
+static inline bool midi_tx_ring_peek(midi_tx_ring_t *r, void *out)
+{
+    const uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    const uint32_t idx = pos & r->mask;
+    const uint32_t seq = atomic_load_explicit(&r->seq[idx], memory_order_acquire);
+    if (seq != pos + 1u) return false; /* empty (or producer still writing) */
+
+    memcpy(out, &r->items[idx * r->item_size], r->item_size);
+    return true;
+}
+
+/* Consumer side: drop the item returned by the last successful peek. */
+static inline void midi_tx_ring_pop(midi_tx_ring_t *r)
+{
+    const uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    const uint32_t idx = pos & r->mask;
+    atomic_store_explicit(&r->seq[idx], pos + r->mask + 1u, memory_order_release);
+    atomic_store_explicit(&r->tail, pos + 1u, memory_order_relaxed);
+}
+
+static inline bool midi_tx_ring_pop_into(midi_tx_ring_t *r, void *out)
+{
+    if (!midi_tx_ring_peek(r, out)) return false;
+    midi_tx_ring_pop(r);
+    return true;
+}
+
+/* Consumer side: copy up to max of the oldest items (stops at the first
+ * one still being written). Returns the count; pop them with pop_n.
+ */
+static inline size_t midi_tx_ring_peek_n(midi_tx_ring_t *r, void *out, size_t max)
+{
+    const uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint8_t *dst = (uint8_t *)out;
+    size_t n = 0;
+    while (n < max) {
+        const uint32_t idx = (pos + (uint32_t)n) & r->mask;
+        if (atomic_load_explicit(&r->seq[idx], memory_order_acquire) != pos + (uint32_t)n + 1u) break;
+        memcpy(dst + n * r->item_size, &r->items[idx * r->item_size], r->item_size);
+        n++;
+    }
+    return n;
+}
+
+static inline void midi_tx_ring_pop_n(midi_tx_ring_t *r, size_t n)
+{
+    while (n--) midi_tx_ring_pop(r);
+}
+
+/* Consumer side: call before the final "anything left?" pass of an idle
+ * loop (ring check + coalesced flush), then midi_tx_ring_wait().
+ */
+static inline void midi_tx_ring_clear_kick(midi_tx_ring_t *r)
+{
+    atomic_store(&r->kicked, false);
+}
+
+/* Consumer side: block until a producer kicks or timeout. Returns
+ * immediately if work arrived since midi_tx_ring_clear_kick().
+ */
+static inline void midi_tx_ring_wait(midi_tx_ring_t *r, TickType_t timeout)
+{
+    atomic_store(&r->waiting, true);
+    if (atomic_load(&r->kicked)) {
+        atomic_store(&r->waiting, false);
+        return;
+    }
+    (void)ulTaskNotifyTake(pdTRUE, timeout);
+    atomic_store(&r->waiting, false);
+}
+
+static inline uint32_t midi_tx_ring_hwm(midi_tx_ring_t *r)
+{
+    return atomic_load_explicit(&r->hwm, memory_order_relaxed);
+}
+
+static inline void midi_tx_ring_reset_hwm(midi_tx_ring_t *r)
+{
+    atomic_store_explicit(&r->hwm, 0, memory_order_relaxed);
+}
+
+/* =========================================================
+ * Latest-wins cells (one per channel and controller)
+ *
+ * bit31 == pending, low bits == value. A put replaces the value and
+ * reports whether an unsent value was overwritten (coalesced).
+ * ========================================================= */
+
+typedef _Atomic uint32_t midi_tx_latest_t;
+
+#define MIDI_TX_LATEST_PENDING 0x80000000u
+
+static inline bool midi_tx_latest_put(midi_tx_latest_t *c, uint32_t value)
+{
+    const uint32_t old = atomic_exchange(c, MIDI_TX_LATEST_PENDING | (value & ~MIDI_TX_LATEST_PENDING));
+    return (old & MIDI_TX_LATEST_PENDING) != 0;
+}
+
+static inline bool midi_tx_latest_take(midi_tx_latest_t *c, uint32_t *value)
+{
+    const uint32_t v = atomic_exchange(c, 0u);
+    if ((v & MIDI_TX_LATEST_PENDING) == 0) return false;
+    *value = v & ~MIDI_TX_LATEST_PENDING;
+    return true;
+}
+
+/* Put a taken value back after a failed send, unless a newer one arrived. */
+static inline void midi_tx_latest_restore(midi_tx_latest_t *c, uint32_t value)
+{
+    uint32_t expected = 0u;
+    (void)atomic_compare_exchange_strong(c, &expected, MIDI_TX_LATEST_PENDING | value);
+}
+
+/* =========================================================
+ * CC#1 cell value
+ *
+ * Modulation arrives as a plain CC#1 (3 bytes) or as a 14-bit
+ * CC#1 (MSB) + CC#33 (LSB) pair (6 bytes). Either form is one cell
+ * word, so a pair is coalesced as a unit and its halves never mix
+ * two slider positions.
+ * ========================================================= */
+
+#define MIDI_TX_CC1_PAIR 0x4000u /* value: bits 0..13 = msb << 7 | lsb */
+
+static inline bool midi_tx_is_cc1(const uint8_t *b, size_t len)
+{
+    if (len != 3 && len != 6) return false;
+    if ((b[0] & 0xF0u) != 0xB0u || (b[1] & 0x7Fu) != 1u) return false;
+    return len == 3 || (b[3] == b[0] && (b[4] & 0x7Fu) == 33u);
+}
+
+/* Cell value of a message accepted by midi_tx_is_cc1() */
+static inline uint32_t midi_tx_cc1_value(const uint8_t *b, size_t len)
+{
+    if (len == 3) return (uint32_t)(b[2] & 0x7Fu);
+    return MIDI_TX_CC1_PAIR | ((uint32_t)(b[2] & 0x7Fu) << 7) | (uint32_t)(b[5] & 0x7Fu);
+}
+
+/* Wire bytes of a cell value; returns the length (3 or 6). */
+static inline size_t midi_tx_cc1_encode(uint8_t ch, uint32_t v, uint8_t out[6])
+{
+    out[0] = (uint8_t)(0xB0u | (ch & 0x0Fu));
+    out[1] = 1u;
+    if ((v & MIDI_TX_CC1_PAIR) == 0) {
+        out[2] = (uint8_t)(v & 0x7Fu);
+        return 3;
+    }
+    out[2] = (uint8_t)((v >> 7) & 0x7Fu);
+    out[3] = out[0];
+    out[4] = 33u;
+    out[5] = (uint8_t)(v & 0x7Fu);
+    return 6;
+}
+
+/* =========================================================
+ * Continuous-controller budget (per route, sender task only)
+ *
+ * Each route declares how many bytes per second its coalesced
+ * controllers (pitch bend, CC#1) may use. A flush pass runs when the
+ * credit is not negative and then spends what it wrote, so the average
+ * rate is the budget and a pass is never split. rate_bps == 0 means
+ * unlimited (the link paces itself).
+ * ========================================================= */
+
+typedef struct {
+    uint32_t rate_bps;
+    int32_t credit; /* bytes; negative == in debt */
+    int32_t burst;  /* credit cap, bytes */
+    int64_t last_us;
+} midi_tx_budget_t;
+
+static inline void midi_tx_budget_init(midi_tx_budget_t *b, uint32_t rate_bps, int32_t burst)
+{
+    b->rate_bps = rate_bps;
+    b->credit = burst;
+    b->burst = burst;
+    b->last_us = 0;
+}
+
+/* Microseconds until the next pass may run (0 == now). */
+static inline uint32_t midi_tx_budget_wait_us(midi_tx_budget_t *b, int64_t now_us)
+{
+    if (b->rate_bps == 0) return 0;
+    if (b->last_us == 0) {
+        b->last_us = now_us;
+    } else if (now_us > b->last_us) {
+        const int64_t earned = ((now_us - b->last_us) * (int64_t)b->rate_bps) / 1000000;
+        if (earned > 0) {
+            const int64_t c = (int64_t)b->credit + earned;
+            if (c >= b->burst) {
+                b->credit = b->burst;
+                b->last_us = now_us;
+            } else {
+                /* keep the remainder: advance only by the time that was paid out */
+                b->credit = (int32_t)c;
+                b->last_us += (earned * 1000000) / (int64_t)b->rate_bps;
+            }
+        }
+    }
+    if (b->credit >= 0) return 0;
+    return (uint32_t)(((int64_t)-b->credit * 1000000 + b->rate_bps - 1) / b->rate_bps);
+}
+
+static inline void midi_tx_budget_spend(midi_tx_budget_t *b, uint32_t bytes)
+{
+    if (b->rate_bps != 0) b->credit -= (int32_t)bytes;
+}
+
+/* Sleep bound for a sender with a pass pending in `wait_us` (>= 1 tick). */
+static inline TickType_t midi_tx_budget_ticks(uint32_t wait_us, TickType_t idle)
+{
+    if (wait_us == 0) return idle;
+    TickType_t t = pdMS_TO_TICKS((wait_us + 999u) / 1000u);
+    if (t == 0) t = 1;
+    return t < idle ? t : idle;
+}
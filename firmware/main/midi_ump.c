@@ -0,0 +1,215 @@
+#include "midi_ump.h"
+
+static inline uint8_t clamp_ch(uint8_t ch) { return (ch > 15) ? 15 : ch; }
+
+size_t midi_ump_word_count(uint32_t word0)
+{
+    /* Packet size per message type (UMP spec, table "Message Type"). */
+    static const uint8_t words_for_mt[16] = {
+        1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4,
+    };
+    return words_for_mt[(word0 >> 28) & 0x0Fu];
+}
+
+uint32_t midi_ump_scale_up(uint32_t value, uint8_t src_bits, uint8_t dst_bits)
+{
+    if (src_bits == 0 || dst_bits <= src_bits || dst_bits > 32) return value;
+
+    const uint8_t scale_bits = (uint8_t)(dst_bits - src_bits);
+    const uint32_t shifted = value << scale_bits;
+    const uint32_t src_center = 1u << (src_bits - 1u);
+
+    /* Lower half (including center) is a plain shift so center stays center. */
+    if (value <= src_center) return shifted;
+
+    /* Upper half: repeat the bits below the MSB to reach full scale at max. */
+    const uint8_t repeat_bits = (uint8_t)(src_bits - 1u);
+    const uint32_t repeat_mask = (1u << repeat_bits) - 1u;
+    uint32_t repeat = value & repeat_mask;
+    if (scale_bits > repeat_bits) {
+        repeat <<= (scale_bits - repeat_bits);
+    } else {
+        repeat >>= (repeat_bits - scale_bits);
+    }
+
+    uint32_t result = shifted;
+    while (repeat != 0) {
+        result |= repeat;
+        repeat >>= repeat_bits;
+    }
+    return result;
+}
+
+static inline uint32_t midi2_word0(uint8_t group, uint8_t status_nibble, uint8_t ch, uint8_t b2, uint8_t b3)
+{
+    return (MIDI_UMP_MT_MIDI2_CV << 28) |
+           ((uint32_t)(group & 0x0Fu) << 24) |
+           ((uint32_t)(status_nibble & 0x0Fu) << 20) |
+           ((uint32_t)clamp_ch(ch) << 16) |
+           ((uint32_t)b2 << 8) |
+           (uint32_t)b3;
+}
+
+size_t midi_ump_encode_midi2(const midi_msg_t *msg, uint8_t group, uint32_t out[MIDI_UMP_MAX_WORDS])
+{
+    if (!msg || !out) return 0;
+
+    const uint8_t ch = msg->channel;
+
+    switch (msg->type) {
+        case MIDI_MSG_NOTE_ON:
+        case MIDI_MSG_NOTE_OFF: {
+            const uint8_t note = msg->data.note.note & 0x7Fu;
+            uint16_t vel16 = msg->hires ? msg->data.note.velocity16
+                                        : midi_ump_velocity_7_to_16(msg->data.note.velocity);
+            /* MIDI 1.0 "Note On velocity 0" means Note Off; MIDI 2.0 does not
+             * have that rule, so translate explicitly (spec translation rule).
+             */
+            bool on = (msg->type == MIDI_MSG_NOTE_ON);
+            if (on && !msg->hires && (msg->data.note.velocity & 0x7Fu) == 0) {
+                on = false;
+                vel16 = midi_ump_velocity_7_to_16(64);
+            }
+            out[0] = midi2_word0(group, on ? 0x9u : 0x8u, ch, note, msg->data.note.attr_type);
+            out[1] = ((uint32_t)vel16 << 16) | (uint32_t)msg->data.note.attr_data;
+            return 2;
+        }
+
+        case MIDI_MSG_CC:
+            out[0] = midi2_word0(group, 0xBu, ch, msg->data.cc.cc & 0x7Fu, 0);
+            out[1] = msg->hires ? msg->data.cc.value32 : midi_ump_value_7_to_32(msg->data.cc.value);
+            return 2;
+
+        case MIDI_MSG_PITCH_BEND: {
+            uint16_t v = msg->data.pitchbend.value;
+            if (v > 16383) v = 16383;
+            out[0] = midi2_word0(group, 0xEu, ch, 0, 0);
+            out[1] = msg->hires ? msg->data.pitchbend.value32 : midi_ump_value_14_to_32(v);
+            return 2;
+        }
+
+        case MIDI_MSG_CH_PRESSURE:
+            out[0] = midi2_word0(group, 0xDu, ch, 0, 0);
+            out[1] = midi_ump_value_7_to_32(msg->data.ch_pressure.value);
+            return 2;
+
+        case MIDI_MSG_PROGRAM_CHANGE:
+            /* Option flags = 0: no bank select */
+            out[0] = midi2_word0(group, 0xCu, ch, 0, 0);
+            out[1] = (uint32_t)(msg->data.program.program & 0x7Fu) << 24;
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
+size_t midi_ump_encode_midi1_bytes(const uint8_t *bytes, size_t len, uint8_t group, uint32_t out[1])
+{
+    if (!bytes || !out || len == 0 || len > 3) return 0;
+
+    const uint8_t status = bytes[0];
+    if ((status & 0x80u) == 0 || status == 0xF0u || status == 0xF7u) return 0;
+
+    const uint32_t mt = (status >= 0xF0u) ? MIDI_UMP_MT_SYSTEM : MIDI_UMP_MT_MIDI1_CV;
+    const uint8_t d1 = (len > 1) ? (uint8_t)(bytes[1] & 0x7Fu) : 0;
+    const uint8_t d2 = (len > 2) ? (uint8_t)(bytes[2] & 0x7Fu) : 0;
+
+    out[0] = (mt << 28) |
+             ((uint32_t)(group & 0x0Fu) << 24) |
+             ((uint32_t)status << 16) |
+             ((uint32_t)d1 << 8) |
+             (uint32_t)d2;
+    return 1;
+}
+
+size_t midi_ump_to_midi1_bytes(const uint32_t *w, size_t n, uint8_t out[MIDI_UMP_MIDI1_BYTES_MAX])
+{
+    if (!w || !out || n == 0) return 0;
+
+    const uint32_t mt = (w[0] >> 28) & 0x0Fu;
+    const uint8_t b1 = (uint8_t)(w[0] >> 16);
+    const uint8_t b2 = (uint8_t)(w[0] >> 8);
+    const uint8_t b3 = (uint8_t)w[0];
+    size_t len = 0;
+
+    switch (mt) {
+        case MIDI_UMP_MT_SYSTEM:
+        case MIDI_UMP_MT_MIDI1_CV:
+            out[len++] = b1;
+            out[len++] = b2 & 0x7Fu;
+            out[len++] = b3 & 0x7Fu;
+            /* The parser knows each status' length; trailing pad bytes of
+             * 1/2-byte messages would be taken as running-status data.
+             */
+            if (b1 >= 0xF8u || b1 == 0xF6u) {
+                len = 1;
+            } else if ((b1 & 0xF0u) == 0xC0u || (b1 & 0xF0u) == 0xD0u || b1 == 0xF1u || b1 == 0xF3u) {
+                len = 2;
+            }
+            break;
+
+        case MIDI_UMP_MT_SYSEX7: {
+            if (n < 2) return 0;
+            const uint8_t form = (uint8_t)((b1 >> 4) & 0x0Fu); /* 0 complete, 1 start, 2 continue, 3 end */
+            uint8_t count = (uint8_t)(b1 & 0x0Fu);
+            if (count > 6) count = 6;
+            const uint8_t payload[6] = {
+                b2, b3,
+                (uint8_t)(w[1] >> 24), (uint8_t)(w[1] >> 16), (uint8_t)(w[1] >> 8), (uint8_t)w[1],
+            };
+            if (form == 0 || form == 1) out[len++] = 0xF0u;
+            for (uint8_t i = 0; i < count; ++i) out[len++] = payload[i] & 0x7Fu;
+            if (form == 0 || form == 3) out[len++] = 0xF7u;
+            break;
+        }
+
+        case MIDI_UMP_MT_MIDI2_CV: {
+            if (n < 2) return 0;
+            const uint8_t op = (uint8_t)(b1 & 0xF0u);
+            const uint8_t ch = (uint8_t)(b1 & 0x0Fu);
+            const uint8_t v7 = (uint8_t)(w[1] >> 25);
+            switch (op) {
+                case 0x80u:
+                case 0x90u: {
+                    uint8_t vel = (uint8_t)(w[1] >> 25);
+                    if (op == 0x90u && vel == 0) vel = 1; /* keep Note On a Note On */
+                    out[len++] = (uint8_t)(op | ch);
+                    out[len++] = b2 & 0x7Fu;
+                    out[len++] = vel;
+                    break;
+                }
+                case 0xA0u:
+                case 0xB0u:
+                    out[len++] = (uint8_t)(op | ch);
+                    out[len++] = b2 & 0x7Fu;
+                    out[len++] = v7;
+                    break;
+                case 0xC0u:
+                    out[len++] = (uint8_t)(op | ch);
+                    out[len++] = (uint8_t)((w[1] >> 24) & 0x7Fu);
+                    break;
+                case 0xD0u:
+                    out[len++] = (uint8_t)(op | ch);
+                    out[len++] = v7;
+                    break;
+                case 0xE0u: {
+                    const uint16_t v14 = (uint16_t)(w[1] >> 18);
+                    out[len++] = (uint8_t)(op | ch);
+                    out[len++] = (uint8_t)(v14 & 0x7Fu);
+                    out[len++] = (uint8_t)((v14 >> 7) & 0x7Fu);
+                    break;
+                }
+                default:
+                    return 0;
+            }
+            break;
+        }
+
+        default:
+            /* Utility, data, flex data and stream messages are not used on input yet. */
+            return 0;
+    }
+
+    return len;
+}
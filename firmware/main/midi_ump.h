@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "midi_out.h"
+
+/* =========================================================
+ * Universal MIDI Packet (UMP) encoding helpers
+ *
+ * - Pure functions (no transport, no RTOS) so encoding can be verified
+ *   off-target.
+ * - MIDI 2.0 Channel Voice (message type 0x4, 64-bit) carries 16-bit
+ *   velocity and 32-bit controller / pitch bend values.
+ * - MIDI 1.0 Channel Voice in UMP (message type 0x2, 32-bit) is used as the
+ *   fallback when the host selected MIDI 1.0 protocol.
+ * - Value upscaling follows the MIDI 2.0 "Min-Center-Max" rule so that
+ *   center (e.g. pitch bend 8192) maps exactly to the 32-bit center.
+ * ========================================================= */
+
+#define MIDI_UMP_MAX_WORDS 2
+
+#define MIDI_UMP_MT_SYSTEM 0x1u
+#define MIDI_UMP_MT_MIDI1_CV 0x2u
+#define MIDI_UMP_MT_SYSEX7 0x3u
+#define MIDI_UMP_MT_MIDI2_CV 0x4u
+
+/* Number of 32-bit words in a UMP, derived from its message type nibble. */
+size_t midi_ump_word_count(uint32_t word0);
+
+/* Min-Center-Max upscaling (MIDI 2.0 spec, "Translation" section). */
+uint32_t midi_ump_scale_up(uint32_t value, uint8_t src_bits, uint8_t dst_bits);
+
+static inline uint16_t midi_ump_velocity_7_to_16(uint8_t v) { return (uint16_t)midi_ump_scale_up(v & 0x7Fu, 7, 16); }
+static inline uint32_t midi_ump_value_7_to_32(uint8_t v) { return midi_ump_scale_up(v & 0x7Fu, 7, 32); }
+static inline uint32_t midi_ump_value_14_to_32(uint16_t v) { return midi_ump_scale_up(v & 0x3FFFu, 14, 32); }
+
+/* Encode a structured message as a MIDI 2.0 Channel Voice UMP.
+ * Uses the message's high-resolution fields when msg->hires is set,
+ * otherwise upscales the 7/14-bit fields.
+ * Returns the number of words written (0 on unsupported type).
+ */
+size_t midi_ump_encode_midi2(const midi_msg_t *msg, uint8_t group, uint32_t out[MIDI_UMP_MAX_WORDS]);
+
+/* Wrap a MIDI 1.0 channel voice / system message (1..3 bytes, no SysEx)
+ * into a single 32-bit UMP (message type 0x2 or 0x1).
+ * Returns the number of words written (0 on invalid input).
+ */
+size_t midi_ump_encode_midi1_bytes(const uint8_t *bytes, size_t len, uint8_t group, uint32_t out[1]);
+
+/* Most MIDI 1.0 bytes one UMP converts to (a complete 6-byte SysEx7 packet) */
+#define MIDI_UMP_MIDI1_BYTES_MAX 8
+
+/* Convert one received UMP (n words, n >= midi_ump_word_count(w[0])) back
+ * to a MIDI 1.0 byte stream, for the MIDI 1.0 input parser. MIDI 2.0
+ * values are downscaled by truncation (spec translation rule); a MIDI 2.0
+ * Note On keeps velocity >= 1. SysEx7 packets become F0/F7-framed pieces.
+ * Returns the bytes written; 0 for messages with no MIDI 1.0 form
+ * (per-note controllers, RPN/NRPN in UMP form, utility, stream, etc.).
+ */
+size_t midi_ump_to_midi1_bytes(const uint32_t *w, size_t n, uint8_t out[MIDI_UMP_MIDI1_BYTES_MAX]);
@@ -0,0 +1,97 @@
+#include "note_map.h"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+#include "midi_mpe.h"
+
+static const char *TAG = "note_map";
+
+/* Standard tuning, Str1 (high E, E4=64) .. Str6 (low E, E2=40) */
+static const uint8_t k_standard_tuning[NOTE_MAP_ROWS] = {64, 59, 55, 50, 45, 40};
+
+/* Settings and table recycling are serialized by s_mux (UI / slider
+ * tasks, rare); readers never take it.
+ */
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t s_tuning[NOTE_MAP_ROWS];
+static uint8_t s_capo = 0;
+static int s_octave = 0;
+
+static note_map_t s_maps[3];
+static unsigned s_next = 0;
+
+_Atomic(const note_map_t *) g_note_map = NULL;
+
+/* Caller holds s_mux */
+static void build_and_publish(void)
+{
+    note_map_t *m = &s_maps[s_next];
+    s_next = (s_next + 1u) % 3u;
+
+    const bool mpe = midi_mpe_is_enabled();
+    for (int r = 0; r < NOTE_MAP_ROWS; ++r) {
+        const uint8_t ch = mpe ? midi_mpe_channel_for_row(r) : midi_mpe_default_channel();
+        for (int c = 0; c < NOTE_MAP_COLS; ++c) {
+            const int note = (int)s_tuning[r] + (int)s_capo + c + 12 * s_octave;
+            m->key[r][c].note = (note >= 0 && note <= 127) ? (uint8_t)note : NOTE_MAP_SILENT;
+            m->key[r][c].channel = ch;
+        }
+    }
+    atomic_store_explicit(&g_note_map, (const note_map_t *)m, memory_order_release);
+}
+
+void note_map_init(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    for (int r = 0; r < NOTE_MAP_ROWS; ++r) s_tuning[r] = k_standard_tuning[r];
+    s_capo = 0;
+    s_octave = 0;
+    build_and_publish();
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void note_map_rebuild(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    build_and_publish();
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void note_map_set_tuning(const uint8_t open_notes[NOTE_MAP_ROWS])
+{
+    if (!open_notes) return;
+    portENTER_CRITICAL(&s_mux);
+    for (int r = 0; r < NOTE_MAP_ROWS; ++r) s_tuning[r] = open_notes[r] & 0x7Fu;
+    build_and_publish();
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void note_map_set_capo(uint8_t fret)
+{
+    if (fret > NOTE_MAP_CAPO_MAX) fret = NOTE_MAP_CAPO_MAX;
+    portENTER_CRITICAL(&s_mux);
+    s_capo = fret;
+    build_and_publish();
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void note_map_set_octave(int oct)
+{
+    if (oct < NOTE_MAP_OCTAVE_MIN) oct = NOTE_MAP_OCTAVE_MIN;
+    if (oct > NOTE_MAP_OCTAVE_MAX) oct = NOTE_MAP_OCTAVE_MAX;
+    portENTER_CRITICAL(&s_mux);
+    const bool changed = (s_octave != oct);
+    s_octave = oct;
+    if (changed) build_and_publish();
+    portEXIT_CRITICAL(&s_mux);
+    if (changed) ESP_LOGI(TAG, "octave %+d", oct);
+}
+
+int note_map_get_octave(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    const int oct = s_octave;
+    portEXIT_CRITICAL(&s_mux);
+    return oct;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Key -> note map
+ *
+ * All 6 x 13 keys resolved to (MIDI note, channel) ahead of time from
+ * tuning, capo, octave shift and the MPE channel layout. Any change
+ * builds a fresh table and publishes it with one atomic pointer store,
+ * so the key path is a single table load and alternate tunings cost
+ * nothing at runtime.
+ *
+ * Readers use a table for one key event only. Tables are recycled three
+ * rebuilds later, far longer than any reader holds one.
+ * ========================================================= */
+
+#define NOTE_MAP_ROWS 6
+#define NOTE_MAP_COLS 13
+
+/* note value of keys that fall outside 0..127 */
+#define NOTE_MAP_SILENT 0xFFu
+
+#define NOTE_MAP_OCTAVE_MIN (-3)
+#define NOTE_MAP_OCTAVE_MAX 3
+#define NOTE_MAP_CAPO_MAX   12
+
+typedef struct {
+    uint8_t note;    /* 0..127, NOTE_MAP_SILENT == no note */
+    uint8_t channel; /* 0..15 (0 == MIDI ch1) */
+} note_map_entry_t;
+
+typedef struct {
+    note_map_entry_t key[NOTE_MAP_ROWS][NOTE_MAP_COLS];
+} note_map_t;
+
+/* Build the first table (standard tuning, no capo, octave 0). */
+void note_map_init(void);
+
+/* Rebuild with the current settings; call after MPE layout changes. */
+void note_map_rebuild(void);
+
+/* Open-string notes, row 0 (Str1) first. Default: E4 B3 G3 D3 A2 E2. */
+void note_map_set_tuning(const uint8_t open_notes[NOTE_MAP_ROWS]);
+void note_map_set_capo(uint8_t fret);       /* clamped to 0..NOTE_MAP_CAPO_MAX */
+void note_map_set_octave(int oct);          /* clamped to OCTAVE_MIN..MAX */
+int note_map_get_octave(void);
+
+/* Current table; NULL before note_map_init() */
+extern _Atomic(const note_map_t *) g_note_map;
+
+static inline note_map_entry_t note_map_lookup(int row, int col)
+{
+    const note_map_t *m = atomic_load_explicit(&g_note_map, memory_order_acquire);
+    if (!m || row < 0 || row >= NOTE_MAP_ROWS || col < 0 || col >= NOTE_MAP_COLS) {
+        return (note_map_entry_t){.note = NOTE_MAP_SILENT, .channel = 0};
+    }
+    return m->key[row][col];
+}
@@ -0,0 +1,173 @@
+#include "rt_stats.h"
+
+#if CONFIG_EMIUET_RT_STATS
+
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "task_layout.h"
+
+extern void esp_rom_delay_us(uint32_t us);
+
+static const char *TAG = "rt_stats";
+
+#define RT_STATS_BUCKETS 256
+#define RT_STATS_LOG_MS  5000
+
+typedef struct {
+    const char *name;
+    uint32_t bucket_us;
+    _Atomic uint32_t hist[RT_STATS_BUCKETS + 1]; /* last == overflow */
+    _Atomic uint32_t max_us;
+} rt_hist_t;
+
+/* Bucket widths: key path is expected in the tens of us, scan period ~5 ms */
+static rt_hist_t s_hist[RT_STAT_COUNT] = {
+    [RT_STAT_KEY_TO_ENQUEUE] = {.name = "key_to_enq_us", .bucket_us = 4},
+    [RT_STAT_SCAN_PERIOD] = {.name = "scan_period_us", .bucket_us = 100},
+};
+
+static TaskHandle_t s_log_task = NULL;
+
+void rt_stats_record(rt_stat_id_t id, uint32_t us)
+{
+    if ((unsigned)id >= RT_STAT_COUNT) return;
+    rt_hist_t *h = &s_hist[id];
+
+    const uint32_t b = us / h->bucket_us;
+    atomic_fetch_add_explicit(&h->hist[(b < RT_STATS_BUCKETS) ? b : RT_STATS_BUCKETS], 1u, memory_order_relaxed);
+
+    uint32_t m = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    while (us > m && !atomic_compare_exchange_weak_explicit(&h->max_us, &m, us, memory_order_relaxed,
+                                                             memory_order_relaxed)) {
+    }
+}
+
+static uint32_t percentile_us(const uint32_t *hist, uint32_t total, uint32_t pct, uint32_t bucket_us, uint32_t max_us)
+{
+    if (total == 0) return 0;
+    const uint32_t want = (total * pct + 99u) / 100u;
+    uint32_t acc = 0;
+    for (int b = 0; b < RT_STATS_BUCKETS; ++b) {
+        acc += hist[b];
+        if (acc >= want) {
+            const uint32_t upper = (uint32_t)(b + 1) * bucket_us;
+            return (upper < max_us) ? upper : max_us;
+        }
+    }
+    return max_us;
+}
+
+void rt_stats_take(rt_stat_id_t id, rt_stats_summary_t *out)
+{
+    *out = (rt_stats_summary_t){0};
+    if ((unsigned)id >= RT_STAT_COUNT) return;
+    rt_hist_t *h = &s_hist[id];
+
+    uint32_t snap[RT_STATS_BUCKETS + 1];
+    uint32_t total = 0;
+    for (int b = 0; b <= RT_STATS_BUCKETS; ++b) {
+        snap[b] = atomic_exchange_explicit(&h->hist[b], 0u, memory_order_relaxed);
+        total += snap[b];
+    }
+    const uint32_t max_us = atomic_exchange_explicit(&h->max_us, 0u, memory_order_relaxed);
+
+    out->n = total;
+    out->over = snap[RT_STATS_BUCKETS];
+    out->p50_us = percentile_us(snap, total, 50, h->bucket_us, max_us);
+    out->p99_us = percentile_us(snap, total, 99, h->bucket_us, max_us);
+    out->max_us = max_us;
+}
+
+static void rt_stats_log_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(RT_STATS_LOG_MS));
+
+        for (int id = 0; id < RT_STAT_COUNT; ++id) {
+            rt_stats_summary_t sum;
+            rt_stats_take((rt_stat_id_t)id, &sum);
+            if (sum.n == 0) continue;
+
+            ESP_LOGI(TAG, "stats %s{n=%lu over=%lu p50<=%lu p99<=%lu max=%lu}",
+                     s_hist[id].name,
+                     (unsigned long)sum.n,
+                     (unsigned long)sum.over,
+                     (unsigned long)sum.p50_us,
+                     (unsigned long)sum.p99_us,
+                     (unsigned long)sum.max_us);
+        }
+    }
+}
+
+#if CONFIG_EMIUET_RT_STRESS_CORE0
+/* 20 ms stall every RT_STRESS_PERIOD_US. The period is off the 1 ms tick,
+ * so stall starts drift through every phase of the scan cycle instead of
+ * always landing on the tick that wakes the scan task.
+ */
+#define RT_STRESS_BUSY_US   20000u
+#define RT_STRESS_PERIOD_US 100137u
+
+static TaskHandle_t s_stress_task = NULL;
+
+static void rt_stress_timer_cb(void *arg)
+{
+    (void)arg;
+    xTaskNotifyGive(s_stress_task);
+}
+
+/* Hold the I/O core without yielding, above every task there, like the
+ * interrupt work of a long polled I2C transfer or a stalled USB write.
+ */
+static void rt_stress_task(void *arg)
+{
+    (void)arg;
+    while (1) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_rom_delay_us(RT_STRESS_BUSY_US);
+    }
+}
+
+void rt_stats_stress_start(void)
+{
+    if (s_stress_task) return;
+
+    xTaskCreatePinnedToCore(rt_stress_task, "rt_stress", TASK_RT_STRESS_STACK, NULL,
+                            TASK_RT_STRESS_PRIO, &s_stress_task, TASK_RT_STRESS_CORE);
+
+    const esp_timer_create_args_t args = {
+        .callback = rt_stress_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "rt_stress",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer = NULL;
+    if (esp_timer_create(&args, &timer) != ESP_OK || esp_timer_start_periodic(timer, RT_STRESS_PERIOD_US) != ESP_OK) {
+        ESP_LOGE(TAG, "stall injector timer failed");
+        return;
+    }
+    ESP_LOGW(TAG, "core-0 stall injector running (%d ms busy every %d us)", (int)(RT_STRESS_BUSY_US / 1000u),
+             (int)RT_STRESS_PERIOD_US);
+}
+#endif
+
+void rt_stats_start(void)
+{
+    if (s_log_task) return;
+
+    xTaskCreatePinnedToCore(rt_stats_log_task, "rt_stats", TASK_RT_STATS_STACK, NULL,
+                            TASK_RT_STATS_PRIO, &s_log_task, TASK_RT_STATS_CORE);
+
+#if CONFIG_EMIUET_RT_STRESS_CORE0
+    rt_stats_stress_start();
+#endif
+}
+
+#endif /* CONFIG_EMIUET_RT_STATS */
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+/* =========================================================
+ * Real-time latency stats (development)
+ *
+ * - Lock-free histograms filled from the music core (scan task).
+ * - A low-priority task on the I/O core logs p50/p99/max every few
+ *   seconds and resets the window.
+ * - Optional core-0 stall injector to verify that I/O-core load does not
+ *   move music-core latency (see task_layout.h).
+ * - The host rt bench (firmware/host/rt_bench_main.c) runs the injector
+ *   alone and reads the windows itself.
+ * Compiled to no-ops unless CONFIG_EMIUET_RT_STATS is enabled.
+ * ========================================================= */
+
+/* Defensive defaults for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_RT_STATS
+#define CONFIG_EMIUET_RT_STATS 0
+#endif
+
+#ifndef CONFIG_EMIUET_RT_STRESS_CORE0
+#define CONFIG_EMIUET_RT_STRESS_CORE0 0
+#endif
+
+typedef enum {
+	RT_STAT_KEY_TO_ENQUEUE = 0, /* column read -> MIDI event enqueued (us) */
+	RT_STAT_SCAN_PERIOD,        /* start-to-start of full matrix scans (us) */
+	RT_STAT_COUNT,
+} rt_stat_id_t;
+
+/* One window: sample count, samples past the histogram range, p50/p99 as
+ * bucket upper bounds (capped at max), exact max.
+ */
+typedef struct {
+	uint32_t n;
+	uint32_t over;
+	uint32_t p50_us;
+	uint32_t p99_us;
+	uint32_t max_us;
+} rt_stats_summary_t;
+
+#if CONFIG_EMIUET_RT_STATS
+/* Log task, plus the stall injector when CONFIG_EMIUET_RT_STRESS_CORE0 */
+void rt_stats_start(void);
+void rt_stats_record(rt_stat_id_t id, uint32_t us);
+/* Summarise the window since the last take and start a new one */
+void rt_stats_take(rt_stat_id_t id, rt_stats_summary_t *out);
+#else
+static inline void rt_stats_start(void) {}
+static inline void rt_stats_record(rt_stat_id_t id, uint32_t us) { (void)id; (void)us; }
+static inline void rt_stats_take(rt_stat_id_t id, rt_stats_summary_t *out)
+{
+	(void)id;
+	*out = (rt_stats_summary_t){0};
+}
+#endif
+
+#if CONFIG_EMIUET_RT_STATS && CONFIG_EMIUET_RT_STRESS_CORE0
+/* Injector only (no log task) */
+void rt_stats_stress_start(void);
+#else
+static inline void rt_stats_stress_start(void) {}
+#endif
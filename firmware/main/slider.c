@@ -1,142 +1,246 @@
 #include "slider.h"
 #include "board_pins.h"
 #include "adc_manager.h"
+#include "slider_filter.h"
 #include "esp_err.h"
 #include "esp_log.h"
-#include <limits.h>
 
 static const char *TAG = "slider";
 
-/* EMA filter state */
-/* EMA filter state and initialization guard */
-static float pb_ema = 0.0f;
-static bool pb_ema_initialized = false;
-static float mod_ema = 0.0f;
-static float vel_ema = 0.0f;
+/* Filter chains (slider_filter.h), stepped only by the slider task.
+ * Tuned with the host filter bench (emiuet_filterbench,
+ * firmware/host/traces/slider_pb.trace). Mod and velocity (10 ms poll):
+ * median + EMA + 3-LSB hysteresis. Pitch bend, fed the oversampled
+ * reading: One-Euro (0.5 Hz at rest) + 1-LSB hysteresis. Against the EMA
+ * plus slider_task's former send deadband (rest jitter pp 16 LSB, step
+ * t90 180 ms, bend lag 78 ms):
+ *   per 0.9 ms frame   pp ~1 LSB, t90 9 ms, lag 11 ms (-p 1 "frame_" chain)
+ *   per 10 ms poll     pp 1 LSB, t90 30 ms, lag 30 ms (median3 for spikes)
+ */
+#ifndef SLIDER_ADC_EMA_ALPHA
+#define SLIDER_ADC_EMA_ALPHA 0.25f
+#endif
+#define SLIDER_CHAIN_CFG {.median = 3, .ema_alpha = SLIDER_FILTER_ALPHA(SLIDER_ADC_EMA_ALPHA), .hyst = 24}
+/* Pitch bend, stepped per ADC frame (streamed) or per poll (oneshot) */
+static const slider_filter_cfg_t k_pb_frame_cfg = {.euro_fmin_mhz = 500, .euro_beta_mhz = 5000, .hyst = 8};
+static const slider_filter_cfg_t k_pb_poll_cfg = {.median = 3, .euro_fmin_mhz = 500, .euro_beta_mhz = 10000, .hyst = 8};
+static slider_filter_t s_pb_filter;
+static slider_filter_t s_mod_filter = {.cfg = SLIDER_CHAIN_CFG};
+static slider_filter_t s_vel_filter = {.cfg = SLIDER_CHAIN_CFG};
+
+/* Oneshot pitch-bend burst, trimmed-mean'd into one reading */
+#ifndef SLIDER_ADC_SAMPLES
+#define SLIDER_ADC_SAMPLES 8
+#endif
+
 static bool s_enabled = false;
-/* Last-good raw (0..1023) to return on transient ADC failures */
-static int s_last_raw = 0;
+/* Last-good raw (0..4095) per slider, returned on transient ADC failures */
+static uint16_t s_last_pb = 0;
+static uint16_t s_last_pb_fine = 0;
+static uint16_t s_last_mod = 0;
+static uint16_t s_last_mod_fine = 0;
+static uint16_t s_last_vel = 0;
 static int s_adc_fail_count = 0;
-#ifdef SLIDER_DEBUG_CALIB
-/* Observed min/max for optional calibration logging */
-static int s_observed_min = INT_MAX;
-static int s_observed_max = INT_MIN;
-#endif
+
+/* ADC channel per slider, resolved once at init */
+static adc_chan_t s_chan[SLIDER_COUNT];
+static const gpio_num_t k_slider_pin[SLIDER_COUNT] = {PIN_SLIDER_PB, PIN_SLIDER_MOD, PIN_SLIDER_VEL};
+
+/* Per-slider linearization (zeroed == identity) and the last input it saw */
+static slider_calib_t s_calib[SLIDER_COUNT];
+static uint16_t s_in_q15[SLIDER_COUNT];
+static const char *const k_calib_key[SLIDER_COUNT] = {"pb", "mod", "vel"};
+
+/* One sample in (Q15, as converted from the ADC), linearized Q15 out */
+static inline uint16_t linearize(slider_id_t id, uint16_t q15)
+{
+    s_in_q15[id] = q15;
+    return slider_calib_apply(&s_calib[id], q15);
+}
 
 void slider_init(void)
 {
     /* adc_manager_init() is idempotent */
     s_enabled = adc_manager_init();
+    for (int id = 0; s_enabled && id < SLIDER_COUNT; ++id) {
+        const esp_err_t err = adc_manager_chan_open(k_slider_pin[id], &s_chan[id]);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "%s: gpio %d not readable (%s)", k_calib_key[id], (int)k_slider_pin[id], esp_err_to_name(err));
+        }
+    }
+    /* Streamed: the slider task steps the bend filter once per ADC frame,
+     * and adc_manager already drops spike conversions within each frame.
+     */
+    const uint32_t frame_us = s_chan[SLIDER_PB].streamed ? adc_manager_frame_period_us() : 0;
+    slider_filter_cfg_t cfg = frame_us ? k_pb_frame_cfg : k_pb_poll_cfg;
+    cfg.period_us = (uint16_t)(frame_us ? frame_us : SLIDER_POLL_MS * 1000);
+    slider_filter_init(&s_pb_filter, &cfg);
     if (!s_enabled) {
         ESP_LOGW(TAG, "ADC manager not available; sliders disabled");
+        return;
+    }
+
+    for (int id = 0; id < SLIDER_COUNT; ++id) {
+        const esp_err_t err = slider_calib_load(k_calib_key[id], &s_calib[id]);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "%s: calibrated travel %u..%u", k_calib_key[id], (unsigned)s_calib[id].lo,
+                     (unsigned)s_calib[id].hi);
+        } else if (err != ESP_ERR_NOT_FOUND) {
+            ESP_LOGW(TAG, "%s: calibration not loaded (%s)", k_calib_key[id], esp_err_to_name(err));
+        }
     }
 }
 
-static uint16_t read_adc_gpio_or_last(gpio_num_t gpio)
+/* `n` raw reads (0..4095) in one batch; all of them the last good value on failure */
+static void read_adc_or_last(slider_id_t id, uint16_t *out, size_t n, uint16_t *last)
 {
-    if (!s_enabled) return (uint16_t)s_last_raw;
-
-    int raw = 0;
-    esp_err_t ret = adc_manager_read_raw(gpio, &raw);
+    int raw[SLIDER_ADC_SAMPLES];
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (s_enabled && n <= SLIDER_ADC_SAMPLES) {
+        ret = adc_manager_chan_read(&s_chan[id], 1, n, raw, NULL);
+    }
     if (ret != ESP_OK) {
         s_adc_fail_count++;
         if (s_adc_fail_count == 1) {
-            ESP_LOGW(TAG, "adc read failed for gpio %d (first failure)", (int)gpio);
+            ESP_LOGW(TAG, "adc read failed for gpio %d (first failure)", (int)k_slider_pin[id]);
         } else if (s_adc_fail_count == 8) {
             ESP_LOGW(TAG, "adc read failing repeatedly (%d times) - returning last good value", s_adc_fail_count);
         }
-        return (uint16_t)s_last_raw;
+        for (size_t i = 0; i < n; ++i) out[i] = *last;
+        return;
     }
 
     s_adc_fail_count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (uint16_t)(raw[i] < 0 ? 0 : raw[i] > 4095 ? 4095 : raw[i]);
+    }
+    *last = out[n - 1];
+}
 
-    /* Map raw (0..4095) to 0..1023 */
-    if (raw < 0) raw = 0;
-    if (raw > 4095) raw = 4095;
-    int mapped = (int)((raw * 1023) / 4095);
-    s_last_raw = mapped;
+/* Oversampled 16-bit code (raw << 4) for pitch bend */
+static uint16_t read_adc_fine_or_last(slider_id_t id, uint16_t *last)
+{
+    if (!s_enabled) return *last;
 
-#ifdef SLIDER_DEBUG_CALIB
-    if (mapped < s_observed_min) {
-        s_observed_min = mapped;
-        ESP_LOGD(TAG, "slider observed min=%d", s_observed_min);
-    }
-    if (mapped > s_observed_max) {
-        s_observed_max = mapped;
-        ESP_LOGD(TAG, "slider observed max=%d", s_observed_max);
+    uint16_t fine = 0;
+    if (adc_manager_chan_read_fine(&s_chan[id], &fine) != ESP_OK) {
+        s_adc_fail_count++;
+        if (s_adc_fail_count == 1) {
+            ESP_LOGW(TAG, "adc fine read failed for gpio %d (first failure)", (int)k_slider_pin[id]);
+        }
+        return *last;
     }
-#endif
-
-    return (uint16_t)mapped;
+    s_adc_fail_count = 0;
+    *last = fine;
+    return fine;
 }
 
 uint16_t slider_read_pitchbend(void)
 {
     if (!s_enabled) return 0;
 
-    /* Multi-sample with simple trimming to reject spikes */
-#ifndef SLIDER_ADC_SAMPLES
-#define SLIDER_ADC_SAMPLES 8
-#endif
-    const int samples = SLIDER_ADC_SAMPLES;
-    int minv = INT_MAX;
-    int maxv = INT_MIN;
-    int sum = 0;
-    for (int i = 0; i < samples; ++i) {
-        int v = read_adc_gpio_or_last(PIN_SLIDER_PB);
-        sum += v;
-        if (v < minv) minv = v;
-        if (v > maxv) maxv = v;
+    /* Full resolution end to end: a streamed pin is decimated over every
+     * conversion since the last poll (~14 effective bits); oneshot keeps
+     * the fraction of a trimmed burst mean.
+     */
+    uint16_t fine; /* 12-bit raw << 4 */
+    if (s_chan[SLIDER_PB].streamed) {
+        fine = read_adc_fine_or_last(SLIDER_PB, &s_last_pb_fine);
+    } else {
+        /* one lock round trip for the whole burst */
+        uint16_t burst[SLIDER_ADC_SAMPLES];
+        read_adc_or_last(SLIDER_PB, burst, SLIDER_ADC_SAMPLES, &s_last_pb);
+        for (int i = 0; i < SLIDER_ADC_SAMPLES; ++i) burst[i] = (uint16_t)(burst[i] << 4);
+        fine = slider_filter_trimmed_mean(burst, SLIDER_ADC_SAMPLES);
     }
 
-    /* Trim one min and one max if samples >=3 (robust against spikes) */
-    int denom = samples;
-    if (samples >= 3) {
-        sum -= minv + maxv;
-        denom -= 2;
-    }
-    float avg = (denom > 0) ? ((float)sum / (float)denom) : 0.0f;
+    /* Return 0..1023 (smoothed); slider_pitchbend_last_fine() has the rest */
+    const uint16_t q = linearize(SLIDER_PB, slider_filter_fine_to_q15(fine));
+    return slider_filter_q15_to_bits(slider_filter_step_q15(&s_pb_filter, q), 10);
+}
 
-    /* Clamp into expected range */
-    if (avg < 0.0f) avg = 0.0f;
-    if (avg > 1023.0f) avg = 1023.0f;
+uint16_t slider_pitchbend_last_fine(void)
+{
+    /* The filter keeps far more than the 10 bits slider_read_pitchbend()
+     * returns; expose it for 14-bit and 32-bit bends.
+     */
+    if (!s_enabled || !s_pb_filter.primed) return 0;
+    const uint16_t q = slider_filter_value(&s_pb_filter);
+    return (uint16_t)((q << 1) | (q >> 14));
+}
 
-    /* initialize EMA on first stable observation to avoid startup wander */
-#ifndef SLIDER_ADC_EMA_ALPHA
-#define SLIDER_ADC_EMA_ALPHA 0.12f
-#endif
-    const float alpha = SLIDER_ADC_EMA_ALPHA;
-    if (!pb_ema_initialized) {
-        pb_ema = avg;
-        pb_ema_initialized = true;
-        ESP_LOGD(TAG, "pb_ema initialized=%.2f", pb_ema);
+uint16_t slider_read_mod(void)
+{
+    if (!s_enabled) return 0;
+    /* Streamed: the mean since the last poll, enough bits for 14-bit CC#1 */
+    uint16_t q;
+    if (s_chan[SLIDER_MOD].streamed) {
+        uint16_t fine = 0;
+        if (s_mod_filter.primed) {
+            fine = read_adc_fine_or_last(SLIDER_MOD, &s_last_mod_fine);
+        } else if (adc_manager_chan_read_fine(&s_chan[SLIDER_MOD], &fine) == ESP_OK) {
+            s_last_mod_fine = fine;
+        } else {
+            return 0; /* no frame converted yet: don't prime the filter on a zero */
+        }
+        q = slider_filter_fine_to_q15(fine);
     } else {
-        pb_ema = pb_ema * (1.0f - alpha) + avg * alpha;
+        uint16_t raw;
+        read_adc_or_last(SLIDER_MOD, &raw, 1, &s_last_mod);
+        q = slider_filter_raw_to_q15(raw);
     }
-
-    /* Return 0..1023 (smoothed) */
-    return (uint16_t)pb_ema;
+    q = slider_filter_step_q15(&s_mod_filter, linearize(SLIDER_MOD, q));
+    return slider_filter_q15_to_bits(q, 10);
 }
 
-uint16_t slider_read_mod(void)
+bool slider_mod_last_fine(uint16_t *out)
 {
-    if (!s_enabled) return 0;
-    uint16_t v = read_adc_gpio_or_last(PIN_SLIDER_MOD);
-    float nv = (float)v;
-    mod_ema = mod_ema * 0.9f + nv * 0.1f;
-    return (uint16_t)mod_ema;
+    if (!s_enabled || !s_mod_filter.primed) return false;
+    const uint16_t q = slider_filter_value(&s_mod_filter);
+    *out = (uint16_t)((q << 1) | (q >> 14));
+    return true;
 }
 
 uint16_t slider_read_velocity(void)
 {
     if (!s_enabled) return 0;
-    uint16_t v = read_adc_gpio_or_last(PIN_SLIDER_VEL);
-    float nv = (float)v;
-    vel_ema = vel_ema * 0.9f + nv * 0.1f;
-    return (uint16_t)vel_ema;
+    /* the first reading primes the filter: the first notes after boot use the real position */
+    uint16_t raw;
+    read_adc_or_last(SLIDER_VEL, &raw, 1, &s_last_vel);
+    const uint16_t q = linearize(SLIDER_VEL, slider_filter_raw_to_q15(raw));
+    return slider_filter_q15_to_bits(slider_filter_step_q15(&s_vel_filter, q), 10);
 }
 
 bool slider_is_enabled(void)
 {
     return s_enabled;
 }
+
+uint16_t slider_last_input_q15(slider_id_t id)
+{
+    return (id < SLIDER_COUNT) ? s_in_q15[id] : 0;
+}
+
+esp_err_t slider_calibrate(slider_id_t id, const uint16_t points[SLIDER_CALIB_POINTS])
+{
+    if (id >= SLIDER_COUNT) return ESP_ERR_INVALID_ARG;
+
+    slider_calib_t c;
+    esp_err_t err = slider_calib_build(&c, points);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s: points %u..%u not monotonic or travel too short; previous table kept",
+                 k_calib_key[id], (unsigned)points[0], (unsigned)points[SLIDER_CALIB_POINTS - 1]);
+        return err;
+    }
+    err = slider_calib_save(k_calib_key[id], &c);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s: calibration not stored (%s); used until reboot", k_calib_key[id], esp_err_to_name(err));
+    }
+
+    /* Restart the chain on the new scale so it does not glide there */
+    s_calib[id] = c;
+    slider_filter_t *const f[SLIDER_COUNT] = {&s_pb_filter, &s_mod_filter, &s_vel_filter};
+    slider_filter_reset(f[id]);
+    ESP_LOGI(TAG, "%s: calibrated travel %u..%u", k_calib_key[id], (unsigned)c.lo, (unsigned)c.hi);
+    return err;
+}
@@ -3,21 +3,61 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "esp_err.h"
+#include "slider_calib.h"
+
 /* Slider driver
  * - Reads ADC for pitch/mod/vel sliders
  * - Exposes normalized values (0..1023)
  * - Pitch bend behavior (upward-only) handled in midi_mpe layer
  */
 
+/* Slider task poll period; the pitch-bend filter is tuned for it */
+#define SLIDER_POLL_MS 10
+
+typedef enum {
+    SLIDER_PB = 0,
+    SLIDER_MOD,
+    SLIDER_VEL,
+    SLIDER_COUNT,
+} slider_id_t;
+
 void slider_init(void);
 uint16_t slider_read_pitchbend(void);
+
+/* Last smoothed pitch-bend position scaled to 0..65535 (no new ADC read).
+ * Same filter state as slider_read_pitchbend(), without the truncation to
+ * 10 bits: the oversampled input keeps ~14 effective bits, used for the
+ * 14-bit and MIDI 2.0 32-bit bends.
+ */
+uint16_t slider_pitchbend_last_fine(void);
 uint16_t slider_read_mod(void);
+
+/* Last smoothed mod position scaled to 0..65535 (no new ADC read), for
+ * 14-bit CC#1/CC#33. The filter's hysteresis holds it still at rest.
+ * False until the first reading.
+ */
+bool slider_mod_last_fine(uint16_t *out);
 uint16_t slider_read_velocity(void);
 
 /* Start a background task that polls the pitch-bend slider and applies
- * pitch-bend messages via `midi_mpe_apply_pitchbend`. Call after midi/init.
+ * pitch-bend messages via `midi_mpe_apply_pitchbend`, and sends the mod
+ * slider as CC#1. Call after midi/init.
  */
 void slider_task_start(void);
 
 /* Return true if slider ADC is available and initialized */
 bool slider_is_enabled(void);
+
+/* Calibration (slider task only). slider_init() loads each slider's
+ * linearization from NVS; without one the input passes unchanged.
+ */
+
+/* Last input of the slider's read (Q15) before linearization */
+uint16_t slider_last_input_q15(slider_id_t id);
+
+/* Build the linearization from inputs captured at 0, 25, 50, 75 and
+ * 100 % of travel, store it in NVS and use it from the next read.
+ * Keeps the previous one if the points are unusable.
+ */
+esp_err_t slider_calibrate(slider_id_t id, const uint16_t points[SLIDER_CALIB_POINTS]);
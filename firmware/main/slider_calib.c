@@ -0,0 +1,126 @@
+#include "slider_calib.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "slider_calib";
+
+#define SLIDER_CALIB_NVS_NAMESPACE "slider_cal"
+#define SLIDER_CALIB_BLOB_VERSION 1
+
+/* Stored form: the scale is derived again at load */
+typedef struct {
+    uint16_t version;
+    uint16_t lo;
+    uint16_t hi;
+    uint16_t lut[SLIDER_CALIB_LUT_N];
+} slider_calib_blob_t;
+
+static inline uint32_t span_of(uint16_t lo, uint16_t hi)
+{
+    return (hi > lo) ? (uint32_t)(hi - lo) : (uint32_t)(lo - hi);
+}
+
+/* Rounded up, so the far end of travel lands exactly on 32768 */
+static inline uint32_t scale_for(uint32_t span)
+{
+    return ((32768u << 16) + span - 1u) / span;
+}
+
+esp_err_t slider_calib_build(slider_calib_t *out, const uint16_t points[SLIDER_CALIB_POINTS])
+{
+    if (!out || !points) return ESP_ERR_INVALID_ARG;
+
+    const bool rising = points[SLIDER_CALIB_POINTS - 1] > points[0];
+    for (int k = 1; k < SLIDER_CALIB_POINTS; ++k) {
+        if (rising ? (points[k] <= points[k - 1]) : (points[k] >= points[k - 1])) return ESP_ERR_INVALID_ARG;
+    }
+    const uint32_t span = span_of(points[0], points[SLIDER_CALIB_POINTS - 1]);
+    if (span < SLIDER_CALIB_MIN_SPAN) return ESP_ERR_INVALID_ARG;
+
+    slider_calib_t c = {
+        .lo = points[0],
+        .hi = points[SLIDER_CALIB_POINTS - 1],
+        .scale_q16 = scale_for(span),
+    };
+
+    /* Normalized travel at each captured point; the targets are even steps */
+    uint32_t t[SLIDER_CALIB_POINTS];
+    for (int k = 0; k < SLIDER_CALIB_POINTS; ++k) {
+        t[k] = (span_of(points[0], points[k]) * c.scale_q16) >> 16;
+    }
+
+    /* Piecewise-linear through the points, sampled on the LUT grid */
+    int k = 0;
+    for (int i = 0; i < SLIDER_CALIB_LUT_N; ++i) {
+        const uint32_t g = (uint32_t)i << SLIDER_CALIB_LUT_SHIFT;
+        while (k < SLIDER_CALIB_POINTS - 2 && g > t[k + 1]) k++;
+        const uint32_t y0 = (uint32_t)k * 32767u / (SLIDER_CALIB_POINTS - 1);
+        const uint32_t y1 = (uint32_t)(k + 1) * 32767u / (SLIDER_CALIB_POINTS - 1);
+        const uint32_t dt = t[k + 1] - t[k];
+        const uint32_t into = (g > t[k]) ? g - t[k] : 0u;
+        const uint32_t y = y0 + ((y1 - y0) * into + dt / 2u) / dt;
+        c.lut[i] = (uint16_t)(y > 32767u ? 32767u : y);
+    }
+
+    *out = c;
+    return ESP_OK;
+}
+
+esp_err_t slider_calib_load(const char *key, slider_calib_t *out)
+{
+    if (!key || !out) return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SLIDER_CALIB_NVS_NAMESPACE, NVS_READONLY, &h);
+    if (err == ESP_ERR_NVS_NOT_FOUND) return ESP_ERR_NOT_FOUND;
+    if (err != ESP_OK) return err;
+
+    slider_calib_blob_t blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(h, key, &blob, &len);
+    nvs_close(h);
+    if (err == ESP_ERR_NVS_NOT_FOUND) return ESP_ERR_NOT_FOUND;
+    if (err != ESP_OK) return err;
+
+    const uint32_t span = span_of(blob.lo, blob.hi);
+    if (len != sizeof(blob) || blob.version != SLIDER_CALIB_BLOB_VERSION || span < SLIDER_CALIB_MIN_SPAN ||
+        blob.lo > 32767u || blob.hi > 32767u) {
+        ESP_LOGW(TAG, "%s: stored calibration invalid; ignored", key);
+        return ESP_ERR_NOT_FOUND;
+    }
+    for (int i = 0; i < SLIDER_CALIB_LUT_N; ++i) {
+        if (blob.lut[i] > 32767u) {
+            ESP_LOGW(TAG, "%s: stored calibration invalid; ignored", key);
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    out->lo = blob.lo;
+    out->hi = blob.hi;
+    out->scale_q16 = scale_for(span);
+    memcpy(out->lut, blob.lut, sizeof(out->lut));
+    return ESP_OK;
+}
+
+esp_err_t slider_calib_save(const char *key, const slider_calib_t *c)
+{
+    if (!key || !c || c->scale_q16 == 0) return ESP_ERR_INVALID_ARG;
+
+    slider_calib_blob_t blob = {
+        .version = SLIDER_CALIB_BLOB_VERSION,
+        .lo = c->lo,
+        .hi = c->hi,
+    };
+    memcpy(blob.lut, c->lut, sizeof(blob.lut));
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SLIDER_CALIB_NVS_NAMESPACE, NVS_READWRITE, &h);
+    if (err != ESP_OK) return err;
+    err = nvs_set_blob(h, key, &blob, sizeof(blob));
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    return err;
+}
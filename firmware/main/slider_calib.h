@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* =========================================================
+ * Slider linearization
+ *
+ * Real potentiometers stop short of the rails and their taper is not
+ * quite linear. Calibration captures each slider at SLIDER_CALIB_POINTS
+ * evenly spaced positions (0, 25, 50, 75, 100 %); from those this builds
+ *
+ *   lo/hi    input (Q15) at the ends of travel
+ *   lut      SLIDER_CALIB_LUT_N outputs over the normalized travel
+ *
+ * so applying it is a clamp, one multiply and one table interpolation,
+ * integer only. A zeroed slider_calib_t is the identity.
+ * ========================================================= */
+
+#define SLIDER_CALIB_POINTS 5
+#define SLIDER_CALIB_LUT_SHIFT 9 /* 512 steps per segment: knees between points stay sharp */
+#define SLIDER_CALIB_LUT_N ((32768 >> SLIDER_CALIB_LUT_SHIFT) + 1)
+
+/* Smallest end-to-end travel accepted, Q15 (1/8 of the ADC range) */
+#define SLIDER_CALIB_MIN_SPAN 4096
+
+typedef struct {
+    uint16_t lo;        /* input at 0 % (may be above hi: reversed slider) */
+    uint16_t hi;        /* input at 100 % */
+    uint32_t scale_q16; /* 32768 / |hi - lo| in Q16; 0 == identity */
+    uint16_t lut[SLIDER_CALIB_LUT_N];
+} slider_calib_t;
+
+/* Build from inputs (Q15) captured at 0, 25, 50, 75 and 100 %. Fails
+ * (ESP_ERR_INVALID_ARG) unless the points are strictly monotonic and the
+ * travel spans at least SLIDER_CALIB_MIN_SPAN; `out` is then untouched.
+ */
+esp_err_t slider_calib_build(slider_calib_t *out, const uint16_t points[SLIDER_CALIB_POINTS]);
+
+static inline uint16_t slider_calib_apply(const slider_calib_t *c, uint16_t q15)
+{
+    if (c->scale_q16 == 0) return q15;
+
+    /* Normalized travel 0..32768; the clamp keeps the product in 32 bits */
+    uint32_t d;
+    if (c->hi > c->lo) {
+        d = (q15 <= c->lo) ? 0u : (q15 >= c->hi) ? (uint32_t)(c->hi - c->lo) : (uint32_t)(q15 - c->lo);
+    } else {
+        d = (q15 >= c->lo) ? 0u : (q15 <= c->hi) ? (uint32_t)(c->lo - c->hi) : (uint32_t)(c->lo - q15);
+    }
+    const uint32_t t = (d * c->scale_q16) >> 16;
+    if (t >= 32768u) return c->lut[SLIDER_CALIB_LUT_N - 1];
+
+    const uint32_t i = t >> SLIDER_CALIB_LUT_SHIFT;
+    const int32_t f = (int32_t)(t & ((1u << SLIDER_CALIB_LUT_SHIFT) - 1u));
+    const int32_t a = c->lut[i];
+    const int32_t b = c->lut[i + 1u];
+    return (uint16_t)(a + (((b - a) * f) >> SLIDER_CALIB_LUT_SHIFT));
+}
+
+/* NVS persistence, one blob per slider under `key` (<= 15 chars), in
+ * this module's namespace of the default partition. The partition is
+ * app_main's: it must be initialized first (otherwise the NVS error is
+ * returned). Load returns ESP_ERR_NOT_FOUND when nothing valid is stored.
+ */
+esp_err_t slider_calib_load(const char *key, slider_calib_t *out);
+esp_err_t slider_calib_save(const char *key, const slider_calib_t *c);
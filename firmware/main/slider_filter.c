@@ -0,0 +1,157 @@
+#include "slider_filter.h"
+
+#include <string.h>
+
+static inline void swap_u16(uint16_t *a, uint16_t *b)
+{
+    if (*a > *b) {
+        const uint16_t t = *a;
+        *a = *b;
+        *b = t;
+    }
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    swap_u16(&a, &b);
+    swap_u16(&b, &c);
+    swap_u16(&a, &b);
+    return b;
+}
+
+/* 9-comparator sorting network; the median is the middle element */
+static uint16_t median5(const uint16_t *w)
+{
+    uint16_t s0 = w[0], s1 = w[1], s2 = w[2], s3 = w[3], s4 = w[4];
+    swap_u16(&s0, &s1);
+    swap_u16(&s3, &s4);
+    swap_u16(&s2, &s4);
+    swap_u16(&s2, &s3);
+    swap_u16(&s0, &s3);
+    swap_u16(&s0, &s2);
+    swap_u16(&s1, &s4);
+    swap_u16(&s1, &s3);
+    swap_u16(&s1, &s2);
+    return s2;
+}
+
+/* Q15 smoothing factor of a one-pole low-pass at fc_mhz sampled every
+ * period_us: alpha = w / (1 + w), w = 2*pi*fc*T.
+ */
+static uint16_t euro_alpha(uint64_t fc_mhz, uint32_t period_us)
+{
+    if (fc_mhz > 1000000u) fc_mhz = 1000000u; /* 1 kHz: alpha is ~1 long before */
+    const uint64_t w = fc_mhz * period_us * 411775u / 1000000000u; /* Q16; 411775 = 2*pi*65536 */
+    const uint64_t a = (w << 15) / (65536u + w);
+    return (uint16_t)(a > SLIDER_FILTER_Q15_MAX ? SLIDER_FILTER_Q15_MAX : (a ? a : 1u));
+}
+
+void slider_filter_init(slider_filter_t *f, const slider_filter_cfg_t *cfg)
+{
+    memset(f, 0, sizeof(*f));
+    if (cfg) f->cfg = *cfg;
+    if (f->cfg.median != 3 && f->cfg.median != 5) f->cfg.median = 0;
+    if (f->cfg.trim > SLIDER_FILTER_TRIM_MAX) f->cfg.trim = SLIDER_FILTER_TRIM_MAX;
+    if (f->cfg.trim < 3) f->cfg.trim = 0;
+    if (f->cfg.period_us == 0) f->cfg.euro_fmin_mhz = 0;
+    if (f->cfg.euro_fmin_mhz) {
+        const uint16_t dcut = f->cfg.euro_dcut_mhz ? f->cfg.euro_dcut_mhz : SLIDER_FILTER_EURO_DCUT_DEFAULT_MHZ;
+        f->euro_alpha_d = euro_alpha(dcut, f->cfg.period_us);
+    }
+}
+
+void slider_filter_reset(slider_filter_t *f)
+{
+    const slider_filter_cfg_t cfg = f->cfg;
+    slider_filter_init(f, &cfg);
+}
+
+uint16_t slider_filter_trimmed_mean(const uint16_t *s, int n)
+{
+    if (!s || n <= 0) return 0;
+    uint32_t sum = 0;
+    uint16_t lo = UINT16_MAX;
+    uint16_t hi = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += s[i];
+        if (s[i] < lo) lo = s[i];
+        if (s[i] > hi) hi = s[i];
+    }
+    if (n >= 3) {
+        sum -= (uint32_t)lo + hi;
+        n -= 2;
+    }
+    return (uint16_t)((sum + (uint32_t)n / 2u) / (uint32_t)n);
+}
+
+uint16_t slider_filter_step_q15(slider_filter_t *f, uint16_t q15)
+{
+    uint16_t x = q15 > SLIDER_FILTER_Q15_MAX ? SLIDER_FILTER_Q15_MAX : q15;
+
+    if (f->cfg.median) {
+        const uint8_t n = f->cfg.median;
+        if (!f->primed) {
+            for (uint8_t i = 0; i < n; ++i) f->med_buf[i] = x;
+        }
+        f->med_buf[f->med_pos] = x;
+        f->med_pos = (uint8_t)((f->med_pos + 1u) % n);
+        x = (n == 3) ? median3(f->med_buf[0], f->med_buf[1], f->med_buf[2]) : median5(f->med_buf);
+    }
+
+    if (f->cfg.trim) {
+        const uint8_t n = f->cfg.trim;
+        if (!f->primed) {
+            for (uint8_t i = 0; i < n; ++i) f->trim_buf[i] = x;
+        }
+        f->trim_buf[f->trim_pos] = x;
+        f->trim_pos = (uint8_t)((f->trim_pos + 1u) % n);
+        x = slider_filter_trimmed_mean(f->trim_buf, n);
+    }
+
+    if (f->cfg.euro_fmin_mhz) {
+        const int32_t target = (int32_t)x << 8;
+        if (!f->primed) {
+            f->ema = target;
+            f->dx = 0;
+        } else {
+            /* speed from the previous output, itself low-passed */
+            const int32_t d = target - f->ema;
+            f->dx += (int32_t)(((int64_t)(d - f->dx) * f->euro_alpha_d) >> 15);
+            const uint64_t speed = (uint64_t)(f->dx < 0 ? -(int64_t)f->dx : f->dx);
+            /* speed in full scale/s = speed / (32767 << 8) * 1e6 / period_us */
+            const uint64_t fc = f->cfg.euro_fmin_mhz +
+                                (uint64_t)f->cfg.euro_beta_mhz * speed * 1000000u /
+                                    ((uint64_t)SLIDER_FILTER_Q15_MAX * 256u * f->cfg.period_us);
+            const uint16_t alpha = euro_alpha(fc, f->cfg.period_us);
+            f->ema += (int32_t)(((int64_t)(target - f->ema) * alpha) >> 15);
+        }
+        x = (uint16_t)((f->ema + 128) >> 8);
+    } else if (f->cfg.ema_alpha > 0 && f->cfg.ema_alpha < SLIDER_FILTER_Q15_MAX) {
+        const int32_t target = (int32_t)x << 8;
+        if (!f->primed) {
+            f->ema = target;
+        } else {
+            /* 8 extra fraction bits keep slow EMAs from stalling short of the input */
+            f->ema += (int32_t)(((int64_t)(target - f->ema) * f->cfg.ema_alpha) >> 15);
+        }
+        x = (uint16_t)((f->ema + 128) >> 8);
+    }
+
+    if (f->cfg.hyst && f->primed) {
+        const int32_t h = f->cfg.hyst;
+        const int32_t out = f->out;
+        if (x == 0 || x == SLIDER_FILTER_Q15_MAX) {
+            /* rails pass through, so both ends stay reachable */
+        } else if ((int32_t)x > out + h) {
+            x = (uint16_t)(x - h);
+        } else if ((int32_t)x < out - h) {
+            x = (uint16_t)(x + h);
+        } else {
+            x = f->out;
+        }
+    }
+
+    f->primed = true;
+    f->out = x;
+    return x;
+}
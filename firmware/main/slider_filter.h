@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Fixed-point slider filter chain
+ *
+ * One raw ADC sample (12-bit) in, one Q15 position (0..32767) out,
+ * through optional stages in this order:
+ *
+ *   median   window 3 or 5: removes single-sample spikes
+ *   trim     sliding window of up to 8, mean without its min and max
+ *   ema      one-pole low-pass, alpha in Q15
+ *   euro     One-Euro adaptive low-pass, replaces ema when enabled: the
+ *            cutoff rises with the estimated slider speed, so a slider at
+ *            rest is heavily smoothed and a fast move passes with little lag
+ *   hyst     output moves only once the input leaves +-hyst (backlash);
+ *            the rails (0, full scale) pass through
+ *
+ * Integer only and deterministic: the same samples give the same output
+ * on the device and in the host filter bench (firmware/host).
+ * ========================================================= */
+
+#define SLIDER_FILTER_Q15_MAX   32767
+#define SLIDER_FILTER_MEDIAN_MAX 5
+#define SLIDER_FILTER_TRIM_MAX   8
+
+/* alpha as a fraction, e.g. SLIDER_FILTER_ALPHA(0.12f); compile-time use */
+#define SLIDER_FILTER_ALPHA(a) ((uint16_t)((a) * 32767.0f + 0.5f))
+
+/* One-Euro speed cutoff when euro_dcut_mhz is 0 */
+#define SLIDER_FILTER_EURO_DCUT_DEFAULT_MHZ 1000
+
+typedef struct {
+    uint8_t median;     /* 0/1 = off, 3 or 5 */
+    uint8_t trim;       /* 0 = off, 3..SLIDER_FILTER_TRIM_MAX */
+    uint16_t ema_alpha; /* Q15; 0 or >= 32767 = off */
+    uint16_t hyst;      /* Q15 half-width; 0 = off */
+    /* One-Euro: cutoff = fmin + beta * speed (full scale per second) */
+    uint16_t euro_fmin_mhz; /* minimum cutoff, mHz; 0 = off */
+    uint16_t euro_beta_mhz; /* added cutoff per full scale/s, mHz */
+    uint16_t euro_dcut_mhz; /* speed estimate cutoff, mHz */
+    uint16_t period_us;     /* sample period; euro is off while 0 */
+} slider_filter_cfg_t;
+
+typedef struct {
+    slider_filter_cfg_t cfg;
+    uint16_t med_buf[SLIDER_FILTER_MEDIAN_MAX];
+    uint16_t trim_buf[SLIDER_FILTER_TRIM_MAX];
+    uint8_t med_pos;
+    uint8_t trim_pos;
+    int32_t ema; /* Q15 << 8 */
+    int32_t dx;  /* euro speed, Q15 << 8 per sample */
+    uint16_t euro_alpha_d;
+    uint16_t out;
+    bool primed;
+} slider_filter_t;
+
+void slider_filter_init(slider_filter_t *f, const slider_filter_cfg_t *cfg);
+
+/* Forget history: the next sample primes every stage. */
+void slider_filter_reset(slider_filter_t *f);
+
+/* Feed one sample already in Q15 (e.g. an oversampled reading); returns
+ * the filtered Q15 position.
+ */
+uint16_t slider_filter_step_q15(slider_filter_t *f, uint16_t q15);
+
+/* Last output (0 before the first sample) */
+static inline uint16_t slider_filter_value(const slider_filter_t *f)
+{
+    return f->out;
+}
+
+/* Unfiltered Q15 value of a raw sample, and back to n-bit */
+static inline uint16_t slider_filter_raw_to_q15(uint16_t raw12)
+{
+    if (raw12 > 4095u) raw12 = 4095u;
+    return (uint16_t)((raw12 << 3) | (raw12 >> 9));
+}
+
+/* 16-bit oversampled code (12-bit raw << 4, see adc_manager_read_fine) to Q15 */
+static inline uint16_t slider_filter_fine_to_q15(uint16_t fine16)
+{
+    if (fine16 > (4095u << 4)) fine16 = 4095u << 4;
+    return (uint16_t)((fine16 >> 1) | (fine16 >> 13));
+}
+
+/* Feed one raw sample (0..4095); returns the filtered Q15 position. */
+static inline uint16_t slider_filter_step(slider_filter_t *f, uint16_t raw12)
+{
+    return slider_filter_step_q15(f, slider_filter_raw_to_q15(raw12));
+}
+
+static inline uint16_t slider_filter_q15_to_bits(uint16_t q15, unsigned bits)
+{
+    return (uint16_t)(q15 >> (15u - bits));
+}
+
+/* Trimmed mean of a burst (drops one min and one max when n >= 3) */
+uint16_t slider_filter_trimmed_mean(const uint16_t *samples, int n);
@@ -1,80 +1,229 @@
 #include "slider.h"
+#include "adc_manager.h"
 #include "midi_mpe.h"
+#include "midi_out.h"
 #include "board_pins.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "task_layout.h"
+#include "velocity.h"
+#include "sdkconfig.h"
+
+/* Defensive default for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_VELOCITY_SLIDER
+#define CONFIG_EMIUET_VELOCITY_SLIDER 1
+#endif
+
+#ifndef CONFIG_EMIUET_MOD_SLIDER
+#define CONFIG_EMIUET_MOD_SLIDER 1
+#endif
+
+#ifndef CONFIG_EMIUET_MOD_CC14
+#define CONFIG_EMIUET_MOD_CC14 0
+#endif
+
+#ifndef CONFIG_EMIUET_SLIDER_CALIB
+#define CONFIG_EMIUET_SLIDER_CALIB 1
+#endif
 
 static const char *TAG = "slider_task";
 static TaskHandle_t s_task = NULL;
 
-#define SLIDER_PB_POLL_MS      10
-#define SLIDER_PB_DEADBAND     12   /* 8〜16くらいで好み調整 */
-/* Minimum interval between pitch-bend sends (ms) to avoid flooding */
-/* Minimum interval between pitch-bend sends (ms) to avoid flooding when
- * rapid changes occur. Sending still only happens on meaningful diffs or
- * events (bottom snap). No unconditional periodic sends. */
-#define SLIDER_PB_MIN_SEND_MS  20
-/* When raw <= this value treat as bottom (center) snap. Tune by feel. */
+/* When raw <= this value treat as bottom (center) snap. Tune by feel.
+ * Calibration maps the bottom of travel to 0, so it holds for every unit.
+ */
 #define SLIDER_PB_BOTTOM_RAW   16
-/* ADC/sample/filter tuning */
-#ifndef SLIDER_ADC_SAMPLES
-#define SLIDER_ADC_SAMPLES 8
+
+/* 32-bit upward-only bend for MIDI 2.0 routes. Uses the unquantized slider
+ * position; center stays exactly 0x80000000 so bottom snap is bit-exact.
+ */
+static void slider_apply_pitchbend(uint16_t value14)
+{
+    if (value14 <= 8192) {
+        midi_mpe_apply_pitchbend_hr(0x80000000u);
+        return;
+    }
+    const uint32_t fine = slider_pitchbend_last_fine(); /* 0..65535 */
+    const uint32_t value32 = 0x80000000u + (uint32_t)(((uint64_t)fine * 0x7FFFFFFFu) / 65535u);
+    midi_mpe_apply_pitchbend_hr(value32);
+}
+
+#if CONFIG_EMIUET_MOD_SLIDER
+/* Mod slider -> CC#1 (or a 14-bit CC#1/CC#33 pair) on the default
+ * channel, which is the MPE master channel while member channels start
+ * at 2. The filter's hysteresis gates noise, so only motion changes the
+ * value; each route's CC#1 slot coalesces what its link cannot carry.
+ */
+static void poll_mod(void)
+{
+    static uint32_t last_sent = UINT32_MAX; /* the first reading is sent: synths start in sync */
+    (void)slider_read_mod();
+    uint16_t fine; /* 0..65535 */
+    if (!slider_mod_last_fine(&fine)) return;
+#if CONFIG_EMIUET_MOD_CC14
+    const uint32_t v = fine >> 2;
+#else
+    const uint32_t v = fine >> 9;
+#endif
+    if (v == last_sent) return;
+    last_sent = v;
+#if CONFIG_EMIUET_MOD_CC14
+    midi_send_cc14(midi_mpe_default_channel(), 1, (uint16_t)v);
+#else
+    midi_send_cc(midi_mpe_default_channel(), 1, (uint8_t)v);
+#endif
+}
+#endif
+
+#if CONFIG_EMIUET_SLIDER_CALIB
+/* =========================================================
+ * Calibration mode
+ *
+ * Hold SW_CENTER while the slider task starts. For pitch bend, mod and
+ * velocity in turn, move the slider to 0, 25, 50, 75 and 100 % of its
+ * travel and press SW_CENTER at each; the mean input over the next
+ * SLIDER_CALIB_AVG_POLLS polls is captured. No MIDI is sent meanwhile.
+ * Tables are stored only once every point is captured; a step left
+ * waiting for SLIDER_CALIB_STEP_TIMEOUT_MS aborts and keeps them all.
+ * ========================================================= */
+
+#define SLIDER_CALIB_AVG_POLLS 16
+#define SLIDER_CALIB_STEP_TIMEOUT_MS 30000
+
+static void calib_read_all(void)
+{
+    (void)slider_read_pitchbend();
+    (void)slider_read_mod();
+    (void)slider_read_velocity();
+    vTaskDelay(pdMS_TO_TICKS(SLIDER_POLL_MS));
+}
+
+/* Debounced level change of SW_CENTER to `level`; sliders keep sampling.
+ * False when the switch did not get there within the step timeout.
+ */
+static bool calib_wait_center(int level)
+{
+    int stable = 0;
+    for (uint32_t polls = 0; stable < 3; ++polls) {
+        if (polls >= SLIDER_CALIB_STEP_TIMEOUT_MS / SLIDER_POLL_MS) return false;
+        stable = (gpio_get_level(PIN_SW_CENTER) == level) ? stable + 1 : 0;
+        calib_read_all();
+    }
+    return true;
+}
+
+/* Every point of every slider, in order; false on a step timeout */
+static bool calib_capture(uint16_t points[SLIDER_COUNT][SLIDER_CALIB_POINTS])
+{
+    static const char *const name[SLIDER_COUNT] = {"pitch bend", "mod", "velocity"};
+
+    ESP_LOGI(TAG, "slider calibration: release the center switch");
+    if (!calib_wait_center(1)) return false;
+    for (int id = 0; id < SLIDER_COUNT; ++id) {
+        for (int k = 0; k < SLIDER_CALIB_POINTS; ++k) {
+            ESP_LOGI(TAG, "calibrate %s: move to %d %% and press center", name[id],
+                     k * 100 / (SLIDER_CALIB_POINTS - 1));
+            if (!calib_wait_center(0)) return false;
+            uint32_t sum = 0;
+            for (int i = 0; i < SLIDER_CALIB_AVG_POLLS; ++i) {
+                calib_read_all();
+                sum += slider_last_input_q15((slider_id_t)id);
+            }
+            points[id][k] = (uint16_t)((sum + SLIDER_CALIB_AVG_POLLS / 2) / SLIDER_CALIB_AVG_POLLS);
+            ESP_LOGI(TAG, "  captured %u", (unsigned)points[id][k]);
+            if (!calib_wait_center(1)) return false;
+        }
+    }
+    return true;
+}
+
+static void run_calibration(void)
+{
+    uint16_t points[SLIDER_COUNT][SLIDER_CALIB_POINTS];
+
+    if (!calib_capture(points)) {
+        ESP_LOGW(TAG, "slider calibration aborted: no center switch change in %u s; nothing stored",
+                 (unsigned)(SLIDER_CALIB_STEP_TIMEOUT_MS / 1000));
+        return;
+    }
+    /* NVS writes on the music core: the calibration-mode exception in
+     * task_layout.h
+     */
+    for (int id = 0; id < SLIDER_COUNT; ++id) {
+        (void)slider_calibrate((slider_id_t)id, points[id]); /* logs the outcome */
+    }
+    ESP_LOGI(TAG, "slider calibration done");
+}
 #endif
 
-#define SLIDER_SEND_DIFF_THRESHOLD 12 /* difference (mapped units) required to send */
-/* State-machine thresholds (tuneable) */
-#define SLIDER_START_THRESHOLD  16   /* raw units to consider movement start */
-#define SLIDER_START_COUNT      2    /* consecutive polls above start threshold */
-#define SLIDER_STOP_THRESHOLD   8    /* raw units for settling/stop */
-#define SLIDER_STOP_COUNT       6    /* consecutive polls within stop threshold */
+/* Velocity and mod sliders and the center switch, every SLIDER_POLL_MS */
+static void poll_slow_inputs(void)
+{
+#if CONFIG_EMIUET_VELOCITY_SLIDER
+    /* Background velocity sample: note-on only reads the published value */
+    velocity_update(slider_read_velocity());
+#endif
+#if CONFIG_EMIUET_MOD_SLIDER
+    poll_mod();
+#endif
+    /* Poll SW_CENTER (PIN_SW_CENTER) for MPE toggle/debug. Detect edges. */
+    static int last_sw_center = 1;
+    int sw_now = gpio_get_level(PIN_SW_CENTER);
+    if (sw_now != last_sw_center) {
+        /* simple debounce: require stable for 30ms (polled at 10ms) */
+        static int stable_count = 0;
+        if (sw_now == last_sw_center) {
+            stable_count = 0;
+        } else {
+            stable_count++;
+        }
+        if (stable_count >= 3) {
+            /* falling edge = pressed (active low) */
+            if (sw_now == 0) {
+                bool new_en = !midi_mpe_is_enabled();
+                midi_mpe_set_enabled(new_en);
+                ESP_LOGI(TAG, "SW_CENTER pressed: MPE %s", new_en ? "ENABLED" : "DISABLED");
+            }
+            last_sw_center = sw_now;
+            stable_count = 0;
+        }
+    }
+}
 
 static void slider_task(void *arg)
 {
     (void)arg;
-    const TickType_t delay = pdMS_TO_TICKS(SLIDER_PB_POLL_MS);
-
-    uint16_t last_sent = 0xFFFF; /* impossible init */
-    TickType_t last_send_tick = 0; /* rate-limit last send time */
-    const TickType_t min_send_ticks = pdMS_TO_TICKS(SLIDER_PB_MIN_SEND_MS);
+#if CONFIG_EMIUET_SLIDER_CALIB
+    if (gpio_get_level(PIN_SW_CENTER) == 0) run_calibration();
+#endif
+    const TickType_t delay = pdMS_TO_TICKS(SLIDER_POLL_MS);
+    /* Streamed pitch bend: run once per ADC frame (>= 1 kHz), so a bend
+     * leaves within about a frame of the move; the rest stays at the poll
+     * period. Oneshot: everything on the poll period.
+     */
+    const bool frame_driven = adc_manager_is_streamed(PIN_SLIDER_PB);
+    if (frame_driven) adc_manager_set_frame_listener(xTaskGetCurrentTaskHandle());
+    TickType_t last_poll = xTaskGetTickCount() - delay;
 
-    enum { SLIDER_STATE_IDLE = 0, SLIDER_STATE_ACTIVE, SLIDER_STATE_SETTLE } state = SLIDER_STATE_IDLE;
-    uint16_t baseline = 0;
-    int start_count = 0;
-    int stop_count = 0;
-    uint16_t pending_value = 0;
-    static bool pb_target_locked = false;
-    bool just_activated = false;
+    uint16_t last_sent = 0xFFFF; /* adopts the first reading without sending */
+    bool pb_target_locked = false;
 
     while (1) {
         uint16_t raw = slider_read_pitchbend(); /* 0..1023 */
-        /* Poll SW_CENTER (PIN_SW_CENTER) for MPE toggle/debug. Detect edges. */
-        static int last_sw_center = 1;
-        int sw_now = gpio_get_level(PIN_SW_CENTER);
-        if (sw_now != last_sw_center) {
-            /* simple debounce: require stable for 30ms (polled at 10ms) */
-            static int stable_count = 0;
-            if (sw_now == last_sw_center) {
-                stable_count = 0;
-            } else {
-                stable_count++;
-            }
-            if (stable_count >= 3) {
-                /* falling edge = pressed (active low) */
-                if (sw_now == 0) {
-                    bool new_en = !midi_mpe_is_enabled();
-                    midi_mpe_set_enabled(new_en);
-                    ESP_LOGI(TAG, "SW_CENTER pressed: MPE %s", new_en ? "ENABLED" : "DISABLED");
-                }
-                last_sw_center = sw_now;
-                stable_count = 0;
-            }
+
+        const TickType_t now = xTaskGetTickCount();
+        if (!frame_driven || (now - last_poll) >= delay) {
+            last_poll = now;
+            poll_slow_inputs();
         }
 
         const int MIDI_CENTER = 8192;
         const int MIDI_MAX = 16383;
-        uint32_t mapped = MIDI_CENTER + ((uint32_t)raw * (MIDI_MAX - MIDI_CENTER) / 1023U);
+        /* Upper half from the fine position: one bend unit per ~14-bit step */
+        const uint32_t fine = slider_pitchbend_last_fine(); /* 0..65535 */
+        uint32_t mapped = MIDI_CENTER + ((fine * (MIDI_MAX - MIDI_CENTER) + 32767U) / 65535U);
         if (mapped > MIDI_MAX) mapped = MIDI_MAX;
 
         uint16_t cur = (uint16_t)mapped;
@@ -82,144 +231,36 @@ static void slider_task(void *arg)
         const bool is_bottom = (raw <= SLIDER_PB_BOTTOM_RAW);
         if (is_bottom) cur = MIDI_CENTER;
 
-        /* State machine for sending */
-        switch (state) {
-        case SLIDER_STATE_IDLE: {
-            /* Initialize baseline on first pass */
-            if (baseline == 0) baseline = cur;
-
-            int delta = (int)cur - (int)baseline;
-            if (delta < 0) delta = -delta;
-            if (delta >= SLIDER_START_THRESHOLD) {
-                start_count++;
-            } else {
-                start_count = 0;
+        /* The pitch-bend filter (slider.c, One-Euro) already tells motion from
+         * noise, so every change of the bend value is sent. Each route's
+         * latest-value slot coalesces bends its link cannot carry yet, so
+         * link bandwidth, not a sleep, sets the output rate.
+         */
+        if (last_sent == 0xFFFF) last_sent = cur;
+        if (cur != last_sent) {
+            if (midi_mpe_is_enabled() && !pb_target_locked) {
+                /* lock on the first bend; a center send still locks briefly so reset behaves */
+                midi_mpe_lock_pitchbend_target(true);
+                pb_target_locked = true;
             }
+            slider_apply_pitchbend(cur);
+            ESP_LOGD(TAG, "PB send raw=%u cur=%u bottom=%d locked=%d last_ch=%d", (unsigned)raw, (unsigned)cur,
+                     (int)is_bottom, (int)pb_target_locked, midi_mpe_get_last_active_channel());
+            last_sent = cur;
 
-            if (start_count >= SLIDER_START_COUNT) {
-                state = SLIDER_STATE_ACTIVE;
-                pending_value = cur;
-                start_count = 0;
-                stop_count = 0;
-                just_activated = true;
-                /* reset rate timer so immediate send on activation is allowed */
-                last_send_tick = 0;
-                ESP_LOGI(TAG, "slider: ACTIVE (baseline=%u)", (unsigned)baseline);
+            /* center (bottom snap): unlock and reset the MPE target */
+            if (cur == MIDI_CENTER && pb_target_locked && midi_mpe_is_enabled()) {
+                midi_mpe_lock_pitchbend_target(false);
+                midi_mpe_reset_pitchbend_target();
+                pb_target_locked = false;
             }
-            break;
         }
 
-        case SLIDER_STATE_ACTIVE: {
-            /* Movement ongoing; update pending. Send at rate limit. */
-            pending_value = cur;
-            TickType_t now = xTaskGetTickCount();
-
-            /* Bottom-handling: always send exactly one center and return to IDLE */
-            if (is_bottom) {
-                if (last_sent != MIDI_CENTER) {
-                    /* send center immediately */
-                    if (midi_mpe_is_enabled() && !pb_target_locked) {
-                        /* ensure lock/unlock semantics: lock briefly so reset behaves */
-                        midi_mpe_lock_pitchbend_target(true);
-                        pb_target_locked = true;
-                    }
-                    midi_mpe_apply_pitchbend(MIDI_CENTER);
-                    ESP_LOGD(TAG, "PB bottom snap -> center sent");
-                    last_sent = MIDI_CENTER;
-                    /* unlock/reset and go idle */
-                    if (pb_target_locked && midi_mpe_is_enabled()) {
-                        midi_mpe_lock_pitchbend_target(false);
-                        midi_mpe_reset_pitchbend_target();
-                        pb_target_locked = false;
-                    }
-                }
-                state = SLIDER_STATE_IDLE;
-                baseline = MIDI_CENTER;
-                break;
-            }
-
-            /* Decide whether to send: only if difference is meaningful */
-            int send_diff = (int)pending_value - (int)last_sent; if (send_diff < 0) send_diff = -send_diff;
-            bool should_send = false;
-            if (just_activated) {
-                /* when movement first detected, send immediately */
-                should_send = true;
-            } else if (last_sent == 0xFFFF) {
-                /* no prior sends yet */
-                should_send = true;
-            } else if (send_diff >= SLIDER_SEND_DIFF_THRESHOLD) {
-                should_send = true;
-            }
-
-            if (should_send) {
-                if ((now - last_send_tick) >= min_send_ticks || just_activated) {
-                    /* On first non-center send, lock MPE target */
-                    if (midi_mpe_is_enabled()) {
-                        if (pending_value != MIDI_CENTER && !pb_target_locked) {
-                            midi_mpe_lock_pitchbend_target(true);
-                            pb_target_locked = true;
-                        }
-                    }
-
-                    midi_mpe_apply_pitchbend(pending_value);
-                    int last_ch = midi_mpe_get_last_active_channel();
-                    ESP_LOGD(TAG, "PB send raw=%u cur=%u bottom=%d locked=%d last_ch=%d",
-                             (unsigned)raw, (unsigned)pending_value, (int)is_bottom,
-                             (int)pb_target_locked, last_ch);
-                    last_send_tick = now;
-                    last_sent = pending_value;
-
-                    /* If center sent (shouldn't happen here), unlock/reset PB target immediately */
-                    if (pending_value == MIDI_CENTER && pb_target_locked && midi_mpe_is_enabled()) {
-                        midi_mpe_lock_pitchbend_target(false);
-                        midi_mpe_reset_pitchbend_target();
-                        pb_target_locked = false;
-                    }
-                }
-            }
-
-            just_activated = false;
-
-            /* detect settle: last_sent close to current reading */
-            int diff = (int)cur - (int)last_sent; if (diff < 0) diff = -diff;
-            if (diff <= SLIDER_STOP_THRESHOLD) {
-                stop_count++;
-            } else {
-                stop_count = 0;
-            }
-
-            if (stop_count >= SLIDER_STOP_COUNT) {
-                state = SLIDER_STATE_SETTLE;
-                ESP_LOGI(TAG, "slider: SETTLE (last_sent=%u)", (unsigned)last_sent);
-                stop_count = 0;
-            }
-            break;
+        if (frame_driven) {
+            (void)ulTaskNotifyTake(pdTRUE, delay); /* the timeout keeps the slow inputs alive if ADC stalls */
+        } else {
+            vTaskDelay(delay);
         }
-
-        case SLIDER_STATE_SETTLE: {
-            /* Wait briefly to confirm stop, then go idle and adopt baseline */
-            int diff = (int)cur - (int)last_sent; if (diff < 0) diff = -diff;
-            if (diff <= SLIDER_STOP_THRESHOLD) {
-                stop_count++;
-            } else {
-                /* movement resumed */
-                state = SLIDER_STATE_ACTIVE;
-                stop_count = 0;
-                break;
-            }
-
-            if (stop_count >= SLIDER_STOP_COUNT) {
-                state = SLIDER_STATE_IDLE;
-                baseline = cur;
-                last_sent = cur; /* avoid immediate resend */
-                stop_count = 0;
-                ESP_LOGI(TAG, "slider: IDLE (new baseline=%u)", (unsigned)baseline);
-            }
-            break;
-        }
-        }
-
-        vTaskDelay(delay);
     }
 }
 
@@ -233,6 +274,11 @@ void slider_task_start(void)
         return;
     }
 
+#if CONFIG_EMIUET_VELOCITY_SLIDER
+    velocity_init();
+    velocity_update(slider_read_velocity());
+#endif
+
     /* Configure center switch (PIN_SW_CENTER) for debug MPE toggle/logging */
     gpio_config_t io = {0};
     io.mode = GPIO_MODE_INPUT;
@@ -241,6 +287,7 @@ void slider_task_start(void)
     io.pull_down_en = 0;
     gpio_config(&io);
 
-    xTaskCreate(slider_task, "slider_task", 4096, NULL, 6, &s_task);
+    xTaskCreatePinnedToCore(slider_task, "slider_task", TASK_SLIDER_STACK, NULL, TASK_SLIDER_PRIO, &s_task,
+                            TASK_SLIDER_CORE);
     ESP_LOGD(TAG, "slider task started");
 }
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+/* =========================================================
+ * Task placement (single source of truth)
+ *
+ * Core 1 ("music core"): matrix scan + key->MIDI bridge (runs in the scan
+ *   task), slider/pitch-bend, matrix simulator. Nothing on this core does
+ *   I/O that can stall (I2C, USB, UART, flash, logging in hot paths).
+ * Core 0 ("I/O core"): MIDI transports (TinyUSB, sender tasks, USB RX),
+ *   UI (OLED / LEDs), housekeeping (boot sequencing, USB state, stats).
+ *
+ * The two sides only meet through the lock-free MIDI transmit rings
+ * (midi_tx_ring.h) and atomic state (matrix pressed masks, MPE routing),
+ * so a long OLED I2C transfer or a USB stall on core 0 cannot delay a
+ * key event on core 1.
+ *
+ * Note: esp_timer callbacks (MIDI scheduler) run in the esp_timer task,
+ * whose core is CONFIG_ESP_TIMER_TASK_AFFINITY (core 0 by default).
+ *
+ * Exception: slider calibration mode (center switch held at boot) stores
+ * its tables to NVS from the slider task on core 1. It runs only before
+ * the slider loop starts and sends no MIDI; a flash write stalls both
+ * cores' cache anyway, so moving it to core 0 would not spare core 1.
+ * ========================================================= */
+
+/* Defensive defaults for stale sdkconfig.h; must match Kconfig.projbuild. */
+#ifndef CONFIG_EMIUET_TASK_PARTITION
+#define CONFIG_EMIUET_TASK_PARTITION 1
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY 7
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY 6
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY 6
+#endif
+
+#ifndef CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY
+#define CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY 5
+#endif
+
+#define TASK_CORE_IO 0
+
+#if CONFIG_EMIUET_TASK_PARTITION && !defined(CONFIG_FREERTOS_UNICORE)
+#define TASK_CORE_MUSIC 1
+#else
+/* Partitioning disabled (or single core): legacy placement, music tasks float */
+#define TASK_CORE_MUSIC tskNO_AFFINITY
+#endif
+
+/* ---- Music core ---- */
+#define TASK_MATRIX_SCAN_CORE   TASK_CORE_MUSIC
+#define TASK_MATRIX_SCAN_PRIO   10
+#define TASK_MATRIX_SCAN_STACK  4096
+
+#define TASK_SLIDER_CORE        TASK_CORE_MUSIC
+#define TASK_SLIDER_PRIO        6
+#define TASK_SLIDER_STACK       4096
+
+/* Continuous ADC frame reader (see adc_manager.c): above the slider task
+ * so a frame is published before the slider poll that wants it.
+ */
+#define TASK_ADC_CONT_CORE      TASK_CORE_MUSIC
+#define TASK_ADC_CONT_PRIO      7
+#define TASK_ADC_CONT_STACK     3072
+
+#define TASK_MATRIX_SIM_CORE    TASK_CORE_MUSIC
+#define TASK_MATRIX_SIM_PRIO    5
+#define TASK_MATRIX_SIM_STACK   4096
+
+/* ---- I/O core: transports ---- */
+#define TASK_TINYUSB_CORE       TASK_CORE_IO
+#define TASK_TINYUSB_PRIO       5
+
+#define TASK_MIDI_TRS_TX_CORE   TASK_CORE_IO
+#define TASK_MIDI_TRS_TX_PRIO   CONFIG_EMIUET_MIDI_TASK_TRS_PRIORITY
+#define TASK_MIDI_TRS_TX_STACK  4096
+
+#define TASK_MIDI_USB_TX_CORE   TASK_CORE_IO
+#define TASK_MIDI_USB_TX_PRIO   CONFIG_EMIUET_MIDI_TASK_USB_PRIORITY
+#define TASK_MIDI_USB_TX_STACK  4096
+
+#define TASK_MIDI_BLE_TX_CORE   TASK_CORE_IO
+#define TASK_MIDI_BLE_TX_PRIO   CONFIG_EMIUET_MIDI_TASK_BLE_PRIORITY
+#define TASK_MIDI_BLE_TX_STACK  4096
+
+#define TASK_MIDI_USB_RX_CORE   TASK_CORE_IO
+#define TASK_MIDI_USB_RX_PRIO   CONFIG_EMIUET_MIDI_TASK_USB_RX_PRIORITY
+#define TASK_MIDI_USB_RX_STACK  4096
+
+/* ---- I/O core: UI ---- */
+#define TASK_OLED_CORE          TASK_CORE_IO
+#define TASK_OLED_PRIO          3
+#define TASK_OLED_STACK         4096
+
+#define TASK_LED_CORE           TASK_CORE_IO
+#define TASK_LED_PRIO           3
+#define TASK_LED_STACK          4096
+
+#define TASK_UI_BUTTONS_CORE    TASK_CORE_IO
+#define TASK_UI_BUTTONS_PRIO    3
+#define TASK_UI_BUTTONS_STACK   2560
+
+/* ---- I/O core: housekeeping ---- */
+#define TASK_BOARD_INIT_CORE    TASK_CORE_IO
+#define TASK_BOARD_INIT_PRIO    5
+#define TASK_BOARD_INIT_STACK   8192
+
+#define TASK_USB_STATE_CORE     TASK_CORE_IO
+#define TASK_USB_STATE_PRIO     5
+#define TASK_USB_STATE_STACK    2048
+
+#define TASK_RT_STATS_CORE      TASK_CORE_IO
+#define TASK_RT_STATS_PRIO      2
+#define TASK_RT_STATS_STACK     3072
+
+/* Development only: core-0 stall injector (see rt_stats.c). Above every
+ * task, like interrupt work: a task that can preempt it shows no stall, so
+ * only the core a music task runs on keeps it out of the way.
+ */
+#define TASK_RT_STRESS_CORE     TASK_CORE_IO
+#define TASK_RT_STRESS_PRIO     (configMAX_PRIORITIES - 1)
+#define TASK_RT_STRESS_STACK    2048
+
+/* Development only: bend sweep for the MIDI storm bench (see midi_bench.c),
+ * placed like the slider task it stands in for.
+ */
+#define TASK_MIDI_BENCH_BEND_CORE   TASK_CORE_MUSIC
+#define TASK_MIDI_BENCH_BEND_PRIO   TASK_SLIDER_PRIO
+#define TASK_MIDI_BENCH_BEND_STACK  3072
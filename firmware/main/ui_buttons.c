@@ -0,0 +1,68 @@
+#include "ui_buttons.h"
+
+#include <stdbool.h>
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "board_pins.h"
+#include "note_map.h"
+#include "task_layout.h"
+
+static const char *TAG = "ui_buttons";
+
+/* Polled every 10 ms; a level must hold for 3 polls (30 ms) to count.
+ * Pins are configured with pull-ups by board_pins_init_early().
+ *
+ * NOTE: PIN_SW_LEFT is UART0 RX. A console on UART0 only sees a break
+ * while the button is held; the level read here is unaffected.
+ */
+#define UI_BUTTONS_POLL_MS  10
+#define UI_BUTTONS_STABLE_N 3
+
+typedef struct {
+    gpio_num_t pin;
+    int step;   /* octave change per press */
+    int level;  /* debounced level, 1 == released */
+    int stable; /* polls the raw level has differed from `level` */
+} ui_button_t;
+
+static TaskHandle_t s_task = NULL;
+
+static void buttons_task(void *arg)
+{
+    (void)arg;
+    ui_button_t btn[] = {
+        {.pin = PIN_SW_LEFT, .step = -1, .level = 1},
+        {.pin = PIN_SW_RIGHT, .step = +1, .level = 1},
+    };
+
+    while (1) {
+        for (size_t i = 0; i < sizeof(btn) / sizeof(btn[0]); ++i) {
+            ui_button_t *b = &btn[i];
+            const int now = gpio_get_level(b->pin);
+            if (now == b->level) {
+                b->stable = 0;
+                continue;
+            }
+            if (++b->stable < UI_BUTTONS_STABLE_N) continue;
+
+            b->level = now;
+            b->stable = 0;
+            if (now == 0) { /* falling edge = pressed (active low) */
+                note_map_set_octave(note_map_get_octave() + b->step);
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(UI_BUTTONS_POLL_MS));
+    }
+}
+
+void ui_buttons_start(void)
+{
+    if (s_task) return;
+    xTaskCreatePinnedToCore(buttons_task, "ui_buttons", TASK_UI_BUTTONS_STACK, NULL, TASK_UI_BUTTONS_PRIO, &s_task,
+                            TASK_UI_BUTTONS_CORE);
+    ESP_LOGI(TAG, "octave buttons started");
+}
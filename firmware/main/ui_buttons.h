@@ -0,0 +1,14 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Octave buttons: PIN_SW_LEFT = octave down, PIN_SW_RIGHT = octave up.
+ * Each press shifts the note map by one octave (see note_map.h).
+ */
+void ui_buttons_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,7 +8,10 @@
 #include "freertos/portmacro.h"
 
 #include "driver/ledc.h"
+#include "esp_timer.h"
+#include "adc_manager.h"
 #include "board_pins.h"
+#include "task_layout.h"
 
 // ============================================================
 // LED HW (PIN_STATUS_LED + LEDC PWM)
@@ -35,6 +38,11 @@
 
 static const int MAX_DUTY = (1 << 13) - 1;
 
+// PWM phase for the ADC's quiet windows (GPIO6 couples into the sliders):
+// counter reset time and period, set once in led_hw_init()
+static int64_t s_pwm_rise_us;
+static uint32_t s_pwm_period_ns;
+
 static led_state_t s_state_req = LED_ST_SYSTEM_NORMAL;
 static portMUX_TYPE s_state_mux = portMUX_INITIALIZER_UNLOCKED;
 
@@ -68,9 +76,18 @@ static void led_hw_init(void)
     };
     (void)ledc_channel_config(&cconf);
 
+    // Restart the counter at a known time: hpoint 0 => the output rises
+    // at every counter wrap, and falls `duty` counts later
+    (void)ledc_timer_rst(LEDC_MODE, LEDC_TIMER);
+    s_pwm_rise_us = esp_timer_get_time();
+    const uint32_t freq = ledc_get_freq(LEDC_MODE, LEDC_TIMER);
+    s_pwm_period_ns = freq ? 1000000000u / freq : 0;
+
     // start OFF
     ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, LED_ACTIVE_LOW ? MAX_DUTY : 0);
     ledc_update_duty(LEDC_MODE, LEDC_CHANNEL);
+    adc_manager_set_pwm_phase(s_pwm_rise_us, s_pwm_period_ns,
+                              (uint32_t)(((uint64_t)(LED_ACTIVE_LOW ? MAX_DUTY : 0) * s_pwm_period_ns) >> 13));
 
     printf("[LedHW] LEDC init: GPIO%d, %dHz, %dbit, active-%s\n",
            LED_GPIO, LEDC_FREQUENCY_HZ, 13, LED_ACTIVE_LOW ? "LOW" : "HIGH");
@@ -88,6 +105,7 @@ static void led_hw_apply(uint8_t level_0_255)
 
     ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, duty);
     ledc_update_duty(LEDC_MODE, LEDC_CHANNEL);
+    adc_manager_set_pwm_phase(s_pwm_rise_us, s_pwm_period_ns, (uint32_t)(((uint64_t)duty * s_pwm_period_ns) >> 13));
 }
 
 // ============================================================
@@ -205,5 +223,5 @@ void led_status_start(void)
     led_hw_init();
 
     // Single task only, as requested
-    xTaskCreatePinnedToCore(led_status_task, "LedStatus", 4096, NULL, 3, NULL, 0);
+    xTaskCreatePinnedToCore(led_status_task, "LedStatus", TASK_LED_STACK, NULL, TASK_LED_PRIO, NULL, TASK_LED_CORE);
 }
@@ -21,6 +21,8 @@
 #include "slider.h"
 
 #include "matrix_scan.h"
+#include "note_map.h"
+#include "task_layout.h"
 
 #include "esp_timer.h"
 
@@ -228,6 +230,7 @@ static void draw_cell_doublebox_fill(
 // ADC access (centralized)
 // -------------------------
 static bool s_adc_ok = false;
+static adc_chan_t s_bat_chan;
 
 // デバッグ用モード（PIN_SW_CENTER 押下で巡回）
 static power_debug_mode_t s_dbg_mode = PWR_MODE_BATTERY;
@@ -256,9 +259,9 @@ static void gpio_init_inputs(void)
 
 static void adc_init(void)
 {
-    s_adc_ok = adc_manager_init();
+    s_adc_ok = adc_manager_init() && adc_manager_chan_open(PIN_BAT_VSENSE, &s_bat_chan) == ESP_OK;
     if (!s_adc_ok) {
-        ESP_LOGW("OLED", "adc_manager_init failed; falling back to slider proxy");
+        ESP_LOGW("OLED", "battery sense ADC unavailable; falling back to slider proxy");
     }
 }
 
@@ -266,14 +269,14 @@ static int read_adc_mv_batvsense(void)
 {
     if (!s_adc_ok) {
         /* No ADC unit available; approximate battery from slider proxy. */
-        uint16_t raw = slider_read_pitchbend();
+        uint16_t raw = slider_pitchbend_last_fine() >> 6; /* no new sample: the slider task owns the filter */
         int slider_mv = (raw * 3300) / 1023;
         return 3300 + (slider_mv * 900) / 3300; // same formula as before
     }
 
-    int mv = 0;
-    if (adc_manager_read_mv(PIN_BAT_VSENSE, &mv) != ESP_OK) {
-        uint16_t raw = slider_read_pitchbend();
+    int raw = 0, mv = 0;
+    if (adc_manager_chan_read(&s_bat_chan, 1, 1, &raw, &mv) != ESP_OK) {
+        raw = slider_pitchbend_last_fine() >> 6; /* no new sample: the slider task owns the filter */
         int slider_mv = (raw * 3300) / 1023;
         return 3300 + (slider_mv * 900) / 3300;
     }
@@ -612,7 +615,7 @@ static void power_ui_update_blink_phase(power_ui_t *p, int64_t now_ms)
 
 static void draw_fixed_layout(u8g2_t *u8g2)
 {
-    // --- Yellow area (top): Battery + OCT: 0 ---
+    // --- Yellow area (top): Battery + OCT ---
     draw_battery_icon(u8g2, &s_pwr_ui);
 
     // ---- Cell size presets ----
@@ -625,11 +628,17 @@ static void draw_fixed_layout(u8g2_t *u8g2)
     // Compact:
     // const grid_layout_t g = grid_make_layout(8, 6, 1, 1); // grid_h=41
 
-    // --- Yellow area (top): OCT: 0 ---
+    // --- Yellow area (top): OCT (octave buttons, note_map) ---
     u8g2_SetFont(u8g2, u8g2_font_6x12_tf);
     u8g2_SetFontPosBaseline(u8g2);
 
-    const char *oct_text = "OCT: 0";
+    char oct_text[12];
+    const int oct = note_map_get_octave();
+    if (oct == 0) {
+        snprintf(oct_text, sizeof(oct_text), "OCT: 0");
+    } else {
+        snprintf(oct_text, sizeof(oct_text), "OCT: %+d", oct);
+    }
     int tw = u8g2_GetStrWidth(u8g2, oct_text);
     int tx = (OLED_W - tw) / 2;
     int ty = 12; // baseline within 0..15
@@ -746,5 +755,5 @@ static void oled_task(void *arg)
 
 void oled_demo_start(void)
 {
-    xTaskCreatePinnedToCore(oled_task, "OledDemo", 4096, NULL, 3, NULL, 0);
+    xTaskCreatePinnedToCore(oled_task, "OledDemo", TASK_OLED_STACK, NULL, TASK_OLED_PRIO, NULL, TASK_OLED_CORE);
 }
@@ -0,0 +1,85 @@
+#include "velocity.h"
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "input_pipeline.h"
+
+/* Defensive default for stale sdkconfig.h; must match Kconfig.projbuild. */
+#if defined(CONFIG_EMIUET_VELOCITY_CURVE_SOFT)
+#define VELOCITY_CURVE_DEFAULT VELOCITY_CURVE_SOFT
+#elif defined(CONFIG_EMIUET_VELOCITY_CURVE_HARD)
+#define VELOCITY_CURVE_DEFAULT VELOCITY_CURVE_HARD
+#else
+#define VELOCITY_CURVE_DEFAULT VELOCITY_CURVE_LINEAR
+#endif
+
+static const char *TAG = "velocity";
+
+#define VELOCITY_POS_MAX 1023u
+
+/* Position -> velocity. Rebuilt in place on curve changes (rare, UI
+ * task); a sample taken mid-rebuild gets either curve's value.
+ */
+static uint8_t s_lut[VELOCITY_POS_MAX + 1];
+static _Atomic velocity_curve_t s_curve = VELOCITY_CURVE_DEFAULT;
+static _Atomic uint16_t s_last_pos = 0;
+
+_Atomic uint8_t g_velocity = 100;
+
+static void build_lut(velocity_curve_t curve)
+{
+    for (uint32_t p = 0; p <= VELOCITY_POS_MAX; ++p) {
+        /* x in 0..1023; y in 0..1023 */
+        uint32_t y;
+        switch (curve) {
+        case VELOCITY_CURVE_SOFT: {
+            const uint32_t inv = VELOCITY_POS_MAX - p;
+            y = VELOCITY_POS_MAX - (inv * inv + VELOCITY_POS_MAX / 2u) / VELOCITY_POS_MAX;
+            break;
+        }
+        case VELOCITY_CURVE_HARD:
+            y = (p * p + VELOCITY_POS_MAX / 2u) / VELOCITY_POS_MAX;
+            break;
+        case VELOCITY_CURVE_LINEAR:
+        default:
+            y = p;
+            break;
+        }
+        s_lut[p] = (uint8_t)(1u + (y * 126u + VELOCITY_POS_MAX / 2u) / VELOCITY_POS_MAX);
+    }
+}
+
+static uint8_t velocity_source(const ip_event_t *ev)
+{
+    (void)ev;
+    return velocity_current();
+}
+
+void velocity_init(void)
+{
+    build_lut(atomic_load(&s_curve));
+    input_pipeline_set_velocity_source(velocity_source);
+    ESP_LOGI(TAG, "velocity slider on (curve=%d)", (int)atomic_load(&s_curve));
+}
+
+void velocity_set_curve(velocity_curve_t curve)
+{
+    if (curve > VELOCITY_CURVE_HARD) return;
+    atomic_store(&s_curve, curve);
+    build_lut(curve);
+    /* apply to the held position right away rather than at the next sample */
+    atomic_store_explicit(&g_velocity, s_lut[atomic_load(&s_last_pos)], memory_order_relaxed);
+}
+
+velocity_curve_t velocity_get_curve(void)
+{
+    return atomic_load(&s_curve);
+}
+
+void velocity_update(uint16_t pos)
+{
+    if (pos > VELOCITY_POS_MAX) pos = VELOCITY_POS_MAX;
+    atomic_store_explicit(&s_last_pos, pos, memory_order_relaxed);
+    atomic_store_explicit(&g_velocity, s_lut[pos], memory_order_relaxed);
+}
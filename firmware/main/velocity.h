@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Note-on velocity from the velocity slider
+ *
+ * The slider task samples PIN_SLIDER_VEL in the background and pushes
+ * each filtered position through a precomputed curve LUT; the result is
+ * published as one atomic byte. A note-on reads that byte and never
+ * touches the ADC, so velocity control adds no latency to the key path.
+ * ========================================================= */
+
+typedef enum {
+    VELOCITY_CURVE_LINEAR = 0,
+    VELOCITY_CURVE_SOFT, /* louder low on the slider: 1 - (1 - x)^2 */
+    VELOCITY_CURVE_HARD, /* quieter low on the slider: x^2 */
+} velocity_curve_t;
+
+/* Build the LUT (Kconfig curve) and install the velocity source in the
+ * input pipeline. Call from the sampling task's start, after slider_init().
+ */
+void velocity_init(void);
+
+/* Rebuild the LUT; takes effect at the next sample. */
+void velocity_set_curve(velocity_curve_t curve);
+velocity_curve_t velocity_get_curve(void);
+
+/* Sampler side: filtered slider position 0..1023 */
+void velocity_update(uint16_t pos);
+
+/* Latest note-on velocity (1..127) */
+extern _Atomic uint8_t g_velocity;
+
+static inline uint8_t velocity_current(void)
+{
+    return atomic_load_explicit(&g_velocity, memory_order_relaxed);
+}